@@ -128,3 +128,280 @@ TEST_F(TestHistogram, TestBinning){
         EXPECT_DOUBLE_EQ(-42 + (0.5 + i++) * 2, x);
     }
 }
+
+TEST_F(TestHistogram, DynamicHistogram_MatchesHistogram){
+    std::fill(displ_gaussian.data(), displ_gaussian.data() + ndof, 0);
+    mcpele::SampleGaussian sampler(42, ss, displ_gaussian);
+    mcpele::Histogram hist(-1, 1, 0.5);
+    mcpele::DynamicHistogram dhist(-1, 1, 0.5);
+    EXPECT_EQ(hist.size(), dhist.size());
+    for (size_t step = 0; step < nsteps; ++step) {
+        sampler.displace(displ_gaussian, mc);
+        for (size_t dof = 0; dof < ndof; ++dof) {
+            hist.add_entry(displ_gaussian[dof]);
+            dhist.add_entry(displ_gaussian[dof]);
+        }
+    }
+    EXPECT_EQ(static_cast<size_t>(hist.get_count()), dhist.get_count());
+    EXPECT_DOUBLE_EQ(hist.min(), dhist.min());
+    EXPECT_DOUBLE_EQ(hist.max(), dhist.max());
+    EXPECT_DOUBLE_EQ(hist.get_mean(), dhist.get_mean());
+    const std::vector<double> vecdata = hist.get_vecdata();
+    const std::vector<double> dvecdata = dhist.get_vecdata();
+    EXPECT_EQ(vecdata.size(), dvecdata.size());
+    for (size_t i = 0; i < vecdata.size(); ++i) {
+        EXPECT_DOUBLE_EQ(vecdata.at(i), dvecdata.at(i));
+        EXPECT_DOUBLE_EQ(hist.get_position(i), dhist.get_position(i));
+    }
+    EXPECT_EQ(dhist.get_count(), std::accumulate(dhist.begin(), dhist.end(), size_t(0)));
+}
+
+TEST_F(TestHistogram, DynamicHistogram_GrowsBothWays){
+    mcpele::DynamicHistogram hist(0, 1, 1);
+    const long n = 1e5;
+    size_t nr_reallocations = 0;
+    size_t capacity = hist.get_capacity();
+    for (long i = 0; i < n; ++i) {
+        hist.add_entry(-i - 0.5);
+        hist.add_entry(i + 0.5);
+        if (hist.get_capacity() != capacity) {
+            ++nr_reallocations;
+            capacity = hist.get_capacity();
+        }
+    }
+    EXPECT_EQ(static_cast<size_t>(2 * n), hist.size());
+    EXPECT_DOUBLE_EQ(-n, hist.min());
+    EXPECT_DOUBLE_EQ(n, hist.max());
+    EXPECT_LE(nr_reallocations, 20u);
+    EXPECT_LE(hist.get_capacity(), 4 * hist.size());
+    for (size_t i = 0; i < hist.size(); ++i) {
+        EXPECT_EQ(1u, hist.get_entry(i));
+    }
+}
+
+TEST_F(TestHistogram, SparseHistogram_MatchesDynamicHistogram){
+    std::fill(displ_gaussian.data(), displ_gaussian.data() + ndof, 0);
+    mcpele::SampleGaussian sampler(42, ss, displ_gaussian);
+    mcpele::DynamicHistogram dhist(-1, 1, 0.1);
+    mcpele::SparseHistogram shist(-1, 1, 0.1);
+    for (size_t step = 0; step < nsteps; ++step) {
+        sampler.displace(displ_gaussian, mc);
+        for (size_t dof = 0; dof < ndof; ++dof) {
+            dhist.add_entry(displ_gaussian[dof]);
+            shist.add_entry(displ_gaussian[dof]);
+        }
+    }
+    EXPECT_EQ(dhist.get_count(), shist.get_count());
+    EXPECT_EQ(dhist.size(), shist.size());
+    EXPECT_DOUBLE_EQ(dhist.min(), shist.min());
+    EXPECT_DOUBLE_EQ(dhist.max(), shist.max());
+    const std::vector<double> dvecdata = dhist.get_vecdata();
+    const std::vector<double> svecdata = shist.get_vecdata();
+    EXPECT_EQ(dvecdata.size(), svecdata.size());
+    size_t nr_occupied = 0;
+    for (size_t i = 0; i < dvecdata.size(); ++i) {
+        EXPECT_DOUBLE_EQ(dvecdata.at(i), svecdata.at(i));
+        EXPECT_EQ(dhist.get_entry(i), shist.get_entry(i));
+        nr_occupied += (dvecdata.at(i) > 0);
+    }
+    EXPECT_EQ(nr_occupied, shist.get_nr_occupied_bins());
+    std::vector<double> positions;
+    std::vector<size_t> counts;
+    shist.get_occupied_bins(positions, counts);
+    EXPECT_EQ(nr_occupied, positions.size());
+    EXPECT_TRUE(std::is_sorted(positions.begin(), positions.end()));
+    EXPECT_EQ(shist.get_count(), std::accumulate(counts.begin(), counts.end(), size_t(0)));
+}
+
+TEST_F(TestHistogram, SparseHistogram_WideRangeBoundedMemory){
+    mcpele::SparseHistogram hist(0, 1, 1e-3);
+    const double energies[] = {-1e12, 1e12, 0.5, -1e12, 3e9};
+    for (const double e : energies) {
+        hist.add_entry(e);
+    }
+    EXPECT_EQ(4u, hist.get_nr_occupied_bins());
+    EXPECT_LE(hist.get_capacity(), 16u);
+    EXPECT_LE(hist.min(), -1e12);
+    EXPECT_GE(hist.max(), 1e12);
+    std::vector<double> positions;
+    std::vector<size_t> counts;
+    hist.get_occupied_bins(positions, counts);
+    EXPECT_EQ(2u, counts.front());
+    EXPECT_NEAR(-1e12, positions.front(), 1e-3);
+    EXPECT_EQ(5u, hist.get_count());
+}
+
+TEST_F(TestHistogram, Moments_MergeMatchesSequential){
+    mcpele::Moments all, a, b;
+    for (size_t i = 0; i < 1000; ++i) {
+        const double x = std::sin(i) * 10 + 3;
+        all(x);
+        if (i % 3) {
+            a(x);
+        }
+        else {
+            b(x);
+        }
+    }
+    a.merge(b);
+    EXPECT_EQ(all.count(), a.count());
+    EXPECT_NEAR(all.mean(), a.mean(), 1e-12);
+    EXPECT_NEAR(all.variance(), a.variance(), 1e-10);
+    double buffer[mcpele::Moments::buffer_size];
+    a.write_buffer(buffer);
+    mcpele::Moments c;
+    c.read_buffer(buffer);
+    EXPECT_EQ(a.count(), c.count());
+    EXPECT_DOUBLE_EQ(a.mean(), c.mean());
+}
+
+TEST_F(TestHistogram, Histogram_MergeDifferentRanges){
+    mcpele::Histogram all(0, 1, 0.5);
+    mcpele::Histogram a(0, 1, 0.5);
+    mcpele::Histogram b(-3, -2, 0.5);
+    for (size_t i = 0; i < 1000; ++i) {
+        const double x = std::sin(i) * 4;
+        all.add_entry(x);
+        if (i % 2) {
+            a.add_entry(x);
+        }
+        else {
+            b.add_entry(x);
+        }
+    }
+    mcpele::Histogram c(a.get_buffer());
+    a.merge(b);
+    c.merge_buffer(b.get_buffer());
+    for (const mcpele::Histogram* h : {&a, &c}) {
+        EXPECT_DOUBLE_EQ(all.min(), h->min());
+        EXPECT_DOUBLE_EQ(all.max(), h->max());
+        EXPECT_EQ(all.size(), h->size());
+        EXPECT_EQ(all.get_count(), h->get_count());
+        EXPECT_NEAR(all.get_mean(), h->get_mean(), 1e-12);
+        EXPECT_NEAR(all.get_variance(), h->get_variance(), 1e-10);
+        for (size_t i = 0; i < all.size(); ++i) {
+            EXPECT_DOUBLE_EQ(all.get_entry(i), h->get_entry(i));
+        }
+    }
+    EXPECT_THROW(a.merge(mcpele::Histogram(0, 1, 0.25)), std::runtime_error);
+}
+
+TEST_F(TestHistogram, DynamicSparse_MergeBuffers){
+    mcpele::DynamicHistogram all(0, 1, 0.5);
+    mcpele::DynamicHistogram a(0, 1, 0.5);
+    mcpele::SparseHistogram b(-30, -20, 0.5);
+    mcpele::SparseHistogram c(5, 6, 0.5);
+    for (size_t i = 0; i < 1000; ++i) {
+        const double x = std::sin(i) * 4;
+        all.add_entry(x);
+        if (i % 2) {
+            a.add_entry(x);
+        }
+        else {
+            b.add_entry(x);
+        }
+    }
+    all.extend_range(-30, 6);
+    // b is spread over few bins of a wide range: its buffer holds (k, count) pairs
+    const std::vector<double> sparse_buffer = b.get_buffer();
+    EXPECT_DOUBLE_EQ(1, sparse_buffer[4]);
+    EXPECT_GT(b.size(), sparse_buffer.size() - mcpele::BaseHistogram::buffer_header_size);
+    // the entries of a cover their range densely
+    mcpele::DynamicHistogram d(-4, 4, 0.5);
+    for (size_t i = 1; i < 1000; i += 2) {
+        d.add_entry(std::sin(i) * 4);
+    }
+    const std::vector<double> dense_buffer = d.get_buffer();
+    EXPECT_DOUBLE_EQ(0, dense_buffer[4]);
+    EXPECT_EQ(d.size(), dense_buffer.size() - mcpele::BaseHistogram::buffer_header_size);
+    mcpele::DynamicHistogram e(0, 1, 0.5);
+    e.merge_buffer(dense_buffer);
+    e.merge_buffer(sparse_buffer);
+    e.extend_range(5, 6);
+    EXPECT_EQ(all.get_vecdata(), e.get_vecdata());
+    c.merge(a);
+    c.merge_buffer(sparse_buffer);
+    a.merge(b);
+    a.extend_range(5, 6);
+    for (const mcpele::BaseHistogram* h : {static_cast<mcpele::BaseHistogram*>(&a), static_cast<mcpele::BaseHistogram*>(&c)}) {
+        EXPECT_DOUBLE_EQ(all.min(), h->min());
+        EXPECT_DOUBLE_EQ(all.max(), h->max());
+        EXPECT_EQ(all.get_count(), h->get_count());
+        EXPECT_NEAR(all.get_mean(), h->get_mean(), 1e-12);
+        const std::vector<double> vall = all.get_vecdata();
+        const std::vector<double> vh = h->get_vecdata();
+        EXPECT_EQ(vall.size(), vh.size());
+        for (size_t i = 0; i < vall.size(); ++i) {
+            EXPECT_DOUBLE_EQ(vall.at(i), vh.at(i));
+        }
+    }
+}
+
+TEST_F(TestHistogram, Moments_LargeOffset_VarianceAccurate){
+    // E[x^2] - E[x]^2 cancels catastrophically for a large offset
+    mcpele::Moments mom;
+    const double offset = 1e9;
+    for (size_t i = 0; i < 100000; ++i) {
+        mom(offset + (i % 2 ? 1 : -1));
+    }
+    EXPECT_NEAR(offset, mom.mean(), 1e-6);
+    EXPECT_NEAR(1, mom.variance(), 1e-6);
+}
+
+TEST_F(TestHistogram, Moments_MergeKeepsCompensation){
+    // the mean rounds to the nearest double only if the compensations of both halves are merged
+    const double offset = 1e9;
+    mcpele::Moments a, b;
+    double deviation_mean = 0;
+    const size_t n = 100000;
+    for (size_t i = 0; i < n; ++i) {
+        const double deviation = 0.3 * std::sin(i);
+        deviation_mean += deviation / n;
+        if (i % 2) {
+            a(offset + deviation);
+        }
+        else {
+            b(offset + deviation);
+        }
+    }
+    a.merge(b);
+    double buffer[mcpele::Moments::buffer_size];
+    a.write_buffer(buffer);
+    EXPECT_EQ(offset + deviation_mean, buffer[1]);
+}
+
+TEST_F(TestHistogram, Moments_BatchAndHigherMatchTwoPass){
+    std::vector<double> x(5000);
+    for (size_t i = 0; i < x.size(); ++i) {
+        x[i] = std::exp(std::sin(0.1 * i)) + 0.5;
+    }
+    double mean = 0;
+    for (size_t i = 0; i < x.size(); ++i) {
+        mean += x[i] / x.size();
+    }
+    double m2 = 0, m3 = 0, m4 = 0;
+    for (size_t i = 0; i < x.size(); ++i) {
+        const double d = x[i] - mean;
+        m2 += d * d;
+        m3 += d * d * d;
+        m4 += d * d * d * d;
+    }
+    const double n = x.size();
+    const double skewness = sqrt(n) * m3 / pow(m2, 1.5);
+    const double kurtosis = n * m4 / (m2 * m2) - 3;
+    mcpele::Moments sequential(true), batch(true), plain;
+    for (size_t i = 0; i < x.size(); ++i) {
+        sequential(x[i]);
+    }
+    batch.update(x.data(), x.data() + x.size());
+    plain.update(x.data(), x.data() + x.size());
+    EXPECT_THROW(plain.skewness(), std::runtime_error);
+    EXPECT_EQ(x.size(), batch.count());
+    for (auto mom : {sequential, batch}) {
+        EXPECT_NEAR(mean, mom.mean(), 1e-12);
+        EXPECT_NEAR(m2 / n, mom.variance(), 1e-12);
+        EXPECT_NEAR(skewness, mom.skewness(), 1e-10);
+        EXPECT_NEAR(kurtosis, mom.kurtosis(), 1e-10);
+    }
+    EXPECT_NEAR(m2 / n, plain.variance(), 1e-12);
+}
@@ -0,0 +1,120 @@
+#include <iostream>
+#include <stdexcept>
+#include <cmath>
+#include <vector>
+#include <memory>
+#include <gtest/gtest.h>
+
+#include "pele/array.h"
+#include "pele/base_potential.h"
+
+#include "mcpele/lowest_eigenvalue.h"
+
+namespace {
+
+/**
+ * particles on a line joined by springs with energy dx^2 / 2 + c dx^4 / 4;
+ * for c = 0 the Hessian is the graph Laplacian of a path and, apart from
+ * the translation, its lowest eigenvalue is 2 (1 - cos(pi / n)). For c > 0
+ * the Hessian depends on the configuration.
+ */
+struct SpringChain : public pele::BasePotential {
+    const double m_c;
+    SpringChain(const double c=0)
+        : m_c(c)
+    {}
+    virtual double get_energy(pele::Array<double> x)
+    {
+        double energy = 0;
+        for (size_t i = 0; i + 1 < x.size(); ++i) {
+            const double dx = x[i + 1] - x[i];
+            energy += 0.5 * dx * dx + 0.25 * m_c * dx * dx * dx * dx;
+        }
+        return energy;
+    }
+    virtual double get_energy_gradient(pele::Array<double> x, pele::Array<double> grad)
+    {
+        for (size_t i = 0; i < grad.size(); ++i) {
+            grad[i] = 0;
+        }
+        for (size_t i = 0; i + 1 < x.size(); ++i) {
+            const double dx = x[i + 1] - x[i];
+            const double force = dx + m_c * dx * dx * dx;
+            grad[i] -= force;
+            grad[i + 1] += force;
+        }
+        return get_energy(x);
+    }
+};
+
+} // namespace
+
+TEST(LowestEigenvalue, LBFGSWarmStart){
+    const size_t n = 20;
+    auto chain = std::make_shared<SpringChain>(0.5);
+    pele::Array<double> coords(n);
+    pele::Array<double> ranvec(n);
+    for (size_t i = 0; i < n; ++i) {
+        coords[i] = i;
+        ranvec[i] = std::sin(1.3 * i * i + 0.1);
+    }
+    mcpele::FindLowestEigenvalue cold(chain, 1, ranvec, 2000);
+    mcpele::FindLowestEigenvalue warm(chain, 1, ranvec, 2000, true);
+    const double first_cold = cold.compute_lowest_eigenvalue(coords);
+    EXPECT_NEAR(warm.compute_lowest_eigenvalue(coords), first_cold, 1e-6);
+    EXPECT_EQ(cold.get_last_niter(), warm.get_last_niter());
+    const size_t first_niter = warm.get_last_niter();
+    // a small MC-like move changes the Hessian a little
+    for (size_t i = 0; i < n; ++i) {
+        coords[i] += 0.05 * std::sin(3. * i);
+    }
+    const double lowest_cold = cold.compute_lowest_eigenvalue(coords);
+    const double lowest_warm = warm.compute_lowest_eigenvalue(coords);
+    // both converge to the LBFGS gradient tolerance
+    EXPECT_NEAR(lowest_cold, lowest_warm, 1e-5);
+    EXPECT_NE(lowest_cold, first_cold);
+    EXPECT_LT(warm.get_last_niter(), cold.get_last_niter());
+    EXPECT_EQ(warm.get_nr_computations(), 2u);
+    EXPECT_EQ(warm.get_total_niter(), first_niter + warm.get_last_niter());
+}
+
+TEST(LowestEigenvalue, LanczosWarmStart){
+    const size_t n = 40;
+    const double exact = 2 * (1 - std::cos(M_PI / n));
+    auto chain = std::make_shared<SpringChain>();
+    pele::Array<double> coords(n);
+    pele::Array<double> ranvec(n);
+    for (size_t i = 0; i < n; ++i) {
+        coords[i] = i;
+        ranvec[i] = std::sin(1.3 * i * i + 0.1);
+    }
+    mcpele::FindLowestEigenvalue cold(chain, 1, ranvec, 100, false, true);
+    mcpele::FindLowestEigenvalue warm(chain, 1, ranvec, 100, true, true);
+    EXPECT_NEAR(cold.compute_lowest_eigenvalue(coords), exact, 1e-6);
+    EXPECT_NEAR(warm.compute_lowest_eigenvalue(coords), exact, 1e-6);
+    const size_t first_niter = warm.get_last_niter();
+    EXPECT_EQ(cold.get_last_niter(), first_niter);
+    EXPECT_GT(first_niter, 5u);
+    // the Hessian does not depend on the configuration, the warm start converges at once
+    for (size_t i = 0; i < n; ++i) {
+        coords[i] += 0.1 * std::sin(i);
+    }
+    EXPECT_NEAR(warm.compute_lowest_eigenvalue(coords), exact, 1e-6);
+    EXPECT_LE(warm.get_last_niter(), 2u);
+    EXPECT_NEAR(cold.compute_lowest_eigenvalue(coords), exact, 1e-6);
+    EXPECT_EQ(cold.get_last_niter(), first_niter);
+    EXPECT_EQ(warm.get_nr_computations(), 2u);
+    EXPECT_EQ(warm.get_total_niter(), first_niter + warm.get_last_niter());
+}
+
+TEST(LowestEigenvalue, Tridiagonal){
+    // path graph Laplacian 3x3 has eigenvalues 0, 1, 3
+    std::vector<double> alpha = {1, 2, 1};
+    std::vector<double> beta = {-1, -1};
+    const double lowest = mcpele::FindLowestEigenvalue::tridiagonal_lowest_eigenvalue(alpha, beta);
+    EXPECT_NEAR(lowest, 0, 1e-12);
+    std::vector<double> evec = mcpele::FindLowestEigenvalue::tridiagonal_lowest_eigenvector(alpha, beta, lowest);
+    for (size_t i = 0; i < evec.size(); ++i) {
+        EXPECT_NEAR(std::abs(evec[i]), 1 / std::sqrt(3.), 1e-8);
+    }
+}
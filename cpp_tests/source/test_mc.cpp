@@ -5,10 +5,15 @@
 #include <algorithm>
 #include <memory>
 #include <string>
+#include <chrono>
+#include <thread>
 #include <gtest/gtest.h>
 
 #include "pele/harmonic.h"
+#include "pele/lbfgs.h"
 
+#include "mcpele/batched_mc.h"
+#include "mcpele/check_spherical_container_config.h"
 #include "mcpele/random_coords_displacement.h"
 #include "mcpele/metropolis_test.h"
 #include "mcpele/energy_window_test.h"
@@ -17,6 +22,17 @@
 #include "mcpele/take_step_pattern.h"
 #include "mcpele/take_step_probabilities.h"
 #include "mcpele/progress.h"
+#include "mcpele/record_energy_autocorrelation.h"
+#include "mcpele/record_energy_blocking.h"
+#include "mcpele/stop_criteria.h"
+#include "mcpele/equilibration_detector.h"
+#include "mcpele/async_action.h"
+#include "mcpele/quench_pool.h"
+#include "mcpele/nested_sampling.h"
+#include "mcpele/check_spherical_container.h"
+#include "mcpele/minima_database.h"
+#include "mcpele/wang_landau.h"
+#include "mcpele/tabulated_bias.h"
 
 #define EXPECT_NEAR_RELATIVE(A, B, T)  EXPECT_NEAR(fabs(A)/(fabs(A)+fabs(B)+1), fabs(B)/(fabs(A)+fabs(B)+1), T)
 
@@ -83,6 +99,70 @@ TEST_F(TestMC, BasicFunctionalityAddingModulesDynamic){
     delete mc;
 }
 
+TEST_F(TestMC, StopCriteria_StopEarly){
+    mcpele::MC mc(potential, x, 1);
+    mc.set_takestep(std::make_shared<mcpele::RandomCoordsDisplacementAll>(42, 0.05));
+    mc.add_accept_test(std::make_shared<mcpele::MetropolisTest>(42));
+    auto blocking = std::make_shared<mcpele::RecordEnergyBlocking>(1, 1000);
+    auto autocorrelation = std::make_shared<mcpele::RecordEnergyAutocorrelation>(1, 1000);
+    mc.add_action(blocking);
+    mc.add_action(autocorrelation);
+    // equipartition: the mean energy is ndof T / 2 with standard deviation sqrt(ndof / 2) T
+    const double tolerance = 0.25;
+    auto stop_se = std::make_shared<mcpele::StopStandardError>(blocking, tolerance);
+    mc.add_stop_criterion(stop_se);
+    mc.set_stop_check_every(500);
+    EXPECT_EQ(500u, mc.get_stop_check_every());
+    mc.run(max_iter);
+    const size_t nsteps = mc.get_iterations_count();
+    EXPECT_LT(nsteps, max_iter);
+    EXPECT_EQ(0u, nsteps % 500);
+    EXPECT_LT(blocking->get_standard_error(), tolerance);
+    EXPECT_EQ(stop_se->get_reason(), mc.get_stop_reason());
+    EXPECT_EQ(0u, mc.get_stop_reason().find("standard error"));
+    EXPECT_NEAR(0.5 * ndof, blocking->get_mean(), 5 * tolerance);
+    // the effective sample size accumulates over runs
+    mcpele::StopEffectiveSampleSize stop_ess(autocorrelation, 1e9);
+    EXPECT_FALSE(stop_ess.stop(&mc));
+    EXPECT_LT(stop_ess.get_effective_sample_size(), autocorrelation->get_count());
+    mc.add_stop_criterion(std::make_shared<mcpele::StopEffectiveSampleSize>(autocorrelation, 0.5 * stop_ess.get_effective_sample_size()));
+    mc.run(max_iter);
+    EXPECT_EQ(nsteps + 500, mc.get_iterations_count());
+}
+
+TEST_F(TestMC, StopCriteria_WallClockAndMaxIter){
+    mcpele::MC mc(potential, x, 1);
+    mc.set_takestep(std::make_shared<mcpele::RandomCoordsDisplacementAll>(42, stepsize));
+    mc.run(100);
+    EXPECT_EQ("max_iter", mc.get_stop_reason());
+    mc.add_stop_criterion(std::make_shared<mcpele::StopWallClock>(0));
+    mc.set_stop_check_every(10);
+    mc.run(100);
+    EXPECT_EQ(110u, mc.get_iterations_count());
+    EXPECT_EQ(0u, mc.get_stop_reason().find("wall-clock"));
+}
+
+TEST_F(TestMC, EquilibrationDetector_SwitchesActionsOn){
+    // start far from equilibrium, the energy relaxes to ndof T / 2
+    std::fill(x.data(), x.data() + ndof, 0.5);
+    mcpele::MC mc(potential, x, 1);
+    mc.set_takestep(std::make_shared<mcpele::AdaptiveTakeStep>(std::make_shared<mcpele::RandomCoordsDisplacementAll>(42, 0.05), 100));
+    mc.add_accept_test(std::make_shared<mcpele::MetropolisTest>(42));
+    mc.set_report_steps(max_iter);
+    auto detector = std::make_shared<mcpele::EquilibrationDetector>(10, 400);
+    auto hist = std::make_shared<mcpele::RecordEnergyHistogram>(0, 100, 1, 0);
+    detector->add_action(hist);
+    mc.add_action(detector);
+    mc.run(max_iter);
+    EXPECT_TRUE(detector->is_equilibrated());
+    const size_t eq_step = detector->get_equilibration_step();
+    EXPECT_GT(eq_step, 4000u);
+    EXPECT_LT(eq_step, max_iter / 2);
+    EXPECT_EQ(eq_step, mc.get_report_steps());
+    EXPECT_EQ(max_iter - eq_step, hist->get_count());
+    EXPECT_NEAR(0.5 * ndof, hist->get_mean(), 1);
+}
+
 TEST_F(TestMC, BasicFunctionalityPolyHarmonic){
     //max_iter *= 10;
     mcpele::MC* mc = new mcpele::MC(potential, x, 1);
@@ -385,3 +465,593 @@ TEST_F(TestMCMock, RecordEnergyHistogram_Works) {
     }
 }
 
+
+TEST_F(TestMCMock, RecordEnergyHistogramSparse_Works) {
+    const size_t report_steps = 1e2;
+    auto hist_dense = std::make_shared<mcpele::RecordEnergyHistogram>(0, 42, 2, report_steps);
+    auto hist_sparse = std::make_shared<mcpele::RecordEnergyHistogram>(0, 42, 2, report_steps, true);
+    mc->add_action(hist_dense);
+    mc->add_action(hist_sparse);
+    mc->set_report_steps(report_steps);
+    mc->run(10 * report_steps);
+    EXPECT_TRUE(hist_sparse->is_sparse());
+    pele::Array<double> hd = hist_dense->get_histogram();
+    pele::Array<double> hs = hist_sparse->get_histogram();
+    EXPECT_EQ(hd.size(), hs.size());
+    for (size_t i = 0; i < hd.size(); ++i) {
+        EXPECT_DOUBLE_EQ(hd[i], hs[i]);
+    }
+    EXPECT_EQ(hist_dense->get_count(), hist_sparse->get_count());
+    std::vector<double> positions, counts;
+    hist_sparse->get_occupied_bins(positions, counts);
+    EXPECT_LT(0u, positions.size());
+    double total = 0;
+    for (size_t i = 0; i < positions.size(); ++i) {
+        const size_t bin_index = (positions[i] - hist_sparse->get_min()) / 2;
+        EXPECT_DOUBLE_EQ(hd[bin_index], counts[i]);
+        total += counts[i];
+    }
+    EXPECT_DOUBLE_EQ(hist_sparse->get_count(), total);
+}
+
+TEST(BatchedMC, ComputePi_Works){
+    const size_t nwalkers = 64;
+    const size_t ndim = 2;
+    const double radius = 1;
+    Array<double> x0(nwalkers * ndim, 0);
+    mcpele::BatchedMC mc(std::make_shared<mcpele::BatchedNullPotential>(), x0, nwalkers, 1);
+    mc.set_takestep(std::make_shared<mcpele::BatchedUniformRectangularSampling>(42, Array<double>(ndim, 2 * radius)));
+    mc.add_conf_test(std::make_shared<mcpele::BatchedCheckSphericalContainerConfig>(radius));
+    const size_t niter = 1e3;
+    mc.run(niter);
+    EXPECT_EQ(niter, mc.get_iterations_count());
+    EXPECT_EQ(niter * nwalkers, mc.get_naccept() + mc.get_nconf_reject());
+    EXPECT_NEAR(M_PI / 4, mc.get_accepted_fraction(), 5e-3);
+    for (size_t w = 0; w < nwalkers; ++w) {
+        const Array<double> x = mc.get_coords(w);
+        EXPECT_LE(pele::dot(x, x), radius * radius);
+    }
+}
+
+TEST(BatchedMC, ScalarFallback_MatchesConfTest){
+    const size_t nwalkers = 16;
+    const size_t ndim = 3;
+    Array<double> x0(nwalkers * ndim, 0);
+    auto conf_batched = std::make_shared<mcpele::BatchedCheckSphericalContainerConfig>(0.5);
+    auto conf_scalar = std::make_shared<mcpele::BatchedConfTestAdaptor>(std::make_shared<mcpele::CheckSphericalContainerConfig>(0.5));
+    std::vector<double> x(nwalkers * ndim);
+    mcpele::BatchedUniformRectangularSampling step(42, Array<double>(ndim, 2));
+    for (size_t i = 0; i < 100; ++i) {
+        step.displace(x.data(), nwalkers, ndim);
+        std::vector<char> result_batched(nwalkers, true);
+        std::vector<char> result_scalar(nwalkers, true);
+        conf_batched->conf_test(x.data(), nwalkers, ndim, result_batched.data());
+        conf_scalar->conf_test(x.data(), nwalkers, ndim, result_scalar.data());
+        for (size_t w = 0; w < nwalkers; ++w) {
+            EXPECT_EQ(result_batched[w], result_scalar[w]);
+        }
+    }
+}
+
+TEST(BatchedMC, HarmonicEquipartition_Works){
+    // mean harmonic energy per degree of freedom is T / 2
+    const size_t nwalkers = 32;
+    const size_t ndof = 4;
+    const double temperature = 0.5;
+    Array<double> origin(ndof, 0);
+    auto potential = std::make_shared<mcpele::BatchedPotentialAdaptor>(std::make_shared<pele::Harmonic>(origin, 1, ndof));
+    mcpele::BatchedMC mc(potential, Array<double>(nwalkers * ndof, 0), nwalkers, temperature);
+    mc.set_takestep(std::make_shared<mcpele::BatchedRandomCoordsDisplacement>(42, 1.5));
+    mc.run(1e3);
+    mcpele::Moments energy;
+    for (size_t i = 0; i < 2e3; ++i) {
+        mc.one_iteration();
+        for (size_t w = 0; w < nwalkers; ++w) {
+            energy(mc.get_energy(w));
+        }
+    }
+    EXPECT_NEAR(0.5 * ndof * temperature, energy.mean(), 0.05);
+    EXPECT_LT(0, mc.get_accepted_fraction());
+    EXPECT_LT(mc.get_accepted_fraction(), 1);
+}
+
+namespace {
+
+/**
+ * check the energy of each configuration it is given with its own potential
+ */
+struct CheckEnergyAction : public mcpele::Action {
+    std::shared_ptr<pele::Harmonic> potential;
+    std::vector<size_t> steps;
+    size_t nr_wrong;
+    CheckEnergyAction(pele::Array<double> origin, const double k, const size_t boxdim)
+        : potential(std::make_shared<pele::Harmonic>(origin, k, boxdim)),
+          nr_wrong(0)
+    {}
+    virtual void action(pele::Array<double> &coords, double energy, bool accepted, MC* mc)
+    {
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+        if (std::abs(potential->get_energy(coords) - energy) > 1e-10 * (1 + std::abs(energy))
+                || mc->get_energy() != energy) {
+            ++nr_wrong;
+        }
+        steps.push_back(mc->get_iterations_count());
+    }
+};
+
+struct ThrowingAction : public mcpele::Action {
+    virtual void action(pele::Array<double> &coords, double energy, bool accepted, MC* mc)
+    {
+        throw std::runtime_error("ThrowingAction");
+    }
+};
+
+} // namespace
+
+TEST_F(TestMC, AsyncAction_ProcessesEverySnapshot){
+    const size_t niter = 5000;
+    const size_t record_every = 10;
+    const size_t eqsteps = 1000;
+    MC mc(potential, x, 1);
+    mc.set_takestep(std::make_shared<mcpele::RandomCoordsDisplacementAll>(42, stepsize));
+    std::vector<std::shared_ptr<mcpele::Action> > workers;
+    for (size_t i = 0; i < 3; ++i) {
+        workers.push_back(std::make_shared<CheckEnergyAction>(origin, k, boxdim));
+    }
+    auto async = std::make_shared<mcpele::AsyncAction>(workers, record_every, eqsteps, 4);
+    mc.add_action(async);
+    mc.run(niter);
+    async->flush();
+    const size_t nrecords = (niter - eqsteps) / record_every;
+    EXPECT_EQ(async->get_nr_processed(), nrecords);
+    std::vector<size_t> steps;
+    for (auto & worker : workers) {
+        auto check = std::static_pointer_cast<CheckEnergyAction>(worker);
+        EXPECT_EQ(check->nr_wrong, 0u);
+        steps.insert(steps.end(), check->steps.begin(), check->steps.end());
+    }
+    std::sort(steps.begin(), steps.end());
+    ASSERT_EQ(steps.size(), nrecords);
+    for (size_t i = 0; i < nrecords; ++i) {
+        EXPECT_EQ(steps[i], eqsteps + (i + 1) * record_every);
+    }
+}
+
+TEST_F(TestMC, AsyncAction_RethrowsWorkerError){
+    MC mc(potential, x, 1);
+    mc.set_takestep(std::make_shared<mcpele::RandomCoordsDisplacementAll>(42, stepsize));
+    std::vector<std::shared_ptr<mcpele::Action> > workers(1, std::make_shared<ThrowingAction>());
+    auto async = std::make_shared<mcpele::AsyncAction>(workers, 1, 0);
+    mc.add_action(async);
+    EXPECT_THROW({ mc.run(100); async->flush(); }, std::runtime_error);
+}
+
+namespace {
+
+/**
+ * tilted double well in every coordinate, 2^ndof minima of distinct energies
+ */
+struct TiltedDoubleWell : public pele::BasePotential {
+    virtual double get_energy(pele::Array<double> x)
+    {
+        double energy = 0;
+        for (size_t i = 0; i < x.size(); ++i) {
+            energy += (x[i] * x[i] - 1) * (x[i] * x[i] - 1) + 0.1 * (i + 1) * x[i];
+        }
+        return energy;
+    }
+    virtual double get_energy_gradient(pele::Array<double> x, pele::Array<double> grad)
+    {
+        for (size_t i = 0; i < x.size(); ++i) {
+            grad[i] = 4 * x[i] * (x[i] * x[i] - 1) + 0.1 * (i + 1);
+        }
+        return get_energy(x);
+    }
+};
+
+struct RecordSteps : public mcpele::Action {
+    std::vector<size_t> steps;
+    virtual void action(pele::Array<double> &coords, double energy, bool accepted, MC* mc)
+    {
+        steps.push_back(mc->get_iterations_count());
+    }
+};
+
+std::shared_ptr<mcpele::MinimaDatabase> sample_minima(const size_t nr_threads, const size_t niter,
+        const size_t record_every, std::vector<size_t>& steps)
+{
+    const size_t ndof = 3;
+    pele::Array<double> x(ndof, 0);
+    MC mc(std::make_shared<TiltedDoubleWell>(), x, 1);
+    mc.set_takestep(std::make_shared<mcpele::RandomCoordsDisplacementAll>(42, 1));
+    std::vector<std::shared_ptr<pele::GradientOptimizer> > optimizers;
+    for (size_t i = 0; i < nr_threads; ++i) {
+        optimizers.push_back(std::make_shared<pele::LBFGS>(std::make_shared<TiltedDoubleWell>(), x));
+    }
+    auto pool = std::make_shared<mcpele::QuenchPool>(optimizers, record_every, 0, 8);
+    auto database = std::make_shared<mcpele::MinimaDatabase>(1e-6);
+    auto record_steps = std::make_shared<RecordSteps>();
+    pool->add_action(database);
+    pool->add_action(record_steps);
+    mc.add_action(pool);
+    mc.run(niter);
+    EXPECT_EQ(pool->get_nr_pending(), (niter / record_every) % 8);
+    pool->flush();
+    EXPECT_EQ(pool->get_nr_quenched(), niter / record_every);
+    EXPECT_EQ(pool->get_nr_failed(), 0u);
+    steps = record_steps->steps;
+    return database;
+}
+
+} // namespace
+
+TEST(QuenchPool, ParallelMatchesSerial){
+    const size_t niter = 1000;
+    const size_t record_every = 5;
+    std::vector<size_t> steps_serial, steps_parallel;
+    auto serial = sample_minima(1, niter, record_every, steps_serial);
+    auto parallel = sample_minima(3, niter, record_every, steps_parallel);
+    // minima are passed on in the order of the steps
+    ASSERT_EQ(steps_parallel.size(), niter / record_every);
+    for (size_t i = 0; i < steps_parallel.size(); ++i) {
+        EXPECT_EQ(steps_parallel[i], (i + 1) * record_every);
+    }
+    EXPECT_GE(serial->size(), 2u);
+    EXPECT_LE(serial->size(), 8u);
+    ASSERT_EQ(parallel->size(), serial->size());
+    pele::Array<double> energies = parallel->get_energies();
+    pele::Array<double> counts = parallel->get_counts();
+    pele::Array<double> serial_counts = serial->get_counts();
+    double total = 0;
+    for (size_t i = 0; i < parallel->size(); ++i) {
+        if (i > 0) {
+            EXPECT_LT(energies[i - 1], energies[i]);
+        }
+        EXPECT_DOUBLE_EQ(counts[i], serial_counts[i]);
+        total += counts[i];
+    }
+    EXPECT_DOUBLE_EQ(total, niter / record_every);
+}
+
+TEST(MinimaDatabase, DegenerateMinima){
+    pele::Array<double> left(2, -1);
+    pele::Array<double> right(2, 1);
+    pele::Array<double> near_left(2, -1 + 1e-4);
+    // by energy alone mirror images are the same minimum
+    mcpele::MinimaDatabase by_energy(1e-6);
+    EXPECT_EQ(by_energy.add_minimum(left, -1, 10), 0u);
+    EXPECT_EQ(by_energy.add_minimum(right, -1 + 1e-8, 20), 0u);
+    EXPECT_EQ(by_energy.size(), 1u);
+    // with a distance tolerance they are told apart
+    mcpele::MinimaDatabase by_coords(1e-6, 1e-2);
+    by_coords.add_minimum(left, -1, 10);
+    by_coords.add_minimum(right, -1 + 1e-8, 20);
+    by_coords.add_minimum(near_left, -1 - 1e-8, 30);
+    ASSERT_EQ(by_coords.size(), 2u);
+    pele::Array<double> counts = by_coords.get_counts();
+    for (size_t i = 0; i < by_coords.size(); ++i) {
+        const pele::Array<double> coords = by_coords.get_minimum(i);
+        if (coords[0] < 0) {
+            EXPECT_DOUBLE_EQ(counts[i], 2);
+            EXPECT_EQ(by_coords.get_first_step(i), 10u);
+        }
+        else {
+            EXPECT_DOUBLE_EQ(counts[i], 1);
+            EXPECT_EQ(by_coords.get_first_step(i), 20u);
+        }
+    }
+    EXPECT_THROW(mcpele::MinimaDatabase(1e-6, -1), std::runtime_error);
+}
+
+namespace {
+
+/**
+ * Wang-Landau run on a 4 dimensional harmonic well, where g(E) is proportional to E
+ */
+std::shared_ptr<mcpele::RecordWangLandau> run_wang_landau(const double emin, const double emax, const size_t seed)
+{
+    const size_t ndof = 4;
+    Array<double> origin(ndof, 0);
+    Array<double> coords(ndof, 0.5);
+    auto potential = std::make_shared<pele::Harmonic>(origin, 1, ndof);
+    auto dos = std::make_shared<mcpele::RecordWangLandau>(emin, emax, 0.25, 0.8, 1000, 1, 1e-5);
+    MC mc(potential, coords, 1);
+    mc.disable_input_warnings();
+    mc.set_takestep(std::make_shared<mcpele::RandomCoordsDisplacementAll>(seed, 1));
+    mc.add_accept_test(std::make_shared<mcpele::WangLandauTest>(dos, seed + 1));
+    mc.add_action(dos);
+    mc.add_stop_criterion(std::make_shared<mcpele::StopWangLandau>(dos));
+    mc.set_stop_check_every(1000);
+    mc.run(1e8);
+    return dos;
+}
+
+void expect_linear_density(const mcpele::RecordWangLandau& dos, const double tol)
+{
+    const Array<double> energies = dos.get_energies();
+    const Array<double> lng = dos.get_log_density_of_states();
+    EXPECT_DOUBLE_EQ(0, *std::min_element(lng.begin(), lng.end()));
+    for (size_t i = 1; i < lng.size(); ++i) {
+        EXPECT_NEAR(std::log(energies[i] / energies[0]), lng[i] - lng[0], tol);
+    }
+}
+
+} // namespace
+
+TEST(WangLandau, HarmonicDensityOfStates){
+    auto dos = run_wang_landau(0.25, 4.25, 42);
+    EXPECT_TRUE(dos->is_converged());
+    EXPECT_TRUE(dos->is_one_over_t());
+    EXPECT_LT(0u, dos->get_nr_stages());
+    EXPECT_EQ(16u, dos->size());
+    expect_linear_density(*dos, 0.05);
+}
+
+TEST(WangLandau, ParallelWindowsMerge){
+    std::shared_ptr<mcpele::RecordWangLandau> low, high;
+    // the high window starts below its range and walks into it
+    std::thread low_walker([&low]{ low = run_wang_landau(0.25, 2.5, 1); });
+    std::thread high_walker([&high]{ high = run_wang_landau(2, 4.25, 2); });
+    low_walker.join();
+    high_walker.join();
+    EXPECT_TRUE(high->is_converged());
+    low->merge(*high);
+    EXPECT_DOUBLE_EQ(0.25, low->min());
+    EXPECT_DOUBLE_EQ(4.25, low->max());
+    EXPECT_EQ(16u, low->size());
+    expect_linear_density(*low, 0.05);
+    mcpele::RecordWangLandau shifted(0.3, 1, 0.25);
+    EXPECT_THROW(low->merge(shifted), std::runtime_error);
+}
+
+TEST(TabulatedBias, InterpolatesLinearly){
+    Array<double> log_weights(3);
+    log_weights[0] = 0;
+    log_weights[1] = 2;
+    log_weights[2] = -1;
+    mcpele::TabulatedBias bias(std::make_shared<mcpele::EnergyCollectiveVariable>(), -1, 1, 3, log_weights);
+    EXPECT_DOUBLE_EQ(0, bias.get_log_weight(-1));
+    EXPECT_DOUBLE_EQ(1, bias.get_log_weight(-0.5));
+    EXPECT_DOUBLE_EQ(0.5, bias.get_log_weight(0.5));
+    EXPECT_DOUBLE_EQ(-1, bias.get_log_weight(1));
+    EXPECT_EQ(1u, bias.get_node_index(0.4));
+    EXPECT_EQ(2u, bias.get_node_index(0.6));
+    EXPECT_FALSE(bias.in_range(1.1));
+    EXPECT_DOUBLE_EQ(0.5, bias.get_distance(-1.5));
+}
+
+TEST(TabulatedBias, RefinedBiasCrossesBarrier){
+    // (x^2 - 1)^2 + 0.1 x at T = 0.1: a barrier of 10 T, the right well 2 T higher
+    const double temperature = 0.1;
+    Array<double> x(1, -1.);
+    auto potential = std::make_shared<TiltedDoubleWell>();
+    auto cv = std::make_shared<mcpele::ProjectionCollectiveVariable>(Array<double>(1, 1.));
+    auto bias = std::make_shared<mcpele::TabulatedBias>(cv, -1.4, 1.4, 29);
+    auto refine = std::make_shared<mcpele::RefineTabulatedBias>(bias, 20000, 0, 0.5);
+    MC mc(potential, x, temperature);
+    mc.disable_input_warnings();
+    mc.set_takestep(std::make_shared<mcpele::RandomCoordsDisplacementAll>(42, 0.3));
+    mc.add_accept_test(std::make_shared<mcpele::MetropolisTest>(43));
+    mc.add_accept_test(std::make_shared<mcpele::TabulatedBiasTest>(bias, 44));
+    mc.add_action(refine);
+    for (size_t i = 0; i < 100 && refine->is_refining(); ++i) {
+        mc.run(20000);
+    }
+    EXPECT_FALSE(refine->is_refining());
+    EXPECT_LT(0u, refine->get_nr_refinements());
+    refine->clear_histogram();
+    mc.run(400000);
+    const Array<double> nodes = bias->get_nodes();
+    const Array<double> free_energy = refine->get_free_energy();
+    const Array<double> histogram = refine->get_histogram();
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        EXPECT_LT(0, histogram[i]);
+    }
+    // nodes 4 and 24 are the minima at x = -1 and x = 1, node 14 the barrier at x = 0
+    EXPECT_DOUBLE_EQ(-1, nodes[4]);
+    EXPECT_NEAR(2, free_energy[24] - free_energy[4], 0.3);
+    EXPECT_NEAR(11, free_energy[14] - free_energy[4], 0.5);
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        Array<double> xi(1, nodes[i]);
+        EXPECT_NEAR(potential->get_energy(xi) / temperature, free_energy[i] + potential->get_energy(Array<double>(1, -1.)) / temperature, 0.5);
+    }
+}
+
+namespace {
+
+struct CountingCollectiveVariable : public mcpele::ProjectionCollectiveVariable {
+    size_t count;
+    CountingCollectiveVariable() : mcpele::ProjectionCollectiveVariable(Array<double>(1, 1.)), count(0) {}
+    virtual double get_value(Array<double> &coords, const double energy)
+    {
+        ++count;
+        return mcpele::ProjectionCollectiveVariable::get_value(coords, energy);
+    }
+};
+
+/**
+ * calls a TabulatedBiasTest without the MC, which disables its cache
+ */
+struct UncachedBiasTest : public mcpele::AcceptTest {
+    std::shared_ptr<mcpele::TabulatedBiasTest> m_test;
+    UncachedBiasTest(std::shared_ptr<mcpele::TabulatedBiasTest> test) : m_test(test) {}
+    virtual bool test(Array<double> &trial_coords, double trial_energy, Array<double> &old_coords,
+            double old_energy, double temperature, MC * mc)
+    {
+        return m_test->test(trial_coords, trial_energy, old_coords, old_energy, temperature, NULL);
+    }
+};
+
+/**
+ * rejects every third call
+ */
+struct RejectSome : public mcpele::AcceptTest {
+    size_t count;
+    RejectSome() : count(0) {}
+    virtual bool test(Array<double> &, double, Array<double> &, double, double, MC *)
+    {
+        return ++count % 3 != 0;
+    }
+};
+
+} // namespace
+
+TEST(TabulatedBias, TestCachesOldValue){
+    const double temperature = 0.3;
+    Array<double> log_weights(29);
+    for (size_t i = 0; i < log_weights.size(); ++i) {
+        log_weights[i] = std::sin(0.7 * i);
+    }
+    std::vector<std::shared_ptr<MC> > mcs;
+    std::vector<std::shared_ptr<CountingCollectiveVariable> > cvs;
+    std::vector<std::shared_ptr<mcpele::TabulatedBiasTest> > tests;
+    for (size_t cached = 0; cached < 2; ++cached) {
+        auto cv = std::make_shared<CountingCollectiveVariable>();
+        auto bias = std::make_shared<mcpele::TabulatedBias>(cv, -1.4, 1.4, 29, log_weights);
+        auto test = std::make_shared<mcpele::TabulatedBiasTest>(bias, 44);
+        Array<double> x(1, -1.);
+        auto mc = std::make_shared<MC>(std::make_shared<TiltedDoubleWell>(), x, temperature);
+        mc->disable_input_warnings();
+        mc->set_takestep(std::make_shared<mcpele::RandomCoordsDisplacementAll>(42, 0.3));
+        // the bias test is skipped after a Metropolis rejection, and its acceptances are sometimes overruled
+        mc->add_accept_test(std::make_shared<mcpele::MetropolisTest>(43));
+        if (cached) {
+            mc->add_accept_test(test);
+        }
+        else {
+            mc->add_accept_test(std::make_shared<UncachedBiasTest>(test));
+        }
+        mc->add_accept_test(std::make_shared<RejectSome>());
+        mcs.push_back(mc);
+        cvs.push_back(cv);
+        tests.push_back(test);
+    }
+    for (size_t run = 0; run < 2; ++run) {
+        for (auto & mc : mcs) {
+            mc->run(5000);
+            // a new configuration between runs, with a different energy
+            Array<double> x(1, 0.9 - 0.2 * run);
+            mc->set_coordinates(x, mc->get_potential_ptr()->get_energy(x));
+        }
+    }
+    EXPECT_EQ(mcs[0]->get_naccept(), mcs[1]->get_naccept());
+    EXPECT_DOUBLE_EQ(mcs[0]->get_coords()[0], mcs[1]->get_coords()[0]);
+    EXPECT_EQ(0u, tests[0]->get_nr_cached());
+    EXPECT_LT(0u, tests[1]->get_nr_cached());
+    // the cached test computes the value of the trial configuration only, apart from after set_coordinates
+    EXPECT_EQ(cvs[1]->count, cvs[0]->count - tests[1]->get_nr_cached());
+    EXPECT_LT(cvs[1]->count, cvs[0]->count * 3 / 4);
+}
+
+TEST(NestedSampling, HarmonicThermodynamics){
+    // 3 dimensional harmonic well in a ball of radius 2, sampled uniformly:
+    // Z = (2 pi T)^(3/2) / V for T << 4, <E> = 3 T / 2 and Cv = 3 / 2
+    const size_t ndof = 3;
+    const size_t nr_live = 200;
+    const double radius = 2;
+    Array<double> origin(ndof, 0);
+    std::mt19937_64 generator(42);
+    std::uniform_real_distribution<double> uniform(-radius, radius);
+    Array<double> live_coords(nr_live * ndof);
+    for (size_t i = 0; i < nr_live; ++i) {
+        double r2;
+        do {
+            r2 = 0;
+            for (size_t k = 0; k < ndof; ++k) {
+                live_coords[i * ndof + k] = uniform(generator);
+                r2 += live_coords[i * ndof + k] * live_coords[i * ndof + k];
+            }
+        } while (r2 > radius * radius);
+    }
+    std::vector<std::shared_ptr<MC> > walkers;
+    for (size_t t = 0; t < 2; ++t) {
+        auto potential = std::make_shared<pele::Harmonic>(origin, 1, ndof);
+        auto walker = std::make_shared<MC>(potential, origin, 1);
+        walker->set_takestep(std::make_shared<mcpele::RandomCoordsDisplacementAll>(t + 1, 0.5));
+        walker->add_conf_test(std::make_shared<mcpele::CheckSphericalContainer>(radius, ndof));
+        walkers.push_back(walker);
+    }
+    mcpele::NestedSampling ns(walkers, live_coords, 50, 43);
+    EXPECT_EQ(nr_live, ns.get_nr_live());
+    ns.run(1500);
+    const Array<double> energies = ns.get_energies();
+    const Array<double> log_volumes = ns.get_log_volumes();
+    EXPECT_EQ(3000u, energies.size());
+    for (size_t i = 1; i < energies.size(); ++i) {
+        EXPECT_LE(energies[i], energies[i - 1]);
+    }
+    EXPECT_LT(ns.get_max_energy(), energies[energies.size() - 1]);
+    // two removals per iteration, with 200 and 199 live points
+    EXPECT_NEAR(-1500. * (1. / nr_live + 1. / (nr_live - 1)), log_volumes[log_volumes.size() - 1], 1e-9);
+    EXPECT_LT(0.1, ns.get_accepted_fraction());
+    const double volume = 4. / 3 * M_PI * radius * radius * radius;
+    for (double temperature : {0.02, 0.05, 0.1}) {
+        EXPECT_NEAR(1.5 * std::log(2 * M_PI * temperature) - std::log(volume),
+                ns.get_log_partition_function(temperature), 0.4);
+        EXPECT_NEAR(1.5 * temperature, ns.get_mean_energy(temperature), 0.15 * temperature);
+        EXPECT_NEAR(1.5, ns.get_heat_capacity(temperature), 0.3);
+    }
+}
+
+namespace {
+
+struct FailingConfTest : public mcpele::ConfTest {
+    bool fail;
+    FailingConfTest() : fail(false) {}
+    virtual bool conf_test(Array<double> &trial_coords, MC * mc)
+    {
+        if (fail) {
+            throw std::runtime_error("FailingConfTest");
+        }
+        return true;
+    }
+};
+
+std::vector<std::shared_ptr<MC> > nested_sampling_walkers(const size_t nr_walkers,
+        std::shared_ptr<FailingConfTest> failing=std::shared_ptr<FailingConfTest>())
+{
+    Array<double> origin(2, 0);
+    std::vector<std::shared_ptr<MC> > walkers;
+    for (size_t t = 0; t < nr_walkers; ++t) {
+        auto walker = std::make_shared<MC>(std::make_shared<pele::Harmonic>(origin, 1, 2), origin, 1);
+        walker->set_takestep(std::make_shared<mcpele::RandomCoordsDisplacementAll>(t + 1, 0.3));
+        walker->add_conf_test(std::make_shared<mcpele::CheckSphericalContainer>(1, 2));
+        if (failing && t == nr_walkers - 1) {
+            walker->add_conf_test(failing);
+        }
+        walkers.push_back(walker);
+    }
+    return walkers;
+}
+
+} // namespace
+
+TEST(NestedSampling, PersistentWorkers){
+    Array<double> live_coords(40);
+    for (size_t i = 0; i < live_coords.size(); ++i) {
+        live_coords[i] = 0.6 * std::sin(1.7 * i);
+    }
+    // the walkers have their own generators, so the result does not depend on how run() is split
+    mcpele::NestedSampling once(nested_sampling_walkers(3), live_coords, 20, 43);
+    mcpele::NestedSampling split(nested_sampling_walkers(3), live_coords, 20, 43);
+    once.run(30);
+    for (size_t i = 0; i < 30; ++i) {
+        split.run(1);
+    }
+    EXPECT_EQ(30u, split.get_nr_iterations());
+    const Array<double> energies_once = once.get_energies();
+    const Array<double> energies_split = split.get_energies();
+    ASSERT_EQ(90u, energies_split.size());
+    for (size_t i = 0; i < energies_once.size(); ++i) {
+        EXPECT_DOUBLE_EQ(energies_once[i], energies_split[i]);
+    }
+    // an error of a walk on a worker thread is rethrown by run()
+    auto failing = std::make_shared<FailingConfTest>();
+    mcpele::NestedSampling ns(nested_sampling_walkers(3, failing), live_coords, 20, 43);
+    ns.run(2);
+    failing->fail = true;
+    EXPECT_THROW(ns.run(1), std::runtime_error);
+    failing->fail = false;
+    ns.run(2);
+    EXPECT_EQ(4u, ns.get_nr_iterations());
+}
@@ -4,11 +4,15 @@
 #include <vector>
 #include <algorithm>
 #include <utility>
+#include <numeric>
+#include <random>
 #include <gtest/gtest.h>
 
 #include "pele/lbfgs.h"
 
+#include "mcpele/random_coords_displacement.h"
 #include "mcpele/record_pair_dist_histogram.h"
+#include "mcpele/record_structure_factor.h"
 
 using pele::Array;
 
@@ -103,3 +107,172 @@ TEST_F(TestPairDistHist, BasicFunctionality){
     }
 }
 
+
+namespace {
+
+std::vector<double> brute_force_gr(const Array<double> coords, const Array<double> boxvector,
+        const size_t nr_bins, const double max_dist)
+{
+    pele::periodic_distance<boxdim> dist(boxvector);
+    mcpele::PairDistHistogram<boxdim> ref(boxvector, nr_bins, 1, max_dist);
+    const size_t nr_particles = coords.size() / boxdim;
+    const double dr = max_dist / nr_bins;
+    std::vector<double> counts(nr_bins, 0);
+    for (size_t i = 0; i < nr_particles; ++i) {
+        for (size_t j = i + 1; j < nr_particles; ++j) {
+            double rij[boxdim];
+            dist.get_rij(rij, coords.data() + i * boxdim, coords.data() + j * boxdim);
+            const double r = sqrt(std::inner_product(rij, rij + boxdim, rij, double(0)));
+            if (r < max_dist) {
+                counts[std::min<size_t>(r / dr, nr_bins - 1)] += 1;
+            }
+        }
+    }
+    const double number_density = nr_particles / pow(boxvector[0], boxdim);
+    std::vector<double> result(nr_bins);
+    for (size_t i = 0; i < nr_bins; ++i) {
+        const double r = (i + 0.5) * dr;
+        const double shell = ref.volume_nball(r + 0.5 * dr, boxdim) - ref.volume_nball(r - 0.5 * dr, boxdim);
+        result[i] = 2 * counts[i] / (nr_particles * shell * number_density);
+    }
+    return result;
+}
+
+}
+
+TEST_F(TestPairDistHist, CellListThreads_MatchBruteForce){
+    const size_t nr_particles = 300;
+    const double L = 10;
+    std::fill(boxvector.data(), boxvector.data() + boxdim, L);
+    Array<double> coords(nr_particles * boxdim);
+    std::mt19937_64 gen(42);
+    std::uniform_real_distribution<double> uniform(-L, L);
+    for (size_t i = 0; i < coords.size(); ++i) {
+        coords[i] = uniform(gen);
+    }
+    const double number_density = nr_particles / pow(L, boxdim);
+    // max_dist = L / 3 allows for 3 cells per direction
+    const double max_dist = L / 3;
+    std::vector<double> expected = brute_force_gr(coords, boxvector, nr_bins, max_dist);
+    for (size_t nr_threads = 1; nr_threads <= 4; nr_threads += 3) {
+        mcpele::PairDistHistogram<boxdim> cells(boxvector, nr_bins, nr_threads, max_dist);
+        EXPECT_TRUE(cells.uses_cell_list());
+        cells.add_configuration(coords);
+        std::vector<double> gr = cells.get_vecdata_gr(number_density, nr_particles);
+        for (size_t i = 0; i < nr_bins; ++i) {
+            EXPECT_NEAR_RELATIVE(gr[i], expected[i], 1e-12);
+        }
+    }
+    // the default range of half the box is too large for a cell list
+    mcpele::PairDistHistogram<boxdim> all_pairs(boxvector, nr_bins, 3);
+    EXPECT_FALSE(all_pairs.uses_cell_list());
+    all_pairs.add_configuration(coords);
+    std::vector<double> gr = all_pairs.get_vecdata_gr(number_density, nr_particles);
+    expected = brute_force_gr(coords, boxvector, nr_bins, 0.5 * L);
+    for (size_t i = 0; i < nr_bins; ++i) {
+        EXPECT_NEAR_RELATIVE(gr[i], expected[i], 1e-12);
+    }
+}
+
+TEST_F(TestPairDistHist, Incremental_MatchesFullRecompute){
+    const size_t nr_particles = 30;
+    const double L = 10;
+    std::fill(boxvector.data(), boxvector.data() + boxdim, L);
+    Array<double> coords(nr_particles * boxdim);
+    std::mt19937_64 gen(42);
+    std::uniform_real_distribution<double> uniform(-0.5 * L, 0.5 * L);
+    for (size_t i = 0; i < coords.size(); ++i) {
+        coords[i] = uniform(gen);
+    }
+    std::shared_ptr<mcpele::MC> mc = std::make_shared<mcpele::MC>(potential, coords, 1);
+    mc->set_takestep(std::make_shared<mcpele::RandomCoordsDisplacementSingle>(42, nr_particles, boxdim, 1));
+    auto record_full = std::make_shared<mcpele::RecordPairDistHistogram<boxdim> >(boxvector, nr_bins, 10, 1);
+    auto record_incr = std::make_shared<mcpele::RecordPairDistHistogram<boxdim> >(boxvector, nr_bins, 10, 1, 1, 0, true);
+    EXPECT_FALSE(record_full->is_incremental());
+    EXPECT_TRUE(record_incr->is_incremental());
+    mc->add_action(record_full);
+    mc->add_action(record_incr);
+    mc->run(1000);
+    const double number_density = nr_particles / pow(L, boxdim);
+    pele::Array<double> gr_full = record_full->get_hist_gr(number_density, nr_particles);
+    pele::Array<double> gr_incr = record_incr->get_hist_gr(number_density, nr_particles);
+    for (size_t i = 0; i < nr_bins; ++i) {
+        EXPECT_NEAR_RELATIVE(gr_incr[i], gr_full[i], 1e-12);
+    }
+}
+
+TEST_F(TestPairDistHist, StructureFactor_MatchesDirectSum){
+    const size_t nr_particles = 100;
+    const double L = 8;
+    const double kmax = 5;
+    const size_t nr_k_bins = 10;
+    std::fill(boxvector.data(), boxvector.data() + boxdim, L);
+    Array<double> coords(nr_particles * boxdim);
+    std::mt19937_64 gen(42);
+    std::uniform_real_distribution<double> uniform(-L, L);
+    for (size_t i = 0; i < coords.size(); ++i) {
+        coords[i] = uniform(gen);
+    }
+    mcpele::StructureFactor<boxdim> sk(boxvector, kmax, nr_k_bins);
+    sk.add_configuration(coords);
+    // direct sum over all wavevectors, including -k
+    const long nmax = kmax * L / (2 * M_PI);
+    std::vector<double> expected(nr_k_bins, 0);
+    std::vector<double> count(nr_k_bins, 0);
+    for (long n0 = -nmax; n0 <= nmax; ++n0) {
+        for (long n1 = -nmax; n1 <= nmax; ++n1) {
+            for (long n2 = -nmax; n2 <= nmax; ++n2) {
+                const double k[3] = {2 * M_PI * n0 / L, 2 * M_PI * n1 / L, 2 * M_PI * n2 / L};
+                const double knorm = sqrt(k[0] * k[0] + k[1] * k[1] + k[2] * k[2]);
+                if (knorm == 0 || knorm >= kmax) {
+                    continue;
+                }
+                double re = 0;
+                double im = 0;
+                for (size_t j = 0; j < nr_particles; ++j) {
+                    const double kr = std::inner_product(k, k + 3, coords.data() + j * 3, double(0));
+                    re += cos(kr);
+                    im += sin(kr);
+                }
+                const size_t bin = knorm / (kmax / nr_k_bins);
+                expected[bin] += (re * re + im * im) / nr_particles;
+                count[bin] += 1;
+            }
+        }
+    }
+    std::vector<double> result = sk.get_vecdata_sk();
+    for (size_t i = 0; i < nr_k_bins; ++i) {
+        if (count[i] > 0) {
+            expected[i] /= count[i];
+        }
+        EXPECT_NEAR_RELATIVE(result[i], expected[i], 1e-10);
+    }
+    EXPECT_EQ(2 * sk.get_nr_wavevectors(), std::accumulate(count.begin(), count.end(), double(0)));
+}
+
+TEST_F(TestPairDistHist, StructureFactorIncremental_MatchesFullRecompute){
+    const size_t nr_particles = 30;
+    const double L = 10;
+    std::fill(boxvector.data(), boxvector.data() + boxdim, L);
+    Array<double> coords(nr_particles * boxdim);
+    std::mt19937_64 gen(42);
+    std::uniform_real_distribution<double> uniform(-0.5 * L, 0.5 * L);
+    for (size_t i = 0; i < coords.size(); ++i) {
+        coords[i] = uniform(gen);
+    }
+    std::shared_ptr<mcpele::MC> mc = std::make_shared<mcpele::MC>(potential, coords, 1);
+    mc->set_takestep(std::make_shared<mcpele::RandomCoordsDisplacementSingle>(42, nr_particles, boxdim, 1));
+    auto record_full = std::make_shared<mcpele::RecordStructureFactor<boxdim> >(boxvector, 4, 20, 10, 1);
+    auto record_incr = std::make_shared<mcpele::RecordStructureFactor<boxdim> >(boxvector, 4, 20, 10, 1, true);
+    EXPECT_TRUE(record_incr->is_incremental());
+    mc->add_action(record_full);
+    mc->add_action(record_incr);
+    mc->run(1000);
+    pele::Array<double> sk_full = record_full->get_hist_sk();
+    pele::Array<double> sk_incr = record_incr->get_hist_sk();
+    pele::Array<double> k = record_full->get_hist_k();
+    EXPECT_DOUBLE_EQ(k[0], 0.5 * 4. / 20);
+    for (size_t i = 0; i < sk_full.size(); ++i) {
+        EXPECT_NEAR_RELATIVE(sk_incr[i], sk_full[i], 1e-10);
+    }
+}
@@ -11,7 +11,9 @@
 #include "mcpele/adaptive_takestep.h"
 #include "mcpele/histogram.h"
 #include "mcpele/metropolis_test.h"
+#include "mcpele/nullpotential.h"
 #include "mcpele/particle_pair_swap.h"
+#include "mcpele/quasi_random_sampling.h"
 #include "mcpele/random_coords_displacement.h"
 #include "mcpele/take_step_pattern.h"
 #include "mcpele/take_step_probabilities.h"
@@ -202,6 +204,138 @@ TEST_F(TakeStepTest, Single_BasicFunctionalityAveragingErasing_NIterations){
     }
 }
 
+TEST(HaltonSequence, Unscrambled_VanDerCorput){
+    mcpele::HaltonSequence seq(2, 42, false);
+    const double expected_base2[] = {0, 0.5, 0.25, 0.75, 0.125};
+    const double expected_base3[] = {0, 1. / 3, 2. / 3, 1. / 9, 4. / 9};
+    double x[2];
+    for (size_t i = 0; i < 5; ++i) {
+        seq.next(x);
+        EXPECT_DOUBLE_EQ(expected_base2[i], x[0]);
+        EXPECT_DOUBLE_EQ(expected_base3[i], x[1]);
+    }
+}
+
+TEST(HaltonSequence, SkipAhead_MatchesSequential){
+    const size_t ndim = 7;
+    mcpele::HaltonSequence seq(ndim, 42);
+    mcpele::HaltonSequence seq_skip(ndim, 42);
+    seq_skip.skip_ahead(100);
+    std::vector<double> x(ndim), y(ndim);
+    for (size_t i = 0; i < 100; ++i) {
+        seq.next(x.data());
+    }
+    for (size_t i = 0; i < 10; ++i) {
+        seq.next(x.data());
+        seq_skip.next(y.data());
+        for (size_t k = 0; k < ndim; ++k) {
+            EXPECT_EQ(x[k], y[k]);
+            EXPECT_LE(0, y[k]);
+            EXPECT_LT(y[k], 1);
+        }
+    }
+}
+
+TEST_F(TakeStepTest, QuasiRandomRectangular_ComputesPi){
+    // fraction of points of the square [-1, 1]^2 within the unit circle
+    const size_t nsamples = 1e4;
+    mcpele::QuasiRandomRectangularSampling sampler(42, {2, 2}, 2);
+    pele::Array<double> x(2);
+    size_t inside = 0;
+    for (size_t i = 0; i < nsamples; ++i) {
+        sampler.displace(x, NULL);
+        EXPECT_LE(std::fabs(x[0]), 1);
+        EXPECT_LE(std::fabs(x[1]), 1);
+        inside += (x[0] * x[0] + x[1] * x[1] <= 1);
+    }
+    // pseudo-random sampling would give an error of about 1.6e-2
+    EXPECT_NEAR(M_PI, 4 * static_cast<double>(inside) / nsamples, 2e-3);
+    EXPECT_EQ(nsamples, sampler.get_count());
+}
+
+TEST_F(TakeStepTest, QuasiRandomSpherical_CorrectMoments){
+    // mean squared distance from the origin is R^2 * n / (n + 2) in an n-ball
+    const size_t nsamples = 1e4;
+    const double radius = 2;
+    for (size_t n = 1; n < 6; ++n) {
+        mcpele::QuasiRandomSphericalSampling sampler(42, radius, n);
+        pele::Array<double> x(n);
+        double r2_mean = 0;
+        for (size_t i = 0; i < nsamples; ++i) {
+            sampler.displace(x, NULL);
+            const double r2 = pele::dot(x, x);
+            EXPECT_LE(r2, radius * radius * (1 + 1e-12));
+            r2_mean += r2 / nsamples;
+        }
+        EXPECT_NEAR(radius * radius * n / (n + 2), r2_mean, 1e-3);
+    }
+}
+
+TEST_F(TakeStepTest, PeriodicAll_StaysInBox){
+    Array<double> boxvec(ndim, 5);
+    mcpele::RandomCoordsDisplacementPeriodicAll displ(seed, boxvec, stepsize);
+    for (size_t i = 0; i < niterations; ++i) {
+        displ.displace(coor, mc);
+        for (size_t k = 0; k < ndof; ++k) {
+            EXPECT_LE(std::fabs(coor[k]), 0.5 * boxvec[k % ndim]);
+        }
+    }
+}
+
+TEST_F(TakeStepTest, PeriodicSingle_OnlyMovedParticleWrapped){
+    Array<double> boxvec(ndim, 5);
+    mcpele::RandomCoordsDisplacementPeriodicSingle displ(seed, nparticles, boxvec, stepsize);
+    displ.displace(coor, mc);
+    const size_t part = displ.get_rand_particle();
+    for (size_t i = 0; i < nparticles; ++i) {
+        for (size_t j = 0; j < ndim; ++j) {
+            if (i == part) {
+                EXPECT_LE(std::fabs(coor[i * ndim + j]), 0.5 * boxvec[j]);
+            }
+            else {
+                EXPECT_EQ(reference[i * ndim + j], coor[i * ndim + j]);
+            }
+        }
+    }
+}
+
+struct RejectEveryOther : public mcpele::AcceptTest {
+    size_t m_count;
+    RejectEveryOther() : m_count(0) {}
+    virtual bool test(Array<double>&, double, Array<double>&, double, double, MC*)
+    {
+        return (m_count++ % 2) == 0;
+    }
+};
+
+TEST_F(TakeStepTest, PeriodicImages_UnwrappedMatchesFreeRun){
+    Array<double> boxvec(ndim, 2);
+    auto potential = std::make_shared<mcpele::NullPotential>();
+    MC mc_free(potential, coor, 1);
+    MC mc_periodic(potential, coor, 1);
+    mc_free.disable_input_warnings();
+    mc_periodic.disable_input_warnings();
+    auto step_free = std::make_shared<mcpele::RandomCoordsDisplacementSingle>(seed, nparticles, ndim, 1);
+    auto step_periodic = std::make_shared<mcpele::RandomCoordsDisplacementPeriodicSingle>(seed, nparticles, boxvec, 1);
+    mc_free.set_takestep(step_free);
+    mc_periodic.set_takestep(step_periodic);
+    mc_free.add_accept_test(std::make_shared<RejectEveryOther>());
+    mc_periodic.add_accept_test(std::make_shared<RejectEveryOther>());
+    mc_free.run(niterations);
+    mc_periodic.run(niterations);
+    const Array<double> x_free = mc_free.get_coords();
+    const Array<double> x_periodic = mc_periodic.get_coords();
+    const Array<double> x_unwrapped = step_periodic->get_image_tracker()->get_unwrapped_coords(x_periodic);
+    const Array<long> images = step_periodic->get_image_tracker()->get_image_counts(x_periodic);
+    long nshifts = 0;
+    for (size_t i = 0; i < ndof; ++i) {
+        EXPECT_LE(std::fabs(x_periodic[i]), 0.5 * boxvec[i % ndim]);
+        EXPECT_NEAR(x_free[i], x_unwrapped[i], 1e-9);
+        nshifts += std::abs(images[i]);
+    }
+    EXPECT_LT(0, nshifts);
+}
+
 TEST_F(TakeStepTest, PairSwapWorks){
     const size_t box_dimension = 3;
     const size_t nr_particles = ndof / box_dimension;
@@ -3,6 +3,11 @@
 #include <cmath>
 #include <vector>
 #include <memory>
+#include <random>
+#include <cstdio>
+#include <deque>
+#include <fstream>
+#include <sstream>
 #include <gtest/gtest.h>
 
 #include "pele/array.h"
@@ -12,7 +17,15 @@
 
 #include "mcpele/moving_average.h"
 #include "mcpele/record_energy_timeseries.h"
+#include "mcpele/record_coords_timeseries.h"
+#include "mcpele/chunked_arena.h"
+#include "mcpele/record_compressed_trajectory.h"
+#include "mcpele/random_coords_displacement.h"
+#include "mcpele/record_energy_autocorrelation.h"
+#include "mcpele/record_energy_blocking.h"
 #include "mcpele/record_displacement_per_particle_timeseries.h"
+#include "mcpele/record_displacement_correlation.h"
+#include "mcpele/nullpotential.h"
 #include "mcpele/record_lowest_evalue_timeseries.h"
 
 #define EXPECT_NEAR_RELATIVE(A, B, T)  EXPECT_NEAR(fabs(A)/(fabs(A)+fabs(B)+1), fabs(B)/(fabs(A)+fabs(B)+1), T)
@@ -167,3 +180,412 @@ TEST(RecordEnergyTimeseries, Throws)
     }
     EXPECT_TRUE(threw);
 }
+
+TEST(MultiTauCorrelator, AR1_IntegratedTimeCorrect){
+    // x_t = phi x_{t-1} + noise: rho(t) = phi^t, tau_int = (1 + phi) / (2 (1 - phi))
+    const double phi = 0.9;
+    const size_t nsamples = 1e6;
+    std::mt19937_64 gen(42);
+    std::normal_distribution<double> noise(0, 1);
+    mcpele::MultiTauCorrelator corr(16);
+    double x = 0;
+    for (size_t i = 0; i < nsamples; ++i) {
+        x = phi * x + noise(gen);
+        corr(x + 1e3);
+    }
+    EXPECT_EQ(nsamples, corr.get_count());
+    EXPECT_LE(corr.get_nr_levels(), 21u);
+    EXPECT_NEAR(1e3, corr.get_mean(), 0.1);
+    EXPECT_NEAR(1 / (1 - phi * phi), corr.get_variance(), 0.2);
+    std::vector<double> lags = corr.get_lags();
+    std::vector<double> rho = corr.get_autocorrelation();
+    EXPECT_DOUBLE_EQ(1, lags[1]);
+    EXPECT_NEAR(1, rho[0], 1e-12);
+    EXPECT_NEAR(phi, rho[1], 0.01);
+    EXPECT_NEAR_RELATIVE((1 + phi) / (2 * (1 - phi)), corr.get_integrated_time(), 0.03);
+}
+
+TEST(EnergyAutocorrelation, ConstantEnergy_Uncorrelated){
+    const size_t niter = 10000;
+    const size_t record_every = 10;
+    const size_t eqsteps = 1000;
+    pele::Array<double> coords(6, 2);
+    pele::Array<double> origin(6, 0);
+    std::shared_ptr<pele::Harmonic> potential = std::make_shared<pele::Harmonic>(origin, 1, 3);
+    std::shared_ptr<mcpele::MC> mc = std::make_shared<mcpele::MC>(potential, coords, 1);
+    std::shared_ptr<mcpele::RecordEnergyAutocorrelation> ac = std::make_shared<mcpele::RecordEnergyAutocorrelation>(record_every, eqsteps);
+    mc->add_action(ac);
+    mc->set_takestep(std::make_shared<TrivialTakestep>());
+    mc->run(niter);
+    EXPECT_EQ((niter - eqsteps) / record_every, ac->get_count());
+    EXPECT_DOUBLE_EQ(potential->get_energy(coords), ac->get_mean());
+    EXPECT_DOUBLE_EQ(0, ac->get_variance());
+    EXPECT_DOUBLE_EQ(0.5 * record_every, ac->get_integrated_time());
+    EXPECT_EQ(record_every, ac->get_lags()[1]);
+}
+
+struct DriftTakestep : public mcpele::TakeStep{
+    const double velocity;
+    DriftTakestep(const double velocity_)
+        : velocity(velocity_)
+    {}
+    virtual void displace(pele::Array<double> &coords, mcpele::MC * mc=NULL)
+    {
+        for (size_t i = 0; i < coords.size(); ++i) {
+            coords[i] += velocity;
+        }
+    }
+};
+
+TEST(DisplacementCorrelation, Drift_Ballistic){
+    // every dof moves by v per step: msd(t) = ndim (v t)^2, fs(t) = cos(q v t)
+    const size_t boxdim = 3;
+    const size_t niter = 1000;
+    const double velocity = 0.01;
+    const double q = 2;
+    pele::Array<double> coords(4 * boxdim, 0.5);
+    auto mc = std::make_shared<mcpele::MC>(std::make_shared<mcpele::NullPotential>(), coords, 1);
+    auto corr = std::make_shared<mcpele::RecordDisplacementCorrelation>(1, 0, boxdim, q);
+    mc->add_action(corr);
+    mc->set_takestep(std::make_shared<DriftTakestep>(velocity));
+    mc->run(niter);
+    EXPECT_EQ(niter, corr->get_count());
+    const pele::Array<double> lags = corr->get_lags();
+    const pele::Array<double> msd = corr->get_mean_square_displacement();
+    const pele::Array<double> fs = corr->get_self_intermediate_scattering();
+    const pele::Array<double> nr_origins = corr->get_nr_origins();
+    ASSERT_EQ(lags.size(), msd.size());
+    ASSERT_EQ(lags.size(), fs.size());
+    EXPECT_DOUBLE_EQ(1, lags[0]);
+    EXPECT_DOUBLE_EQ(niter - 1, nr_origins[0]);
+    EXPECT_LT(lags[lags.size() - 1], niter);
+    EXPECT_GT(lags[lags.size() - 1], niter / 4);
+    // logarithmic lags: few levels for many steps
+    EXPECT_LE(corr->get_nr_levels(), 10u);
+    for (size_t i = 0; i < lags.size(); ++i) {
+        if (i > 0) {
+            EXPECT_LT(lags[i - 1], lags[i]);
+        }
+        const double displacement = velocity * lags[i];
+        EXPECT_NEAR_RELATIVE(boxdim * displacement * displacement, msd[i], 1e-9);
+        EXPECT_NEAR(std::cos(q * displacement), fs[i], 1e-9);
+    }
+}
+
+TEST(DisplacementCorrelation, Periodic_MatchesFreeRun){
+    const size_t boxdim = 3;
+    const size_t nparticles = 5;
+    const size_t niter = 2000;
+    const size_t seed = 44;
+    pele::Array<double> boxvec(boxdim, 1);
+    pele::Array<double> coords(nparticles * boxdim, 0);
+    auto potential = std::make_shared<mcpele::NullPotential>();
+    mcpele::MC mc_free(potential, coords, 1);
+    mcpele::MC mc_periodic(potential, coords, 1);
+    mc_free.disable_input_warnings();
+    mc_periodic.disable_input_warnings();
+    auto step_periodic = std::make_shared<mcpele::RandomCoordsDisplacementPeriodicSingle>(seed, nparticles, boxvec, 0.5);
+    mc_free.set_takestep(std::make_shared<mcpele::RandomCoordsDisplacementSingle>(seed, nparticles, boxdim, 0.5));
+    mc_periodic.set_takestep(step_periodic);
+    auto corr_free = std::make_shared<mcpele::RecordDisplacementCorrelation>(10, 100, boxdim, 3);
+    auto corr_periodic = std::make_shared<mcpele::RecordDisplacementCorrelation>(10, 100, step_periodic->get_image_tracker(), 3);
+    mc_free.add_action(corr_free);
+    mc_periodic.add_action(corr_periodic);
+    mc_free.run(niter);
+    mc_periodic.run(niter);
+    const pele::Array<double> msd_free = corr_free->get_mean_square_displacement();
+    const pele::Array<double> msd_periodic = corr_periodic->get_mean_square_displacement();
+    const pele::Array<double> fs_free = corr_free->get_self_intermediate_scattering();
+    const pele::Array<double> fs_periodic = corr_periodic->get_self_intermediate_scattering();
+    EXPECT_EQ((niter - 100) / 10, corr_periodic->get_count());
+    EXPECT_DOUBLE_EQ(10, corr_periodic->get_lags()[0]);
+    ASSERT_EQ(msd_free.size(), msd_periodic.size());
+    for (size_t i = 0; i < msd_free.size(); ++i) {
+        EXPECT_NEAR_RELATIVE(msd_free[i], msd_periodic[i], 1e-9);
+        EXPECT_NEAR(fs_free[i], fs_periodic[i], 1e-9);
+    }
+    // diffusive: the particles move well beyond the box
+    EXPECT_GT(msd_periodic[msd_periodic.size() - 1], 4 * boxdim);
+}
+
+TEST(BlockingAnalysis, AR1_StandardErrorCorrect){
+    // standard error of the mean of AR(1): sqrt(var (1 + phi) / ((1 - phi) N))
+    const double phi = 0.9;
+    const size_t nsamples = 1 << 20;
+    std::mt19937_64 gen(42);
+    std::normal_distribution<double> noise(0, 1);
+    mcpele::BlockingAnalysis blocking;
+    double x = 0;
+    for (size_t i = 0; i < nsamples; ++i) {
+        x = phi * x + noise(gen);
+        blocking(x);
+    }
+    const double variance = 1 / (1 - phi * phi);
+    const double expected = sqrt(variance * (1 + phi) / ((1 - phi) * nsamples));
+    std::vector<double> block_sizes = blocking.get_block_sizes();
+    std::vector<double> se = blocking.get_standard_errors();
+    EXPECT_EQ(17u, se.size()); // 2^16 blocks of 16 at the last level
+    EXPECT_DOUBLE_EQ(1, block_sizes[0]);
+    EXPECT_DOUBLE_EQ(65536, block_sizes.back());
+    EXPECT_NEAR_RELATIVE(sqrt(variance / nsamples), se[0], 0.01);
+    EXPECT_TRUE(blocking.has_plateau());
+    EXPECT_NEAR_RELATIVE(expected, blocking.get_standard_error(), 0.1);
+    EXPECT_NEAR_RELATIVE((1 + phi) / (1 - phi), blocking.get_statistical_inefficiency(), 0.2);
+}
+
+TEST(EnergyBlocking, Works){
+    const size_t niter = 10000;
+    pele::Array<double> coords(6, 2);
+    pele::Array<double> origin(6, 0);
+    std::shared_ptr<pele::Harmonic> potential = std::make_shared<pele::Harmonic>(origin, 1, 3);
+    std::shared_ptr<mcpele::MC> mc = std::make_shared<mcpele::MC>(potential, coords, 1);
+    std::shared_ptr<mcpele::RecordEnergyBlocking> blocking = std::make_shared<mcpele::RecordEnergyBlocking>(10, 1000);
+    mc->add_action(blocking);
+    mc->set_takestep(std::make_shared<TrivialTakestep>());
+    mc->run(niter);
+    EXPECT_EQ(900u, blocking->get_count());
+    EXPECT_DOUBLE_EQ(potential->get_energy(coords), blocking->get_mean());
+    EXPECT_DOUBLE_EQ(0, blocking->get_standard_error());
+    EXPECT_EQ(6u, blocking->get_block_sizes().size());
+}
+
+TEST(ChunkedArena, RowsSurviveChunkingAndCompaction){
+    const size_t row_size = 3000;
+    const size_t nrows = 100;
+    mcpele::ChunkedArena arena;
+    pele::Array<double> row(row_size);
+    for (size_t i = 0; i < nrows; ++i) {
+        for (size_t j = 0; j < row_size; ++j) {
+            row[j] = i * row_size + j;
+        }
+        arena.push_back(row);
+    }
+    EXPECT_EQ(arena.size(), nrows);
+    EXPECT_EQ(arena.row_size(), row_size);
+    EXPECT_GT(arena.get_nr_chunks(), 1u);
+    EXPECT_LT(arena.get_nr_chunks(), 10u);
+    pele::Array<double> row7 = arena.get_row(7);
+    arena.compact();
+    EXPECT_EQ(arena.get_nr_chunks(), 1u);
+    pele::Array<double> block = arena.get_chunk(0);
+    ASSERT_EQ(block.size(), nrows * row_size);
+    for (size_t i = 0; i < block.size(); ++i) {
+        EXPECT_DOUBLE_EQ(block[i], i);
+    }
+    arena.clear();
+    // views keep their chunk alive
+    for (size_t j = 0; j < row_size; ++j) {
+        EXPECT_DOUBLE_EQ(row7[j], 7 * row_size + j);
+    }
+    EXPECT_THROW(arena.get_row(0), std::runtime_error);
+}
+
+TEST(CoordsTimeseries, RecordsIntoArena){
+    const size_t boxdim = 3;
+    const size_t nparticles = 10;
+    const size_t ndof = nparticles * boxdim;
+    const size_t niter = 1000;
+    const size_t record_every = 10;
+    pele::Array<double> coords(ndof, 1);
+    pele::Array<double> origin(ndof, 0);
+    auto potential = std::make_shared<pele::Harmonic>(origin, 1, boxdim);
+    auto mc = std::make_shared<mcpele::MC>(potential, coords, 1);
+    auto ts = std::make_shared<mcpele::RecordCoordsTimeseries>(ndof, record_every, 0);
+    mc->add_action(ts);
+    mc->set_takestep(std::make_shared<TrivialTakestep>());
+    mc->run(niter);
+    std::deque<pele::Array<double> > series = ts->get_time_series();
+    EXPECT_EQ(series.size(), niter / record_every);
+    EXPECT_EQ(ts->get_arena().size(), series.size());
+    ts->get_arena().compact();
+    pele::Array<double> block = ts->get_arena().get_chunk(0);
+    ASSERT_EQ(block.size(), series.size() * ndof);
+    for (size_t i = 0; i < block.size(); ++i) {
+        EXPECT_DOUBLE_EQ(block[i], 1);
+    }
+}
+
+TEST(CompressedTrajectory, RoundTripWithinPrecision){
+    const size_t boxdim = 3;
+    const size_t nparticles = 50;
+    const size_t ndof = nparticles * boxdim;
+    const size_t niter = 2000;
+    const size_t record_every = 10;
+    const double precision = 1e-3;
+    const std::string filename = "test_compressed_trajectory.mctraj";
+    pele::Array<double> coords(ndof, 0);
+    pele::Array<double> origin(ndof, 0);
+    auto potential = std::make_shared<pele::Harmonic>(origin, 1, boxdim);
+    auto mc = std::make_shared<mcpele::MC>(potential, coords, 1);
+    auto reference = std::make_shared<mcpele::RecordCoordsTimeseries>(ndof, record_every, 0);
+    auto traj = std::make_shared<mcpele::RecordCompressedTrajectory>(filename, ndof, record_every, 0, precision, 7);
+    mc->add_action(reference);
+    mc->add_action(traj);
+    mc->set_takestep(std::make_shared<mcpele::RandomCoordsDisplacementAll>(42, 0.1));
+    mc->run(niter);
+    traj->flush();
+    const size_t nframes = niter / record_every;
+    EXPECT_EQ(traj->get_nr_frames(), nframes);
+    // well below the 8 bytes per coordinate of raw doubles
+    EXPECT_LT(traj->get_bytes_written(), nframes * ndof * 8 / 3);
+    std::deque<pele::Array<double> > series = reference->get_time_series();
+    mcpele::CompressedTrajectoryReader reader(filename);
+    EXPECT_EQ(reader.get_ndof(), ndof);
+    EXPECT_DOUBLE_EQ(reader.get_precision(), precision);
+    pele::Array<double> frame(ndof);
+    size_t step;
+    double energy;
+    size_t iframe = 0;
+    while (reader.read_frame(frame, step, energy)) {
+        ASSERT_LT(iframe, nframes);
+        EXPECT_EQ(step, (iframe + 1) * record_every);
+        for (size_t i = 0; i < ndof; ++i) {
+            EXPECT_NEAR(frame[i], series[iframe][i], 0.5 * precision * (1 + 1e-9));
+        }
+        ++iframe;
+    }
+    EXPECT_EQ(iframe, nframes);
+    std::remove(filename.c_str());
+}
+
+TEST(CompressedTrajectory, RejectedFrameKeepsDeltaReference){
+    const size_t ndof = 3;
+    const double precision = 1e-3;
+    const std::string filename = "test_compressed_trajectory_rejected.mctraj";
+    pele::Array<double> first(ndof, 1.);
+    pele::Array<double> bad(ndof, 2.);
+    bad[ndof - 1] = 1e300;
+    pele::Array<double> second(ndof, 3.);
+    {
+        mcpele::CompressedTrajectoryWriter writer(filename, ndof, precision, 100);
+        writer.write_frame(first, 1, 0);
+        EXPECT_THROW(writer.write_frame(bad, 2, 0), std::runtime_error);
+        writer.write_frame(second, 3, 0);
+    }
+    mcpele::CompressedTrajectoryReader reader(filename);
+    pele::Array<double> frame(ndof);
+    size_t step;
+    double energy;
+    ASSERT_TRUE(reader.read_frame(frame, step, energy));
+    EXPECT_EQ(step, 1u);
+    ASSERT_TRUE(reader.read_frame(frame, step, energy));
+    EXPECT_EQ(step, 3u);
+    for (size_t i = 0; i < ndof; ++i) {
+        EXPECT_NEAR(frame[i], second[i], 0.5 * precision);
+    }
+    EXPECT_FALSE(reader.read_frame(frame, step, energy));
+    std::remove(filename.c_str());
+}
+
+namespace {
+
+std::string read_file(const std::string& filename)
+{
+    std::ifstream file(filename.c_str(), std::ios::binary);
+    std::stringstream ss;
+    ss << file.rdbuf();
+    return ss.str();
+}
+
+} // namespace
+
+TEST(MappedTimeseries, ScalarAndVectorNpyFiles){
+    const size_t boxdim = 3;
+    const size_t nparticles = 4;
+    const size_t ndof = nparticles * boxdim;
+    const size_t niter = 1000;
+    const size_t record_every = 10;
+    const std::string energy_file = "test_mapped_energy.npy";
+    const std::string coords_file = "test_mapped_coords.npy";
+    pele::Array<double> coords(ndof, 0);
+    pele::Array<double> origin(ndof, 0);
+    auto potential = std::make_shared<pele::Harmonic>(origin, 1, boxdim);
+    auto mc = std::make_shared<mcpele::MC>(potential, coords, 1);
+    auto energies = std::make_shared<mcpele::RecordEnergyTimeseries>(niter, record_every);
+    auto trajectory = std::make_shared<mcpele::RecordCoordsTimeseries>(ndof, record_every, 0);
+    mc->add_action(energies);
+    mc->add_action(trajectory);
+    mc->set_takestep(std::make_shared<mcpele::RandomCoordsDisplacementAll>(42, 0.1));
+    mc->run(niter / 2);
+    // values recorded before mapping are moved to the file
+    energies->map_to_file(energy_file, 7);
+    trajectory->map_to_file(coords_file, 7);
+    EXPECT_THROW(energies->map_to_file(energy_file), std::runtime_error);
+    // the coordinates file is created at the next record
+    EXPECT_TRUE(trajectory->is_mapped());
+    EXPECT_FALSE(trajectory->is_file_created());
+    mc->run(niter / 2);
+    EXPECT_TRUE(trajectory->is_file_created());
+    energies->flush_file();
+    trajectory->flush_file();
+    const size_t nrecords = niter / record_every;
+    pele::Array<double> energy_series = energies->get_time_series();
+    std::deque<pele::Array<double> > coords_series = trajectory->get_time_series();
+    ASSERT_EQ(energy_series.size(), nrecords);
+    ASSERT_EQ(coords_series.size(), nrecords);
+    // live files: npy header with the current shape, then the raw data
+    const size_t header_size = mcpele::MappedTimeseries::header_size;
+    std::string content = read_file(energy_file);
+    ASSERT_GE(content.size(), header_size + nrecords * sizeof(double));
+    EXPECT_EQ(content.substr(0, 6), "\x93NUMPY");
+    EXPECT_NE(content.find("'shape': (100,)"), std::string::npos);
+    const double* values = reinterpret_cast<const double*>(content.data() + header_size);
+    for (size_t i = 0; i < nrecords; ++i) {
+        EXPECT_DOUBLE_EQ(values[i], energy_series[i]);
+    }
+    content = read_file(coords_file);
+    EXPECT_NE(content.find("'shape': (100, 12)"), std::string::npos);
+    values = reinterpret_cast<const double*>(content.data() + header_size);
+    for (size_t i = 0; i < nrecords; ++i) {
+        for (size_t j = 0; j < ndof; ++j) {
+            EXPECT_DOUBLE_EQ(values[i * ndof + j], coords_series[i][j]);
+        }
+    }
+    // closed files have their exact size
+    energies.reset();
+    mc.reset();
+    EXPECT_EQ(read_file(energy_file).size(), header_size + nrecords * sizeof(double));
+    std::remove(energy_file.c_str());
+    std::remove(coords_file.c_str());
+}
+
+struct RecordIterationTimeseries : public mcpele::RecordScalarTimeseries {
+    RecordIterationTimeseries(const size_t niter, const size_t record_every, const size_t capacity)
+        : mcpele::RecordScalarTimeseries(niter, record_every, capacity)
+    {}
+    virtual double get_recorded_scalar(pele::Array<double> &coords, const double energy, const bool accepted, mcpele::MC* mc)
+    {
+        return mc->get_iterations_count();
+    }
+};
+
+TEST(ScalarTimeseries, RingBufferKeepsLastValues){
+    const size_t ndof = 3;
+    const size_t capacity = 7;
+    pele::Array<double> coords(ndof, 1);
+    pele::Array<double> origin(ndof, 0);
+    auto potential = std::make_shared<pele::Harmonic>(origin, 1, 3);
+    auto mc = std::make_shared<mcpele::MC>(potential, coords, 1);
+    auto ts = std::make_shared<RecordIterationTimeseries>(0, 1, capacity);
+    mc->add_action(ts);
+    mc->set_takestep(std::make_shared<TrivialTakestep>());
+    mc->run(5);
+    pele::Array<double> series = ts->get_time_series_view();
+    ASSERT_EQ(series.size(), 5u);
+    for (size_t i = 0; i < series.size(); ++i) {
+        EXPECT_DOUBLE_EQ(series[i], i + 1);
+    }
+    for (size_t n = 0; n < 3 * capacity; ++n) {
+        mc->run(1);
+        series = ts->get_time_series_view();
+        ASSERT_EQ(series.size(), std::min<size_t>(6 + n, capacity));
+        // contiguous, from old to new
+        for (size_t i = 0; i < series.size(); ++i) {
+            EXPECT_DOUBLE_EQ(series[i], mc->get_iterations_count() - series.size() + 1 + i);
+        }
+    }
+    EXPECT_EQ(ts->get_time_series().size(), capacity);
+    EXPECT_THROW(ts->map_to_file("unused.npy"), std::runtime_error);
+    ts->clear();
+    EXPECT_EQ(ts->size(), 0u);
+}
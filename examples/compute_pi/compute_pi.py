@@ -8,36 +8,33 @@ from __future__ import division
 import numpy as np
 import copy
 from scipy.special import gamma
-from mcpele.monte_carlo import _BaseMCRunner
-from mcpele.monte_carlo import NullPotential
-from mcpele.monte_carlo import UniformRectangularSampling
-from mcpele.monte_carlo import CheckSphericalContainerConfig
+from mcpele.monte_carlo import BatchedMC
+from mcpele.monte_carlo import BatchedNullPotential
+from mcpele.monte_carlo import BatchedUniformRectangularSampling
+from mcpele.monte_carlo import BatchedCheckSphericalContainerConfig
 
 def volume_nball(radius, n):
     return np.power(np.pi, n / 2) * np.power(radius, n) / gamma(n / 2 + 1)
 
 def get_pi(accepted_fraction, ndim):
     return np.power(2 ** ndim * accepted_fraction * gamma(ndim / 2 + 1), 2 / ndim)
-    
-class MC(_BaseMCRunner):
-    def set_control(self, temp):
-        self.set_temperature(temp)
 
 class ComputePi(object):
-    def __init__(self, ndim=2, nsamples=1e4):
+    """the samples are drawn by nwalkers walkers in lockstep, see :class:`BatchedMC`"""
+    def __init__(self, ndim=2, nsamples=1e4, nwalkers=64):
         #
         self.ndim = ndim
         self.nsamples = nsamples
+        self.nwalkers = nwalkers
         #
         self.radius = 44
-        self.potential = NullPotential()
-        self.mc = MC(self.potential, np.ones(self.ndim), 1, self.nsamples)
-        self.step = UniformRectangularSampling(42, self.radius)
+        self.potential = BatchedNullPotential()
+        niter = int(np.ceil(self.nsamples / self.nwalkers))
+        self.mc = BatchedMC(self.potential, np.ones((self.nwalkers, self.ndim)), self.nwalkers, 1, niter)
+        self.step = BatchedUniformRectangularSampling(42, self.radius)
         self.mc.set_takestep(self.step)
-        self.mc.set_report_steps(0)
-        self.conftest_check_spherical_container = CheckSphericalContainerConfig(self.radius)
+        self.conftest_check_spherical_container = BatchedCheckSphericalContainerConfig(self.radius)
         self.mc.add_conf_test(self.conftest_check_spherical_container)
-        self.mc.set_print_progress()
         self.mc.run()
         self.p = self.mc.get_accepted_fraction()
         self.pi = get_pi(self.p, self.ndim)
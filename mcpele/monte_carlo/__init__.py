@@ -3,6 +3,9 @@ from _conf_test_cpp import CheckSphericalContainer
 from _conf_test_cpp import CheckSphericalContainerConfig
 from _conf_test_cpp import ConfTestOR
 from _takestep_cpp import RandomCoordsDisplacement
+from _takestep_cpp import RandomCoordsDisplacementPeriodicAll
+from _takestep_cpp import RandomCoordsDisplacementPeriodicSingle
+from _takestep_cpp import PeriodicImageTracker
 from _takestep_cpp import SampleGaussian
 from _takestep_cpp import GaussianCoordsDisplacement
 from _takestep_cpp import ParticlePairSwap
@@ -10,13 +13,43 @@ from _takestep_cpp import TakeStepPattern
 from _takestep_cpp import TakeStepProbabilities
 from _takestep_cpp import UniformSphericalSampling
 from _takestep_cpp import UniformRectangularSampling
+from _takestep_cpp import QuasiRandomSphericalSampling
+from _takestep_cpp import QuasiRandomRectangularSampling
 from _monte_carlo_cpp import _BaseMCRunner
+from _monte_carlo_cpp import NestedSampling
+from _monte_carlo_cpp import BatchedMC
+from _monte_carlo_cpp import BatchedNullPotential
+from _monte_carlo_cpp import BatchedPotentialAdaptor
+from _monte_carlo_cpp import BatchedConfTestAdaptor
+from _monte_carlo_cpp import BatchedCheckSphericalContainerConfig
+from _monte_carlo_cpp import BatchedRandomCoordsDisplacement
+from _monte_carlo_cpp import BatchedUniformRectangularSampling
 from _action_cpp import RecordEnergyHistogram
 from _action_cpp import RecordEnergyTimeseries
+from _action_cpp import RecordEnergyAutocorrelation
+from _action_cpp import RecordEnergyBlocking
+from _action_cpp import StopStandardError
+from _action_cpp import StopEffectiveSampleSize
+from _action_cpp import StopWallClock
+from _action_cpp import StopWangLandau
+from _action_cpp import RecordWangLandau
+from _action_cpp import WangLandauTest
+from _action_cpp import EnergyCollectiveVariable
+from _action_cpp import ProjectionCollectiveVariable
+from _action_cpp import TabulatedBias
+from _action_cpp import TabulatedBiasTest
+from _action_cpp import RefineTabulatedBias
+from _action_cpp import EquilibrationDetector
+from _action_cpp import AsyncAction
+from _action_cpp import QuenchPool
+from _action_cpp import MinimaDatabase
 from _action_cpp import RecordPairDistHistogram
+from _action_cpp import RecordStructureFactor
 from _action_cpp import RecordLowestEValueTimeseries
 from _action_cpp import RecordDisplacementPerParticleTimeseries
+from _action_cpp import RecordDisplacementCorrelation
 from _action_cpp import RecordCoordsTimeseries
+from _action_cpp import RecordCompressedTrajectory
 from _nullpotential_cpp import NullPotential
 from mcrunner import Metropolis_MCrunner
 
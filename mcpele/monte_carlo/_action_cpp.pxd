@@ -2,8 +2,13 @@ cimport pele.potentials._pele as _pele
 cimport pele.optimize._pele_opt as _pele_opt
 #from pele.potentials._pele cimport array_wrap_np
 from _pele_mc cimport cppAction,_Cdef_Action, shared_ptr
+from _pele_mc cimport cppStopCriterion, _Cdef_StopCriterion
+from _pele_mc cimport cppAcceptTest, _Cdef_AcceptTest
+from _takestep_cpp cimport cppPeriodicImageTracker, _Cdef_PeriodicImageTracker
 from libcpp cimport bool as cbool
 from libcpp.deque cimport deque
+from libcpp.vector cimport vector
+from libcpp.string cimport string
 
 # cython has no support for integer template argument.  This is a hack to get around it
 # https://groups.google.com/forum/#!topic/cython-users/xAZxdCFw6Xs
@@ -16,47 +21,135 @@ cdef extern from *:
 
 cdef extern from "mcpele/record_energy_histogram.h" namespace "mcpele": 
     cdef cppclass cppRecordEnergyHistogram "mcpele::RecordEnergyHistogram":
-        cppRecordEnergyHistogram(double, double, double, size_t) except +
+        cppRecordEnergyHistogram(double, double, double, size_t, cbool) except +
         _pele.Array[double] get_histogram() except +
+        void get_occupied_bins(vector[double]&, vector[double]&) except +
         void print_terminal() except +
         double get_max() except +
         double get_min() except +
         double get_mean() except +
         double get_variance() except +
-        int get_count() except +
+        size_t get_count() except +
+        cbool is_sparse() except +
+        vector[double] get_buffer() except +
+        void merge_buffer(vector[double]&) except +
 
 cdef extern from "mcpele/record_pair_dist_histogram.h" namespace "mcpele":
     cdef cppclass cppRecordPairDistHistogram "mcpele::RecordPairDistHistogram"[ndim]:
-        cppRecordPairDistHistogram(_pele.Array[double], size_t, size_t, size_t) except +
-        cppRecordPairDistHistogram(_pele.Array[double], size_t, size_t, size_t, shared_ptr[_pele_opt.cGradientOptimizer]) except +
+        cppRecordPairDistHistogram(_pele.Array[double], size_t, size_t, size_t, size_t, double, cbool) except +
+        cppRecordPairDistHistogram(_pele.Array[double], size_t, size_t, size_t, shared_ptr[_pele_opt.cGradientOptimizer], size_t, double) except +
         _pele.Array[double] get_hist_r() except +
         _pele.Array[double] get_hist_gr(double, size_t) except +
         size_t get_eqsteps() except +
 
+cdef extern from "mcpele/record_structure_factor.h" namespace "mcpele":
+    cdef cppclass cppRecordStructureFactor "mcpele::RecordStructureFactor"[ndim]:
+        cppRecordStructureFactor(_pele.Array[double], double, size_t, size_t, size_t, cbool) except +
+        _pele.Array[double] get_hist_k() except +
+        _pele.Array[double] get_hist_sk() except +
+        size_t get_eqsteps() except +
+        size_t get_nr_wavevectors() except +
+
 cdef extern from "mcpele/record_scalar_timeseries.h" namespace "mcpele":
     cdef cppclass cppRecordScalarTimeseries "mcpele::RecordScalarTimeseries":
         _pele.Array[double] get_time_series() except +
+        _pele.Array[double] get_time_series_view() except +
+        size_t size() except +
+        size_t get_capacity() except +
         void clear() except +
         cbool moving_average_is_stable(size_t, double) except +
+        void map_to_file(string, size_t) except +
+        cbool is_mapped() except +
+        void flush_file() except +
 
 cdef extern from "mcpele/record_energy_timeseries.h" namespace "mcpele":
     cdef cppclass cppRecordEnergyTimeseries "mcpele::RecordEnergyTimeseries":
-        cppRecordEnergyTimeseries(size_t, size_t) except +
+        cppRecordEnergyTimeseries(size_t, size_t, size_t) except +
         
+cdef extern from "mcpele/record_scalar_autocorrelation.h" namespace "mcpele":
+    cdef cppclass cppRecordScalarAutocorrelation "mcpele::RecordScalarAutocorrelation":
+        _pele.Array[double] get_lags() except +
+        _pele.Array[double] get_autocorrelation() except +
+        double get_integrated_time(double) except +
+        size_t get_decorrelation_steps() except +
+        size_t get_count() except +
+        double get_mean() except +
+        double get_variance() except +
+        void clear() except +
+
+cdef extern from "mcpele/record_energy_autocorrelation.h" namespace "mcpele":
+    cdef cppclass cppRecordEnergyAutocorrelation "mcpele::RecordEnergyAutocorrelation":
+        cppRecordEnergyAutocorrelation(size_t, size_t, size_t) except +
+
+cdef extern from "mcpele/record_scalar_blocking.h" namespace "mcpele":
+    cdef cppclass cppRecordScalarBlocking "mcpele::RecordScalarBlocking":
+        _pele.Array[double] get_block_sizes() except +
+        _pele.Array[double] get_standard_errors() except +
+        _pele.Array[double] get_standard_error_errors() except +
+        double get_standard_error() except +
+        cbool has_plateau() except +
+        double get_statistical_inefficiency() except +
+        size_t get_count() except +
+        double get_mean() except +
+        double get_variance() except +
+        void clear() except +
+
+cdef extern from "mcpele/record_energy_blocking.h" namespace "mcpele":
+    cdef cppclass cppRecordEnergyBlocking "mcpele::RecordEnergyBlocking":
+        cppRecordEnergyBlocking(size_t, size_t, size_t) except +
+
+cdef extern from "mcpele/equilibration_detector.h" namespace "mcpele":
+    cdef cppclass cppEquilibrationDetector "mcpele::EquilibrationDetector":
+        cppEquilibrationDetector(size_t, size_t, double) except +
+        void add_action(shared_ptr[cppAction]) except +
+        cbool is_equilibrated() except +
+        size_t get_equilibration_step() except +
+
 cdef extern from "mcpele/record_lowest_evalue_timeseries.h" namespace "mcpele":
     cdef cppclass cppRecordLowestEValueTimeseries "mcpele::RecordLowestEValueTimeseries":
         cppRecordLowestEValueTimeseries(size_t, size_t,
             shared_ptr[_pele.cBasePotential], size_t, _pele.Array[double]
-            , size_t) except +
+            , size_t, cbool, cbool, double) except +
+        size_t get_last_niter() except +
+        size_t get_total_niter() except +
+        size_t get_nr_computations() except +
     
 cdef extern from "mcpele/record_displacement_per_particle_timeseries.h" namespace "mcpele":
     cdef cppclass cppRecordDisplacementPerParticleTimeseries "mcpele::RecordDisplacementPerParticleTimeseries":
         cppRecordDisplacementPerParticleTimeseries(size_t, size_t,
             _pele.Array[double], size_t) except +
+        cppRecordDisplacementPerParticleTimeseries(size_t, size_t,
+            _pele.Array[double], shared_ptr[cppPeriodicImageTracker]) except +
+
+cdef extern from "mcpele/record_displacement_correlation.h" namespace "mcpele":
+    cdef cppclass cppRecordDisplacementCorrelation "mcpele::RecordDisplacementCorrelation":
+        cppRecordDisplacementCorrelation(size_t, size_t, size_t, double, size_t) except +
+        cppRecordDisplacementCorrelation(size_t, size_t, shared_ptr[cppPeriodicImageTracker], double, size_t) except +
+        _pele.Array[double] get_lags() except +
+        _pele.Array[double] get_mean_square_displacement() except +
+        _pele.Array[double] get_self_intermediate_scattering() except +
+        _pele.Array[double] get_nr_origins() except +
+        size_t get_count() except +
+        size_t get_nr_levels() except +
+        void clear() except +
+
+cdef extern from "mcpele/chunked_arena.h" namespace "mcpele":
+    cdef cppclass cppChunkedArena "mcpele::ChunkedArena":
+        size_t size() except +
+        size_t row_size() except +
+        size_t get_nr_chunks() except +
+        size_t get_chunk_nr_rows(size_t) except +
+        _pele.Array[double] get_chunk(size_t) except +
+        void compact() except +
 
 cdef extern from "mcpele/record_vector_timeseries.h" namespace "mcpele":
     cdef cppclass cppRecordVectorTimeseries "mcpele::RecordVectorTimeseries":
         deque[_pele.Array[double]] get_time_series() except +
+        cppChunkedArena& get_arena() except +
+        void map_to_file(string, size_t) except +
+        cbool is_mapped() except +
+        cbool is_file_created() except +
+        void flush_file() except +
         void clear() except +
         size_t get_record_every() except +
 
@@ -67,3 +160,106 @@ cdef extern from "mcpele/record_coords_timeseries.h" namespace "mcpele":
         _pele.Array[double] get_mean2_coordinate_vector() except +
         _pele.Array[double] get_variance_coordinate_vector() except +
         size_t get_count() except +
+
+cdef extern from "mcpele/record_compressed_trajectory.h" namespace "mcpele":
+    cdef cppclass cppRecordCompressedTrajectory "mcpele::RecordCompressedTrajectory":
+        cppRecordCompressedTrajectory(string, size_t, size_t, size_t, double, size_t) except +
+        void flush() except +
+        size_t get_nr_frames() except +
+        size_t get_bytes_written() except +
+        size_t get_record_every() except +
+
+cdef extern from "mcpele/async_action.h" namespace "mcpele":
+    cdef cppclass cppAsyncAction "mcpele::AsyncAction":
+        cppAsyncAction(vector[shared_ptr[cppAction]], size_t, size_t, size_t) except +
+        void flush() nogil except +
+        size_t get_nr_threads() except +
+        size_t get_max_queue() except +
+        size_t get_nr_processed() except +
+
+cdef extern from "mcpele/quench_pool.h" namespace "mcpele":
+    cdef cppclass cppQuenchPool "mcpele::QuenchPool":
+        cppQuenchPool(vector[shared_ptr[_pele_opt.cGradientOptimizer]], size_t, size_t, size_t) except +
+        void add_action(shared_ptr[cppAction]) except +
+        void flush() nogil except +
+        size_t get_nr_threads() except +
+        size_t get_batch_size() except +
+        size_t get_nr_quenched() except +
+        size_t get_nr_failed() except +
+        size_t get_nr_pending() except +
+
+cdef extern from "mcpele/minima_database.h" namespace "mcpele":
+    cdef cppclass cppMinimaDatabase "mcpele::MinimaDatabase":
+        cppMinimaDatabase(double, double) except +
+        size_t size() except +
+        _pele.Array[double] get_energies() except +
+        _pele.Array[double] get_counts() except +
+        _pele.Array[double] get_minimum(size_t) except +
+        size_t get_first_step(size_t) except +
+        void clear() except +
+
+cdef extern from "mcpele/wang_landau.h" namespace "mcpele":
+    cdef cppclass cppRecordWangLandau "mcpele::RecordWangLandau":
+        cppRecordWangLandau(double, double, double, double, size_t, double, double) except +
+        cbool is_flat() except +
+        cbool is_converged() except +
+        void merge(cppRecordWangLandau&) except +
+        double min() except +
+        double max() except +
+        double bin() except +
+        size_t size() except +
+        double get_lnf() except +
+        size_t get_nr_updates() except +
+        size_t get_nr_stages() except +
+        cbool is_one_over_t() except +
+        _pele.Array[double] get_energies() except +
+        _pele.Array[double] get_log_density_of_states() except +
+        _pele.Array[double] get_histogram() except +
+    cdef cppclass cppWangLandauTest "mcpele::WangLandauTest":
+        cppWangLandauTest(shared_ptr[cppRecordWangLandau], size_t) except +
+        size_t get_seed() except +
+        void set_generator_seed(size_t) except +
+
+cdef extern from "mcpele/tabulated_bias.h" namespace "mcpele":
+    cdef cppclass cppCollectiveVariable "mcpele::CollectiveVariable"
+    cdef cppclass cppEnergyCollectiveVariable "mcpele::EnergyCollectiveVariable":
+        cppEnergyCollectiveVariable() except +
+    cdef cppclass cppProjectionCollectiveVariable "mcpele::ProjectionCollectiveVariable":
+        cppProjectionCollectiveVariable(_pele.Array[double]) except +
+    cdef cppclass cppTabulatedBias "mcpele::TabulatedBias":
+        cppTabulatedBias(shared_ptr[cppCollectiveVariable], double, double, size_t, _pele.Array[double]) except +
+        double get_log_weight(double) except +
+        cbool in_range(double) except +
+        size_t size() except +
+        _pele.Array[double] get_nodes() except +
+        _pele.Array[double] get_log_weights() except +
+        void set_log_weights(_pele.Array[double]) except +
+    cdef cppclass cppTabulatedBiasTest "mcpele::TabulatedBiasTest":
+        cppTabulatedBiasTest(shared_ptr[cppTabulatedBias], size_t) except +
+        size_t get_seed() except +
+        void set_generator_seed(size_t) except +
+    cdef cppclass cppRefineTabulatedBias "mcpele::RefineTabulatedBias":
+        cppRefineTabulatedBias(shared_ptr[cppTabulatedBias], size_t, size_t, double) except +
+        cbool refine() except +
+        cbool is_flat() except +
+        cbool is_refining() except +
+        void set_refining(cbool) except +
+        size_t get_nr_refinements() except +
+        size_t get_count() except +
+        _pele.Array[double] get_histogram() except +
+        _pele.Array[double] get_free_energy() except +
+        void clear_histogram() except +
+
+cdef extern from "<memory>" namespace "std":
+    shared_ptr[T] static_pointer_cast[T, U](shared_ptr[U])
+
+cdef extern from "mcpele/stop_criteria.h" namespace "mcpele":
+    cdef cppclass cppStopStandardError "mcpele::StopStandardError":
+        cppStopStandardError(shared_ptr[cppRecordScalarBlocking], double, cbool) except +
+    cdef cppclass cppStopEffectiveSampleSize "mcpele::StopEffectiveSampleSize":
+        cppStopEffectiveSampleSize(shared_ptr[cppRecordScalarAutocorrelation], double) except +
+        double get_effective_sample_size() except +
+    cdef cppclass cppStopWallClock "mcpele::StopWallClock":
+        cppStopWallClock(double) except +
+    cdef cppclass cppStopWangLandau "mcpele::StopWangLandau":
+        cppStopWangLandau(shared_ptr[cppRecordWangLandau]) except +
@@ -9,14 +9,31 @@ import sys
 
 from pele.potentials._pele cimport array_wrap_np
 
+np.import_array()
+
+cdef class _ArenaBlock:
+    """owns a reference to a block of a ChunkedArena, the base of the numpy views"""
+    cdef _pele.Array[double] block
+
+cdef _arena_block_view(_pele.Array[double] block, size_t nrows, size_t row_size):
+    """zero-copy 2-D numpy view of a row-major pele array, which it keeps alive"""
+    cdef _ArenaBlock owner = _ArenaBlock()
+    owner.block = block
+    cdef np.npy_intp shape[2]
+    shape[0] = nrows
+    shape[1] = row_size
+    cdef np.ndarray view = np.PyArray_SimpleNewFromData(2, shape, np.NPY_DOUBLE, <void*> block.data())
+    np.set_array_base(view, owner)
+    return view
+
 #===============================================================================
 # Record Energy Histogram
 #===============================================================================        
 
 cdef class _Cdef_RecordEnergyHistogram(_Cdef_Action):
     cdef cppRecordEnergyHistogram* newptr
-    def __cinit__(self, min, max, bin, eqsteps):
-        self.thisptr = shared_ptr[cppAction](<cppAction*> new cppRecordEnergyHistogram(min, max, bin, eqsteps))
+    def __cinit__(self, min, max, bin, eqsteps, sparse=False):
+        self.thisptr = shared_ptr[cppAction](<cppAction*> new cppRecordEnergyHistogram(min, max, bin, eqsteps, sparse))
         self.newptr = <cppRecordEnergyHistogram*> self.thisptr.get()
     
     @cython.boundscheck(False)
@@ -37,6 +54,24 @@ cdef class _Cdef_RecordEnergyHistogram(_Cdef_Action):
             hist[i] = histdata[i]
               
         return hist
+    
+    def get_occupied_bins(self):
+        """returns the visited bins only
+        
+        Unlike :meth:`get_histogram` this does not allocate the whole energy
+        range, use it to read a sparse histogram.
+        
+        Returns
+        -------
+        positions : numpy.array
+            bin centres, sorted by energy
+        counts : numpy.array
+            number of entries in each bin
+        """
+        cdef vector[double] positions
+        cdef vector[double] counts
+        self.newptr.get_occupied_bins(positions, counts)
+        return np.array(positions, dtype=float), np.array(counts, dtype=float)
         
     def print_terminal(self):
         """draws histogram on the terminal
@@ -81,6 +116,32 @@ cdef class _Cdef_RecordEnergyHistogram(_Cdef_Action):
         """
         count = self.newptr.get_count()
         return count
+    
+    def get_buffer(self):
+        """get a contiguous representation of the histogram
+        
+        The buffer can be communicated, e.g. with MPI, and merged into the
+        histogram of another process with :meth:`merge_buffer`.
+        
+        Returns
+        -------
+        numpy.array
+            bin size, range, count, layout, moments and bins of the histogram;
+            the bins are either the dense counts over the range or, when that
+            is shorter, (k, count) pairs of the visited bins only
+        """
+        return np.array(self.newptr.get_buffer(), dtype=float)
+    
+    def merge_buffer(self, buffer):
+        """add the entries of a histogram exported with :meth:`get_buffer`
+        
+        Parameters
+        ----------
+        buffer : numpy.array
+            output of :meth:`get_buffer` of a histogram with the same bin size
+        """
+        cdef vector[double] buf = np.asarray(buffer, dtype=float)
+        self.newptr.merge_buffer(buf)
         
 class RecordEnergyHistogram(_Cdef_RecordEnergyHistogram):
     """Bins energies into a resizable histogram
@@ -101,6 +162,10 @@ class RecordEnergyHistogram(_Cdef_RecordEnergyHistogram):
         choice for the bin size
     eqsteps: int
         number of iterations to skip before starting to record entries
+    sparse : bool
+        if True, only the visited bins are stored, which bounds memory for
+        very wide energy ranges; read them with :meth:`get_occupied_bins`,
+        :meth:`get_histogram` builds the dense histogram over the whole range
         
     """
 
@@ -111,25 +176,29 @@ cdef class  _Cdef_RecordPairDistHistogram(_Cdef_Action):
     cdef cppRecordPairDistHistogram[INT2]* newptr2
     cdef cppRecordPairDistHistogram[INT3]* newptr3
     cdef _pele_opt.GradientOptimizer optimizer
-    def __cinit__(self, boxvec, nr_bins, eqsteps, record_every, optimizer=None):
+    def __cinit__(self, boxvec, nr_bins, eqsteps, record_every, optimizer=None, nr_threads=1, max_dist=None, incremental=False):
         cdef np.ndarray[double, ndim=1] bv = np.array(boxvec, dtype=float)
         bv_ = array_wrap_np(bv)
         ndim = len(boxvec)
         assert(ndim == 2 or ndim == 3)
         assert(len(boxvec)==ndim)
+        if max_dist is None:
+            max_dist = 0
+        if optimizer is not None and incremental:
+            raise ValueError("RecordPairDistHistogram: incremental mode is not available with a quench")
         if optimizer is None:
             self.quench = False
             if ndim == 2:
-                self.thisptr = shared_ptr[cppAction](<cppAction*> new cppRecordPairDistHistogram[INT2](bv_, nr_bins, eqsteps, record_every))
+                self.thisptr = shared_ptr[cppAction](<cppAction*> new cppRecordPairDistHistogram[INT2](bv_, nr_bins, eqsteps, record_every, nr_threads, max_dist, incremental))
             else:
-                self.thisptr = shared_ptr[cppAction](<cppAction*> new cppRecordPairDistHistogram[INT3](bv_, nr_bins, eqsteps, record_every))
+                self.thisptr = shared_ptr[cppAction](<cppAction*> new cppRecordPairDistHistogram[INT3](bv_, nr_bins, eqsteps, record_every, nr_threads, max_dist, incremental))
         else:
             self.quench = True
             self.optimizer = optimizer
             if ndim == 2:
-                self.thisptr = shared_ptr[cppAction](<cppAction*> new cppRecordPairDistHistogram[INT2](bv_, nr_bins, eqsteps, record_every, self.optimizer.thisptr))
+                self.thisptr = shared_ptr[cppAction](<cppAction*> new cppRecordPairDistHistogram[INT2](bv_, nr_bins, eqsteps, record_every, self.optimizer.thisptr, nr_threads, max_dist))
             else:
-                self.thisptr = shared_ptr[cppAction](<cppAction*> new cppRecordPairDistHistogram[INT3](bv_, nr_bins, eqsteps, record_every, self.optimizer.thisptr))
+                self.thisptr = shared_ptr[cppAction](<cppAction*> new cppRecordPairDistHistogram[INT3](bv_, nr_bins, eqsteps, record_every, self.optimizer.thisptr, nr_threads, max_dist))
         if ndim == 2:
             self.newptr2 = <cppRecordPairDistHistogram[INT2]*> self.thisptr.get()
         else:
@@ -217,16 +286,127 @@ class RecordPairDistHistogram(_Cdef_RecordPairDistHistogram):
         accumulating the distances to the g(r) histogram. This is
         intended to give the quenched g(r) mentioned here:
         http://dx.doi.org/10.1063/1.449840
+    nr_threads : int (optional)
+        number of threads sharing the pair loop of each recorded configuration
+    max_dist : double (optional)
+        range of the :math:`g(r)` histogram, half the smallest box side by
+        default; if it is at most a third of every box side, a cell list is
+        used so that only pairs closer than ``max_dist`` are visited
+    incremental : bool (optional)
+        if True, the histogram of the current configuration is kept and only
+        the pairs of the particles that moved since the last record are
+        updated, so recording every step is cheap for single particle moves;
+        not available together with ``optimizer``
     """
     
+#===============================================================================
+# Record Static Structure Factor
+#===============================================================================
+cdef class  _Cdef_RecordStructureFactor(_Cdef_Action):
+    cdef cppRecordStructureFactor[INT2]* newptr2
+    cdef cppRecordStructureFactor[INT3]* newptr3
+    def __cinit__(self, boxvec, kmax, nr_bins, eqsteps, record_every, incremental=False):
+        cdef np.ndarray[double, ndim=1] bv = np.array(boxvec, dtype=float)
+        bv_ = array_wrap_np(bv)
+        ndim = len(boxvec)
+        assert(ndim == 2 or ndim == 3)
+        if ndim == 2:
+            self.thisptr = shared_ptr[cppAction](<cppAction*> new cppRecordStructureFactor[INT2](bv_, kmax, nr_bins, eqsteps, record_every, incremental))
+            self.newptr2 = <cppRecordStructureFactor[INT2]*> self.thisptr.get()
+        else:
+            self.thisptr = shared_ptr[cppAction](<cppAction*> new cppRecordStructureFactor[INT3](bv_, kmax, nr_bins, eqsteps, record_every, incremental))
+            self.newptr3 = <cppRecordStructureFactor[INT3]*> self.thisptr.get()
+        self.ndim = ndim
+
+    def get_hist_k(self):
+        """get array of :math:`k` values for :math:`S(k)` measurement
+
+        Returns
+        -------
+        numpy.array
+            centres of the :math:`|k|` shells
+        """
+        cdef _pele.Array[double] histi
+        if self.ndim == 2:
+            histi = self.newptr2.get_hist_k()
+        else:
+            histi = self.newptr3.get_hist_k()
+        cdef double *histdata = histi.data()
+        cdef np.ndarray[double, ndim=1, mode="c"] hist = np.zeros(histi.size())
+        cdef size_t i
+        for i in xrange(histi.size()):
+            hist[i] = histdata[i]
+        return hist
+
+    def get_hist_sk(self):
+        """get array of :math:`S(k)` values
+
+        Returns
+        -------
+        numpy.array
+            :math:`S(k)` averaged over configurations and over the
+            wavevectors in each :math:`|k|` shell, zero for empty shells
+        """
+        cdef _pele.Array[double] histi
+        if self.ndim == 2:
+            histi = self.newptr2.get_hist_sk()
+        else:
+            histi = self.newptr3.get_hist_sk()
+        cdef double *histdata = histi.data()
+        cdef np.ndarray[double, ndim=1, mode="c"] hist = np.zeros(histi.size())
+        cdef size_t i
+        for i in xrange(histi.size()):
+            hist[i] = histdata[i]
+        return hist
+
+    def get_nr_wavevectors(self):
+        """get number of wavevectors :math:`k` (one of each pair :math:`\pm k`)"""
+        if self.ndim == 2:
+            return self.newptr2.get_nr_wavevectors()
+        else:
+            return self.newptr3.get_nr_wavevectors()
+
+    def get_eqsteps(self):
+        """get number of equilibration steps"""
+        if self.ndim == 2:
+            return self.newptr2.get_eqsteps()
+        else:
+            return self.newptr3.get_eqsteps()
+
+class RecordStructureFactor(_Cdef_RecordStructureFactor):
+    """Record the static structure factor :math:`S(k)`
+
+    This class is the Python interface for the c++ mcpele::RecordStructureFactor implementation.
+    :math:`S(k) = |\sum_j \exp(i k \cdot r_j)|^2 / N` is accumulated on the fly for the
+    wavevectors of the periodic box with :math:`|k| <` ``kmax`` and averaged over shells of
+    :math:`|k|`, which avoids dumping coordinates for post-processing.
+
+    Parameters
+    ----------
+    boxvec : numpy.array
+        array of box side lengths
+    kmax : double
+        wavevectors with :math:`|k| <` ``kmax`` are used
+    nr_bins : int
+        number of :math:`|k|` shells
+    eqsteps : int
+        number of equilibration steps to be excluded from :math:`S(k)` computation
+    record_every : int
+        after ``eqsteps`` steps have been done, record every ``record_everyth`` steps
+    incremental : bool (optional)
+        if True, the density modes of the current configuration are kept and
+        only the particles that moved since the last record are updated
+    """
+
 #===============================================================================
 # RecordEnergyTimeseries
 #===============================================================================
         
 cdef class _Cdef_RecordEnergyTimeseries(_Cdef_Action):
     cdef cppRecordScalarTimeseries* newptr
-    def __cinit__(self, niter, record_every):
-        self.thisptr = shared_ptr[cppAction](<cppAction*> new cppRecordEnergyTimeseries(niter, record_every))
+    cdef public object mapped_filename
+    def __cinit__(self, niter, record_every, capacity=0):
+        self.thisptr = shared_ptr[cppAction](<cppAction*> new cppRecordEnergyTimeseries(niter, record_every, capacity))
         self.newptr = <cppRecordScalarTimeseries*> self.thisptr.get()
         
     @cython.boundscheck(False)
@@ -239,14 +419,18 @@ cdef class _Cdef_RecordEnergyTimeseries(_Cdef_Action):
         numpy.array
             array containing the energy time series
         """
-        cdef _pele.Array[double] seriesi = self.newptr.get_time_series()
-        cdef double *seriesdata = seriesi.data()
-        cdef np.ndarray[double, ndim=1, mode="c"] series = np.zeros(seriesi.size())
-        cdef size_t i
-        for i in xrange(seriesi.size()):
-            series[i] = seriesdata[i]
-              
-        return series
+        if self.newptr.is_mapped():
+            self.newptr.flush_file()
+            return np.load(self.mapped_filename, mmap_mode="r")
+        cdef _pele.Array[double] seriesi = self.newptr.get_time_series_view()
+        if seriesi.size() == 0:
+            return np.zeros(0)
+        cdef double[::1] view = <double[:seriesi.size()]> seriesi.data()
+        return np.array(view, copy=True)
+    
+    def get_capacity(self):
+        """number of most recent energies kept, 0 if all are kept"""
+        return self.newptr.get_capacity()
     
     def clear(self):
         """clear time series container
@@ -255,6 +439,23 @@ cdef class _Cdef_RecordEnergyTimeseries(_Cdef_Action):
         """
         self.newptr.clear()
     
+    def map_to_file(self, filename, flush_every=1024):
+        """append the time series to a memory mapped .npy file from now on
+        
+        The energies recorded so far are moved to the file. The file can be
+        read while the simulation runs with ``numpy.load(filename, mmap_mode="r")``,
+        it contains the energies up to the last flush, every ``flush_every`` records.
+        :func:`get_time_series` then returns such a read only memory map.
+        """
+        if not isinstance(filename, bytes):
+            filename = filename.encode()
+        self.newptr.map_to_file(filename, flush_every)
+        self.mapped_filename = filename
+    
+    def flush_file(self):
+        """update the memory mapped file with all energies recorded so far"""
+        self.newptr.flush_file()
+    
 class RecordEnergyTimeseries(_Cdef_RecordEnergyTimeseries):
     """Record a time series of the energy
     
@@ -267,23 +468,531 @@ class RecordEnergyTimeseries(_Cdef_RecordEnergyTimeseries):
         expected number of steps (to preallocate)
     record_every : int
         interval every which the energy is recorded
+    capacity : int (optional)
+        keep only the last ``capacity`` energies in a ring buffer of constant
+        size, 0 keeps all energies
+    """
+    
+#===============================================================================
+# RecordEnergyAutocorrelation
+#===============================================================================
+
+cdef class _Cdef_RecordEnergyAutocorrelation(_Cdef_Action):
+    cdef cppRecordScalarAutocorrelation* newptr
+    def __cinit__(self, record_every, eqsteps, nr_lags=16):
+        self.thisptr = shared_ptr[cppAction](<cppAction*> new cppRecordEnergyAutocorrelation(record_every, eqsteps, nr_lags))
+        self.newptr = <cppRecordScalarAutocorrelation*> self.thisptr.get()
+
+    @cython.boundscheck(False)
+    @cython.wraparound(False)
+    def get_lags(self):
+        """get the lags of the autocorrelation, in MC steps"""
+        cdef _pele.Array[double] lagsi = self.newptr.get_lags()
+        cdef double *lagsdata = lagsi.data()
+        cdef np.ndarray[double, ndim=1, mode="c"] lags = np.zeros(lagsi.size())
+        cdef size_t i
+        for i in xrange(lagsi.size()):
+            lags[i] = lagsdata[i]
+        return lags
+
+    @cython.boundscheck(False)
+    @cython.wraparound(False)
+    def get_autocorrelation(self):
+        """get the normalised autocorrelation at the lags of :meth:`get_lags`"""
+        cdef _pele.Array[double] rhoi = self.newptr.get_autocorrelation()
+        cdef double *rhodata = rhoi.data()
+        cdef np.ndarray[double, ndim=1, mode="c"] rho = np.zeros(rhoi.size())
+        cdef size_t i
+        for i in xrange(rhoi.size()):
+            rho[i] = rhodata[i]
+        return rho
+
+    def get_integrated_time(self, window=6):
+        """get the integrated autocorrelation time, in MC steps
+
+        Parameters
+        ----------
+        window : double
+            Sokal's window: the sum over the autocorrelation is truncated at
+            the first lag larger than ``window`` times the estimate
+        """
+        return self.newptr.get_integrated_time(window)
+
+    def get_decorrelation_steps(self):
+        """get the number of MC steps between effectively independent samples"""
+        return self.newptr.get_decorrelation_steps()
+
+    def get_count(self):
+        return self.newptr.get_count()
+
+    def get_mean(self):
+        return self.newptr.get_mean()
+
+    def get_variance(self):
+        return self.newptr.get_variance()
+
+    def clear(self):
+        """reset the correlator"""
+        self.newptr.clear()
+
+class RecordEnergyAutocorrelation(_Cdef_RecordEnergyAutocorrelation):
+    """Record the autocorrelation of the energy on the fly
+
+    This class is the Python interface for the c++ mcpele::RecordEnergyAutocorrelation
+    :class:`Action` class implementation. A multi-tau correlator with logarithmically
+    spaced lags keeps O(log T) memory, and the integrated autocorrelation time is
+    available at any time during the run.
+
+    Parameters
+    ----------
+    record_every : int
+        interval every which the energy is recorded
+    eqsteps : int
+        number of equilibration steps to be skipped
+    nr_lags : int (optional)
+        number of lags per level of the correlator, even
+    """
+
+#===============================================================================
+# RecordEnergyBlocking
+#===============================================================================
+
+cdef class _Cdef_RecordEnergyBlocking(_Cdef_Action):
+    cdef cppRecordScalarBlocking* newptr
+    def __cinit__(self, record_every, eqsteps, min_blocks=16):
+        self.thisptr = shared_ptr[cppAction](<cppAction*> new cppRecordEnergyBlocking(record_every, eqsteps, min_blocks))
+        self.newptr = <cppRecordScalarBlocking*> self.thisptr.get()
+
+    @cython.boundscheck(False)
+    @cython.wraparound(False)
+    def get_block_sizes(self):
+        """get the block sizes, in recorded samples, of the levels with enough blocks"""
+        cdef _pele.Array[double] vi = self.newptr.get_block_sizes()
+        cdef double *vdata = vi.data()
+        cdef np.ndarray[double, ndim=1, mode="c"] v = np.zeros(vi.size())
+        cdef size_t i
+        for i in xrange(vi.size()):
+            v[i] = vdata[i]
+        return v
+
+    @cython.boundscheck(False)
+    @cython.wraparound(False)
+    def get_standard_errors(self):
+        """get the standard error of the mean estimated at each block size"""
+        cdef _pele.Array[double] vi = self.newptr.get_standard_errors()
+        cdef double *vdata = vi.data()
+        cdef np.ndarray[double, ndim=1, mode="c"] v = np.zeros(vi.size())
+        cdef size_t i
+        for i in xrange(vi.size()):
+            v[i] = vdata[i]
+        return v
+
+    @cython.boundscheck(False)
+    @cython.wraparound(False)
+    def get_standard_error_errors(self):
+        """get the uncertainty of each standard error estimate"""
+        cdef _pele.Array[double] vi = self.newptr.get_standard_error_errors()
+        cdef double *vdata = vi.data()
+        cdef np.ndarray[double, ndim=1, mode="c"] v = np.zeros(vi.size())
+        cdef size_t i
+        for i in xrange(vi.size()):
+            v[i] = vdata[i]
+        return v
+
+    def get_standard_error(self):
+        """get the standard error of the mean at the plateau of the blocking
+        analysis, or the largest estimate if there is no plateau yet"""
+        return self.newptr.get_standard_error()
+
+    def has_plateau(self):
+        """whether the standard error estimates have reached a plateau"""
+        return self.newptr.has_plateau()
+
+    def get_statistical_inefficiency(self):
+        return self.newptr.get_statistical_inefficiency()
+
+    def get_count(self):
+        return self.newptr.get_count()
+
+    def get_mean(self):
+        return self.newptr.get_mean()
+
+    def get_variance(self):
+        return self.newptr.get_variance()
+
+    def clear(self):
+        """reset the blocking analysis"""
+        self.newptr.clear()
+
+class RecordEnergyBlocking(_Cdef_RecordEnergyBlocking):
+    """Streaming blocking analysis of the energy
+
+    This class is the Python interface for the c++ mcpele::RecordEnergyBlocking
+    :class:`Action` class implementation. Block averages of 1, 2, 4, ... samples
+    are accumulated in O(log T) memory (Flyvbjerg and Petersen), so that the
+    standard error of the mean energy is available while the run is going.
+
+    Parameters
+    ----------
+    record_every : int
+        interval every which the energy is recorded
+    eqsteps : int
+        number of equilibration steps to be skipped
+    min_blocks : int (optional)
+        block sizes with fewer blocks are not reported
+    """
+
+#===============================================================================
+# EquilibrationDetector
+#===============================================================================
+
+cdef class _Cdef_EquilibrationDetector(_Cdef_Action):
+    cdef cppEquilibrationDetector* newptr
+    cdef list actions
+    def __cinit__(self, record_every, nr_samples, threshold=0.1):
+        self.thisptr = shared_ptr[cppAction](<cppAction*> new cppEquilibrationDetector(record_every, nr_samples, threshold))
+        self.newptr = <cppEquilibrationDetector*> self.thisptr.get()
+        self.actions = []
+
+    def add_action(self, _Cdef_Action action):
+        """add an :class:`Action` that is switched on once the energy is stationary
+
+        the action should be constructed with ``eqsteps=0``
+        """
+        self.actions.append(action)
+        self.newptr.add_action(action.thisptr)
+
+    def is_equilibrated(self):
+        return self.newptr.is_equilibrated()
+
+    def get_equilibration_step(self):
+        """get the MC step at which equilibration was detected, 0 before"""
+        return self.newptr.get_equilibration_step()
+
+class EquilibrationDetector(_Cdef_EquilibrationDetector):
+    """Detect equilibration from the energy instead of a fixed number of steps
+
+    This class is the Python interface for the c++ mcpele::EquilibrationDetector
+    :class:`Action` class implementation. The energy is recorded every ``record_every``
+    steps; the last ``nr_samples`` energies are stationary once the standard deviation
+    of their moving averages, over windows of ``nr_samples / 2``, is below ``threshold``
+    times the standard deviation of the energies. Then the step size adaptation ends and
+    the actions added with :func:`add_action` are switched on.
+
+    Parameters
+    ----------
+    record_every : int
+        interval every which the energy is recorded
+    nr_samples : int
+        number of energies tested for stationarity, a multiple of 4
+    threshold : double (optional)
+        relative spread of the moving averages below which the energy is stationary
+    """
+
+#===============================================================================
+# RecordCompressedTrajectory
+#===============================================================================
+
+cdef class _Cdef_RecordCompressedTrajectory(_Cdef_Action):
+    cdef cppRecordCompressedTrajectory* newptr
+    def __cinit__(self, filename, ndof, record_every=1, eqsteps=0, precision=1e-3, keyframe_every=100):
+        if not isinstance(filename, bytes):
+            filename = filename.encode()
+        self.thisptr = shared_ptr[cppAction](<cppAction*> new cppRecordCompressedTrajectory(filename, ndof, record_every, eqsteps, precision, keyframe_every))
+        self.newptr = <cppRecordCompressedTrajectory*> self.thisptr.get()
+
+    def flush(self):
+        """write the buffered frames to the file"""
+        self.newptr.flush()
+
+    def get_nr_frames(self):
+        return self.newptr.get_nr_frames()
+
+    def get_bytes_written(self):
+        """size of the trajectory in bytes, including buffered frames"""
+        return self.newptr.get_bytes_written()
+
+    def get_record_every(self):
+        return self.newptr.get_record_every()
+
+class RecordCompressedTrajectory(_Cdef_RecordCompressedTrajectory):
+    """Stream the coordinates to a file in a compact fixed precision format
+
+    This class is the Python interface for the c++ mcpele::RecordCompressedTrajectory
+    :class:`Action` class implementation. Coordinates are rounded to multiples of
+    ``precision``; frames store the differences to the previous frame as variable
+    length integers, except for every ``keyframe_every``-th frame. Frames are buffered
+    and written when the buffer is full, on :func:`flush` and when the action is
+    destroyed. Read the file with :func:`mcpele.utils.read_compressed_trajectory`.
+
+    Parameters
+    ----------
+    filename : string
+        trajectory file, overwritten if it exists
+    ndof : int
+        number of degrees of freedom
+    record_every : int
+        interval every which the coordinates are recorded
+    eqsteps : int
+        number of equilibration steps, during which nothing is recorded
+    precision : double (optional)
+        absolute precision of the stored coordinates
+    keyframe_every : int (optional)
+        interval, in frames, of frames stored without reference to the previous one
+    """
+
+#===============================================================================
+# AsyncAction
+#===============================================================================
+
+cdef class _Cdef_AsyncAction(_Cdef_Action):
+    cdef cppAsyncAction* newptr
+    cdef list worker_actions
+    def __cinit__(self, worker_actions, record_every, eqsteps, max_queue=0):
+        cdef vector[shared_ptr[cppAction]] workers
+        cdef _Cdef_Action worker
+        for worker in worker_actions:
+            workers.push_back(worker.thisptr)
+        self.thisptr = shared_ptr[cppAction](<cppAction*> new cppAsyncAction(workers, record_every, eqsteps, max_queue))
+        self.newptr = <cppAsyncAction*> self.thisptr.get()
+        self.worker_actions = list(worker_actions)
+
+    def flush(self):
+        """wait until all queued configurations are processed
+        
+        call before reading the results of the worker actions
+        """
+        with nogil:
+            self.newptr.flush()
+
+    def get_worker_actions(self):
+        return list(self.worker_actions)
+
+    def get_nr_threads(self):
+        return self.newptr.get_nr_threads()
+
+    def get_max_queue(self):
+        return self.newptr.get_max_queue()
+
+    def get_nr_processed(self):
+        """number of configurations processed by the worker actions"""
+        return self.newptr.get_nr_processed()
+
+class AsyncAction(_Cdef_AsyncAction):
+    """Run expensive actions on worker threads while the chain keeps moving
+    
+    This class is the Python interface for the c++ mcpele::AsyncAction
+    :class:`Action` class implementation. Every ``record_every`` steps after
+    ``eqsteps`` steps the coordinates are copied and queued; one thread per
+    worker action processes the queue. Worker actions must be independent
+    instances, each with its own potential and optimizer (e.g. several
+    :class:`RecordPairDistHistogram` with a quench), and must not call back into
+    Python. They see the step, energy and temperature of the queued configuration,
+    so they can use the same ``record_every`` and ``eqsteps``. Each worker action
+    holds its own results: call :func:`flush` before reading and combining them.
+    
+    Parameters
+    ----------
+    worker_actions : list of :class:`Action`
+        one action per worker thread
+    record_every : int
+        interval every which the configuration is queued
+    eqsteps : int
+        number of equilibration steps, during which nothing is queued
+    max_queue : int (optional)
+        maximum number of waiting configurations, the chain waits while the queue is
+        full; 0 means twice the number of worker actions
+    """
+
+#===============================================================================
+# QuenchPool
+#===============================================================================
+
+cdef class _Cdef_QuenchPool(_Cdef_Action):
+    cdef cppQuenchPool* newptr
+    cdef list optimizers
+    cdef list actions
+    def __cinit__(self, optimizers, record_every, eqsteps, batch_size=0):
+        cdef vector[shared_ptr[_pele_opt.cGradientOptimizer]] opts
+        cdef _pele_opt.GradientOptimizer opt
+        for opt in optimizers:
+            opts.push_back(opt.thisptr)
+        self.thisptr = shared_ptr[cppAction](<cppAction*> new cppQuenchPool(opts, record_every, eqsteps, batch_size))
+        self.newptr = <cppQuenchPool*> self.thisptr.get()
+        self.optimizers = list(optimizers)
+        self.actions = []
+
+    def add_action(self, _Cdef_Action action):
+        """add an action that is given the minima"""
+        self.newptr.add_action(action.thisptr)
+        self.actions.append(action)
+
+    def flush(self):
+        """quench the configurations of the current, partial batch
+        
+        call at the end of the run, before reading the results of the added actions
+        """
+        with nogil:
+            self.newptr.flush()
+
+    def get_actions(self):
+        return list(self.actions)
+
+    def get_nr_threads(self):
+        return self.newptr.get_nr_threads()
+
+    def get_batch_size(self):
+        return self.newptr.get_batch_size()
+
+    def get_nr_quenched(self):
+        """number of quenches done, including the unconverged ones"""
+        return self.newptr.get_nr_quenched()
+
+    def get_nr_failed(self):
+        """number of unconverged quenches, whose minima were not passed on"""
+        return self.newptr.get_nr_failed()
+
+    def get_nr_pending(self):
+        """number of configurations waiting for the next batch"""
+        return self.newptr.get_nr_pending()
+
+class QuenchPool(_Cdef_QuenchPool):
+    """Inherent structure sampling with batched, parallel quenches
+    
+    This class is the Python interface for the c++ mcpele::QuenchPool
+    :class:`Action` class implementation. Every ``record_every`` steps after
+    ``eqsteps`` steps the coordinates are copied into a batch; full batches are
+    minimised in parallel, one thread per optimizer. The optimizers must be
+    independent instances, each with its own potential, and their potentials must
+    not be implemented in Python: :func:`flush` and the full batches are quenched
+    on threads that do not hold the GIL. The minima are passed, in the
+    order of the MC steps, to the actions added with :func:`add_action`, e.g. a
+    :class:`RecordPairDistHistogram` without optimizer for the inherent structure
+    g(r), a :class:`RecordEnergyHistogram` or a :class:`MinimaDatabase`. These see
+    the step of the configuration and the energy of the minimum, so they can use
+    ``record_every=1`` and ``eqsteps=0``. Call :func:`flush` at the end of the run.
+    
+    Parameters
+    ----------
+    optimizers : list of pele gradient optimizers
+        one optimizer per thread; they must be independent instances, each with its
+        own c++ potential
+    record_every : int
+        interval every which the configuration is quenched
+    eqsteps : int
+        number of equilibration steps, during which nothing is quenched
+    batch_size : int (optional)
+        number of configurations quenched together; 0 means four per optimizer
     """
+
+#===============================================================================
+# MinimaDatabase
+#===============================================================================
+
+cdef class _Cdef_MinimaDatabase(_Cdef_Action):
+    cdef cppMinimaDatabase* newptr
+    def __cinit__(self, energy_tol=1e-6, coords_tol=0):
+        self.thisptr = shared_ptr[cppAction](<cppAction*> new cppMinimaDatabase(energy_tol, coords_tol))
+        self.newptr = <cppMinimaDatabase*> self.thisptr.get()
+
+    def __len__(self):
+        return self.newptr.size()
+
+    @cython.boundscheck(False)
+    @cython.wraparound(False)
+    def get_energies(self):
+        """energies of the distinct minima, in increasing order"""
+        cdef _pele.Array[double] energiesi = self.newptr.get_energies()
+        cdef double *energiesdata = energiesi.data()
+        cdef np.ndarray[double, ndim=1, mode="c"] energies = np.zeros(energiesi.size())
+        cdef size_t i
+        for i in xrange(energiesi.size()):
+            energies[i] = energiesdata[i]
+        return energies
+
+    @cython.boundscheck(False)
+    @cython.wraparound(False)
+    def get_counts(self):
+        """number of times each minimum was found"""
+        cdef _pele.Array[double] countsi = self.newptr.get_counts()
+        cdef double *countsdata = countsi.data()
+        cdef np.ndarray[double, ndim=1, mode="c"] counts = np.zeros(countsi.size())
+        cdef size_t i
+        for i in xrange(countsi.size()):
+            counts[i] = countsdata[i]
+        return counts
+
+    @cython.boundscheck(False)
+    @cython.wraparound(False)
+    def get_minimum(self, i):
+        """coordinates of the first occurrence of minimum i"""
+        cdef _pele.Array[double] coordsi = self.newptr.get_minimum(i)
+        cdef double *coordsdata = coordsi.data()
+        cdef np.ndarray[double, ndim=1, mode="c"] coords = np.zeros(coordsi.size())
+        cdef size_t j
+        for j in xrange(coordsi.size()):
+            coords[j] = coordsdata[j]
+        return coords
+
+    def get_first_step(self, i):
+        """MC step at which minimum i was first found"""
+        return self.newptr.get_first_step(i)
+
+    def clear(self):
+        self.newptr.clear()
+
+class MinimaDatabase(_Cdef_MinimaDatabase):
+    """Distinct minima, kept sorted by energy
     
+    This class is the Python interface for the c++ mcpele::MinimaDatabase
+    :class:`Action` class implementation, usually added to a :class:`QuenchPool`.
+    Two minima are the same if their energies differ by at most ``energy_tol``
+    and, if ``coords_tol`` is positive, their coordinates are at most ``coords_tol``
+    apart. By default minima are told apart by energy alone, so distinct minima
+    with (nearly) the same energy are merged. The distance is not minimised over
+    translations, rotations, permutations or periodic images: with ``coords_tol``
+    such equivalent copies of a minimum are counted as distinct minima.
+    The coordinates and step of the first occurrence and the number of occurrences
+    are stored for each distinct minimum.
+    
+    Parameters
+    ----------
+    energy_tol : double (optional)
+        energy tolerance below which two minima are the same
+    coords_tol : double (optional)
+        Euclidean distance below which two minima of the same energy are the same,
+        0 to compare energies only
+    """
+
 #===============================================================================
 # RecordLowestEValueTimeseries
 #===============================================================================
         
 cdef class _Cdef_RecordLowestEValueTimeseries(_Cdef_Action):
     cdef cppRecordScalarTimeseries* newptr
+    cdef cppRecordLowestEValueTimeseries* newptr2
     cdef ranvec
     def __cinit__(self, niter, record_every, _pele.BasePotential landscape_potential, boxdimension,
-                  ranvec, lbfgsniter):
+                  ranvec, lbfgsniter, warm_start=False, use_lanczos=False, tol=1e-6):
         cdef np.ndarray[double, ndim=1] ranvecc = ranvec
         self.thisptr = shared_ptr[cppAction](<cppAction*> new 
                  cppRecordLowestEValueTimeseries(niter, record_every,
                                                      landscape_potential.thisptr, boxdimension,
-                                                     _pele.Array[double](<double*> ranvecc.data, ranvecc.size), lbfgsniter))
+                                                     _pele.Array[double](<double*> ranvecc.data, ranvecc.size), lbfgsniter,
+                                                     warm_start, use_lanczos, tol))
         self.newptr = <cppRecordScalarTimeseries*> self.thisptr.get()
+        self.newptr2 = <cppRecordLowestEValueTimeseries*> self.thisptr.get()
+    
+    def get_last_niter(self):
+        """solver iterations used for the last eigenvalue"""
+        return self.newptr2.get_last_niter()
+    
+    def get_total_niter(self):
+        """solver iterations used for all eigenvalues"""
+        return self.newptr2.get_total_niter()
+    
+    def get_nr_computations(self):
+        return self.newptr2.get_nr_computations()
         
     @cython.boundscheck(False)
     @cython.wraparound(False)
@@ -335,7 +1044,17 @@ class RecordLowestEValueTimeseries(_Cdef_RecordLowestEValueTimeseries):
         random vector of length equal to the number of degrees of freedom [len(coords)],
         required by the Gram-Schmidt orthogonalisation procedure
     lbfgsniter : int
-        maximum number of steps for the LBFG-S minimisation of the Rayleigh quotient
+        maximum number of steps for the LBFG-S minimisation of the Rayleigh quotient,
+        or of Lanczos iterations
+    warm_start : bool (optional)
+        start each computation from the eigenvector found by the previous one, instead
+        of ``ranvec``; consecutive configurations are similar, so this saves iterations
+    use_lanczos : bool (optional)
+        use the Lanczos method, with Hessian-vector products from finite differences of
+        the gradient, instead of minimising the Rayleigh quotient
+    tol : float (optional)
+        convergence tolerance of the Lanczos iterations, relative to the estimated
+        norm of the Hessian; ignored unless ``use_lanczos`` is set
     """
     
 #===============================================================================
@@ -345,12 +1064,22 @@ class RecordLowestEValueTimeseries(_Cdef_RecordLowestEValueTimeseries):
 cdef class _Cdef_RecordDisplacementPerParticleTimeseries(_Cdef_Action):
     cdef cppRecordScalarTimeseries* newptr
     cdef initial_coords
-    def __cinit__(self, niter, record_every, initial_coords, boxdimension):
+    cdef public object tracker
+    def __cinit__(self, niter, record_every, initial_coords, boxdimension, _Cdef_PeriodicImageTracker tracker=None):
         cdef np.ndarray[double, ndim=1] initialc = initial_coords
-        self.thisptr = shared_ptr[cppAction](<cppAction*> new 
-                 cppRecordDisplacementPerParticleTimeseries(niter, record_every,
-                                                            _pele.Array[double](<double*> initialc.data, initialc.size), 
-                                                            boxdimension))
+        if tracker is None:
+            self.thisptr = shared_ptr[cppAction](<cppAction*> new 
+                     cppRecordDisplacementPerParticleTimeseries(niter, record_every,
+                                                                _pele.Array[double](<double*> initialc.data, initialc.size), 
+                                                                boxdimension))
+        else:
+            if tracker.get_ndim() != boxdimension:
+                raise ValueError("RecordDisplacementPerParticleTimeseries: boxdimension differs from the tracker's")
+            self.thisptr = shared_ptr[cppAction](<cppAction*> new 
+                     cppRecordDisplacementPerParticleTimeseries(niter, record_every,
+                                                                _pele.Array[double](<double*> initialc.data, initialc.size), 
+                                                                tracker.thisptr))
+        self.tracker = tracker
         self.newptr = <cppRecordScalarTimeseries*> self.thisptr.get()
         
     @cython.boundscheck(False)
@@ -395,12 +1124,123 @@ class RecordDisplacementPerParticleTimeseries(_Cdef_RecordDisplacementPerParticl
         initial system coordinates, used to compute rms distance
     boxdimension: int
         dimensionality of the space (dimensionality of box)
+    tracker : :class:`PeriodicImageTracker` (optional)
+        image tracker of a periodic take step, e.g. from
+        :func:`RandomCoordsDisplacementPeriodicAll.get_image_tracker`; the displacement
+        is then computed from the unwrapped coordinates
+    """
+
+#===============================================================================
+# RecordDisplacementCorrelation
+#===============================================================================
+
+cdef class _Cdef_RecordDisplacementCorrelation(_Cdef_Action):
+    cdef cppRecordDisplacementCorrelation* newptr
+    cdef public object tracker
+    def __cinit__(self, record_every, eqsteps, boxdimension, wavenumber=0, nr_lags=16,
+                  _Cdef_PeriodicImageTracker tracker=None):
+        if tracker is None:
+            self.thisptr = shared_ptr[cppAction](<cppAction*> new cppRecordDisplacementCorrelation(record_every, eqsteps, boxdimension, wavenumber, nr_lags))
+        else:
+            if tracker.get_ndim() != boxdimension:
+                raise ValueError("RecordDisplacementCorrelation: boxdimension differs from the tracker's")
+            self.thisptr = shared_ptr[cppAction](<cppAction*> new cppRecordDisplacementCorrelation(record_every, eqsteps, tracker.thisptr, wavenumber, nr_lags))
+        self.tracker = tracker
+        self.newptr = <cppRecordDisplacementCorrelation*> self.thisptr.get()
+
+    @cython.boundscheck(False)
+    @cython.wraparound(False)
+    def get_lags(self):
+        """get the lags, in MC steps"""
+        cdef _pele.Array[double] lagsi = self.newptr.get_lags()
+        cdef double *lagsdata = lagsi.data()
+        cdef np.ndarray[double, ndim=1, mode="c"] lags = np.zeros(lagsi.size())
+        cdef size_t i
+        for i in xrange(lagsi.size()):
+            lags[i] = lagsdata[i]
+        return lags
+
+    @cython.boundscheck(False)
+    @cython.wraparound(False)
+    def get_mean_square_displacement(self):
+        """get the mean square displacement per particle at the lags of :meth:`get_lags`"""
+        cdef _pele.Array[double] msdi = self.newptr.get_mean_square_displacement()
+        cdef double *msddata = msdi.data()
+        cdef np.ndarray[double, ndim=1, mode="c"] msd = np.zeros(msdi.size())
+        cdef size_t i
+        for i in xrange(msdi.size()):
+            msd[i] = msddata[i]
+        return msd
+
+    @cython.boundscheck(False)
+    @cython.wraparound(False)
+    def get_self_intermediate_scattering(self):
+        """get the self intermediate scattering function at the lags of :meth:`get_lags`"""
+        cdef _pele.Array[double] fsi = self.newptr.get_self_intermediate_scattering()
+        cdef double *fsdata = fsi.data()
+        cdef np.ndarray[double, ndim=1, mode="c"] fs = np.zeros(fsi.size())
+        cdef size_t i
+        for i in xrange(fsi.size()):
+            fs[i] = fsdata[i]
+        return fs
+
+    @cython.boundscheck(False)
+    @cython.wraparound(False)
+    def get_nr_origins(self):
+        """get the number of time origins averaged at each lag"""
+        cdef _pele.Array[double] nr_originsi = self.newptr.get_nr_origins()
+        cdef double *nr_originsdata = nr_originsi.data()
+        cdef np.ndarray[double, ndim=1, mode="c"] nr_origins = np.zeros(nr_originsi.size())
+        cdef size_t i
+        for i in xrange(nr_originsi.size()):
+            nr_origins[i] = nr_originsdata[i]
+        return nr_origins
+
+    def get_count(self):
+        return self.newptr.get_count()
+
+    def get_nr_levels(self):
+        return self.newptr.get_nr_levels()
+
+    def clear(self):
+        """reset the correlator"""
+        self.newptr.clear()
+
+class RecordDisplacementCorrelation(_Cdef_RecordDisplacementCorrelation):
+    """Record the multi-origin mean square displacement on the fly
+    
+    This class is the Python interface for the c++ mcpele::RecordDisplacementCorrelation
+    :class:`Action` class implementation. Configurations are kept in multi-tau
+    levels, so that the lags are logarithmically spaced, every configuration is
+    a time origin at its level and memory grows as O(ndof log T) instead of
+    storing the trajectory. The self intermediate scattering function is
+    averaged over wave vectors of length ``wavenumber`` along the axes.
+    
+    Parameters
+    ----------
+    record_every : int
+        interval every which the coordinates are recorded
+    eqsteps : int
+        number of equilibration steps to be skipped
+    boxdimension : int
+        dimensionality of the space
+    wavenumber : double (optional)
+        wavenumber of the self intermediate scattering function, 0 to skip it
+    nr_lags : int (optional)
+        number of lags per level of the correlator, even
+    tracker : :class:`PeriodicImageTracker` (optional)
+        image tracker of a periodic take step, e.g. from
+        :func:`RandomCoordsDisplacementPeriodicAll.get_image_tracker`; the displacements
+        are then computed from the unwrapped coordinates
     """
 
 cdef class _Cdef_RecordCoordsTimeseries(_Cdef_Action):
     cdef cppRecordVectorTimeseries* newptr
     cdef cppRecordCoordsTimeseries* newptr2
+    cdef public object mapped_filename
+    cdef public size_t ndof
     def __cinit__(self, ndof, record_every=1, eqsteps=0):
+        self.ndof = ndof
         self.thisptr = shared_ptr[cppAction](<cppAction*> new cppRecordCoordsTimeseries(ndof, record_every, eqsteps))
         self.newptr = <cppRecordVectorTimeseries*> self.thisptr.get()
         self.newptr2 = <cppRecordCoordsTimeseries*> self.thisptr.get()
@@ -410,20 +1250,63 @@ cdef class _Cdef_RecordCoordsTimeseries(_Cdef_Action):
     def get_time_series(self):
         """get a trajectory
         
+        The recorded coordinates are moved into one contiguous block (if they
+        are not already) and returned without a further copy. The returned
+        array shares memory with the recorder: it stays valid after
+        :func:`clear` or further recording, but should be treated as read only.
+        
         Returns
         -------
         numpy.array
-            deque of arrays
+            array of shape (number of records, ndof)
         """
-        cdef deque[_pele.Array[double]] dq = self.newptr.get_time_series()
-        cdef double *seriesdata
-        cdef np.ndarray[double, ndim=2, mode="c"] series = np.zeros((dq.size(), dq[0].size()))
-        cdef size_t i, j
-        for i in xrange(dq.size()):
-            seriesdata = dq[i].data()
-            for j in xrange(dq[i].size()):
-                series[i][j] = seriesdata[j]
-        return series
+        if self.newptr.is_mapped():
+            self.newptr.flush_file()
+            if self.newptr.get_arena().size() == 0:
+                if not self.newptr.is_file_created():
+                    # the file is created at the first record
+                    return np.zeros((0, self.ndof))
+                return np.load(self.mapped_filename, mmap_mode="r")
+        if self.newptr.get_arena().size() == 0:
+            return np.zeros((0, self.ndof))
+        self.newptr.get_arena().compact()
+        return _arena_block_view(self.newptr.get_arena().get_chunk(0),
+                                 self.newptr.get_arena().size(),
+                                 self.newptr.get_arena().row_size())
+    
+    def map_to_file(self, filename, flush_every=1024):
+        """append the trajectory to a memory mapped .npy file from now on
+        
+        The file is created at the next record, and the coordinates recorded
+        so far are moved to it. It can be read while the simulation runs with
+        ``numpy.load(filename, mmap_mode="r")``; it contains the coordinates
+        up to the last flush, every ``flush_every`` records.
+        :func:`get_time_series` then returns such a read only memory map.
+        """
+        if not isinstance(filename, bytes):
+            filename = filename.encode()
+        self.newptr.map_to_file(filename, flush_every)
+        self.mapped_filename = filename
+    
+    def flush_file(self):
+        """update the memory mapped file with all coordinates recorded so far"""
+        self.newptr.flush_file()
+    
+    def get_time_series_chunks(self):
+        """get the trajectory as it is stored, without copying any data
+        
+        Returns
+        -------
+        list of numpy.array
+            consecutive blocks of records, each of shape (number of records, ndof)
+        """
+        cdef size_t i
+        chunks = []
+        for i in xrange(self.newptr.get_arena().get_nr_chunks()):
+            chunks.append(_arena_block_view(self.newptr.get_arena().get_chunk(i),
+                                            self.newptr.get_arena().get_chunk_nr_rows(i),
+                                            self.newptr.get_arena().row_size()))
+        return chunks
     
     @cython.boundscheck(False)
     @cython.wraparound(False)
@@ -482,3 +1365,426 @@ class RecordCoordsTimeseries(_Cdef_RecordCoordsTimeseries):
     eqsteps : int
         number of equilibration steps to skip when computing averages
     """
+
+#===============================================================================
+# Wang-Landau
+#===============================================================================
+
+cdef class _Cdef_RecordWangLandau(_Cdef_Action):
+    cdef cppRecordWangLandau* newptr
+    def __cinit__(self, min, max, bin, flatness=0.8, check_every=1000, lnf_initial=1, lnf_final=1e-8):
+        self.thisptr = shared_ptr[cppAction](<cppAction*> new cppRecordWangLandau(min, max, bin, flatness,
+                                                                                 check_every, lnf_initial, lnf_final))
+        self.newptr = <cppRecordWangLandau*> self.thisptr.get()
+
+    @cython.boundscheck(False)
+    @cython.wraparound(False)
+    def get_energies(self):
+        """get the energies of the bin centres"""
+        cdef _pele.Array[double] energiesi = self.newptr.get_energies()
+        cdef double *energiesdata = energiesi.data()
+        cdef np.ndarray[double, ndim=1, mode="c"] energies = np.zeros(energiesi.size())
+        cdef size_t i
+        for i in xrange(energiesi.size()):
+            energies[i] = energiesdata[i]
+        return energies
+
+    @cython.boundscheck(False)
+    @cython.wraparound(False)
+    def get_log_density_of_states(self):
+        """get ln g(E), zero at its minimum and -inf in bins that were never visited"""
+        cdef _pele.Array[double] lngi = self.newptr.get_log_density_of_states()
+        cdef double *lngdata = lngi.data()
+        cdef np.ndarray[double, ndim=1, mode="c"] lng = np.zeros(lngi.size())
+        cdef size_t i
+        for i in xrange(lngi.size()):
+            lng[i] = lngdata[i]
+        return lng
+
+    @cython.boundscheck(False)
+    @cython.wraparound(False)
+    def get_histogram(self):
+        """get the visits since the last reduction of ln f"""
+        cdef _pele.Array[double] histi = self.newptr.get_histogram()
+        cdef double *histdata = histi.data()
+        cdef np.ndarray[double, ndim=1, mode="c"] hist = np.zeros(histi.size())
+        cdef size_t i
+        for i in xrange(histi.size()):
+            hist[i] = histdata[i]
+        return hist
+
+    def merge(self, _Cdef_RecordWangLandau other):
+        """join the density of states of another window on the same grid
+        
+        the window is extended to cover both, and the ln g of ``other`` is shifted
+        to match this one over the bins visited by both
+        """
+        self.newptr.merge(other.newptr[0])
+
+    def is_flat(self):
+        return self.newptr.is_flat()
+
+    def is_converged(self):
+        return self.newptr.is_converged()
+
+    def is_one_over_t(self):
+        """True once ln f follows the 1/t schedule"""
+        return self.newptr.is_one_over_t()
+
+    def get_lnf(self):
+        return self.newptr.get_lnf()
+
+    def get_nr_updates(self):
+        return self.newptr.get_nr_updates()
+
+    def get_nr_stages(self):
+        """number of times ln f was halved"""
+        return self.newptr.get_nr_stages()
+
+    def get_bounds(self):
+        return self.newptr.min(), self.newptr.max()
+
+class RecordWangLandau(_Cdef_RecordWangLandau):
+    """Wang-Landau estimate of the density of states
+    
+    This class is the Python interface for the c++ mcpele::RecordWangLandau
+    :class:`Action` class implementation, to be used with :class:`WangLandauTest`.
+    Every step ln g of the current energy bin is increased by ln f. ln f is halved
+    whenever the visit histogram is flat, until it drops below 1/t (t being the
+    number of steps per bin), after which ln f = 1/t. Energy windows on the same
+    grid can be sampled by independent walkers and joined with :func:`merge`.
+    
+    Parameters
+    ----------
+    min : double
+        lower bound of the energy window
+    max : double
+        upper bound of the energy window
+    bin : double
+        width of the energy bins
+    flatness : double (optional)
+        the histogram is flat if every visited bin has at least ``flatness``
+        times the mean number of visits
+    check_every : int (optional)
+        interval every which the flatness is checked
+    lnf_initial : double (optional)
+        initial modification factor ln f
+    lnf_final : double (optional)
+        the run has converged once ln f is below ``lnf_final``, see
+        :class:`StopWangLandau`
+    """
+
+cdef class _Cdef_WangLandauTest(_Cdef_AcceptTest):
+    cdef cppWangLandauTest* newptr
+    cdef object dos
+    def __cinit__(self, _Cdef_RecordWangLandau dos, rseed):
+        self.dos = dos
+        self.thisptr = shared_ptr[cppAcceptTest](<cppAcceptTest*> new cppWangLandauTest(
+                static_pointer_cast[cppRecordWangLandau, cppAction](dos.thisptr), rseed))
+        self.newptr = <cppWangLandauTest*> self.thisptr.get()
+
+    def get_seed(self):
+        return self.newptr.get_seed()
+
+    def set_generator_seed(self, input):
+        self.newptr.set_generator_seed(input)
+
+class WangLandauTest(_Cdef_WangLandauTest):
+    """Wang-Landau acceptance criterion
+    
+    This class is the Python interface for the c++ mcpele::WangLandauTest
+    acceptance test class implementation. Each move is accepted with probability
+    
+    .. math:: P( x_{old} \Rightarrow x_{new}) = min \{ 1, g(E_{old}) / g(E_{new}) \}
+    
+    with the current estimate of g of a :class:`RecordWangLandau`; moves out of its
+    energy window are rejected. The temperature is not used.
+    
+    Parameters
+    ----------
+    dos : :class:`RecordWangLandau`
+        density of states action, also added to the MC runner
+    rseed : int
+        random number generator seed
+    """
+
+#===============================================================================
+# Tabulated bias
+#===============================================================================
+
+cdef class _Cdef_CollectiveVariable(object):
+    cdef shared_ptr[cppCollectiveVariable] thisptr
+
+cdef class _Cdef_EnergyCollectiveVariable(_Cdef_CollectiveVariable):
+    def __cinit__(self):
+        self.thisptr = shared_ptr[cppCollectiveVariable](<cppCollectiveVariable*> new cppEnergyCollectiveVariable())
+
+class EnergyCollectiveVariable(_Cdef_EnergyCollectiveVariable):
+    """The energy as collective variable, e.g. for multicanonical sampling"""
+
+cdef class _Cdef_ProjectionCollectiveVariable(_Cdef_CollectiveVariable):
+    def __cinit__(self, direction):
+        cdef np.ndarray[double, ndim=1] directionc = np.array(direction, dtype=float)
+        self.thisptr = shared_ptr[cppCollectiveVariable](<cppCollectiveVariable*> new cppProjectionCollectiveVariable(
+                _pele.Array[double](<double*> directionc.data, directionc.size)))
+
+class ProjectionCollectiveVariable(_Cdef_ProjectionCollectiveVariable):
+    """The projection of the coordinates onto ``direction`` as collective variable
+    
+    Parameters
+    ----------
+    direction : numpy.array
+        one entry per degree of freedom, e.g. a unit vector to select one coordinate
+    """
+
+cdef class _Cdef_TabulatedBias(object):
+    cdef shared_ptr[cppTabulatedBias] thisptr
+    cdef cppTabulatedBias* newptr
+    cdef object cv
+    def __cinit__(self, _Cdef_CollectiveVariable cv, min, max, nr_nodes, log_weights=None):
+        cdef np.ndarray[double, ndim=1] log_weightsc = np.zeros(nr_nodes) if log_weights is None else np.array(log_weights, dtype=float)
+        self.thisptr = shared_ptr[cppTabulatedBias](new cppTabulatedBias(cv.thisptr, min, max, nr_nodes,
+                _pele.Array[double](<double*> log_weightsc.data, log_weightsc.size)))
+        self.newptr = self.thisptr.get()
+        self.cv = cv
+
+    @cython.boundscheck(False)
+    @cython.wraparound(False)
+    def get_nodes(self):
+        """get the values of the collective variable at the nodes"""
+        cdef _pele.Array[double] nodesi = self.newptr.get_nodes()
+        cdef double *nodesdata = nodesi.data()
+        cdef np.ndarray[double, ndim=1, mode="c"] nodes = np.zeros(nodesi.size())
+        cdef size_t i
+        for i in xrange(nodesi.size()):
+            nodes[i] = nodesdata[i]
+        return nodes
+
+    @cython.boundscheck(False)
+    @cython.wraparound(False)
+    def get_log_weights(self):
+        """get ln w at the nodes"""
+        cdef _pele.Array[double] log_weightsi = self.newptr.get_log_weights()
+        cdef double *log_weightsdata = log_weightsi.data()
+        cdef np.ndarray[double, ndim=1, mode="c"] log_weights = np.zeros(log_weightsi.size())
+        cdef size_t i
+        for i in xrange(log_weightsi.size()):
+            log_weights[i] = log_weightsdata[i]
+        return log_weights
+
+    def set_log_weights(self, log_weights):
+        cdef np.ndarray[double, ndim=1] log_weightsc = np.array(log_weights, dtype=float)
+        self.newptr.set_log_weights(_pele.Array[double](<double*> log_weightsc.data, log_weightsc.size))
+
+    def get_log_weight(self, s):
+        """get the interpolated ln w(s), s must be in range"""
+        if not self.newptr.in_range(s):
+            raise ValueError("s out of the range of the table")
+        return self.newptr.get_log_weight(s)
+
+class TabulatedBias(_Cdef_TabulatedBias):
+    """Bias ln w(s) on a collective variable s, tabulated at equally spaced nodes
+    
+    This class is the Python interface for the c++ mcpele::TabulatedBias. ln w is
+    linearly interpolated between the nodes. The bias is shared by a
+    :class:`TabulatedBiasTest` and optionally a :class:`RefineTabulatedBias`.
+    
+    Parameters
+    ----------
+    cv : :class:`EnergyCollectiveVariable` or :class:`ProjectionCollectiveVariable`
+        collective variable
+    min : double
+        value of s at the first node
+    max : double
+        value of s at the last node
+    nr_nodes : int
+        number of nodes, at least 2
+    log_weights : numpy.array (optional)
+        ln w at the nodes, zero by default
+    """
+
+cdef class _Cdef_TabulatedBiasTest(_Cdef_AcceptTest):
+    cdef cppTabulatedBiasTest* newptr
+    cdef object bias
+    def __cinit__(self, _Cdef_TabulatedBias bias, rseed):
+        self.bias = bias
+        self.thisptr = shared_ptr[cppAcceptTest](<cppAcceptTest*> new cppTabulatedBiasTest(bias.thisptr, rseed))
+        self.newptr = <cppTabulatedBiasTest*> self.thisptr.get()
+
+    def get_seed(self):
+        return self.newptr.get_seed()
+
+    def set_generator_seed(self, input):
+        self.newptr.set_generator_seed(input)
+
+class TabulatedBiasTest(_Cdef_TabulatedBiasTest):
+    """Acceptance criterion for a tabulated bias
+    
+    This class is the Python interface for the c++ mcpele::TabulatedBiasTest
+    acceptance test class implementation. Each move is accepted with probability
+    
+    .. math:: P( x_{old} \Rightarrow x_{new}) = min \{ 1, w(s_{new}) / w(s_{old}) \}
+    
+    and moves out of the range of the table are rejected. Together with a
+    :class:`MetropolisTest` this is umbrella sampling of :math:`\exp(-E / T) w(s)`;
+    alone, with the energy as collective variable, it is a multicanonical sampler.
+    
+    Parameters
+    ----------
+    bias : :class:`TabulatedBias`
+        the bias
+    rseed : int
+        random number generator seed
+    """
+
+cdef class _Cdef_RefineTabulatedBias(_Cdef_Action):
+    cdef cppRefineTabulatedBias* newptr
+    cdef object bias
+    def __cinit__(self, _Cdef_TabulatedBias bias, refine_every, eqsteps=0, flatness=0.8):
+        self.bias = bias
+        self.thisptr = shared_ptr[cppAction](<cppAction*> new cppRefineTabulatedBias(bias.thisptr, refine_every, eqsteps, flatness))
+        self.newptr = <cppRefineTabulatedBias*> self.thisptr.get()
+
+    @cython.boundscheck(False)
+    @cython.wraparound(False)
+    def get_histogram(self):
+        """get the histogram of the collective variable at the nodes"""
+        cdef _pele.Array[double] histi = self.newptr.get_histogram()
+        cdef double *histdata = histi.data()
+        cdef np.ndarray[double, ndim=1, mode="c"] hist = np.zeros(histi.size())
+        cdef size_t i
+        for i in xrange(histi.size()):
+            hist[i] = histdata[i]
+        return hist
+
+    @cython.boundscheck(False)
+    @cython.wraparound(False)
+    def get_free_energy(self):
+        """get the unbiased free energy at the nodes, in units of the temperature"""
+        cdef _pele.Array[double] free_energyi = self.newptr.get_free_energy()
+        cdef double *free_energydata = free_energyi.data()
+        cdef np.ndarray[double, ndim=1, mode="c"] free_energy = np.zeros(free_energyi.size())
+        cdef size_t i
+        for i in xrange(free_energyi.size()):
+            free_energy[i] = free_energydata[i]
+        return free_energy
+
+    def refine(self):
+        """update the bias from the current histogram, or stop refining if it is flat"""
+        return self.newptr.refine()
+
+    def is_flat(self):
+        return self.newptr.is_flat()
+
+    def is_refining(self):
+        return self.newptr.is_refining()
+
+    def set_refining(self, refining):
+        self.newptr.set_refining(refining)
+
+    def get_nr_refinements(self):
+        return self.newptr.get_nr_refinements()
+
+    def get_count(self):
+        return self.newptr.get_count()
+
+    def clear_histogram(self):
+        self.newptr.clear_histogram()
+
+class RefineTabulatedBias(_Cdef_RefineTabulatedBias):
+    """Record the histogram of the collective variable and refine the bias
+    
+    This class is the Python interface for the c++ mcpele::RefineTabulatedBias
+    :class:`Action` class implementation. Every ``refine_every`` recorded steps the
+    bias is updated towards a flat histogram with Berg's multicanonical recursion,
+    until the histogram is flat; then the histogram keeps accumulating, and
+    :func:`get_free_energy` gives the unbiased free energy profile.
+    
+    Parameters
+    ----------
+    bias : :class:`TabulatedBias`
+        the bias, shared with a :class:`TabulatedBiasTest`
+    refine_every : int
+        number of recorded steps between refinements
+    eqsteps : int (optional)
+        number of equilibration steps to be skipped
+    flatness : double (optional)
+        the histogram is flat if every node has at least ``flatness`` times the mean
+        count
+    """
+
+#===============================================================================
+# Stop criteria
+#===============================================================================
+
+cdef class _Cdef_StopStandardError(_Cdef_StopCriterion):
+    cdef object blocking
+    def __cinit__(self, _Cdef_RecordEnergyBlocking blocking, tolerance, require_plateau=True):
+        self.blocking = blocking
+        self.thisptr = shared_ptr[cppStopCriterion](<cppStopCriterion*> new cppStopStandardError(
+                static_pointer_cast[cppRecordScalarBlocking, cppAction](blocking.thisptr), tolerance, require_plateau))
+
+class StopStandardError(_Cdef_StopStandardError):
+    """Stop the MC run once the standard error of the mean energy is small enough
+
+    Parameters
+    ----------
+    blocking : :class:`RecordEnergyBlocking`
+        blocking action, also added to the MC runner
+    tolerance : double
+        the run stops once the standard error is below ``tolerance``
+    require_plateau : bool (optional)
+        if True, the blocking analysis must also have reached a plateau
+    """
+
+cdef class _Cdef_StopEffectiveSampleSize(_Cdef_StopCriterion):
+    cdef object autocorrelation
+    cdef cppStopEffectiveSampleSize* newptr
+    def __cinit__(self, _Cdef_RecordEnergyAutocorrelation autocorrelation, target):
+        self.autocorrelation = autocorrelation
+        self.thisptr = shared_ptr[cppStopCriterion](<cppStopCriterion*> new cppStopEffectiveSampleSize(
+                static_pointer_cast[cppRecordScalarAutocorrelation, cppAction](autocorrelation.thisptr), target))
+        self.newptr = <cppStopEffectiveSampleSize*> self.thisptr.get()
+
+    def get_effective_sample_size(self):
+        return self.newptr.get_effective_sample_size()
+
+class StopEffectiveSampleSize(_Cdef_StopEffectiveSampleSize):
+    """Stop the MC run once the effective sample size of the energy reaches a target
+
+    Parameters
+    ----------
+    autocorrelation : :class:`RecordEnergyAutocorrelation`
+        autocorrelation action, also added to the MC runner
+    target : double
+        number of effectively independent samples, count / (2 tau_int)
+    """
+
+cdef class _Cdef_StopWallClock(_Cdef_StopCriterion):
+    def __cinit__(self, seconds):
+        self.thisptr = shared_ptr[cppStopCriterion](<cppStopCriterion*> new cppStopWallClock(seconds))
+
+class StopWallClock(_Cdef_StopWallClock):
+    """Stop the MC run once it has taken more than ``seconds`` of wall-clock time
+
+    Parameters
+    ----------
+    seconds : double
+        wall-clock budget of each call to run
+    """
+
+cdef class _Cdef_StopWangLandau(_Cdef_StopCriterion):
+    cdef object dos
+    def __cinit__(self, _Cdef_RecordWangLandau dos):
+        self.dos = dos
+        self.thisptr = shared_ptr[cppStopCriterion](<cppStopCriterion*> new cppStopWangLandau(
+                static_pointer_cast[cppRecordWangLandau, cppAction](dos.thisptr)))
+
+class StopWangLandau(_Cdef_StopWangLandau):
+    """Stop the MC run once the ln f of a Wang-Landau run is below its ``lnf_final``
+
+    Parameters
+    ----------
+    dos : :class:`RecordWangLandau`
+        density of states action, also added to the MC runner
+    """
@@ -95,6 +95,33 @@ cdef class _Cdef_MC(_Cdef_BaseMC):
         """
         self.thisptr.get().set_takestep(takestep.thisptr)
         
+    def add_stop_criterion(self, _Cdef_StopCriterion criterion):
+        """add :class:`StopCriterion` to MCrunner
+
+        with stop criteria, :func:`run` stops as soon as one of them is
+        satisfied, see :func:`get_stop_reason`
+
+        Parameters
+        ----------
+        criterion : :class:`StopCriterion`
+            class of type :class:`StopCriterion`, constructed beforehand
+        """
+        self.thisptr.get().add_stop_criterion(criterion.thisptr)
+
+    def set_stop_check_every(self, size_t steps):
+        """set the number of steps between checks of the stop criteria"""
+        self.thisptr.get().set_stop_check_every(steps)
+
+    def get_stop_reason(self):
+        """get why the last :func:`run` ended
+
+        Returns
+        -------
+        reason : str
+            "max_iter", "aborted" or the reason given by the stop criterion
+        """
+        return self.thisptr.get().get_stop_reason().decode()
+
     def set_report_steps(self, size_t steps):
         """ set number of steps for which the MC loop should report to :class`TakeStep`
         
@@ -426,3 +453,351 @@ class _BaseMCRunner(_Cdef_MC):
         status.neval = self.get_neval()
         return status
     
+
+#===============================================================================
+# NestedSampling
+#===============================================================================
+
+cdef np.ndarray _to_numpy(_pele.Array[double] xi):
+    cdef double *xdata = xi.data()
+    cdef np.ndarray[double, ndim=1, mode="c"] x = np.zeros(xi.size())
+    cdef size_t i
+    for i in xrange(xi.size()):
+        x[i] = xdata[i]
+    return x
+
+cdef class _Cdef_NestedSampling(object):
+    cdef shared_ptr[cppNestedSampling] thisptr
+    cdef cppNestedSampling* newptr
+    cdef list walkers
+    def __cinit__(self, walkers, live_coords, nr_steps, rseed, factor=0.9,
+                  min_acceptance_ratio=0.2, max_acceptance_ratio=0.5):
+        cdef vector[shared_ptr[cppMC]] mcs
+        cdef _Cdef_BaseMC walker
+        for walker in walkers:
+            mcs.push_back(walker.thisptr)
+        cdef np.ndarray[double, ndim=1] live_coordsc = np.array(live_coords, dtype=float).ravel()
+        self.thisptr = shared_ptr[cppNestedSampling](new cppNestedSampling(mcs,
+                _pele.Array[double](<double*> live_coordsc.data, live_coordsc.size),
+                nr_steps, rseed, factor, min_acceptance_ratio, max_acceptance_ratio))
+        self.newptr = self.thisptr.get()
+        self.walkers = list(walkers)
+
+    def run(self, size_t nr_iterations):
+        """do nr_iterations iterations, each removing as many live points as there are walkers"""
+        with nogil:
+            self.newptr.run(nr_iterations)
+
+    def get_walkers(self):
+        return list(self.walkers)
+
+    def get_nr_threads(self):
+        return self.newptr.get_nr_threads()
+
+    def get_nr_live(self):
+        return self.newptr.get_nr_live()
+
+    def get_nr_iterations(self):
+        return self.newptr.get_nr_iterations()
+
+    def get_max_energy(self):
+        """get the current bound, the highest live energy"""
+        return self.newptr.get_max_energy()
+
+    def get_accepted_fraction(self):
+        return self.newptr.get_accepted_fraction()
+
+    def get_energies(self):
+        """get the energies of the removed points, in decreasing order"""
+        return _to_numpy(self.newptr.get_energies())
+
+    def get_log_volumes(self):
+        """get ln X after each removal"""
+        return _to_numpy(self.newptr.get_log_volumes())
+
+    def get_live_energies(self):
+        """get the energies of the K current live points, in the order of :func:`get_live_coords`"""
+        return _to_numpy(self.newptr.get_live_energies())
+
+    def get_live_coords(self):
+        """get the coordinates of the K current live points, one per row
+        
+        The live points are those left after the last iteration, below the energy
+        of the last removed point; they are copied, so the array can be kept while
+        the run continues.
+        """
+        cdef size_t i
+        coords = np.zeros((self.newptr.get_nr_live(), self.newptr.get_ndof()))
+        for i in xrange(self.newptr.get_nr_live()):
+            coords[i] = _to_numpy(self.newptr.get_live_coords(i))
+        return coords
+
+    def get_log_partition_function(self, temperature):
+        return self.newptr.get_log_partition_function(temperature)
+
+    def get_mean_energy(self, temperature):
+        return self.newptr.get_mean_energy(temperature)
+
+    def get_heat_capacity(self, temperature):
+        """get the configurational heat capacity, (<E^2> - <E>^2) / T^2"""
+        return self.newptr.get_heat_capacity(temperature)
+
+class NestedSampling(_Cdef_NestedSampling):
+    """Nested sampling with parallel walkers
+    
+    This class is the Python interface for the c++ mcpele::NestedSampling.
+    The K live points are shared by all walkers. Every iteration the P highest
+    energy live points, P being the number of walkers, are removed; each is
+    replaced by a copy of a randomly chosen surviving live point, decorrelated by
+    a walk of ``nr_steps`` steps below the lowest removed energy. The P walks run
+    in parallel, one thread per walker, on threads that are kept for the whole
+    run. The walkers must not call back into Python: their potentials, takesteps
+    and tests must be implemented in c++, because :func:`run` releases the GIL.
+    The step size of each walker is adjusted
+    after every walk towards an acceptance between ``min_acceptance_ratio`` and
+    ``max_acceptance_ratio``. The volume X is relative to the volume sampled by
+    the initial live points, so that
+    
+    .. math:: Z(T) = \sum_i (X_{i-1} - X_i) \exp(-E_i / T) + X_{last} / K \sum_{live} \exp(-E / T)
+    
+    is the configurational partition function divided by that volume.
+    
+    Parameters
+    ----------
+    walkers : list of MC runners
+        one per thread; they must be independent instances, each with its own
+        potential, takestep and conf tests (e.g. a :class:`CheckSphericalContainer`
+        that defines the sampled volume), and without :class:`MetropolisTest`
+    live_coords : numpy.array
+        coordinates of the K initial live points, one per row, sampled uniformly
+        from the volume of interest
+    nr_steps : int
+        number of MC steps of each walk
+    rseed : int
+        seed for the choice of the live points that are copied
+    factor : double (optional)
+        factor by which the step size is adjusted
+    min_acceptance_ratio : double (optional)
+        the step size is decreased below this acceptance
+    max_acceptance_ratio : double (optional)
+        the step size is increased above this acceptance
+    """
+
+#===============================================================================
+# BatchedMC
+#===============================================================================
+
+cdef class _Cdef_BatchedPotential(object):
+    cdef shared_ptr[cppBatchedPotential] thisptr
+
+cdef class _Cdef_BatchedNullPotential(_Cdef_BatchedPotential):
+    def __cinit__(self):
+        self.thisptr = shared_ptr[cppBatchedPotential](<cppBatchedPotential*> new cppBatchedNullPotential())
+
+class BatchedNullPotential(_Cdef_BatchedNullPotential):
+    """Batched potential whose energy is always zero, see :class:`NullPotential`
+    """
+
+cdef class _Cdef_BatchedPotentialAdaptor(_Cdef_BatchedPotential):
+    cdef public _pele.BasePotential potential
+    def __cinit__(self, _pele.BasePotential potential):
+        self.potential = potential
+        self.thisptr = shared_ptr[cppBatchedPotential](<cppBatchedPotential*> new cppBatchedPotentialAdaptor(potential.thisptr))
+
+class BatchedPotentialAdaptor(_Cdef_BatchedPotentialAdaptor):
+    """Batched potential that calls a pele potential for one walker at a time
+    
+    Parameters
+    ----------
+    potential : :class:`BasePotential <pele:pele.potentials.BasePotential>`
+        the potential of a single walker
+    """
+
+cdef class _Cdef_BatchedConfTest(object):
+    cdef shared_ptr[cppBatchedConfTest] thisptr
+
+cdef class _Cdef_BatchedConfTestAdaptor(_Cdef_BatchedConfTest):
+    cdef public _Cdef_ConfTest test
+    def __cinit__(self, _Cdef_ConfTest test):
+        self.test = test
+        self.thisptr = shared_ptr[cppBatchedConfTest](<cppBatchedConfTest*> new cppBatchedConfTestAdaptor(test.thisptr))
+
+class BatchedConfTestAdaptor(_Cdef_BatchedConfTestAdaptor):
+    """Batched conf test that calls a :class:`ConfTest` for one walker at a time
+    
+    The conf test is called without an MC runner, so it must not depend on one.
+    
+    Parameters
+    ----------
+    test : :class:`ConfTest`
+        the conf test of a single walker
+    """
+
+cdef class _Cdef_BatchedCheckSphericalContainerConfig(_Cdef_BatchedConfTest):
+    def __cinit__(self, radius):
+        self.thisptr = shared_ptr[cppBatchedConfTest](<cppBatchedConfTest*> new cppBatchedCheckSphericalContainerConfig(radius))
+
+class BatchedCheckSphericalContainerConfig(_Cdef_BatchedCheckSphericalContainerConfig):
+    """Batched :class:`CheckSphericalContainerConfig`
+    
+    Parameters
+    ----------
+    radius : double
+        radius of the spherical container, centred at the origin
+    """
+
+cdef class _Cdef_BatchedTakeStep(object):
+    cdef shared_ptr[cppBatchedTakeStep] thisptr
+
+cdef class _Cdef_BatchedRandomCoordsDisplacement(_Cdef_BatchedTakeStep):
+    cdef cppBatchedRandomCoordsDisplacement* newptr
+    def __cinit__(self, rseed=42, stepsize=1):
+        self.thisptr = shared_ptr[cppBatchedTakeStep](<cppBatchedTakeStep*> new cppBatchedRandomCoordsDisplacement(rseed, stepsize))
+        self.newptr = <cppBatchedRandomCoordsDisplacement*> self.thisptr.get()
+
+    def set_generator_seed(self, input):
+        self.newptr.set_generator_seed(input)
+
+    def get_stepsize(self):
+        return self.newptr.get_stepsize()
+
+    def set_stepsize(self, input):
+        self.newptr.set_stepsize(input)
+
+class BatchedRandomCoordsDisplacement(_Cdef_BatchedRandomCoordsDisplacement):
+    """Batched :class:`RandomCoordsDisplacement`, all coordinates of all walkers are displaced
+    
+    Parameters
+    ----------
+    rseed : pos int (optional)
+        seed for the random number generator
+    stepsize : double (optional)
+        each coordinate is displaced uniformly in [-stepsize / 2, stepsize / 2)
+    """
+
+cdef class _Cdef_BatchedUniformRectangularSampling(_Cdef_BatchedTakeStep):
+    cdef cppBatchedUniformRectangularSampling* newptr
+    def __cinit__(self, rseed=42, delta=1, np.ndarray[double, ndim=1] boxvec=None):
+        if boxvec is None:
+            boxvec = np.array([2. * delta])
+        self.thisptr = shared_ptr[cppBatchedTakeStep](<cppBatchedTakeStep*> new
+                cppBatchedUniformRectangularSampling(rseed, _pele.Array[double](<double*> boxvec.data, boxvec.size)))
+        self.newptr = <cppBatchedUniformRectangularSampling*> self.thisptr.get()
+
+    def set_generator_seed(self, input):
+        self.newptr.set_generator_seed(input)
+
+class BatchedUniformRectangularSampling(_Cdef_BatchedUniformRectangularSampling):
+    """Batched :class:`UniformRectangularSampling`
+    
+    Parameters
+    ----------
+    rseed : pos int (optional)
+        seed for the random number generator
+    delta : double (optional)
+        coordinates are sampled in a cube of side length 2 * delta
+    boxvec : numpy.array (optional)
+        side lengths of the box, instead of delta
+    """
+
+cdef class _Cdef_BatchedMC(object):
+    cdef shared_ptr[cppBatchedMC] thisptr
+    cdef cppBatchedMC* newptr
+    # these are stored so that the memory is not freed
+    cdef public object potential
+    cdef public object takestep
+    cdef public list conf_tests
+    cdef public size_t niter
+    def __cinit__(self, _Cdef_BatchedPotential potential, coords, size_t nwalkers, double temperature,
+                  size_t niter, rseed=42):
+        cdef np.ndarray[double, ndim=1] coordsc = np.array(coords, dtype=float).ravel()
+        self.thisptr = shared_ptr[cppBatchedMC](new cppBatchedMC(potential.thisptr,
+                _pele.Array[double](<double*> coordsc.data, coordsc.size), nwalkers, temperature, rseed))
+        self.newptr = self.thisptr.get()
+        self.potential = potential
+        self.takestep = None
+        self.conf_tests = []
+        self.niter = niter
+
+    def add_conf_test(self, _Cdef_BatchedConfTest test):
+        """add a batched conf test, run before the energy evaluation"""
+        self.newptr.add_conf_test(test.thisptr)
+        self.conf_tests.append(test)
+
+    def set_takestep(self, _Cdef_BatchedTakeStep takestep):
+        self.newptr.set_takestep(takestep.thisptr)
+        self.takestep = takestep
+
+    def one_iteration(self):
+        self.newptr.one_iteration()
+
+    def run(self):
+        """perform ``niter`` iterations of all walkers"""
+        self.newptr.run(self.niter)
+
+    def set_temperature(self, double T):
+        self.newptr.set_temperature(T)
+
+    def get_temperature(self):
+        return self.newptr.get_temperature()
+
+    def get_nwalkers(self):
+        return self.newptr.get_nwalkers()
+
+    def get_ndof(self):
+        return self.newptr.get_ndof()
+
+    def get_iterations_count(self):
+        return self.newptr.get_iterations_count()
+
+    def get_coords(self):
+        """get the coordinates of the walkers, one per row"""
+        cdef size_t w
+        coords = np.zeros((self.newptr.get_nwalkers(), self.newptr.get_ndof()))
+        for w in xrange(self.newptr.get_nwalkers()):
+            coords[w] = _to_numpy(self.newptr.get_coords(w))
+        return coords
+
+    def get_energies(self):
+        """get the energies of the walkers"""
+        return _to_numpy(self.newptr.get_energies())
+
+    def get_naccept(self):
+        return self.newptr.get_naccept()
+
+    def get_nconf_reject(self):
+        return self.newptr.get_nconf_reject()
+
+    def get_accepted_fraction(self):
+        """get the accepted fraction over all walkers and iterations"""
+        return self.newptr.get_accepted_fraction()
+
+    def get_conf_rejection_fraction(self):
+        return self.newptr.get_conf_rejection_fraction()
+
+class BatchedMC(_Cdef_BatchedMC):
+    """Many independent Markov chains advanced in lockstep
+    
+    This class is the Python interface for the c++ mcpele::BatchedMC. Each
+    iteration displaces all walkers, runs the conf tests, computes the trial
+    energies and applies the Metropolis test, each stage for all walkers at
+    once, which removes the per-step overhead of :class:`_BaseMCRunner` for
+    many small systems, e.g. integration-type runs with a
+    :class:`BatchedNullPotential`. Walkers whose trial configuration fails a
+    conf test or the Metropolis test keep their old configuration.
+    
+    Parameters
+    ----------
+    potential : batched potential
+        e.g. :class:`BatchedNullPotential` or :class:`BatchedPotentialAdaptor`
+    coords : numpy.array
+        initial coordinates, one walker per row (or all walkers one after the other)
+    nwalkers : int
+        number of walkers
+    temperature : double
+        temperature of the Metropolis test
+    niter : int
+        number of iterations done by :func:`run`
+    rseed : int (optional)
+        seed of the Metropolis test
+    """
@@ -4,6 +4,8 @@
 cimport pele.potentials._pele as _pele
 from pele.potentials._pele cimport shared_ptr
 from libcpp cimport bool as cbool
+from libcpp.string cimport string
+from libcpp.vector cimport vector
 
 #===============================================================================
 # mcpele::TakeStep
@@ -53,6 +55,18 @@ cdef class _Cdef_Action(object):
     """
     cdef shared_ptr[cppAction] thisptr
 
+#===============================================================================
+# mcpele::StopCriterion
+#===============================================================================
+
+cdef extern from "mcpele/mc.h" namespace "mcpele":
+    cdef cppclass cppStopCriterion "mcpele::StopCriterion"
+
+cdef class _Cdef_StopCriterion(object):
+    """This class is the python interface for the c++ mcpele::StopCriterion base class implementation
+    """
+    cdef shared_ptr[cppStopCriterion] thisptr
+
 #===============================================================================
 # mcpele::MC
 #===============================================================================
@@ -70,6 +84,9 @@ cdef extern from "mcpele/mc.h" namespace "mcpele":
         void add_conf_test(shared_ptr[cppConfTest]) except +
         void add_late_conf_test(shared_ptr[cppConfTest]) except +
         void set_takestep(shared_ptr[cppTakeStep]) except +
+        void add_stop_criterion(shared_ptr[cppStopCriterion]) except +
+        void set_stop_check_every(size_t) except +
+        string get_stop_reason() except +
         void set_coordinates(_pele.Array[double]&, double) except +
         void reset_energy() except +
         double get_energy() except +
@@ -88,6 +105,71 @@ cdef extern from "mcpele/mc.h" namespace "mcpele":
         void disable_input_warnings() except +
         cbool get_success() except+
 
+#===============================================================================
+# mcpele::NestedSampling
+#===============================================================================
+
+cdef extern from "mcpele/nested_sampling.h" namespace "mcpele":
+    cdef cppclass cppNestedSampling "mcpele::NestedSampling":
+        cppNestedSampling(vector[shared_ptr[cppMC]], _pele.Array[double], size_t, size_t, double, double, double) except +
+        void run(size_t) nogil except +
+        size_t get_nr_threads() except +
+        size_t get_nr_live() except +
+        size_t get_ndof() except +
+        size_t get_nr_iterations() except +
+        double get_max_energy() except +
+        double get_accepted_fraction() except +
+        _pele.Array[double] get_energies() except +
+        _pele.Array[double] get_log_volumes() except +
+        _pele.Array[double] get_live_energies() except +
+        _pele.Array[double] get_live_coords(size_t) except +
+        double get_log_partition_function(double) except +
+        double get_mean_energy(double) except +
+        double get_heat_capacity(double) except +
+
+#===============================================================================
+# mcpele::BatchedMC
+#===============================================================================
+
+cdef extern from "mcpele/batched_mc.h" namespace "mcpele":
+    cdef cppclass cppBatchedPotential "mcpele::BatchedPotential"
+    cdef cppclass cppBatchedConfTest "mcpele::BatchedConfTest"
+    cdef cppclass cppBatchedTakeStep "mcpele::BatchedTakeStep"
+    cdef cppclass cppBatchedPotentialAdaptor "mcpele::BatchedPotentialAdaptor":
+        cppBatchedPotentialAdaptor(shared_ptr[_pele.cBasePotential]) except +
+    cdef cppclass cppBatchedNullPotential "mcpele::BatchedNullPotential":
+        cppBatchedNullPotential() except +
+    cdef cppclass cppBatchedConfTestAdaptor "mcpele::BatchedConfTestAdaptor":
+        cppBatchedConfTestAdaptor(shared_ptr[cppConfTest]) except +
+    cdef cppclass cppBatchedCheckSphericalContainerConfig "mcpele::BatchedCheckSphericalContainerConfig":
+        cppBatchedCheckSphericalContainerConfig(double) except +
+    cdef cppclass cppBatchedRandomCoordsDisplacement "mcpele::BatchedRandomCoordsDisplacement":
+        cppBatchedRandomCoordsDisplacement(size_t, double) except +
+        void set_generator_seed(size_t) except +
+        double get_stepsize() except +
+        void set_stepsize(double) except +
+    cdef cppclass cppBatchedUniformRectangularSampling "mcpele::BatchedUniformRectangularSampling":
+        cppBatchedUniformRectangularSampling(size_t, _pele.Array[double]) except +
+        void set_generator_seed(size_t) except +
+    cdef cppclass cppBatchedMC "mcpele::BatchedMC":
+        cppBatchedMC(shared_ptr[cppBatchedPotential], _pele.Array[double], size_t, double, size_t) except +
+        void one_iteration() except +
+        void run(size_t) except +
+        void add_conf_test(shared_ptr[cppBatchedConfTest]) except +
+        void set_takestep(shared_ptr[cppBatchedTakeStep]) except +
+        void set_temperature(double) except +
+        double get_temperature() except +
+        size_t get_nwalkers() except +
+        size_t get_ndof() except +
+        size_t get_iterations_count() except +
+        _pele.Array[double] get_coords(size_t) except +
+        _pele.Array[double] get_energies() except +
+        double get_energy(size_t) except +
+        size_t get_naccept() except +
+        size_t get_nconf_reject() except +
+        double get_accepted_fraction() except +
+        double get_conf_rejection_fraction() except +
+
 cdef class _Cdef_BaseMC(object):
     """This class is the python interface for the c++ mcpele::MC base class implementation
     """
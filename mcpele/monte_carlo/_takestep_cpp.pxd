@@ -1,6 +1,22 @@
 cimport pele.potentials._pele as _pele
 from _pele_mc cimport cppTakeStep,_Cdef_TakeStep, shared_ptr
 
+cdef extern from "mcpele/periodic_image_tracker.h" namespace "mcpele":
+    cdef cppclass cppPeriodicImageTracker "mcpele::PeriodicImageTracker":
+        cppPeriodicImageTracker(_pele.Array[double]) except +
+        void update(_pele.Array[double]&) except +
+        _pele.Array[long] get_image_counts(_pele.Array[double]&) except +
+        _pele.Array[double] get_unwrapped_coords(_pele.Array[double]&) except +
+        _pele.Array[double] get_boxvec() except +
+        size_t get_ndim() except +
+
+cdef class _Cdef_PeriodicImageTracker(object):
+    """This class is the python interface for the c++ mcpele::PeriodicImageTracker,
+    shared by the periodic take steps and the displacement actions
+    """
+    cdef shared_ptr[cppPeriodicImageTracker] thisptr
+    cdef cppPeriodicImageTracker* _get(self) except NULL
+
 cdef extern from "mcpele/random_coords_displacement.h" namespace "mcpele":
     cdef cppclass cppRandomCoordsDisplacement "mcpele::RandomCoordsDisplacement":
         cppRandomCoordsDisplacement(size_t, double) except +
@@ -18,7 +34,13 @@ cdef extern from "mcpele/random_coords_displacement.h" namespace "mcpele":
         size_t get_seed() except +
         void set_generator_seed(size_t) except +
         double get_stepsize() except +
-        
+    cdef cppclass cppRandomCoordsDisplacementPeriodicAll "mcpele::RandomCoordsDisplacementPeriodicAll":
+        cppRandomCoordsDisplacementPeriodicAll(size_t, _pele.Array[double], double) except +
+        shared_ptr[cppPeriodicImageTracker] get_image_tracker() except +
+    cdef cppclass cppRandomCoordsDisplacementPeriodicSingle "mcpele::RandomCoordsDisplacementPeriodicSingle":
+        cppRandomCoordsDisplacementPeriodicSingle(size_t, size_t, _pele.Array[double], double) except +
+        shared_ptr[cppPeriodicImageTracker] get_image_tracker() except +
+
 cdef extern from "mcpele/uniform_spherical_sampling.h" namespace "mcpele":
     cdef cppclass cppUniformSphericalSampling "mcpele::UniformSphericalSampling":
         cppUniformSphericalSampling(size_t, double) except +
@@ -29,6 +51,18 @@ cdef extern from "mcpele/uniform_rectangular_sampling.h" namespace "mcpele":
         cppUniformRectangularSampling(size_t, _pele.Array[double]) except +
         void set_generator_seed(size_t) except +
 
+cdef extern from "mcpele/quasi_random_sampling.h" namespace "mcpele":
+    cdef cppclass cppQuasiRandomRectangularSampling "mcpele::QuasiRandomRectangularSampling":
+        cppQuasiRandomRectangularSampling(size_t, _pele.Array[double], size_t) except +
+        void set_generator_seed(size_t) except +
+        void skip_ahead(size_t) except +
+        size_t get_count() except +
+    cdef cppclass cppQuasiRandomSphericalSampling "mcpele::QuasiRandomSphericalSampling":
+        cppQuasiRandomSphericalSampling(size_t, double, size_t) except +
+        void set_generator_seed(size_t) except +
+        void skip_ahead(size_t) except +
+        size_t get_count() except +
+
 cdef extern from "mcpele/gaussian_coords_displacement.h" namespace "mcpele":
     cdef cppclass cppGaussianTakeStep "mcpele::GaussianTakeStep":
         cppGaussianTakeStep(size_t, double, size_t) except +
@@ -98,6 +98,194 @@ class RandomCoordsDisplacement(_Cdef_RandomCoordsDisplacement):
         dimensionality of the space (box dimensionality)
     """
 
+#===============================================================================
+# PeriodicImageTracker
+#===============================================================================
+
+cdef class _Cdef_PeriodicImageTracker(object):
+    def __cinit__(self, boxvec=None):
+        cdef np.ndarray[double, ndim=1] bv
+        # without boxvec the tracker of a take step is attached later, see _wrap_image_tracker
+        if boxvec is not None:
+            bv = np.array(boxvec, dtype=float)
+            self.thisptr = shared_ptr[cppPeriodicImageTracker](new cppPeriodicImageTracker(array_wrap_np(bv)))
+
+    cdef cppPeriodicImageTracker* _get(self) except NULL:
+        if self.thisptr.get() == NULL:
+            raise ValueError("PeriodicImageTracker: constructed without boxvec")
+        return self.thisptr.get()
+
+    def get_image_counts(self, coords):
+        """get the number of box lengths by which each coordinate has been shifted
+        
+        Parameters
+        ----------
+        coords : numpy.array
+            current (wrapped) coordinates of the MC runner
+        """
+        cdef np.ndarray[double, ndim=1] coordsc = np.array(coords, dtype=float)
+        cdef _pele.Array[double] coordsi = array_wrap_np(coordsc)
+        cdef _pele.Array[long] imagesi = self._get().get_image_counts(coordsi)
+        cdef long *imagesdata = imagesi.data()
+        cdef np.ndarray[long, ndim=1, mode="c"] images = np.zeros(imagesi.size(), dtype=np.int_)
+        cdef size_t i
+        for i in xrange(imagesi.size()):
+            images[i] = imagesdata[i]
+        return images
+
+    def get_unwrapped_coords(self, coords):
+        """get coords + images * boxvec
+        
+        Parameters
+        ----------
+        coords : numpy.array
+            current (wrapped) coordinates of the MC runner
+        """
+        cdef np.ndarray[double, ndim=1] coordsc = np.array(coords, dtype=float)
+        cdef _pele.Array[double] coordsi = array_wrap_np(coordsc)
+        cdef _pele.Array[double] unwrappedi = self._get().get_unwrapped_coords(coordsi)
+        cdef double *unwrappeddata = unwrappedi.data()
+        cdef np.ndarray[double, ndim=1, mode="c"] unwrapped = np.zeros(unwrappedi.size())
+        cdef size_t i
+        for i in xrange(unwrappedi.size()):
+            unwrapped[i] = unwrappeddata[i]
+        return unwrapped
+
+    def get_boxvec(self):
+        cdef _pele.Array[double] boxveci = self._get().get_boxvec()
+        cdef double *boxvecdata = boxveci.data()
+        cdef np.ndarray[double, ndim=1, mode="c"] boxvec = np.zeros(boxveci.size())
+        cdef size_t i
+        for i in xrange(boxveci.size()):
+            boxvec[i] = boxvecdata[i]
+        return boxvec
+
+    def get_ndim(self):
+        return self._get().get_ndim()
+
+class PeriodicImageTracker(_Cdef_PeriodicImageTracker):
+    """Count the periodic images by which the coordinates have been shifted
+    
+    This class is the Python interface for the c++ mcpele::PeriodicImageTracker.
+    The periodic take steps keep the particles inside the box centred at the origin
+    and record the shifts in their tracker, see
+    :func:`RandomCoordsDisplacementPeriodicAll.get_image_tracker`. Pass the tracker to
+    :class:`RecordDisplacementCorrelation` or
+    :class:`RecordDisplacementPerParticleTimeseries` so that they see the unwrapped
+    coordinates.
+    
+    Parameters
+    ----------
+    boxvec : numpy.array
+        side lengths of the periodic box
+    """
+
+cdef _Cdef_PeriodicImageTracker _wrap_image_tracker(shared_ptr[cppPeriodicImageTracker] ptr):
+    cdef _Cdef_PeriodicImageTracker tracker = PeriodicImageTracker()
+    tracker.thisptr = ptr
+    return tracker
+
+#===============================================================================
+# RandomCoordsDisplacementPeriodic
+#===============================================================================
+
+cdef class _Cdef_RandomCoordsDisplacementPeriodic(_Cdef_TakeStep):
+    cdef cppRandomCoordsDisplacement* newptr
+    cdef shared_ptr[cppPeriodicImageTracker] images
+
+    cdef _set_adaptive(self, report_interval, factor, min_acc_ratio, max_acc_ratio):
+        self.thisptr = shared_ptr[cppTakeStep](<cppTakeStep*> 
+               new cppAdaptiveTakeStep(shared_ptr[cppTakeStep](<cppTakeStep*> self.newptr), 
+                                       report_interval, factor, min_acc_ratio, max_acc_ratio))
+
+    def get_image_tracker(self):
+        """get the :class:`PeriodicImageTracker` that counts the shifts of this take step"""
+        return _wrap_image_tracker(self.images)
+
+    def get_seed(self):
+        return self.newptr.get_seed()
+
+    def set_generator_seed(self, input):
+        cdef inp = input
+        self.newptr.set_generator_seed(inp)
+
+    def get_count(self):
+        return self.newptr.get_count()
+
+    def get_stepsize(self):
+        return self.newptr.get_stepsize()
+
+cdef class _Cdef_RandomCoordsDisplacementPeriodicAll(_Cdef_RandomCoordsDisplacementPeriodic):
+    def __cinit__(self, rseed, boxvec, stepsize, report_interval=100, factor=0.9,
+                  min_acc_ratio=0.2, max_acc_ratio=0.5):
+        cdef np.ndarray[double, ndim=1] bv = np.array(boxvec, dtype=float)
+        cdef cppRandomCoordsDisplacementPeriodicAll* ptr = new cppRandomCoordsDisplacementPeriodicAll(rseed, array_wrap_np(bv), stepsize)
+        self.images = ptr.get_image_tracker()
+        self.newptr = <cppRandomCoordsDisplacement*> ptr
+        self._set_adaptive(report_interval, factor, min_acc_ratio, max_acc_ratio)
+
+class RandomCoordsDisplacementPeriodicAll(_Cdef_RandomCoordsDisplacementPeriodicAll):
+    """Displace all particles uniformly at random and wrap them back into a periodic box
+    
+    This class is the Python interface for the c++ RandomCoordsDisplacementPeriodicAll
+    implementation, wrapped in an adaptive step size, as :class:`RandomCoordsDisplacement`.
+    The box is centred at the origin; the number of box lengths by which each
+    coordinate has been shifted is kept by the :class:`PeriodicImageTracker` returned by
+    :func:`get_image_tracker`.
+    
+    Parameters
+    ----------
+    rseed : pos int
+        seed for the random number generator
+    boxvec : numpy.array
+        side lengths of the periodic box
+    stepsize : double
+        initial step size
+    report_interval : pos int (optional)
+        steps between step size adjustments
+    factor : double (optional)
+        factor by which the step size is adjusted
+    min_acc_ratio : double (optional)
+        the step size is decreased below this acceptance
+    max_acc_ratio : double (optional)
+        the step size is increased above this acceptance
+    """
+
+cdef class _Cdef_RandomCoordsDisplacementPeriodicSingle(_Cdef_RandomCoordsDisplacementPeriodic):
+    def __cinit__(self, rseed, nparticles, boxvec, stepsize, report_interval=100, factor=0.9,
+                  min_acc_ratio=0.2, max_acc_ratio=0.5):
+        cdef np.ndarray[double, ndim=1] bv = np.array(boxvec, dtype=float)
+        cdef cppRandomCoordsDisplacementPeriodicSingle* ptr = new cppRandomCoordsDisplacementPeriodicSingle(rseed, nparticles, array_wrap_np(bv), stepsize)
+        self.images = ptr.get_image_tracker()
+        self.newptr = <cppRandomCoordsDisplacement*> ptr
+        self._set_adaptive(report_interval, factor, min_acc_ratio, max_acc_ratio)
+
+class RandomCoordsDisplacementPeriodicSingle(_Cdef_RandomCoordsDisplacementPeriodicSingle):
+    """Displace one random particle uniformly at random and wrap it back into a periodic box
+    
+    Same as :class:`RandomCoordsDisplacementPeriodicAll`, but a single particle is
+    moved at each step.
+    
+    Parameters
+    ----------
+    rseed : pos int
+        seed for the random number generator
+    nparticles : int
+        number of particles, len(coords) / len(boxvec)
+    boxvec : numpy.array
+        side lengths of the periodic box
+    stepsize : double
+        initial step size
+    report_interval : pos int (optional)
+        steps between step size adjustments
+    factor : double (optional)
+        factor by which the step size is adjusted
+    min_acc_ratio : double (optional)
+        the step size is decreased below this acceptance
+    max_acc_ratio : double (optional)
+        the step size is increased above this acceptance
+    """
+
 #===============================================================================
 # UniformSphericalSampling
 #===============================================================================
@@ -185,6 +373,124 @@ class UniformRectangularSampling(_Cdef_UniformRectangularSampling):
         if set, sampling will be uniform in box volume
     """
 
+#===============================================================================
+# QuasiRandomRectangularSampling
+#===============================================================================
+
+cdef class _Cdef_QuasiRandomRectangularSampling(_Cdef_TakeStep):
+    cdef cppQuasiRandomRectangularSampling* newptr
+    cdef _pele.Array[double] bv
+    def __cinit__(self, rseed=42, delta=1, ndof=1, np.ndarray[double, ndim=1] boxvec=None):
+        if boxvec is None:
+            boxvec = np.array([2. * delta])
+        bv = array_wrap_np(boxvec)
+        self.thisptr = shared_ptr[cppTakeStep](<cppTakeStep*> new cppQuasiRandomRectangularSampling(rseed, bv, ndof))
+        self.newptr = <cppQuasiRandomRectangularSampling*> self.thisptr.get()
+    def set_generator_seed(self, input):
+        """sets the seed of the sequence scrambling
+        
+        Parameters
+        ----------
+        input : pos int
+            scrambling seed
+        """
+        cdef inp = input
+        self.newptr.set_generator_seed(inp)
+    def skip_ahead(self, n):
+        """skip the next ``n`` points of the sequence
+        
+        Parameters
+        ----------
+        n : pos int
+            number of points to skip
+        """
+        self.newptr.skip_ahead(n)
+    def get_count(self):
+        """get the index of the next point of the sequence
+        
+        Returns
+        -------
+        int
+            number of points drawn or skipped
+        """
+        return self.newptr.get_count()
+        
+class QuasiRandomRectangularSampling(_Cdef_QuasiRandomRectangularSampling):
+    """Sample a rectangle (prism etc.) centred at zero with a low-discrepancy
+    sequence.
+    
+    Same as :class:`UniformRectangularSampling`, but each step is a point
+    of a scrambled Halton sequence of dimension ``ndof``. For smooth
+    integrands the error decreases roughly as 1/N instead of 1/sqrt(N).
+    For parallel chunks of n samples, use the same seed and call
+    ``skip_ahead(chunk_index * n)``.
+    
+    Parameters
+    ----------
+    rseed : pos int
+        seed for the scrambling of the sequence
+    delta : double
+        half side length of cube
+    ndof : pos int
+        number of coordinates, i.e. dimension of the sequence
+    boxvec : array (optional)
+        if set, sampling will be in box volume
+    """
+
+#===============================================================================
+# QuasiRandomSphericalSampling
+#===============================================================================
+
+cdef class _Cdef_QuasiRandomSphericalSampling(_Cdef_TakeStep):
+    cdef cppQuasiRandomSphericalSampling* newptr
+    def __cinit__(self, rseed=42, radius=1, ndof=1):
+        self.thisptr = shared_ptr[cppTakeStep](<cppTakeStep*> new cppQuasiRandomSphericalSampling(rseed, radius, ndof))
+        self.newptr = <cppQuasiRandomSphericalSampling*> self.thisptr.get()
+    def set_generator_seed(self, input):
+        """sets the seed of the sequence scrambling
+        
+        Parameters
+        ----------
+        input : pos int
+            scrambling seed
+        """
+        cdef inp = input
+        self.newptr.set_generator_seed(inp)
+    def skip_ahead(self, n):
+        """skip the next ``n`` points of the sequence
+        
+        Parameters
+        ----------
+        n : pos int
+            number of points to skip
+        """
+        self.newptr.skip_ahead(n)
+    def get_count(self):
+        """get the index of the next point of the sequence
+        
+        Returns
+        -------
+        int
+            number of points drawn or skipped
+        """
+        return self.newptr.get_count()
+        
+class QuasiRandomSphericalSampling(_Cdef_QuasiRandomSphericalSampling):
+    """Sample inside N-ball with a low-discrepancy sequence.
+    
+    Same as :class:`UniformSphericalSampling`, but the normal variates are
+    obtained by Box-Muller transform of a scrambled Halton sequence.
+    
+    Parameters
+    ----------
+    rseed : pos int
+        seed for the scrambling of the sequence
+    radius : double
+        radius of ball
+    ndof : pos int
+        number of coordinates
+    """
+
 #===============================================================================
 # GaussianCoordsDisplacement
 #===============================================================================
@@ -35,7 +35,9 @@ class Metropolis_MCrunner(_BaseMCRunner):
        then you might want to add a pele::EnergyWindow test that guarantees to keep you within a specific energy range and/or 
        make the stepsize larger or you might want to re-think about your simulation. Generally you shouldn't be 
        spanning energies that differ by several orders of magnitude, if that is the case, resizable or not resizable arrays are
-       not the problem, you'd be incurring in memory issues no matter what you do, unless you write to disk at every iteration)
+       not the problem, you'd be incurring in memory issues no matter what you do, unless you write to disk at every iteration).
+       Setting sparse_histogram=True stores only the visited bins, so that memory is bounded by the number of distinct
+       energies visited rather than by the energy range.
      * NOTE: some of the modules (e.g. take step and acceptance tests) require to be seeded. Users are free to do this as they think
      * is best, here we generate a random integer in [0,i32max) where i32max is the largest signed integer, for each seed. Each module
      * has a separate rng engine, therefore it's best if each receives a different randomly sampled seed
@@ -43,7 +45,7 @@ class Metropolis_MCrunner(_BaseMCRunner):
     def __init__(self, potential, coords, temperature, stepsize, niter, 
                  hEmin=0, hEmax=100, hbinsize=0.01, radius=2.5, acceptance=0.5, 
                  adjustf=0.9, adjustf_niter=1e4, adjustf_navg=100, bdim=3, 
-                 single=False, seeds=None):
+                 single=False, seeds=None, sparse_histogram=False):
         #construct base class
         super(Metropolis_MCrunner, self).__init__(potential, coords, temperature, niter)
 
@@ -63,7 +65,9 @@ class Metropolis_MCrunner(_BaseMCRunner):
         self.metropolis = MetropolisTest(self.seeds['metropolis'])
         #construct action: energy histogram
         self.binsize = hbinsize
-        self.histogram = RecordEnergyHistogram(hEmin, hEmax, self.binsize, adjustf_niter)
+        self.sparse_histogram = sparse_histogram
+        self.histogram = RecordEnergyHistogram(hEmin, hEmax, self.binsize, adjustf_niter,
+                                               sparse=sparse_histogram)
         #set up pele:MC
         self.set_takestep(self.step)
         self.set_report_steps(adjustf_niter) #set number of iterations for which steps are adapted
@@ -80,31 +84,39 @@ class Metropolis_MCrunner(_BaseMCRunner):
         return self.step.get_stepsize()
     
     def dump_histogram(self, fname):
-        """write histogram to fname"""
-        Emin, Emax = self.histogram.get_bounds_val()
-        histl = self.histogram.get_histogram()
-        hist = np.array(histl)
-        Energies, step = np.linspace(Emin,Emax,num=len(hist),endpoint=False,retstep=True)
-        assert(abs(step - self.binsize) < self.binsize/100)
+        """write histogram to fname, only the visited bins if the histogram is sparse"""
+        Energies, hist, mean, variance = self.get_histogram()
         np.savetxt(fname, np.column_stack((Energies,hist)), delimiter='\t')
-        mean, variance = self.histogram.get_mean_variance()
         return mean, variance
     
     def get_histogram(self):
-        """returns a energy list and a histogram list"""
+        """returns a energy list and a histogram list
+        
+        with a sparse histogram only the visited bins are returned, so that the
+        whole energy range is never allocated
+        """
+        mean, variance = self.histogram.get_mean_variance()
+        if self.sparse_histogram:
+            centres, hist = self.histogram.get_occupied_bins()
+            #lower bin edges, as for the dense histogram
+            Energies = centres - 0.5 * self.binsize
+            return Energies, hist, mean, variance
         Emin, Emax = self.histogram.get_bounds_val()
         histl = self.histogram.get_histogram()
         hist = np.array(histl)
         Energies, step = np.linspace(Emin,Emax,num=len(hist),endpoint=False,retstep=True)
-        mean, variance = self.histogram.get_mean_variance()
         assert(abs(step - self.binsize) < self.binsize/100)
         return Energies, hist, mean, variance
         
     def show_histogram(self):
         """shows the histogram"""
-        hist = self.histogram.get_histogram()
-        val = [i*self.binsize for i in xrange(len(hist))]
-        plt.hist(val, weights=hist,bins=len(hist))
+        if self.sparse_histogram:
+            Energies, hist, mean, variance = self.get_histogram()
+            plt.bar(Energies, hist, width=self.binsize)
+        else:
+            hist = self.histogram.get_histogram()
+            val = [i*self.binsize for i in xrange(len(hist))]
+            plt.hist(val, weights=hist,bins=len(hist))
         plt.show()
     
 #    def print_dos_from_histogram(self,Emin=7.0,Emax=11.0):    
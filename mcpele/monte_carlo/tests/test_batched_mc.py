@@ -0,0 +1,31 @@
+from __future__ import division
+import unittest
+import numpy as np
+from mcpele.monte_carlo import BatchedMC, BatchedNullPotential
+from mcpele.monte_carlo import BatchedUniformRectangularSampling, BatchedCheckSphericalContainerConfig
+
+
+class TestBatchedMC(unittest.TestCase):
+    
+    def setUp(self):
+        self.ndim = 2
+        self.nwalkers = 50
+        self.niter = 2000
+        self.radius = 1
+        self.mc = BatchedMC(BatchedNullPotential(), np.zeros((self.nwalkers, self.ndim)),
+                            self.nwalkers, 1, self.niter)
+        self.mc.set_takestep(BatchedUniformRectangularSampling(42, self.radius))
+        self.mc.add_conf_test(BatchedCheckSphericalContainerConfig(self.radius))
+    
+    def test_compute_pi(self):
+        self.mc.run()
+        self.assertEqual(self.mc.get_iterations_count(), self.niter)
+        # the fraction of the square inside the inscribed circle
+        self.assertAlmostEqual(4 * self.mc.get_accepted_fraction(), np.pi, delta=0.02)
+        coords = self.mc.get_coords()
+        self.assertEqual(coords.shape, (self.nwalkers, self.ndim))
+        self.assertTrue(np.all(np.sum(coords ** 2, axis=1) <= self.radius ** 2))
+        self.assertEqual(self.mc.get_energies().shape, (self.nwalkers,))
+
+if __name__ == "__main__":
+    unittest.main()
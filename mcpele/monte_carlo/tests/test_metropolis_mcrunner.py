@@ -47,6 +47,21 @@ class TestMetropolisGlobal(unittest.TestCase):
         count = self.mcrunner.histogram.get_count()
         self.assertEqual(count, 1400000)
     
+    def test_sparse_histogram(self):
+        mcrunner = Metropolis_MCrunner(self.potential, self.origin, 1, self.stepsize, 1e5, hEmax = 100, 
+                                       adjustf = self.adjustf, adjustf_niter = 3e4, radius=self.radius, 
+                                       bdim=self.bdim, single=False, seeds=self.seeds, sparse_histogram=True)
+        mcrunner.run()
+        binenergy, hist, mean, variance = mcrunner.get_histogram()
+        dense = mcrunner.histogram.get_histogram()
+        Emin, Emax = mcrunner.histogram.get_bounds_val()
+        #only the visited bins, at the same lower bin edges as the dense histogram
+        self.assertGreater(len(hist), 0)
+        self.assertTrue(np.all(hist > 0))
+        self.assertEqual(np.sum(hist), np.sum(dense))
+        indices = np.rint((binenergy - Emin) / self.mcrunner.binsize).astype(int)
+        self.assertListEqual(np.ndarray.tolist(hist), np.ndarray.tolist(dense[indices]))
+    
     def test_heat_capacity_3D_com(self):
         self.bdim = 3
         self.ndim = self.natoms*self.bdim
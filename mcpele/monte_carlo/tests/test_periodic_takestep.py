@@ -0,0 +1,55 @@
+from __future__ import division
+import numpy as np
+from mcpele.monte_carlo import _BaseMCRunner, NullPotential
+from mcpele.monte_carlo import RandomCoordsDisplacementPeriodicAll, RandomCoordsDisplacementPeriodicSingle
+from mcpele.monte_carlo import PeriodicImageTracker, RecordDisplacementCorrelation
+import unittest
+
+class MC(_BaseMCRunner):
+    
+    def set_control(self, temp):
+        self.set_temperature(temp)
+
+class TestPeriodicTakeStep(unittest.TestCase):
+    
+    def setUp(self):
+        self.bdim = 2
+        self.nparticles = 5
+        self.ndim = self.nparticles * self.bdim
+        self.boxvec = np.array([2., 3.])
+        self.nr_steps = 1e4
+        self.origin = np.zeros(self.ndim)
+    
+    def check_tracker(self, step):
+        # free diffusion: every move is accepted and the particles leave the box many times
+        mc = MC(NullPotential(), self.origin, 1, self.nr_steps)
+        mc.set_takestep(step)
+        tracker = step.get_image_tracker()
+        correlation = RecordDisplacementCorrelation(10, 0, self.bdim, tracker=tracker)
+        mc.add_action(correlation)
+        mc.run()
+        coords = mc.get_coords()
+        half = np.tile(self.boxvec, self.nparticles) / 2
+        self.assertTrue(np.all(np.abs(coords) <= half))
+        images = tracker.get_image_counts(coords)
+        self.assertGreater(np.abs(images).sum(), 0)
+        unwrapped = tracker.get_unwrapped_coords(coords)
+        self.assertTrue(np.allclose(unwrapped, coords + images * np.tile(self.boxvec, self.nparticles)))
+        # the mean square displacement grows beyond the box size
+        self.assertGreater(correlation.get_mean_square_displacement().max(), np.dot(self.boxvec, self.boxvec))
+    
+    def test_all(self):
+        self.check_tracker(RandomCoordsDisplacementPeriodicAll(42, self.boxvec, 0.5))
+    
+    def test_single(self):
+        self.check_tracker(RandomCoordsDisplacementPeriodicSingle(42, self.nparticles, self.boxvec, 0.5))
+    
+    def test_tracker(self):
+        tracker = PeriodicImageTracker(self.boxvec)
+        self.assertEqual(tracker.get_ndim(), self.bdim)
+        self.assertListEqual(tracker.get_boxvec().tolist(), self.boxvec.tolist())
+        with self.assertRaises(ValueError):
+            RecordDisplacementCorrelation(10, 0, 3, tracker=tracker)
+
+if __name__ == "__main__":
+    unittest.main()
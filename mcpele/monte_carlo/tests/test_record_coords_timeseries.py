@@ -0,0 +1,41 @@
+from __future__ import division
+import os
+import tempfile
+import unittest
+import numpy as np
+from pele.potentials import Harmonic
+from mcpele.monte_carlo import Metropolis_MCrunner, RecordCoordsTimeseries
+
+
+class TestRecordCoordsTimeseries(unittest.TestCase):
+    
+    def setUp(self):
+        self.ndim = 12
+        self.record_every = 10
+        self.niter = 1000
+        origin = np.zeros(self.ndim)
+        potential = Harmonic(origin, 1, bdim=3, com=False)
+        self.mcrunner = Metropolis_MCrunner(potential, origin, 1, 1, self.niter, adjustf_niter=0,
+                                            bdim=3, seeds=dict(takestep=42, metropolis=44))
+        self.coords = RecordCoordsTimeseries(self.ndim, record_every=self.record_every)
+        self.mcrunner.add_action(self.coords)
+        fd, self.filename = tempfile.mkstemp(suffix=".npy")
+        os.close(fd)
+        os.remove(self.filename)
+    
+    def tearDown(self):
+        if os.path.exists(self.filename):
+            os.remove(self.filename)
+    
+    def test_empty(self):
+        self.assertEqual(self.coords.get_time_series().shape, (0, self.ndim))
+    
+    def test_mapped_before_first_record(self):
+        self.coords.map_to_file(self.filename)
+        self.assertFalse(os.path.exists(self.filename))
+        self.assertEqual(self.coords.get_time_series().shape, (0, self.ndim))
+        self.mcrunner.run()
+        self.assertEqual(self.coords.get_time_series().shape, (self.niter // self.record_every, self.ndim))
+
+if __name__ == "__main__":
+    unittest.main()
@@ -20,4 +20,126 @@ def read_hf5_to_2d_array(path, key):
     """
     df = pd.read_hdf(path, key)
     array = np.array(df.values)
-    return array
\ No newline at end of file
+    return array
+
+_TRAJECTORY_MAGIC = b"MCPTRAJ1"
+_FRAME_HEADER = np.dtype([("step", "<u8"), ("energy", "<f8"), ("flags", "<u4"), ("nbytes", "<u4")])
+
+def _decode_varints(payload, count):
+    """decode count zigzag encoded variable length integers from a uint8 array"""
+    payload = payload.astype(np.uint64)
+    ends = np.flatnonzero(payload < 128)
+    if ends.size != count:
+        raise IOError("corrupt compressed trajectory frame")
+    # position of each byte within its integer
+    starts = np.concatenate(([0], ends[:-1] + 1))
+    position = np.arange(payload.size) - np.repeat(starts, ends - starts + 1)
+    parts = (payload & np.uint64(0x7f)) << (np.uint64(7) * position.astype(np.uint64))
+    u = np.add.reduceat(parts, starts)
+    return (u >> np.uint64(1)).astype(np.int64) ^ -(u & np.uint64(1)).astype(np.int64)
+
+def _read_trajectory_header(data, path):
+    if data.size < 24 or data[:8].tobytes() != _TRAJECTORY_MAGIC:
+        raise IOError("%s is not a compressed trajectory" % path)
+    ndof = int(data[8:16].view("<u8")[0])
+    precision = float(data[16:24].view("<f8")[0])
+    return ndof, precision
+
+def _read_frame_header(data, offset):
+    """return the header of the frame at offset and the offset of its payload"""
+    if offset + _FRAME_HEADER.itemsize > data.size:
+        raise IOError("truncated compressed trajectory frame")
+    header = data[offset:offset + _FRAME_HEADER.itemsize].view(_FRAME_HEADER)[0]
+    offset += _FRAME_HEADER.itemsize
+    if offset + int(header["nbytes"]) > data.size:
+        raise IOError("truncated compressed trajectory frame")
+    return header, offset
+
+def iter_compressed_trajectory(path, start=0, stop=None):
+    """
+    iterate over the frames of a trajectory written by RecordCompressedTrajectory
+
+    The file is memory mapped and decoded one frame at a time, so that memory
+    does not grow with the length of the trajectory. Frames before ``start``
+    are skipped without decoding, up to the last keyframe before it.
+
+    Parameters
+    ----------
+    path : str
+        trajectory file
+    start : int, optional
+        index of the first frame
+    stop : int, optional
+        index after the last frame, the end of the file by default
+
+    Yields
+    ------
+    coords : numpy.array
+        coordinates of the frame
+    step : int
+        MC step of the frame
+    energy : float
+        energy of the frame
+    """
+    data = np.memmap(path, dtype=np.uint8, mode="r")
+    ndof, precision = _read_trajectory_header(data, path)
+    offset, index = 24, 0
+    # find the last keyframe at or before start
+    resume = (offset, index)
+    while index < start and offset < data.size:
+        header, payload = _read_frame_header(data, offset)
+        if header["flags"] & 1:
+            resume = (offset, index)
+        offset = payload + int(header["nbytes"])
+        index += 1
+    offset, index = resume
+    previous = None
+    while offset < data.size and (stop is None or index < stop):
+        header, payload = _read_frame_header(data, offset)
+        offset = payload + int(header["nbytes"])
+        values = _decode_varints(np.asarray(data[payload:offset]), ndof)
+        if header["flags"] & 1:
+            previous = values
+        elif previous is None:
+            raise IOError("first compressed trajectory frame is not a keyframe")
+        else:
+            previous = previous + values
+        if index >= start:
+            yield previous * precision, int(header["step"]), float(header["energy"])
+        index += 1
+
+def read_compressed_trajectory(path, start=0, stop=None):
+    """
+    read a trajectory written by RecordCompressedTrajectory
+
+    Only the frames in [start, stop) are kept in memory, use
+    :func:`iter_compressed_trajectory` to process long trajectories frame by frame.
+
+    Parameters
+    ----------
+    path : str
+        trajectory file
+    start : int, optional
+        index of the first frame
+    stop : int, optional
+        index after the last frame, the end of the file by default
+
+    Returns
+    -------
+    coords : numpy.array
+        coordinates of shape (number of frames, ndof)
+    steps : numpy.array
+        MC step of each frame
+    energies : numpy.array
+        energy of each frame
+    """
+    data = np.memmap(path, dtype=np.uint8, mode="r")
+    ndof, precision = _read_trajectory_header(data, path)
+    del data
+    frames, steps, energies = [], [], []
+    for coords, step, energy in iter_compressed_trajectory(path, start, stop):
+        frames.append(coords)
+        steps.append(step)
+        energies.append(energy)
+    coords = np.array(frames).reshape(len(frames), ndof)
+    return coords, np.array(steps, dtype=np.uint64), np.array(energies)
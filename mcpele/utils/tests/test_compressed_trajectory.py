@@ -0,0 +1,64 @@
+from __future__ import division
+import os
+import tempfile
+import unittest
+import numpy as np
+from pele.potentials import Harmonic
+from mcpele.monte_carlo import Metropolis_MCrunner
+from mcpele.monte_carlo import RecordCompressedTrajectory, RecordCoordsTimeseries
+from mcpele.utils import read_compressed_trajectory, iter_compressed_trajectory
+
+
+class TestCompressedTrajectory(unittest.TestCase):
+    
+    def setUp(self):
+        self.natoms = 4
+        self.bdim = 3
+        self.ndim = self.natoms * self.bdim
+        self.precision = 1e-3
+        self.record_every = 7
+        origin = np.zeros(self.ndim)
+        potential = Harmonic(origin, 1, bdim=self.bdim, com=False)
+        self.mcrunner = Metropolis_MCrunner(potential, origin, 1, 1, 1e4, adjustf_niter=0,
+                                            bdim=self.bdim, seeds=dict(takestep=42, metropolis=44))
+        fd, self.filename = tempfile.mkstemp(suffix=".traj")
+        os.close(fd)
+        # few frames between keyframes, so that frame ranges start between them
+        self.trajectory = RecordCompressedTrajectory(self.filename, self.ndim, record_every=self.record_every,
+                                                     precision=self.precision, keyframe_every=10)
+        self.coords = RecordCoordsTimeseries(self.ndim, record_every=self.record_every)
+        self.mcrunner.add_action(self.trajectory)
+        self.mcrunner.add_action(self.coords)
+        self.mcrunner.run()
+        self.trajectory.flush()
+        # the writer rounds to multiples of the precision
+        self.expected = np.round(self.coords.get_time_series() * (1 / self.precision)) * self.precision
+    
+    def tearDown(self):
+        os.remove(self.filename)
+    
+    def test_read_matches_recorded_coords(self):
+        coords, steps, energies = read_compressed_trajectory(self.filename)
+        self.assertEqual(coords.shape, self.expected.shape)
+        self.assertEqual(len(coords), self.trajectory.get_nr_frames())
+        self.assertTrue(np.array_equal(coords, self.expected))
+        self.assertTrue(np.all(steps % self.record_every == 0))
+        self.assertTrue(np.all(np.diff(steps.astype(np.int64)) == self.record_every))
+        self.assertEqual(len(energies), len(coords))
+    
+    def test_frame_range(self):
+        coords, steps, energies = read_compressed_trajectory(self.filename, 23, 58)
+        self.assertTrue(np.array_equal(coords, self.expected[23:58]))
+        all_coords, all_steps, all_energies = read_compressed_trajectory(self.filename)
+        self.assertListEqual(np.ndarray.tolist(steps), np.ndarray.tolist(all_steps[23:58]))
+        self.assertListEqual(np.ndarray.tolist(energies), np.ndarray.tolist(all_energies[23:58]))
+        coords, steps, energies = read_compressed_trajectory(self.filename, len(all_coords) + 5)
+        self.assertEqual(coords.shape, (0, self.ndim))
+    
+    def test_iterate_frames(self):
+        for i, (coords, step, energy) in enumerate(iter_compressed_trajectory(self.filename)):
+            self.assertTrue(np.array_equal(coords, self.expected[i]))
+        self.assertEqual(i + 1, len(self.expected))
+
+if __name__ == "__main__":
+    unittest.main()
@@ -87,7 +87,8 @@ depends_pele = [os.path.join(pelepath+"/source/pele", f) for f in os.listdir(pel
 # uncomment the next line to add extra optimization options
 
 include_pele_source = '-I'+ pelepath + '/source'
-extra_compile_args = [include_pele_source,'-std=c++0x',"-Wall", '-Wextra','-pedantic','-O3'] #,'-DDEBUG'
+extra_compile_args = [include_pele_source,'-std=c++0x',"-Wall", '-Wextra','-pedantic','-O3','-pthread'] #,'-DDEBUG'
+extra_link_args = ['-pthread']
 
 # note: to compile with debug on and to override extra_compile_args use, e.g.
 # OPT="-g -O2 -march=native" python setup.py ...
@@ -101,42 +102,49 @@ cxx_modules = [
               ["mcpele/monte_carlo/_pele_mc.cxx"] + include_sources_all,
               include_dirs=include_dirs,
               extra_compile_args=extra_compile_args,
+              extra_link_args=extra_link_args,
               language="c++", depends=depends_all,
               ),
     Extension("mcpele.monte_carlo._monte_carlo_cpp", 
               ["mcpele/monte_carlo/_monte_carlo_cpp.cxx"] + include_sources_all,
               include_dirs=include_dirs,
               extra_compile_args=extra_compile_args,
+              extra_link_args=extra_link_args,
               language="c++", depends=depends_all,
               ),
     Extension("mcpele.monte_carlo._takestep_cpp", 
               ["mcpele/monte_carlo/_takestep_cpp.cxx"] + include_sources_all,
               include_dirs=include_dirs,
               extra_compile_args=extra_compile_args,
+              extra_link_args=extra_link_args,
               language="c++", depends=depends_all,
               ),
     Extension("mcpele.monte_carlo._accept_test_cpp", 
               ["mcpele/monte_carlo/_accept_test_cpp.cxx"] + include_sources_all,
               include_dirs=include_dirs,
               extra_compile_args=extra_compile_args,
+              extra_link_args=extra_link_args,
               language="c++", depends=depends_all,
               ),
     Extension("mcpele.monte_carlo._conf_test_cpp", 
               ["mcpele/monte_carlo/_conf_test_cpp.cxx"] + include_sources_all,
               include_dirs=include_dirs,
               extra_compile_args=extra_compile_args,
+              extra_link_args=extra_link_args,
               language="c++", depends=depends_all,
               ),
     Extension("mcpele.monte_carlo._action_cpp", 
               ["mcpele/monte_carlo/_action_cpp.cxx"] + include_sources_all,
               include_dirs=include_dirs,
               extra_compile_args=extra_compile_args,
+              extra_link_args=extra_link_args,
               language="c++", depends=depends_all,
               ),
     Extension("mcpele.monte_carlo._nullpotential_cpp", 
               ["mcpele/monte_carlo/_nullpotential_cpp.cxx"] + include_sources_all,
               include_dirs=include_dirs,
               extra_compile_args=extra_compile_args,
+              extra_link_args=extra_link_args,
               language="c++", depends=depends_all,
               ),
                ]
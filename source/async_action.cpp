@@ -0,0 +1,152 @@
+#include "mcpele/async_action.h"
+
+using pele::Array;
+
+namespace mcpele {
+
+AsyncAction::AsyncAction(std::vector<std::shared_ptr<Action> > worker_actions, const size_t record_every,
+        const size_t eqsteps, const size_t max_queue)
+    : m_record_every(record_every),
+      m_eqsteps(eqsteps),
+      m_max_queue(max_queue ? max_queue : 2 * worker_actions.size()),
+      m_actions(worker_actions),
+      m_nr_busy(0),
+      m_nr_processed(0),
+      m_stop(false)
+{
+    if (record_every == 0) {
+        throw std::runtime_error("AsyncAction: record_every expected to be at least 1");
+    }
+    if (worker_actions.empty()) {
+        throw std::runtime_error("AsyncAction: expected at least one worker action");
+    }
+    for (auto & action : m_actions) {
+        if (!action) {
+            throw std::runtime_error("AsyncAction: worker action is NULL");
+        }
+    }
+    m_threads.reserve(m_actions.size());
+    try {
+        for (size_t i = 0; i < m_actions.size(); ++i) {
+            m_threads.push_back(std::thread(&AsyncAction::m_work, this, i));
+        }
+    }
+    catch (...) {
+        // the destructor does not run, join the workers started so far
+        m_stop_workers();
+        throw;
+    }
+}
+
+AsyncAction::~AsyncAction()
+{
+    m_stop_workers();
+}
+
+void AsyncAction::m_stop_workers()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_job_ready.notify_all();
+    for (auto & thread : m_threads) {
+        thread.join();
+    }
+}
+
+void AsyncAction::action(Array<double> &coords, double energy, bool accepted, MC* mc)
+{
+    const size_t counter = mc->get_iterations_count();
+    if (counter % m_record_every != 0 || counter <= m_eqsteps) {
+        return;
+    }
+    Job job;
+    job.energy = energy;
+    job.temperature = mc->get_temperature();
+    job.accepted = accepted;
+    job.step = counter;
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_job_done.wait(lock, [this]{ return m_queue.size() < m_max_queue || m_error; });
+        m_rethrow_error();
+        if (m_buffer_pool.empty() || m_buffer_pool.back().size() != coords.size()) {
+            job.coords = Array<double>(coords.size());
+        }
+        else {
+            job.coords = m_buffer_pool.back();
+            m_buffer_pool.pop_back();
+        }
+    }
+    // copy outside the lock, the buffer is owned by this job only
+    job.coords.assign(coords);
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_queue.push_back(job);
+    }
+    m_job_ready.notify_one();
+}
+
+void AsyncAction::m_work(const size_t iworker)
+{
+    std::unique_ptr<SnapshotMC> mc;
+    while (true) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_job_ready.wait(lock, [this]{ return m_stop || !m_queue.empty(); });
+            if (m_queue.empty()) {
+                return;
+            }
+            job = m_queue.front();
+            m_queue.pop_front();
+            ++m_nr_busy;
+        }
+        m_job_done.notify_all();
+        std::exception_ptr error;
+        try {
+            if (!mc) {
+                mc.reset(new SnapshotMC(job.coords));
+            }
+            mc->set_snapshot(job.step, job.energy, job.temperature, job.accepted);
+            m_actions[iworker]->action(job.coords, job.energy, job.accepted, mc.get());
+        }
+        catch (...) {
+            error = std::current_exception();
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            --m_nr_busy;
+            ++m_nr_processed;
+            if (error && !m_error) {
+                m_error = error;
+            }
+            m_buffer_pool.push_back(job.coords);
+        }
+        m_job_done.notify_all();
+    }
+}
+
+void AsyncAction::m_rethrow_error()
+{
+    if (m_error) {
+        std::exception_ptr error = m_error;
+        m_error = std::exception_ptr();
+        std::rethrow_exception(error);
+    }
+}
+
+void AsyncAction::flush()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_job_done.wait(lock, [this]{ return (m_queue.empty() && m_nr_busy == 0) || m_error; });
+    m_rethrow_error();
+}
+
+size_t AsyncAction::get_nr_processed()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_nr_processed;
+}
+
+} // namespace mcpele
@@ -0,0 +1,231 @@
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <stdexcept>
+
+#include "mcpele/batched_mc.h"
+
+using pele::Array;
+
+namespace mcpele {
+
+/*BatchedPotentialAdaptor*/
+
+void BatchedPotentialAdaptor::get_energies(const double* x, const size_t nwalkers,
+        const size_t ndof, const char* active, double* energies)
+{
+    if (m_walker.size() != ndof) {
+        m_walker = Array<double>(ndof);
+    }
+    for (size_t w = 0; w < nwalkers; ++w) {
+        if (not active[w]) {
+            continue;
+        }
+        for (size_t i = 0; i < ndof; ++i) {
+            m_walker[i] = x[i * nwalkers + w];
+        }
+        energies[w] = m_potential->get_energy(m_walker);
+    }
+}
+
+/*BatchedConfTestAdaptor*/
+
+void BatchedConfTestAdaptor::conf_test(const double* x, const size_t nwalkers,
+        const size_t ndof, char* result)
+{
+    if (m_walker.size() != ndof) {
+        m_walker = Array<double>(ndof);
+    }
+    for (size_t w = 0; w < nwalkers; ++w) {
+        if (not result[w]) {
+            continue;
+        }
+        for (size_t i = 0; i < ndof; ++i) {
+            m_walker[i] = x[i * nwalkers + w];
+        }
+        result[w] = m_test->conf_test(m_walker, NULL);
+    }
+}
+
+/*BatchedCheckSphericalContainerConfig*/
+
+void BatchedCheckSphericalContainerConfig::conf_test(const double* x, const size_t nwalkers,
+        const size_t ndof, char* result)
+{
+    m_r2.assign(nwalkers, 0);
+    double* r2 = m_r2.data();
+    for (size_t i = 0; i < ndof; ++i) {
+        const double* xi = x + i * nwalkers;
+        for (size_t w = 0; w < nwalkers; ++w) {
+            r2[w] += xi[w] * xi[w];
+        }
+    }
+    for (size_t w = 0; w < nwalkers; ++w) {
+        result[w] &= (r2[w] <= m_radius2);
+    }
+}
+
+/*BatchedRandomCoordsDisplacement*/
+
+void BatchedRandomCoordsDisplacement::displace(double* x, const size_t nwalkers, const size_t ndof)
+{
+    const size_t n = nwalkers * ndof;
+    m_rand.resize(n);
+    for (size_t i = 0; i < n; ++i) {
+        m_rand[i] = m_distribution(m_generator);
+    }
+    const double* rand = m_rand.data();
+    for (size_t i = 0; i < n; ++i) {
+        x[i] += rand[i] * m_stepsize;
+    }
+}
+
+/*BatchedUniformRectangularSampling*/
+
+void BatchedUniformRectangularSampling::displace(double* x, const size_t nwalkers, const size_t ndof)
+{
+    const size_t dim = m_boxvec.size();
+    if (ndof % dim) {
+        throw std::runtime_error("BatchedUniformRectangularSampling::displace: ndof incompatible with boxvec size");
+    }
+    for (size_t i = 0; i < ndof; ++i) {
+        const double boxlength = m_boxvec[i % dim];
+        double* xi = x + i * nwalkers;
+        for (size_t w = 0; w < nwalkers; ++w) {
+            xi[w] = boxlength * m_distribution(m_generator);
+        }
+    }
+}
+
+/*BatchedMC*/
+
+BatchedMC::BatchedMC(std::shared_ptr<BatchedPotential> potential, Array<double> coords,
+        const size_t nwalkers, const double temperature, const size_t rseed)
+    : m_potential(potential),
+      m_nwalkers(nwalkers),
+      m_ndof(nwalkers ? coords.size() / nwalkers : 0),
+      m_coords(coords.size()),
+      m_trial_coords(coords.size()),
+      m_energies(nwalkers),
+      m_trial_energies(nwalkers),
+      m_success(nwalkers, true),
+      m_rand(nwalkers),
+      m_accept_count(nwalkers, 0),
+      m_conf_reject_count(nwalkers, 0),
+      m_generator(rseed),
+      m_distribution(0.0, 1.0),
+      m_temperature(temperature),
+      m_nitercount(0)
+{
+    if (nwalkers == 0 || coords.size() % nwalkers || m_ndof == 0) {
+        throw std::runtime_error("BatchedMC: coords size incompatible with nwalkers");
+    }
+    // transpose to structure-of-arrays layout
+    for (size_t w = 0; w < m_nwalkers; ++w) {
+        for (size_t i = 0; i < m_ndof; ++i) {
+            m_coords[i * m_nwalkers + w] = coords[w * m_ndof + i];
+        }
+    }
+    m_compute_energies(m_coords, m_success, m_energies);
+}
+
+void BatchedMC::one_iteration()
+{
+    ++m_nitercount;
+    const size_t W = m_nwalkers;
+    std::copy(m_coords.begin(), m_coords.end(), m_trial_coords.begin());
+
+    // take a step with the trial coords
+    m_take_step->displace(m_trial_coords.data(), W, m_ndof);
+
+    // perform the configuration tests
+    std::fill(m_success.begin(), m_success.end(), true);
+    for (auto & test : m_conf_tests) {
+        test->conf_test(m_trial_coords.data(), W, m_ndof, m_success.data());
+    }
+    char* success = m_success.data();
+    for (size_t w = 0; w < W; ++w) {
+        m_conf_reject_count[w] += not success[w];
+    }
+
+    // compute the energies and perform the Metropolis test
+    m_compute_energies(m_trial_coords, m_success, m_trial_energies);
+    for (size_t w = 0; w < W; ++w) {
+        m_rand[w] = m_distribution(m_generator);
+    }
+    const double* etrial = m_trial_energies.data();
+    const double* eold = m_energies.data();
+    const double* rand = m_rand.data();
+    const double beta = 1. / m_temperature;
+    for (size_t w = 0; w < W; ++w) {
+        const double dE = etrial[w] - eold[w];
+        const bool accept = (dE <= 0) || (rand[w] <= std::exp(-dE * beta));
+        success[w] &= accept;
+    }
+
+    // copy the accepted trial coords and energies
+    for (size_t i = 0; i < m_ndof; ++i) {
+        double* x = m_coords.data() + i * W;
+        const double* xtrial = m_trial_coords.data() + i * W;
+        for (size_t w = 0; w < W; ++w) {
+            x[w] = success[w] ? xtrial[w] : x[w];
+        }
+    }
+    for (size_t w = 0; w < W; ++w) {
+        m_energies[w] = success[w] ? etrial[w] : eold[w];
+        m_accept_count[w] += success[w];
+    }
+}
+
+void BatchedMC::run(const size_t max_iter)
+{
+    if (!m_take_step) {
+        throw std::runtime_error("BatchedMC::run: takestep not set");
+    }
+    for (size_t i = 0; i < max_iter; ++i) {
+        one_iteration();
+    }
+}
+
+Array<double> BatchedMC::get_coords(const size_t walker) const
+{
+    if (walker >= m_nwalkers) {
+        throw std::runtime_error("BatchedMC::get_coords: illegal walker index");
+    }
+    Array<double> result(m_ndof);
+    for (size_t i = 0; i < m_ndof; ++i) {
+        result[i] = m_coords[i * m_nwalkers + walker];
+    }
+    return result;
+}
+
+Array<double> BatchedMC::get_energies() const
+{
+    Array<double> result(m_nwalkers);
+    std::copy(m_energies.begin(), m_energies.end(), result.data());
+    return result;
+}
+
+size_t BatchedMC::get_naccept() const
+{
+    return std::accumulate(m_accept_count.begin(), m_accept_count.end(), size_t(0));
+}
+
+size_t BatchedMC::get_nconf_reject() const
+{
+    return std::accumulate(m_conf_reject_count.begin(), m_conf_reject_count.end(), size_t(0));
+}
+
+double BatchedMC::get_accepted_fraction() const
+{
+    return static_cast<double>(get_naccept()) /
+            static_cast<double>(m_nitercount * m_nwalkers);
+}
+
+double BatchedMC::get_conf_rejection_fraction() const
+{
+    return static_cast<double>(get_nconf_reject()) /
+            static_cast<double>(m_nitercount * m_nwalkers);
+}
+
+} // namespace mcpele
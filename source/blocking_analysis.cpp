@@ -0,0 +1,121 @@
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include "mcpele/blocking_analysis.h"
+
+namespace mcpele {
+
+BlockingAnalysis::BlockingAnalysis(const size_t min_blocks)
+    : m_min_blocks(min_blocks)
+{
+    if (min_blocks < 2) {
+        throw std::runtime_error("BlockingAnalysis: min_blocks expected to be at least 2");
+    }
+}
+
+void BlockingAnalysis::clear()
+{
+    m_levels.clear();
+    m_pending.clear();
+    m_has_pending.clear();
+}
+
+void BlockingAnalysis::add(const double x)
+{
+    double value = x;
+    for (size_t level = 0; ; ++level) {
+        if (level == m_levels.size()) {
+            m_levels.push_back(Moments());
+            m_pending.push_back(0);
+            m_has_pending.push_back(false);
+        }
+        m_levels[level](value);
+        if (!m_has_pending[level]) {
+            m_pending[level] = value;
+            m_has_pending[level] = true;
+            return;
+        }
+        value = 0.5 * (m_pending[level] + value);
+        m_has_pending[level] = false;
+    }
+}
+
+size_t BlockingAnalysis::m_get_nr_levels_used() const
+{
+    size_t nr_levels = 0;
+    while (nr_levels < m_levels.size() && m_levels[nr_levels].count() >= m_min_blocks) {
+        ++nr_levels;
+    }
+    return nr_levels;
+}
+
+std::vector<double> BlockingAnalysis::get_block_sizes() const
+{
+    std::vector<double> result;
+    for (size_t level = 0; level < m_get_nr_levels_used(); ++level) {
+        result.push_back(std::ldexp(1., level));
+    }
+    return result;
+}
+
+std::vector<double> BlockingAnalysis::get_standard_errors() const
+{
+    std::vector<double> result;
+    for (size_t level = 0; level < m_get_nr_levels_used(); ++level) {
+        const Moments& mom = m_levels[level];
+        result.push_back(std::sqrt(mom.variance() / (mom.count() - 1)));
+    }
+    return result;
+}
+
+std::vector<double> BlockingAnalysis::get_standard_error_errors() const
+{
+    std::vector<double> result(get_standard_errors());
+    for (size_t level = 0; level < result.size(); ++level) {
+        result[level] /= std::sqrt(2. * (m_levels[level].count() - 1));
+    }
+    return result;
+}
+
+size_t BlockingAnalysis::m_get_plateau_level() const
+{
+    const std::vector<double> se(get_standard_errors());
+    const std::vector<double> se_error(get_standard_error_errors());
+    for (size_t level = 0; level + 1 < se.size(); ++level) {
+        if (se[level + 1] <= se[level] + se_error[level]) {
+            return level;
+        }
+    }
+    return se.size();
+}
+
+bool BlockingAnalysis::has_plateau() const
+{
+    return m_get_plateau_level() < m_get_nr_levels_used();
+}
+
+double BlockingAnalysis::get_standard_error() const
+{
+    const std::vector<double> se(get_standard_errors());
+    if (se.empty()) {
+        throw std::runtime_error("BlockingAnalysis: not enough samples");
+    }
+    const size_t plateau = m_get_plateau_level();
+    if (plateau < se.size()) {
+        return se[plateau];
+    }
+    return *std::max_element(se.begin(), se.end());
+}
+
+double BlockingAnalysis::get_statistical_inefficiency() const
+{
+    const std::vector<double> se(get_standard_errors());
+    if (se.empty() || se[0] == 0) {
+        return 1;
+    }
+    const double ratio = get_standard_error() / se[0];
+    return ratio * ratio;
+}
+
+} // namespace mcpele
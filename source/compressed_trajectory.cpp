@@ -0,0 +1,230 @@
+#include "mcpele/compressed_trajectory.h"
+
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+using pele::Array;
+
+namespace mcpele {
+
+namespace {
+
+const char trajectory_magic[8] = {'M', 'C', 'P', 'T', 'R', 'A', 'J', '1'};
+const size_t frame_header_size = 24;
+const uint32_t keyframe_flag = 1;
+
+void put_uint(std::vector<unsigned char>& buffer, uint64_t value, const size_t nbytes)
+{
+    for (size_t i = 0; i < nbytes; ++i) {
+        buffer.push_back(static_cast<unsigned char>(value & 0xff));
+        value >>= 8;
+    }
+}
+
+uint64_t get_uint(const unsigned char* data, const size_t nbytes)
+{
+    uint64_t value = 0;
+    for (size_t i = 0; i < nbytes; ++i) {
+        value |= static_cast<uint64_t>(data[i]) << (8 * i);
+    }
+    return value;
+}
+
+void put_double(std::vector<unsigned char>& buffer, const double value)
+{
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    put_uint(buffer, bits, 8);
+}
+
+double get_double(const unsigned char* data)
+{
+    const uint64_t bits = get_uint(data, 8);
+    double value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+void put_varint(std::vector<unsigned char>& buffer, const int64_t value)
+{
+    // zigzag: small negative and positive values map to small unsigned values
+    uint64_t u = (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+    while (u >= 0x80) {
+        buffer.push_back(static_cast<unsigned char>(u | 0x80));
+        u >>= 7;
+    }
+    buffer.push_back(static_cast<unsigned char>(u));
+}
+
+int64_t get_varint(const unsigned char*& data, const unsigned char* end)
+{
+    uint64_t u = 0;
+    size_t shift = 0;
+    while (true) {
+        if (data == end || shift > 63) {
+            throw std::runtime_error("CompressedTrajectoryReader: corrupt frame");
+        }
+        const unsigned char byte = *data++;
+        u |= static_cast<uint64_t>(byte & 0x7f) << shift;
+        if (byte < 0x80) {
+            break;
+        }
+        shift += 7;
+    }
+    return static_cast<int64_t>(u >> 1) ^ -static_cast<int64_t>(u & 1);
+}
+
+} // namespace
+
+CompressedTrajectoryWriter::CompressedTrajectoryWriter(const std::string& filename, const size_t ndof,
+        const double precision, const size_t keyframe_every, const size_t buffer_size)
+    : m_file(filename.c_str(), std::ios::out | std::ios::binary | std::ios::trunc),
+      m_ndof(ndof),
+      m_precision(precision),
+      m_inv_precision(1 / precision),
+      m_keyframe_every(keyframe_every),
+      m_buffer_size(buffer_size),
+      m_previous(ndof, 0),
+      m_quantized(ndof, 0),
+      m_nr_frames(0),
+      m_bytes_written(0)
+{
+    if (!m_file) {
+        throw std::runtime_error("CompressedTrajectoryWriter: cannot open " + filename);
+    }
+    if (ndof == 0) {
+        throw std::runtime_error("CompressedTrajectoryWriter: ndof expected to be at least 1");
+    }
+    if (!(precision > 0)) {
+        throw std::runtime_error("CompressedTrajectoryWriter: precision expected to be positive");
+    }
+    if (keyframe_every == 0) {
+        throw std::runtime_error("CompressedTrajectoryWriter: keyframe_every expected to be at least 1");
+    }
+    m_buffer.reserve(buffer_size + frame_header_size + 10 * ndof);
+    m_payload.reserve(10 * ndof);
+    m_buffer.insert(m_buffer.end(), trajectory_magic, trajectory_magic + 8);
+    put_uint(m_buffer, ndof, 8);
+    put_double(m_buffer, precision);
+}
+
+CompressedTrajectoryWriter::~CompressedTrajectoryWriter()
+{
+    try {
+        m_write_buffer();
+    }
+    catch (std::runtime_error& e) {
+        std::cerr << "mcpele::CompressedTrajectoryWriter: " << e.what() << std::endl;
+    }
+}
+
+void CompressedTrajectoryWriter::write_frame(const Array<double>& coords, const size_t step, const double energy)
+{
+    if (coords.size() != m_ndof) {
+        throw std::runtime_error("CompressedTrajectoryWriter::write_frame: coords size differs from ndof");
+    }
+    // quantized values are kept far from the int64 range so that differences cannot overflow
+    static const double max_quantized = 4.6e18;
+    // quantise the whole frame first, so that a coordinate out of range
+    // leaves the reference of the next delta frame untouched
+    for (size_t i = 0; i < m_ndof; ++i) {
+        const double scaled = coords[i] * m_inv_precision;
+        if (!(std::fabs(scaled) < max_quantized)) {
+            throw std::runtime_error("CompressedTrajectoryWriter::write_frame: coordinate out of range for the precision");
+        }
+        m_quantized[i] = std::llround(scaled);
+    }
+    const bool keyframe = (m_nr_frames % m_keyframe_every) == 0;
+    m_payload.clear();
+    for (size_t i = 0; i < m_ndof; ++i) {
+        put_varint(m_payload, keyframe ? m_quantized[i] : m_quantized[i] - m_previous[i]);
+    }
+    m_previous.swap(m_quantized);
+    put_uint(m_buffer, step, 8);
+    put_double(m_buffer, energy);
+    put_uint(m_buffer, keyframe ? keyframe_flag : 0, 4);
+    put_uint(m_buffer, m_payload.size(), 4);
+    m_buffer.insert(m_buffer.end(), m_payload.begin(), m_payload.end());
+    ++m_nr_frames;
+    if (m_buffer.size() >= m_buffer_size) {
+        m_write_buffer();
+    }
+}
+
+void CompressedTrajectoryWriter::m_write_buffer()
+{
+    if (m_buffer.empty()) {
+        return;
+    }
+    m_file.write(reinterpret_cast<const char*>(m_buffer.data()), m_buffer.size());
+    if (!m_file) {
+        throw std::runtime_error("CompressedTrajectoryWriter: write failed");
+    }
+    m_bytes_written += m_buffer.size();
+    m_buffer.clear();
+}
+
+void CompressedTrajectoryWriter::flush()
+{
+    m_write_buffer();
+    m_file.flush();
+}
+
+CompressedTrajectoryReader::CompressedTrajectoryReader(const std::string& filename)
+    : m_file(filename.c_str(), std::ios::in | std::ios::binary),
+      m_ndof(0),
+      m_precision(0),
+      m_nr_frames(0)
+{
+    if (!m_file) {
+        throw std::runtime_error("CompressedTrajectoryReader: cannot open " + filename);
+    }
+    unsigned char header[24];
+    m_file.read(reinterpret_cast<char*>(header), sizeof(header));
+    if (!m_file || std::memcmp(header, trajectory_magic, 8) != 0) {
+        throw std::runtime_error("CompressedTrajectoryReader: " + filename + " is not a compressed trajectory");
+    }
+    m_ndof = get_uint(header + 8, 8);
+    m_precision = get_double(header + 16);
+    m_previous.assign(m_ndof, 0);
+}
+
+bool CompressedTrajectoryReader::read_frame(Array<double> coords, size_t& step, double& energy)
+{
+    if (coords.size() != m_ndof) {
+        throw std::runtime_error("CompressedTrajectoryReader::read_frame: coords size differs from ndof");
+    }
+    unsigned char header[frame_header_size];
+    m_file.read(reinterpret_cast<char*>(header), frame_header_size);
+    if (m_file.gcount() == 0) {
+        return false;
+    }
+    if (static_cast<size_t>(m_file.gcount()) != frame_header_size) {
+        throw std::runtime_error("CompressedTrajectoryReader: truncated frame");
+    }
+    step = get_uint(header, 8);
+    energy = get_double(header + 8);
+    const bool keyframe = get_uint(header + 16, 4) & keyframe_flag;
+    const size_t nbytes = get_uint(header + 20, 4);
+    m_payload.resize(nbytes);
+    m_file.read(reinterpret_cast<char*>(m_payload.data()), nbytes);
+    if (static_cast<size_t>(m_file.gcount()) != nbytes) {
+        throw std::runtime_error("CompressedTrajectoryReader: truncated frame");
+    }
+    if (!keyframe && m_nr_frames == 0) {
+        throw std::runtime_error("CompressedTrajectoryReader: first frame is not a keyframe");
+    }
+    const unsigned char* data = m_payload.data();
+    const unsigned char* end = data + nbytes;
+    for (size_t i = 0; i < m_ndof; ++i) {
+        const int64_t value = get_varint(data, end);
+        m_previous[i] = keyframe ? value : m_previous[i] + value;
+        coords[i] = m_previous[i] * m_precision;
+    }
+    ++m_nr_frames;
+    return true;
+}
+
+} // namespace mcpele
@@ -0,0 +1,195 @@
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include "mcpele/displacement_correlator.h"
+
+namespace mcpele {
+
+namespace {
+
+/**
+ * sum of (x - y)^2, with independent partial sums so that the loop
+ * vectorises without reassociating a single accumulator
+ */
+double sum_square_difference(const double* x, const double* y, const size_t n)
+{
+    double s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        const double d0 = x[i] - y[i];
+        const double d1 = x[i + 1] - y[i + 1];
+        const double d2 = x[i + 2] - y[i + 2];
+        const double d3 = x[i + 3] - y[i + 3];
+        s0 += d0 * d0;
+        s1 += d1 * d1;
+        s2 += d2 * d2;
+        s3 += d3 * d3;
+    }
+    for (; i < n; ++i) {
+        const double d = x[i] - y[i];
+        s0 += d * d;
+    }
+    return (s0 + s1) + (s2 + s3);
+}
+
+double sum_cos_difference(const double* x, const double* y, const size_t n, const double q)
+{
+    double s0 = 0, s1 = 0;
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        s0 += std::cos(q * (x[i] - y[i]));
+        s1 += std::cos(q * (x[i + 1] - y[i + 1]));
+    }
+    for (; i < n; ++i) {
+        s0 += std::cos(q * (x[i] - y[i]));
+    }
+    return s0 + s1;
+}
+
+} // namespace
+
+DisplacementCorrelator::DisplacementCorrelator(const size_t ndim, const double wavenumber,
+        const size_t nr_lags, const size_t max_levels)
+    : m_ndim(ndim),
+      m_wavenumber(wavenumber),
+      m_nr_lags(nr_lags),
+      m_max_levels(max_levels),
+      m_ndof(0)
+{
+    if (ndim == 0) {
+        throw std::runtime_error("DisplacementCorrelator: ndim expected to be at least 1");
+    }
+    if (nr_lags < 2 || nr_lags % 2 != 0) {
+        throw std::runtime_error("DisplacementCorrelator: nr_lags must be even and at least 2");
+    }
+    if (wavenumber < 0) {
+        throw std::runtime_error("DisplacementCorrelator: wavenumber expected to be non-negative");
+    }
+}
+
+void DisplacementCorrelator::clear()
+{
+    m_ndof = 0;
+    m_shift.clear();
+    m_nr_inserted.clear();
+    m_msd.clear();
+    m_fs.clear();
+    m_nr_corr.clear();
+}
+
+void DisplacementCorrelator::m_add_level()
+{
+    m_shift.push_back(std::vector<double>(m_nr_lags * m_ndof, 0));
+    m_nr_inserted.push_back(0);
+    m_msd.push_back(std::vector<double>(m_nr_lags, 0));
+    m_fs.push_back(std::vector<double>(m_nr_lags, 0));
+    m_nr_corr.push_back(std::vector<size_t>(m_nr_lags, 0));
+}
+
+void DisplacementCorrelator::add(const double* x, const size_t ndof)
+{
+    if (m_ndof == 0) {
+        if (ndof == 0 || ndof % m_ndim != 0) {
+            throw std::runtime_error("DisplacementCorrelator::add: ndof must be a positive multiple of ndim");
+        }
+        m_ndof = ndof;
+    }
+    else if (ndof != m_ndof) {
+        throw std::runtime_error("DisplacementCorrelator::add: ndof changed");
+    }
+    m_add(x, 0);
+}
+
+void DisplacementCorrelator::m_add(const double* x, const size_t level)
+{
+    if (level == m_shift.size()) {
+        m_add_level();
+    }
+    // circular shift register of configurations, the newest at row nr_inserted % nr_lags
+    double* shift = m_shift[level].data();
+    const size_t pos = m_nr_inserted[level] % m_nr_lags;
+    double* current = shift + pos * m_ndof;
+    std::copy(x, x + m_ndof, current);
+    // the second of every pair, so that the first configuration of a level does not cascade
+    const bool pass_on = (m_nr_inserted[level] % 2) == 1;
+    ++m_nr_inserted[level];
+    const size_t first_lag = (level == 0) ? 1 : m_nr_lags / 2;
+    const size_t nr_valid = std::min(m_nr_inserted[level], m_nr_lags);
+    for (size_t j = first_lag; j < nr_valid; ++j) {
+        const double* origin = shift + ((pos + m_nr_lags - j) % m_nr_lags) * m_ndof;
+        m_msd[level][j] += sum_square_difference(current, origin, m_ndof);
+        if (m_wavenumber > 0) {
+            m_fs[level][j] += sum_cos_difference(current, origin, m_ndof, m_wavenumber);
+        }
+        ++m_nr_corr[level][j];
+    }
+    // the row stays valid if the next level is added: the inner vectors are moved, not copied
+    if (pass_on && (m_max_levels == 0 || level + 1 < m_max_levels)) {
+        m_add(current, level + 1);
+    }
+}
+
+std::vector<double> DisplacementCorrelator::get_lags() const
+{
+    std::vector<double> lags;
+    double spacing = 1;
+    for (size_t level = 0; level < m_shift.size(); ++level) {
+        const size_t first_lag = (level == 0) ? 1 : m_nr_lags / 2;
+        for (size_t j = first_lag; j < m_nr_lags; ++j) {
+            if (m_nr_corr[level][j] > 0) {
+                lags.push_back(j * spacing);
+            }
+        }
+        spacing *= 2;
+    }
+    return lags;
+}
+
+std::vector<double> DisplacementCorrelator::get_mean_square_displacement() const
+{
+    std::vector<double> msd;
+    const double nr_particles = m_ndof / m_ndim;
+    for (size_t level = 0; level < m_shift.size(); ++level) {
+        const size_t first_lag = (level == 0) ? 1 : m_nr_lags / 2;
+        for (size_t j = first_lag; j < m_nr_lags; ++j) {
+            if (m_nr_corr[level][j] > 0) {
+                msd.push_back(m_msd[level][j] / (m_nr_corr[level][j] * nr_particles));
+            }
+        }
+    }
+    return msd;
+}
+
+std::vector<double> DisplacementCorrelator::get_self_intermediate_scattering() const
+{
+    if (m_wavenumber == 0) {
+        throw std::runtime_error("DisplacementCorrelator::get_self_intermediate_scattering: no wavenumber set");
+    }
+    std::vector<double> fs;
+    for (size_t level = 0; level < m_shift.size(); ++level) {
+        const size_t first_lag = (level == 0) ? 1 : m_nr_lags / 2;
+        for (size_t j = first_lag; j < m_nr_lags; ++j) {
+            if (m_nr_corr[level][j] > 0) {
+                fs.push_back(m_fs[level][j] / (m_nr_corr[level][j] * static_cast<double>(m_ndof)));
+            }
+        }
+    }
+    return fs;
+}
+
+std::vector<double> DisplacementCorrelator::get_nr_origins() const
+{
+    std::vector<double> nr_origins;
+    for (size_t level = 0; level < m_shift.size(); ++level) {
+        const size_t first_lag = (level == 0) ? 1 : m_nr_lags / 2;
+        for (size_t j = first_lag; j < m_nr_lags; ++j) {
+            if (m_nr_corr[level][j] > 0) {
+                nr_origins.push_back(m_nr_corr[level][j]);
+            }
+        }
+    }
+    return nr_origins;
+}
+
+} // namespace mcpele
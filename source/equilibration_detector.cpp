@@ -0,0 +1,69 @@
+#include <stdexcept>
+
+#include "mcpele/equilibration_detector.h"
+#include "mcpele/moving_average.h"
+
+using pele::Array;
+
+namespace mcpele {
+
+EquilibrationDetector::EquilibrationDetector(const size_t record_every, const size_t nr_samples, const double threshold)
+    : m_record_every(record_every),
+      m_nr_samples(nr_samples),
+      m_threshold(threshold),
+      m_nr_recorded(0),
+      m_equilibrated(false),
+      m_equilibration_step(0)
+{
+    if (record_every == 0) {
+        throw std::runtime_error("EquilibrationDetector: record_every expected to be at least 1");
+    }
+    if (nr_samples < 8 || nr_samples % 4 != 0) {
+        throw std::runtime_error("EquilibrationDetector: nr_samples expected to be a multiple of 4, at least 8");
+    }
+}
+
+bool EquilibrationDetector::moving_average_is_stable(const double* begin, const double* end,
+        const size_t nr_steps_total, const double threshold)
+{
+    MovingAverageAcc ma(begin, end, nr_steps_total, nr_steps_total / 2);
+    Moments ma_moments;
+    for (size_t i = 0; i < ma.get_nr_steps_ma(); ++i, ma.shift_right()) {
+        ma_moments(ma.get_mean());
+    }
+    Moments moments;
+    moments.update(end - nr_steps_total, end);
+    return ma_moments.std() <= threshold * moments.std();
+}
+
+void EquilibrationDetector::action(Array<double> &coords, double energy, bool accepted, MC* mc)
+{
+    if (m_equilibrated) {
+        for (auto & action : m_actions) {
+            action->action(coords, energy, accepted, mc);
+        }
+        return;
+    }
+    const size_t counter = mc->get_iterations_count();
+    if (counter % m_record_every != 0) {
+        return;
+    }
+    m_energies.push_back(energy);
+    ++m_nr_recorded;
+    // keep at most 2 nr_samples energies, for amortised O(1) trimming
+    if (m_energies.size() > 2 * m_nr_samples) {
+        m_energies.erase(m_energies.begin(), m_energies.end() - m_nr_samples);
+    }
+    if (m_nr_recorded < m_nr_samples || m_nr_recorded % (m_nr_samples / 4) != 0) {
+        return;
+    }
+    if (moving_average_is_stable(m_energies, m_nr_samples, m_threshold)) {
+        m_equilibrated = true;
+        m_equilibration_step = counter;
+        mc->set_report_steps(counter);
+        m_energies.clear();
+        m_energies.shrink_to_fit();
+    }
+}
+
+} // namespace mcpele
@@ -0,0 +1,88 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <random>
+#include <stdexcept>
+
+#include "mcpele/halton_sequence.h"
+
+namespace mcpele {
+
+HaltonSequence::HaltonSequence(const size_t ndim, const size_t seed, const bool scramble)
+    : m_ndim(ndim),
+      m_scramble(scramble),
+      m_index(0)
+{
+    if (ndim == 0) {
+        throw std::runtime_error("HaltonSequence: illegal input: ndim");
+    }
+    // first ndim primes
+    for (size_t candidate = 2; m_bases.size() < m_ndim; ++candidate) {
+        bool is_prime = true;
+        for (size_t i = 0; i < m_bases.size() && m_bases[i] * m_bases[i] <= candidate; ++i) {
+            if (candidate % m_bases[i] == 0) {
+                is_prime = false;
+                break;
+            }
+        }
+        if (is_prime) {
+            m_bases.push_back(candidate);
+        }
+    }
+    // enough digits to resolve double precision
+    const int mantissa_digits = std::numeric_limits<double>::digits;
+    for (size_t d = 0; d < m_ndim; ++d) {
+        const double ndigits = std::ceil(mantissa_digits * std::log(2.) / std::log(static_cast<double>(m_bases[d])));
+        m_ndigits.push_back(static_cast<size_t>(ndigits));
+    }
+    set_seed(seed);
+}
+
+void HaltonSequence::set_seed(const size_t seed)
+{
+    std::mt19937_64 generator(seed);
+    m_permutations.assign(m_ndim, std::vector<size_t>());
+    for (size_t d = 0; d < m_ndim; ++d) {
+        const size_t base = m_bases[d];
+        std::vector<size_t>& perm = m_permutations[d];
+        perm.resize(base * m_ndigits[d]);
+        for (size_t j = 0; j < m_ndigits[d]; ++j) {
+            const auto begin = perm.begin() + j * base;
+            std::iota(begin, begin + base, 0);
+            if (m_scramble) {
+                std::shuffle(begin, begin + base, generator);
+            }
+        }
+    }
+}
+
+double HaltonSequence::get_coordinate(const size_t index, const size_t dim) const
+{
+    const size_t base = m_bases[dim];
+    const size_t* perm = m_permutations[dim].data();
+    const double inv_base = 1. / static_cast<double>(base);
+    double factor = inv_base;
+    double result = 0;
+    size_t n = index;
+    for (size_t j = 0; j < m_ndigits[dim]; ++j) {
+        if (n == 0 && !m_scramble) {
+            break;
+        }
+        const size_t digit = n % base;
+        n /= base;
+        result += perm[j * base + digit] * factor;
+        factor *= inv_base;
+    }
+    // guard against rounding up to 1
+    return std::min(result, 1. - std::numeric_limits<double>::epsilon());
+}
+
+void HaltonSequence::get_point(const size_t index, double* x) const
+{
+    for (size_t d = 0; d < m_ndim; ++d) {
+        x[d] = get_coordinate(index, d);
+    }
+}
+
+} // namespace mcpele
@@ -1,3 +1,5 @@
+#include <utility>
+
 #include "mcpele/histogram.h"
 
 namespace mcpele{
@@ -81,6 +83,68 @@ void Histogram::resize(const double E, const int i)
     }
 }
 
+Histogram::Histogram(const std::vector<double>& buffer)
+    : m_max(0),
+      m_min(0),
+      m_bin(0),
+      m_eps(std::numeric_limits<double>::epsilon()),
+      m_N(0),
+      m_niter(0)
+{
+    const size_t header_size = 4 + Moments::buffer_size;
+    if (buffer.size() < header_size) {
+        throw std::runtime_error("Histogram: buffer too short");
+    }
+    m_bin = buffer[0];
+    m_min = buffer[1];
+    m_max = buffer[2];
+    m_niter = buffer[3];
+    m_moments.read_buffer(&buffer[4]);
+    m_hist.assign(buffer.begin() + header_size, buffer.end());
+    m_N = m_hist.size();
+}
+
+std::vector<double> Histogram::get_buffer() const
+{
+    std::vector<double> buffer(4 + Moments::buffer_size);
+    buffer[0] = m_bin;
+    buffer[1] = m_min;
+    buffer[2] = m_max;
+    buffer[3] = m_niter;
+    m_moments.write_buffer(&buffer[4]);
+    buffer.insert(buffer.end(), m_hist.begin(), m_hist.end());
+    return buffer;
+}
+
+/*
+ * Both histograms have their boundaries on multiples of the bin size, so
+ * their bins are aligned up to rounding.
+ */
+void Histogram::merge(const Histogram& other)
+{
+    if (std::abs(other.m_bin - m_bin) > m_eps * m_bin) {
+        throw std::runtime_error("Histogram::merge: histograms have different bin size");
+    }
+    const double new_min = std::min(m_min, other.m_min);
+    const double new_max = std::max(m_max, other.m_max);
+    const int new_N = round((new_max - new_min) / m_bin);
+    const int offset = round((m_min - new_min) / m_bin);
+    const int other_offset = round((other.m_min - new_min) / m_bin);
+    std::vector<double> hist(new_N, 0);
+    for (size_t i = 0; i < m_hist.size(); ++i) {
+        hist.at(offset + i) += m_hist[i];
+    }
+    for (size_t i = 0; i < other.m_hist.size(); ++i) {
+        hist.at(other_offset + i) += other.m_hist[i];
+    }
+    m_hist.swap(hist);
+    m_min = new_min;
+    m_max = new_max;
+    m_N = new_N;
+    m_niter += other.m_niter;
+    m_moments.merge(other.m_moments);
+}
+
 /*
  * Note: This gives the error bar on a bin of width _bin, under the assumption that the sum of all bin areas is 1.
  * */
@@ -121,4 +185,327 @@ void Histogram::print_terminal() const
     }
 }
 
+BaseHistogram::BaseHistogram(const double min, const double max, const double bin)
+    : m_bin(bin),
+      m_eps(std::numeric_limits<double>::epsilon()),
+      m_kmin(floor(min / bin)),
+      m_kmax(floor(max / bin)),
+      m_niter(0)
+{
+    if (bin <= 0 || m_kmax < m_kmin) {
+        throw std::runtime_error("BaseHistogram: illegal input");
+    }
+}
+
+std::vector<double> BaseHistogram::get_vecdata() const
+{
+    std::vector<double> result(size(), 0);
+    for (size_t i = 0; i < result.size(); ++i) {
+        result.at(i) = get_entry(i);
+    }
+    return result;
+}
+
+std::vector<double> BaseHistogram::get_vecdata_error() const
+{
+    const std::vector<double> data = get_vecdata();
+    std::vector<double> result(data.size(), 0);
+    for (size_t i = 0; i < result.size(); ++i) {
+        const double this_fraction = data.at(i) / static_cast<double>(get_count());
+        result.at(i) = sqrt(this_fraction * (1 - this_fraction) / m_bin) / sqrt(get_count());
+    }
+    return result;
+}
+
+std::vector<double> BaseHistogram::get_vecdata_normalized() const
+{
+    std::vector<double> result = get_vecdata();
+    for (size_t i = 0; i < result.size(); ++i) {
+        const double this_fraction = result.at(i) / static_cast<double>(m_niter);
+        result.at(i) = this_fraction / m_bin;
+    }
+    return result;
+}
+
+std::vector<double> BaseHistogram::get_vectics() const
+{
+    std::vector<double> result(size(), 0);
+    for (size_t i = 0; i < result.size(); ++i) {
+        result.at(i) = get_position(i);
+    }
+    return result;
+}
+
+void BaseHistogram::print_terminal() const
+{
+    const std::vector<double> data = get_vecdata();
+    for(size_t i = 0; i < data.size(); ++i) {
+        std::cout << i << "-" << (i + 1) << ": ";
+        std::cout << std::string(data[i] * 10000 / m_niter, '*') <<  "\n";
+    }
+}
+
+void BaseHistogram::get_occupied_bins(std::vector<double>& positions, std::vector<count_t>& counts) const
+{
+    std::vector<std::pair<long, count_t> > bins;
+    m_get_bins(bins);
+    std::sort(bins.begin(), bins.end());
+    positions.resize(bins.size());
+    counts.resize(bins.size());
+    for (size_t i = 0; i < bins.size(); ++i) {
+        positions[i] = (bins[i].first + 0.5) * m_bin;
+        counts[i] = bins[i].second;
+    }
+}
+
+void BaseHistogram::m_get_bins(std::vector<std::pair<long, count_t> >& bins) const
+{
+    bins.clear();
+    for (size_t i = 0; i < size(); ++i) {
+        const count_t count = get_entry(i);
+        if (count) {
+            bins.push_back(std::make_pair(m_kmin + static_cast<long>(i), count));
+        }
+    }
+}
+
+void BaseHistogram::extend_range(const double min, const double max)
+{
+    m_extend_range(floor(min / m_bin), floor(max / m_bin));
+}
+
+void BaseHistogram::merge(const BaseHistogram& other)
+{
+    if (std::abs(other.m_bin - m_bin) > m_eps * m_bin) {
+        throw std::runtime_error("BaseHistogram::merge: histograms have different bin size");
+    }
+    m_extend_range(other.m_kmin, other.m_kmax);
+    std::vector<std::pair<long, count_t> > bins;
+    other.m_get_bins(bins);
+    for (const auto& b : bins) {
+        m_add_count(b.first, b.second);
+    }
+    m_niter += other.m_niter;
+    m_moments.merge(other.m_moments);
+}
+
+std::vector<double> BaseHistogram::get_buffer() const
+{
+    const size_t header_size = buffer_header_size;
+    std::vector<std::pair<long, count_t> > bins;
+    m_get_bins(bins);
+    const bool sparse = 2 * bins.size() < size();
+    std::vector<double> buffer(header_size + (sparse ? 2 * bins.size() : size()), 0);
+    buffer[0] = m_bin;
+    buffer[1] = m_kmin;
+    buffer[2] = m_kmax;
+    buffer[3] = m_niter;
+    buffer[4] = sparse ? 1 : 0;
+    m_moments.write_buffer(&buffer[5]);
+    for (size_t i = 0; i < bins.size(); ++i) {
+        if (sparse) {
+            buffer[header_size + 2 * i] = bins[i].first;
+            buffer[header_size + 2 * i + 1] = bins[i].second;
+        }
+        else {
+            buffer[header_size + (bins[i].first - m_kmin)] = bins[i].second;
+        }
+    }
+    return buffer;
+}
+
+void BaseHistogram::merge_buffer(const std::vector<double>& buffer)
+{
+    const size_t header_size = buffer_header_size;
+    if (buffer.size() < header_size) {
+        throw std::runtime_error("BaseHistogram::merge_buffer: buffer too short");
+    }
+    const double bin = buffer[0];
+    const long kmin = buffer[1];
+    const long kmax = buffer[2];
+    const double layout = buffer[4];
+    if (std::abs(bin - m_bin) > m_eps * m_bin) {
+        throw std::runtime_error("BaseHistogram::merge_buffer: histograms have different bin size");
+    }
+    if (layout != 0 && layout != 1) {
+        throw std::runtime_error("BaseHistogram::merge_buffer: unknown buffer layout");
+    }
+    const bool sparse = layout == 1;
+    const size_t nr_values = buffer.size() - header_size;
+    if (sparse ? (nr_values % 2 != 0) : (nr_values != static_cast<size_t>(kmax - kmin + 1))) {
+        throw std::runtime_error("BaseHistogram::merge_buffer: buffer size inconsistent with range");
+    }
+    m_extend_range(kmin, kmax);
+    if (sparse) {
+        for (size_t i = header_size; i < buffer.size(); i += 2) {
+            const long k = buffer[i];
+            if (k < kmin || k > kmax) {
+                throw std::runtime_error("BaseHistogram::merge_buffer: bin outside of the range");
+            }
+            m_add_count(k, static_cast<count_t>(buffer[i + 1]));
+        }
+    }
+    else {
+        for (long k = kmin; k <= kmax; ++k) {
+            const count_t count = buffer[header_size + (k - kmin)];
+            if (count) {
+                m_add_count(k, count);
+            }
+        }
+    }
+    m_niter += static_cast<count_t>(buffer[3]);
+    Moments other;
+    other.read_buffer(&buffer[5]);
+    m_moments.merge(other);
+}
+
+/*DynamicHistogram*/
+
+DynamicHistogram::DynamicHistogram(const double min, const double max, const double bin)
+    : BaseHistogram(min, max, bin),
+      m_origin(m_kmin),
+      m_counts(m_kmax - m_kmin + 1, 0)
+{}
+
+void DynamicHistogram::add_entry(double E)
+{
+    const long kmin = m_kmin;
+    const long kmax = m_kmax;
+    const long k = m_record_entry(E);
+    if (k < m_origin || k >= m_origin + static_cast<long>(m_counts.size())) {
+        m_grow(kmin, kmax);
+    }
+    ++m_counts[k - m_origin];
+}
+
+void DynamicHistogram::m_extend_range(const long kmin, const long kmax)
+{
+    const long lo = m_kmin;
+    const long hi = m_kmax;
+    BaseHistogram::m_extend_range(kmin, kmax);
+    if (m_kmin < m_origin || m_kmax >= m_origin + static_cast<long>(m_counts.size())) {
+        m_grow(lo, hi);
+    }
+}
+
+/**
+ * reallocate the storage around the new range [m_kmin, m_kmax], the old
+ * occupied range [lo, hi] is copied over
+ */
+void DynamicHistogram::m_grow(const long lo, const long hi)
+{
+    const size_t span = m_kmax - m_kmin + 1;
+    const size_t capacity = std::max(2 * m_counts.size(), 2 * span);
+    const long origin = m_kmin - static_cast<long>((capacity - span) / 2);
+    std::vector<count_t> counts(capacity, 0);
+    std::copy(m_counts.begin() + (lo - m_origin), m_counts.begin() + (hi + 1 - m_origin),
+            counts.begin() + (lo - origin));
+    m_counts.swap(counts);
+    m_origin = origin;
+}
+
+/*SparseHistogram*/
+
+const long SparseHistogram::m_empty_key = std::numeric_limits<long>::min();
+
+SparseHistogram::SparseHistogram(const double min, const double max, const double bin)
+    : BaseHistogram(min, max, bin),
+      m_keys(16, m_empty_key),
+      m_values(16, 0),
+      m_nr_occupied(0)
+{}
+
+/**
+ * slot holding bin k, or the empty slot where it should be inserted
+ * (Fibonacci hashing into a power of two sized table, linear probing)
+ */
+size_t SparseHistogram::m_find_slot(const long k) const
+{
+    const size_t mask = m_keys.size() - 1;
+    size_t slot = (static_cast<unsigned long>(k) * 0x9E3779B97F4A7C15ul) >> 20;
+    slot &= mask;
+    while (m_keys[slot] != k && m_keys[slot] != m_empty_key) {
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+void SparseHistogram::m_rehash(const size_t capacity)
+{
+    std::vector<long> keys(capacity, m_empty_key);
+    std::vector<count_t> values(capacity, 0);
+    m_keys.swap(keys);
+    m_values.swap(values);
+    for (size_t i = 0; i < keys.size(); ++i) {
+        if (keys[i] != m_empty_key) {
+            const size_t slot = m_find_slot(keys[i]);
+            m_keys[slot] = keys[i];
+            m_values[slot] = values[i];
+        }
+    }
+}
+
+void SparseHistogram::add_entry(double E)
+{
+    m_add_count(m_record_entry(E), 1);
+}
+
+void SparseHistogram::m_add_count(const long k, const count_t count)
+{
+    size_t slot = m_find_slot(k);
+    if (m_keys[slot] == m_empty_key) {
+        // keep the load factor below 1/2
+        if (2 * (m_nr_occupied + 1) > m_keys.size()) {
+            m_rehash(2 * m_keys.size());
+            slot = m_find_slot(k);
+        }
+        m_keys[slot] = k;
+        ++m_nr_occupied;
+    }
+    m_values[slot] += count;
+}
+
+BaseHistogram::count_t SparseHistogram::get_entry(const size_t bin_index) const
+{
+    if (bin_index >= size()) {
+        throw std::out_of_range("SparseHistogram::get_entry: illegal bin index");
+    }
+    const size_t slot = m_find_slot(m_kmin + static_cast<long>(bin_index));
+    return m_keys[slot] == m_empty_key ? 0 : m_values[slot];
+}
+
+std::vector<double> SparseHistogram::get_vecdata() const
+{
+    std::vector<double> result(size(), 0);
+    for (size_t i = 0; i < m_keys.size(); ++i) {
+        if (m_keys[i] != m_empty_key) {
+            result.at(m_keys[i] - m_kmin) = m_values[i];
+        }
+    }
+    return result;
+}
+
+void SparseHistogram::m_get_bins(std::vector<std::pair<long, count_t> >& bins) const
+{
+    bins.clear();
+    bins.reserve(m_nr_occupied);
+    for (size_t i = 0; i < m_keys.size(); ++i) {
+        if (m_keys[i] != m_empty_key) {
+            bins.push_back(std::make_pair(m_keys[i], m_values[i]));
+        }
+    }
+}
+
+void SparseHistogram::print_terminal() const
+{
+    std::vector<std::pair<long, count_t> > bins;
+    m_get_bins(bins);
+    std::sort(bins.begin(), bins.end());
+    for (const auto& b : bins) {
+        const long i = b.first - m_kmin;
+        std::cout << i << "-" << (i + 1) << ": ";
+        std::cout << std::string(b.second * 10000 / m_niter, '*') <<  "\n";
+    }
+}
+
 }//namespace mcpele
@@ -1,29 +1,265 @@
+#include <algorithm>
 #include <cmath>
+#include <limits>
 
 #include "mcpele/lowest_eigenvalue.h"
 
 namespace mcpele{
 
 FindLowestEigenvalue::FindLowestEigenvalue(std::shared_ptr<pele::BasePotential> landscape_potential, const size_t boxdimension,
-        const pele::Array<double> ranvec, const size_t lbfgsniter)
-    : m_lowesteigpot(std::make_shared<pele::LowestEigPotential>(landscape_potential, ranvec.copy(), boxdimension)),
+        const pele::Array<double> ranvec, const size_t lbfgsniter, const bool warm_start,
+        const bool use_lanczos, const double tol)
+    : m_landscape_potential(landscape_potential),
+      m_lowesteigpot(std::make_shared<pele::LowestEigPotential>(landscape_potential, ranvec.copy(), boxdimension)),
       m_ranvec((ranvec.copy() /= norm(ranvec))),
-      m_lbfgs(m_lowesteigpot, m_ranvec.copy())
+      m_lbfgs(m_lowesteigpot, m_ranvec.copy()),
+      m_boxdimension(boxdimension),
+      m_max_iter(lbfgsniter),
+      m_warm_start(warm_start),
+      m_use_lanczos(use_lanczos),
+      m_tol(tol),
+      m_last_niter(0),
+      m_total_niter(0),
+      m_nr_computations(0)
 {
   if (std::isinf(double(1) / norm(ranvec))) {
         throw std::runtime_error("FindLowestEigenvalue: 1/norm(ranvec) is isinf");
     }
+    if (lbfgsniter == 0) {
+        throw std::runtime_error("FindLowestEigenvalue: lbfgsniter expected to be at least 1");
+    }
     m_lbfgs.set_max_iter(lbfgsniter);
 }
 
 double FindLowestEigenvalue::compute_lowest_eigenvalue(pele::Array<double> coords)
 {
-    m_lowesteigpot->reset_coords(coords);
-    m_lbfgs.reset(m_ranvec);
-    m_lbfgs.set_use_relative_f(1);
-    m_lbfgs.run();
-    const double lowesteig = m_lbfgs.get_f();
+    double lowesteig;
+    if (m_use_lanczos) {
+        lowesteig = m_compute_lanczos(coords);
+    }
+    else {
+        m_lowesteigpot->reset_coords(coords);
+        pele::Array<double> start = (m_warm_start && m_eigenvector.size() == m_ranvec.size()) ? m_eigenvector.copy() : m_ranvec.copy();
+        m_lbfgs.reset(start);
+        m_lbfgs.set_use_relative_f(1);
+        m_lbfgs.run();
+        lowesteig = m_lbfgs.get_f();
+        m_last_niter = m_lbfgs.get_niter();
+        m_eigenvector = m_lbfgs.get_x().copy();
+        const double evec_norm = norm(m_eigenvector);
+        if (evec_norm > 0 && std::isfinite(evec_norm)) {
+            m_eigenvector /= evec_norm;
+        }
+        else {
+            m_eigenvector = pele::Array<double>();
+        }
+    }
+    m_total_niter += m_last_niter;
+    ++m_nr_computations;
     return lowesteig;
 }
 
+void FindLowestEigenvalue::m_project_out_translations(pele::Array<double> v) const
+{
+    if (m_boxdimension == 0 || v.size() % m_boxdimension != 0) {
+        return;
+    }
+    const size_t nparticles = v.size() / m_boxdimension;
+    for (size_t d = 0; d < m_boxdimension; ++d) {
+        double mean = 0;
+        for (size_t i = 0; i < nparticles; ++i) {
+            mean += v[i * m_boxdimension + d];
+        }
+        mean /= nparticles;
+        for (size_t i = 0; i < nparticles; ++i) {
+            v[i * m_boxdimension + d] -= mean;
+        }
+    }
+}
+
+/**
+ * Hessian-vector product from central differences of the gradient, v has norm 1
+ */
+void FindLowestEigenvalue::m_hessian_vector_product(pele::Array<double> coords, pele::Array<double> v, pele::Array<double> hv)
+{
+    const size_t n = coords.size();
+    const double eps = 1e-6 * std::max(1., norm(coords) / std::sqrt(static_cast<double>(n)));
+    pele::Array<double> x(n);
+    pele::Array<double> grad_plus(n);
+    pele::Array<double> grad_minus(n);
+    for (size_t i = 0; i < n; ++i) {
+        x[i] = coords[i] + eps * v[i];
+    }
+    m_landscape_potential->get_energy_gradient(x, grad_plus);
+    for (size_t i = 0; i < n; ++i) {
+        x[i] = coords[i] - eps * v[i];
+    }
+    m_landscape_potential->get_energy_gradient(x, grad_minus);
+    for (size_t i = 0; i < n; ++i) {
+        hv[i] = (grad_plus[i] - grad_minus[i]) / (2 * eps);
+    }
+}
+
+double FindLowestEigenvalue::m_compute_lanczos(pele::Array<double> coords)
+{
+    const size_t n = coords.size();
+    if (n != m_ranvec.size()) {
+        throw std::runtime_error("FindLowestEigenvalue: coords and ranvec differ in size");
+    }
+    pele::Array<double> v = (m_warm_start && m_eigenvector.size() == n) ? m_eigenvector.copy() : m_ranvec.copy();
+    m_project_out_translations(v);
+    double vnorm = norm(v);
+    if (!(vnorm > 0)) {
+        v = m_ranvec.copy();
+        m_project_out_translations(v);
+        vnorm = norm(v);
+        if (!(vnorm > 0)) {
+            throw std::runtime_error("FindLowestEigenvalue: start vector is a pure translation");
+        }
+    }
+    v /= vnorm;
+    // the Krylov space cannot be larger than the space orthogonal to the translations
+    const size_t max_iter = std::max<size_t>(1, std::min(m_max_iter, n > m_boxdimension ? n - m_boxdimension : n));
+    std::vector<pele::Array<double> > basis(1, v);
+    std::vector<double> alpha;
+    std::vector<double> beta;
+    std::vector<double> ritz;
+    pele::Array<double> w(n);
+    double theta = 0;
+    double hessian_norm = 0;
+    for (size_t j = 0; j < max_iter; ++j) {
+        const pele::Array<double>& vj = basis[j];
+        m_hessian_vector_product(coords, vj, w);
+        m_project_out_translations(w);
+        const double a = dot(w, vj);
+        alpha.push_back(a);
+        for (size_t i = 0; i < n; ++i) {
+            w[i] -= a * vj[i];
+        }
+        if (j > 0) {
+            const pele::Array<double>& vprev = basis[j - 1];
+            for (size_t i = 0; i < n; ++i) {
+                w[i] -= beta[j - 1] * vprev[i];
+            }
+        }
+        // full reorthogonalisation, the basis is short
+        for (size_t k = 0; k <= j; ++k) {
+            const double overlap = dot(w, basis[k]);
+            for (size_t i = 0; i < n; ++i) {
+                w[i] -= overlap * basis[k][i];
+            }
+        }
+        const double b = norm(w);
+        hessian_norm = std::max(hessian_norm, std::abs(a) + b + (j > 0 ? beta[j - 1] : 0));
+        theta = tridiagonal_lowest_eigenvalue(alpha, beta);
+        ritz = tridiagonal_lowest_eigenvector(alpha, beta, theta);
+        m_last_niter = j + 1;
+        const double residual = b * std::abs(ritz.back());
+        if (residual <= m_tol * hessian_norm || b <= std::numeric_limits<double>::epsilon() * hessian_norm) {
+            break;
+        }
+        beta.push_back(b);
+        basis.push_back(w.copy() /= b);
+    }
+    m_eigenvector = pele::Array<double>(n, 0);
+    for (size_t k = 0; k < ritz.size(); ++k) {
+        for (size_t i = 0; i < n; ++i) {
+            m_eigenvector[i] += ritz[k] * basis[k][i];
+        }
+    }
+    m_eigenvector /= norm(m_eigenvector);
+    return theta;
+}
+
+namespace {
+
+/**
+ * number of eigenvalues of the tridiagonal matrix smaller than x (Sturm sequence)
+ */
+size_t tridiagonal_count_below(const std::vector<double>& alpha, const std::vector<double>& beta, const double x)
+{
+    size_t count = 0;
+    double d = 1;
+    for (size_t i = 0; i < alpha.size(); ++i) {
+        const double offdiag2 = i > 0 ? beta[i - 1] * beta[i - 1] : 0;
+        d = alpha[i] - x - (i > 0 ? offdiag2 / d : 0);
+        if (d == 0) {
+            d = -std::numeric_limits<double>::min();
+        }
+        if (d < 0) {
+            ++count;
+        }
+    }
+    return count;
+}
+
+} // namespace
+
+double FindLowestEigenvalue::tridiagonal_lowest_eigenvalue(const std::vector<double>& alpha, const std::vector<double>& beta)
+{
+    if (alpha.empty() || beta.size() + 1 != alpha.size()) {
+        throw std::runtime_error("FindLowestEigenvalue::tridiagonal_lowest_eigenvalue: illegal input");
+    }
+    // Gershgorin bounds
+    double lo = std::numeric_limits<double>::max();
+    double hi = -std::numeric_limits<double>::max();
+    for (size_t i = 0; i < alpha.size(); ++i) {
+        const double radius = (i > 0 ? std::abs(beta[i - 1]) : 0) + (i < beta.size() ? std::abs(beta[i]) : 0);
+        lo = std::min(lo, alpha[i] - radius);
+        hi = std::max(hi, alpha[i] + radius);
+    }
+    const double scale = std::max(std::abs(lo), std::abs(hi));
+    for (size_t iter = 0; iter < 200 && hi - lo > 4 * std::numeric_limits<double>::epsilon() * scale; ++iter) {
+        const double mid = 0.5 * (lo + hi);
+        if (tridiagonal_count_below(alpha, beta, mid) >= 1) {
+            hi = mid;
+        }
+        else {
+            lo = mid;
+        }
+    }
+    return 0.5 * (lo + hi);
+}
+
+std::vector<double> FindLowestEigenvalue::tridiagonal_lowest_eigenvector(const std::vector<double>& alpha,
+        const std::vector<double>& beta, const double eigenvalue)
+{
+    const size_t m = alpha.size();
+    double scale = std::abs(eigenvalue);
+    for (size_t i = 0; i < m; ++i) {
+        scale = std::max(scale, std::abs(alpha[i]));
+    }
+    // shift just below the lowest eigenvalue: T - shift is positive definite
+    // and the Thomas algorithm needs no pivoting
+    const double shift = eigenvalue - 1e-10 * std::max(scale, std::numeric_limits<double>::min());
+    std::vector<double> s(m, 1 / std::sqrt(static_cast<double>(m)));
+    std::vector<double> c(m);
+    std::vector<double> d(m);
+    for (size_t iter = 0; iter < 3; ++iter) {
+        // forward elimination
+        double pivot = alpha[0] - shift;
+        c[0] = m > 1 ? beta[0] / pivot : 0;
+        d[0] = s[0] / pivot;
+        for (size_t i = 1; i < m; ++i) {
+            pivot = alpha[i] - shift - beta[i - 1] * c[i - 1];
+            c[i] = i < m - 1 ? beta[i] / pivot : 0;
+            d[i] = (s[i] - beta[i - 1] * d[i - 1]) / pivot;
+        }
+        // back substitution
+        s[m - 1] = d[m - 1];
+        for (size_t i = m - 1; i > 0; --i) {
+            s[i - 1] = d[i - 1] - c[i - 1] * s[i];
+        }
+        double snorm = 0;
+        for (size_t i = 0; i < m; ++i) {
+            snorm += s[i] * s[i];
+        }
+        snorm = std::sqrt(snorm);
+        for (size_t i = 0; i < m; ++i) {
+            s[i] /= snorm;
+        }
+    }
+    return s;
+}
+
 }//namespace mcpele
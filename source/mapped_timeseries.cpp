@@ -0,0 +1,165 @@
+#include "mcpele/mapped_timeseries.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace mcpele {
+
+namespace {
+
+std::string system_error(const std::string& what, const std::string& filename)
+{
+    return "MappedTimeseries: " + what + " " + filename + ": " + std::strerror(errno);
+}
+
+bool is_little_endian()
+{
+    const uint16_t one = 1;
+    unsigned char first;
+    std::memcpy(&first, &one, 1);
+    return first == 1;
+}
+
+} // namespace
+
+MappedTimeseries::MappedTimeseries(const std::string& filename, const size_t row_size,
+        const bool one_dimensional, const size_t flush_every)
+    : m_filename(filename),
+      m_row_size(row_size),
+      m_one_dimensional(one_dimensional),
+      m_flush_every(flush_every),
+      m_fd(-1),
+      m_map(NULL),
+      m_capacity(0),
+      m_nr_rows(0)
+{
+    if (row_size == 0) {
+        throw std::runtime_error("MappedTimeseries: row_size expected to be at least 1");
+    }
+    if (one_dimensional && row_size != 1) {
+        throw std::runtime_error("MappedTimeseries: one dimensional time series expected to have row_size 1");
+    }
+    if (flush_every == 0) {
+        throw std::runtime_error("MappedTimeseries: flush_every expected to be at least 1");
+    }
+    m_fd = ::open(filename.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (m_fd < 0) {
+        throw std::runtime_error(system_error("cannot open", filename));
+    }
+    // start with about 1 MiB, or flush_every rows if that is more
+    const size_t min_rows = (1 << 20) / (row_size * sizeof(double));
+    try {
+        m_map_file(std::max<size_t>(std::max<size_t>(flush_every, min_rows), 1));
+    }
+    catch (...) {
+        ::close(m_fd);
+        throw;
+    }
+    m_write_header();
+}
+
+MappedTimeseries::~MappedTimeseries()
+{
+    try {
+        close();
+    }
+    catch (std::runtime_error& e) {
+        std::cerr << "mcpele::MappedTimeseries: " << e.what() << std::endl;
+    }
+}
+
+void MappedTimeseries::m_map_file(const size_t capacity)
+{
+    m_unmap();
+    const size_t nbytes = m_file_size(capacity);
+    if (::ftruncate(m_fd, nbytes) != 0) {
+        throw std::runtime_error(system_error("cannot resize", m_filename));
+    }
+    void* map = ::mmap(NULL, nbytes, PROT_READ | PROT_WRITE, MAP_SHARED, m_fd, 0);
+    if (map == MAP_FAILED) {
+        throw std::runtime_error(system_error("cannot map", m_filename));
+    }
+    m_map = static_cast<char*>(map);
+    m_capacity = capacity;
+}
+
+void MappedTimeseries::m_unmap()
+{
+    if (m_map != NULL) {
+        ::munmap(m_map, m_file_size(m_capacity));
+        m_map = NULL;
+    }
+}
+
+void MappedTimeseries::m_write_header()
+{
+    char dict[header_size];
+    int len;
+    const char* descr = is_little_endian() ? "<f8" : ">f8";
+    if (m_one_dimensional) {
+        len = std::snprintf(dict, sizeof(dict), "{'descr': '%s', 'fortran_order': False, 'shape': (%lu,), }",
+                descr, static_cast<unsigned long>(m_nr_rows));
+    }
+    else {
+        len = std::snprintf(dict, sizeof(dict), "{'descr': '%s', 'fortran_order': False, 'shape': (%lu, %lu), }",
+                descr, static_cast<unsigned long>(m_nr_rows), static_cast<unsigned long>(m_row_size));
+    }
+    // magic, version 1.0, little endian header length, dict padded with spaces and ended by a newline
+    const size_t dict_size = header_size - 10;
+    if (len < 0 || static_cast<size_t>(len) >= dict_size) {
+        throw std::runtime_error("MappedTimeseries: header too long");
+    }
+    char* header = m_map;
+    std::memcpy(header, "\x93NUMPY\x01\x00", 8);
+    header[8] = static_cast<char>(dict_size & 0xff);
+    header[9] = static_cast<char>(dict_size >> 8);
+    std::memcpy(header + 10, dict, len);
+    std::memset(header + 10 + len, ' ', dict_size - len - 1);
+    header[header_size - 1] = '\n';
+}
+
+void MappedTimeseries::flush()
+{
+    if (m_map == NULL) {
+        return;
+    }
+    m_write_header();
+    if (::msync(m_map, m_file_size(m_nr_rows), MS_ASYNC) != 0) {
+        throw std::runtime_error(system_error("cannot flush", m_filename));
+    }
+}
+
+void MappedTimeseries::clear()
+{
+    m_nr_rows = 0;
+    flush();
+}
+
+void MappedTimeseries::close()
+{
+    if (m_fd < 0) {
+        return;
+    }
+    if (m_map != NULL) {
+        m_write_header();
+        ::msync(m_map, m_file_size(m_nr_rows), MS_SYNC);
+        m_unmap();
+    }
+    const int truncated = ::ftruncate(m_fd, m_file_size(m_nr_rows));
+    ::close(m_fd);
+    m_fd = -1;
+    if (truncated != 0) {
+        throw std::runtime_error(system_error("cannot resize", m_filename));
+    }
+}
+
+} // namespace mcpele
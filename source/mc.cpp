@@ -10,6 +10,7 @@ MC::MC(std::shared_ptr<pele::BasePotential> potential, Array<double>& coords, co
       m_coords(coords.copy()),
       m_trial_coords(m_coords.copy()),
       m_take_step(NULL),
+      m_stop_check_every(1000),
       m_nitercount(0),
       m_accept_count(0),
       m_E_reject_count(0),
@@ -83,6 +84,25 @@ void MC::do_actions(Array<double> x, double energy, bool success)
     }
 }
 
+bool MC::do_stop_criteria()
+{
+    for (auto & criterion : m_stop_criteria) {
+        if (criterion->stop(this)) {
+            m_stop_reason = criterion->get_reason();
+            return true;
+        }
+    }
+    return false;
+}
+
+void MC::set_stop_check_every(const size_t stop_check_every)
+{
+    if (stop_check_every == 0) {
+        throw std::runtime_error("MC::set_stop_check_every: expected to be at least 1");
+    }
+    m_stop_check_every = stop_check_every;
+}
+
 void MC::take_steps()
 {
     m_take_step->displace(m_trial_coords, this);
@@ -155,7 +175,12 @@ void MC::check_input()
 
 void MC::set_coordinates(pele::Array<double>& coords, double energy)
 {
-    m_coords = coords.copy();
+    if (coords.size() == m_coords.size()) {
+        m_coords.assign(coords);
+    }
+    else {
+        m_coords = coords.copy();
+    }
     m_energy = energy;
 }
 
@@ -172,11 +197,22 @@ void MC::run(size_t max_iter)
 {
     check_input();
     progress stat(max_iter);
+    for (auto & criterion : m_stop_criteria) {
+        criterion->start(this);
+    }
+    m_stop_reason = "max_iter";
     while(m_niter < max_iter) {
         this->one_iteration();
         if (m_print_progress) {
             stat.next(m_niter);
         }
+        if (m_niter == std::numeric_limits<size_t>::max()) {
+            m_stop_reason = "aborted";
+            break;
+        }
+        if (!m_stop_criteria.empty() && m_niter % m_stop_check_every == 0 && do_stop_criteria()) {
+            break;
+        }
     }
     m_niter = 0;
 }
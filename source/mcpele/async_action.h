@@ -0,0 +1,80 @@
+#ifndef _MCPELE_ASYNC_ACTION_H__
+#define _MCPELE_ASYNC_ACTION_H__
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "mc.h"
+#include "snapshot_mc.h"
+
+namespace mcpele {
+
+/**
+ * Run expensive actions (e.g. a quench in RecordPairDistHistogram, or the
+ * LBFGS of RecordLowestEValueTimeseries) on worker threads, so that the
+ * chain keeps moving.
+ * Every record_every-th step after eqsteps steps the coordinates are copied
+ * into a pooled buffer and queued. Each worker thread owns one of the
+ * worker actions, which must be independent instances (with their own
+ * potential and optimizer), and calls it for the queued configurations.
+ * The worker actions see a SnapshotMC of the queued step, so they can be
+ * constructed with the same record_every and eqsteps.
+ * At most max_queue configurations wait at any time: action() blocks while
+ * the queue is full.
+ * Each worker action accumulates its own results, in the order in which
+ * its worker took the configurations; call flush() before reading them.
+ * An exception thrown by a worker action is rethrown by the next call to
+ * action() or flush().
+ */
+class AsyncAction : public Action {
+private:
+    struct Job {
+        pele::Array<double> coords;
+        double energy;
+        double temperature;
+        bool accepted;
+        size_t step;
+    };
+    const size_t m_record_every;
+    const size_t m_eqsteps;
+    const size_t m_max_queue;
+    std::vector<std::shared_ptr<Action> > m_actions;
+    std::vector<std::thread> m_threads;
+    std::deque<Job> m_queue;
+    std::vector<pele::Array<double> > m_buffer_pool;
+    size_t m_nr_busy;
+    size_t m_nr_processed;
+    bool m_stop;
+    std::exception_ptr m_error;
+    std::mutex m_mutex;
+    std::condition_variable m_job_ready;
+    std::condition_variable m_job_done;
+    void m_work(const size_t iworker);
+    void m_stop_workers();
+    void m_rethrow_error();
+public:
+    AsyncAction(std::vector<std::shared_ptr<Action> > worker_actions, const size_t record_every,
+            const size_t eqsteps, const size_t max_queue=0);
+    virtual ~AsyncAction();
+    virtual void action(pele::Array<double> &coords, double energy, bool accepted, MC* mc);
+    /**
+     * wait until all queued configurations are processed
+     */
+    void flush();
+    size_t get_nr_threads() const { return m_actions.size(); }
+    size_t get_max_queue() const { return m_max_queue; }
+    /**
+     * number of configurations processed by the worker actions
+     */
+    size_t get_nr_processed();
+    std::shared_ptr<Action> get_worker_action(const size_t iworker) const { return m_actions.at(iworker); }
+};
+
+} // namespace mcpele
+
+#endif // #ifndef _MCPELE_ASYNC_ACTION_H__
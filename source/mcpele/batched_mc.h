@@ -0,0 +1,230 @@
+#ifndef _MCPELE_BATCHED_MC_H__
+#define _MCPELE_BATCHED_MC_H__
+
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "pele/array.h"
+#include "pele/base_potential.h"
+
+#include "mc.h"
+
+namespace mcpele {
+
+/**
+ * Interfaces for the batched Monte Carlo engine.
+ * All batched objects work on nwalkers walkers of ndof coordinates each,
+ * stored in structure-of-arrays layout: coordinate i of walker w is
+ * x[i * nwalkers + w]. Loops over walkers are then innermost and contiguous,
+ * so that they vectorise.
+ */
+
+/*
+ * Batched Potential
+ */
+
+/**
+ * energies only need to be computed for the walkers with active[w] true
+ */
+class BatchedPotential {
+public:
+    virtual ~BatchedPotential() {}
+    virtual void get_energies(const double* x, const size_t nwalkers,
+            const size_t ndof, const char* active, double* energies) =0;
+};
+
+/**
+ * scalar fallback, gathers each walker and calls the wrapped pele potential
+ */
+class BatchedPotentialAdaptor : public BatchedPotential {
+protected:
+    std::shared_ptr<pele::BasePotential> m_potential;
+    pele::Array<double> m_walker;
+public:
+    BatchedPotentialAdaptor(std::shared_ptr<pele::BasePotential> potential)
+        : m_potential(potential)
+    {}
+    virtual ~BatchedPotentialAdaptor() {}
+    virtual void get_energies(const double* x, const size_t nwalkers,
+            const size_t ndof, const char* active, double* energies);
+};
+
+class BatchedNullPotential : public BatchedPotential {
+public:
+    virtual ~BatchedNullPotential() {}
+    virtual void get_energies(const double*, const size_t nwalkers,
+            const size_t, const char*, double* energies)
+    {
+        std::fill(energies, energies + nwalkers, 0);
+    }
+};
+
+/*
+ * Batched Conf Test
+ * result[w] is set to false for the walkers which fail the test, it is never
+ * set to true, so that several tests can be chained
+ */
+
+class BatchedConfTest {
+public:
+    virtual ~BatchedConfTest() {}
+    virtual void conf_test(const double* x, const size_t nwalkers,
+            const size_t ndof, char* result) =0;
+};
+
+/**
+ * scalar fallback, gathers each walker and calls the wrapped ConfTest
+ * (with a NULL MC pointer)
+ */
+class BatchedConfTestAdaptor : public BatchedConfTest {
+protected:
+    std::shared_ptr<ConfTest> m_test;
+    pele::Array<double> m_walker;
+public:
+    BatchedConfTestAdaptor(std::shared_ptr<ConfTest> test)
+        : m_test(test)
+    {}
+    virtual ~BatchedConfTestAdaptor() {}
+    virtual void conf_test(const double* x, const size_t nwalkers,
+            const size_t ndof, char* result);
+};
+
+/**
+ * batched CheckSphericalContainerConfig
+ */
+class BatchedCheckSphericalContainerConfig : public BatchedConfTest {
+protected:
+    const double m_radius2;
+    std::vector<double> m_r2;
+public:
+    BatchedCheckSphericalContainerConfig(const double radius)
+        : m_radius2(radius * radius)
+    {}
+    virtual ~BatchedCheckSphericalContainerConfig() {}
+    virtual void conf_test(const double* x, const size_t nwalkers,
+            const size_t ndof, char* result);
+};
+
+/*
+ * Batched Take Step
+ */
+
+class BatchedTakeStep {
+public:
+    virtual ~BatchedTakeStep() {}
+    virtual void displace(double* x, const size_t nwalkers, const size_t ndof) =0;
+};
+
+/**
+ * batched RandomCoordsDisplacementAll
+ */
+class BatchedRandomCoordsDisplacement : public BatchedTakeStep {
+protected:
+    std::mt19937_64 m_generator;
+    std::uniform_real_distribution<double> m_distribution;
+    double m_stepsize;
+    std::vector<double> m_rand;
+public:
+    BatchedRandomCoordsDisplacement(const size_t rseed, const double stepsize=1)
+        : m_generator(rseed),
+          m_distribution(-0.5, 0.5),
+          m_stepsize(stepsize)
+    {}
+    virtual ~BatchedRandomCoordsDisplacement() {}
+    virtual void displace(double* x, const size_t nwalkers, const size_t ndof);
+    void set_generator_seed(const size_t inp) { m_generator.seed(inp); }
+    double get_stepsize() const { return m_stepsize; }
+    void set_stepsize(const double input) { m_stepsize = input; }
+};
+
+/**
+ * batched UniformRectangularSampling
+ */
+class BatchedUniformRectangularSampling : public BatchedTakeStep {
+protected:
+    std::mt19937_64 m_generator;
+    std::uniform_real_distribution<double> m_distribution;
+    pele::Array<double> m_boxvec;
+public:
+    BatchedUniformRectangularSampling(const size_t seed, const pele::Array<double> boxvec)
+        : m_generator(seed),
+          m_distribution(-0.5, 0.5),
+          m_boxvec(boxvec.copy())
+    {}
+    virtual ~BatchedUniformRectangularSampling() {}
+    virtual void displace(double* x, const size_t nwalkers, const size_t ndof);
+    void set_generator_seed(const size_t inp) { m_generator.seed(inp); }
+};
+
+/**
+ * Batched Monte Carlo
+ * Advances nwalkers independent Markov chains in lockstep. Each iteration
+ * displaces all walkers, runs the conf tests, computes the trial energies
+ * and applies the Metropolis criterion, each stage for all walkers at once.
+ * This removes the per-step virtual call overhead of MC for many small
+ * systems (e.g. integration-type runs with a NullPotential, or small
+ * clusters), and lets the compiler vectorise across walkers.
+ * Walkers whose trial configuration fails a conf test, or is rejected by the
+ * Metropolis test, keep their old configuration, as in MC.
+ * The Metropolis test is always applied, with the temperature given to the
+ * constructor.
+ */
+class BatchedMC {
+protected:
+    std::shared_ptr<BatchedPotential> m_potential;
+    std::vector<std::shared_ptr<BatchedConfTest> > m_conf_tests;
+    std::shared_ptr<BatchedTakeStep> m_take_step;
+    const size_t m_nwalkers;
+    const size_t m_ndof;
+    std::vector<double> m_coords;
+    std::vector<double> m_trial_coords;
+    std::vector<double> m_energies;
+    std::vector<double> m_trial_energies;
+    std::vector<char> m_success;
+    std::vector<double> m_rand;
+    std::vector<size_t> m_accept_count;
+    std::vector<size_t> m_conf_reject_count;
+    std::mt19937_64 m_generator;
+    std::uniform_real_distribution<double> m_distribution;
+    double m_temperature;
+    size_t m_nitercount;
+public:
+    /**
+     * coords holds the initial configuration of every walker one after
+     * the other (i.e. nwalkers * ndof values in the usual layout)
+     */
+    BatchedMC(std::shared_ptr<BatchedPotential> potential, pele::Array<double> coords,
+            const size_t nwalkers, const double temperature, const size_t rseed=42);
+    virtual ~BatchedMC() {}
+    void one_iteration();
+    void run(const size_t max_iter);
+    void add_conf_test(std::shared_ptr<BatchedConfTest> conf_test) { m_conf_tests.push_back(conf_test); }
+    void set_takestep(std::shared_ptr<BatchedTakeStep> takestep) { m_take_step = takestep; }
+    void set_temperature(const double T) { m_temperature = T; }
+    double get_temperature() const { return m_temperature; }
+    size_t get_nwalkers() const { return m_nwalkers; }
+    size_t get_ndof() const { return m_ndof; }
+    size_t get_iterations_count() const { return m_nitercount; }
+    pele::Array<double> get_coords(const size_t walker) const;
+    pele::Array<double> get_energies() const;
+    double get_energy(const size_t walker) const { return m_energies.at(walker); }
+    size_t get_naccept(const size_t walker) const { return m_accept_count.at(walker); }
+    size_t get_naccept() const;
+    size_t get_nconf_reject() const;
+    /**
+     * accepted fraction over all walkers and iterations
+     */
+    double get_accepted_fraction() const;
+    double get_conf_rejection_fraction() const;
+protected:
+    void m_compute_energies(const std::vector<double>& x, const std::vector<char>& active,
+            std::vector<double>& energies)
+    {
+        m_potential->get_energies(x.data(), m_nwalkers, m_ndof, active.data(), energies.data());
+    }
+};
+
+} // namespace mcpele
+
+#endif // #ifndef _MCPELE_BATCHED_MC_H__
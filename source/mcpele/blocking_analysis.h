@@ -0,0 +1,56 @@
+#ifndef _MCPELE_BLOCKING_ANALYSIS_H__
+#define _MCPELE_BLOCKING_ANALYSIS_H__
+
+#include <vector>
+
+#include "histogram.h"
+
+namespace mcpele {
+
+/**
+ * Streaming blocking analysis of the error of the mean of a correlated
+ * series (Flyvbjerg and Petersen, J. Chem. Phys. 91, 461 (1989)).
+ * Level k holds the Moments of the averages of consecutive blocks of 2^k
+ * samples; a block is passed on to level k + 1 as soon as its partner is
+ * complete, so memory is O(log T).
+ * The standard error estimate of level k is sqrt(var_k / (n_k - 1)), with
+ * uncertainty se_k / sqrt(2 (n_k - 1)). It grows with the block size until
+ * the blocks are uncorrelated; get_standard_error() returns the first
+ * estimate, with at least min_blocks blocks, that agrees with the next one
+ * within its uncertainty (the plateau), or the largest one if there is no
+ * plateau yet.
+ */
+class BlockingAnalysis {
+private:
+    const size_t m_min_blocks;
+    std::vector<Moments> m_levels;
+    std::vector<double> m_pending;
+    std::vector<bool> m_has_pending;
+    size_t m_get_nr_levels_used() const;
+    size_t m_get_plateau_level() const;
+public:
+    BlockingAnalysis(const size_t min_blocks=16);
+    void add(const double x);
+    void operator() (const double x) { add(x); }
+    void clear();
+    size_t get_count() const { return m_levels.empty() ? 0 : m_levels[0].count(); }
+    double get_mean() const { return m_levels.empty() ? 0 : m_levels[0].mean(); }
+    double get_variance() const { return m_levels.empty() ? 0 : m_levels[0].variance(); }
+    /**
+     * block sizes, standard errors and their uncertainties of the levels
+     * with at least min_blocks blocks
+     */
+    std::vector<double> get_block_sizes() const;
+    std::vector<double> get_standard_errors() const;
+    std::vector<double> get_standard_error_errors() const;
+    double get_standard_error() const;
+    bool has_plateau() const;
+    /**
+     * statistical inefficiency (se / se_0)^2, about 2 tau_int
+     */
+    double get_statistical_inefficiency() const;
+};
+
+} // namespace mcpele
+
+#endif // #ifndef _MCPELE_BLOCKING_ANALYSIS_H__
@@ -0,0 +1,151 @@
+#ifndef _MCPELE_CHUNKED_ARENA_H__
+#define _MCPELE_CHUNKED_ARENA_H__
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+#include <pele/array.h>
+
+namespace mcpele {
+
+/**
+ * Row-major storage for a sequence of equally sized vectors.
+ * Rows are copied into large chunks, each chunk is a single allocation
+ * holding whole rows. Chunks double in size from about 64 KiB up to
+ * about 64 MiB (but always hold at least one row), so recording n rows
+ * costs O(log n) allocations while the tail waste stays bounded.
+ * Chunks are reference counted pele::Arrays: rows and chunks are handed
+ * out as views that stay valid after clear() or compact().
+ */
+class ChunkedArena {
+private:
+    static const size_t m_min_chunk_bytes = 1 << 16;
+    static const size_t m_max_chunk_bytes = 1 << 26;
+    size_t m_row_size;
+    size_t m_nr_rows;
+    size_t m_next_chunk_rows;
+    std::vector<pele::Array<double> > m_chunks;
+    /**
+     * number of rows stored in each chunk, only the last one may be partially filled
+     */
+    std::vector<size_t> m_chunk_rows;
+    void m_add_chunk(const size_t nr_rows)
+    {
+        m_chunks.push_back(pele::Array<double>(nr_rows * m_row_size));
+        m_chunk_rows.push_back(0);
+    }
+    void m_grow()
+    {
+        if (m_next_chunk_rows == 0) {
+            const size_t row_bytes = m_row_size * sizeof(double);
+            m_next_chunk_rows = std::max<size_t>(1, m_min_chunk_bytes / row_bytes);
+        }
+        m_add_chunk(m_next_chunk_rows);
+        const size_t max_rows = std::max<size_t>(1, m_max_chunk_bytes / (m_row_size * sizeof(double)));
+        m_next_chunk_rows = std::min(2 * m_next_chunk_rows, max_rows);
+    }
+    size_t m_chunk_capacity(const size_t ichunk) const
+    {
+        return m_chunks[ichunk].size() / m_row_size;
+    }
+public:
+    ChunkedArena()
+        : m_row_size(0),
+          m_nr_rows(0),
+          m_next_chunk_rows(0)
+    {}
+    /**
+     * copy a row to the end of the arena, the first row fixes the row size
+     */
+    void push_back(const pele::Array<double>& row)
+    {
+        if (m_row_size == 0) {
+            if (row.size() == 0) {
+                throw std::runtime_error("ChunkedArena: rows must not be empty");
+            }
+            m_row_size = row.size();
+        }
+        else if (row.size() != m_row_size) {
+            throw std::runtime_error("ChunkedArena: row size differs from previous rows");
+        }
+        if (m_chunks.empty() || m_chunk_rows.back() == m_chunk_capacity(m_chunks.size() - 1)) {
+            m_grow();
+        }
+        double* dest = m_chunks.back().data() + m_chunk_rows.back() * m_row_size;
+        std::memcpy(dest, row.data(), m_row_size * sizeof(double));
+        ++m_chunk_rows.back();
+        ++m_nr_rows;
+    }
+    size_t size() const { return m_nr_rows; }
+    size_t row_size() const { return m_row_size; }
+    bool empty() const { return m_nr_rows == 0; }
+    size_t get_nr_chunks() const { return m_chunks.size(); }
+    /**
+     * number of rows stored in chunk ichunk
+     */
+    size_t get_chunk_nr_rows(const size_t ichunk) const
+    {
+        return m_chunk_rows.at(ichunk);
+    }
+    /**
+     * view of the filled part of chunk ichunk, row-major
+     */
+    pele::Array<double> get_chunk(const size_t ichunk) const
+    {
+        return m_chunks.at(ichunk).view(0, m_chunk_rows.at(ichunk) * m_row_size);
+    }
+    /**
+     * view of row irow
+     */
+    pele::Array<double> get_row(size_t irow) const
+    {
+        if (irow >= m_nr_rows) {
+            throw std::runtime_error("ChunkedArena::get_row: index out of range");
+        }
+        size_t ichunk = 0;
+        while (irow >= m_chunk_rows[ichunk]) {
+            irow -= m_chunk_rows[ichunk];
+            ++ichunk;
+        }
+        return m_chunks[ichunk].view(irow * m_row_size, (irow + 1) * m_row_size);
+    }
+    /**
+     * move all rows into a single exactly sized chunk, so that the
+     * whole arena is one contiguous row-major block.
+     * Recording may continue afterwards, it starts a new chunk.
+     */
+    void compact()
+    {
+        if (m_chunks.size() == 1 && m_chunk_rows[0] == m_chunk_capacity(0)) {
+            return;
+        }
+        if (m_nr_rows == 0) {
+            m_chunks.clear();
+            m_chunk_rows.clear();
+            return;
+        }
+        pele::Array<double> block(m_nr_rows * m_row_size);
+        double* dest = block.data();
+        for (size_t i = 0; i < m_chunks.size(); ++i) {
+            const size_t n = m_chunk_rows[i] * m_row_size;
+            std::memcpy(dest, m_chunks[i].data(), n * sizeof(double));
+            dest += n;
+        }
+        m_chunks.assign(1, block);
+        m_chunk_rows.assign(1, m_nr_rows);
+    }
+    void clear()
+    {
+        m_chunks.clear();
+        m_chunk_rows.clear();
+        m_row_size = 0;
+        m_nr_rows = 0;
+        m_next_chunk_rows = 0;
+    }
+};
+
+} // namespace mcpele
+
+#endif // #ifndef _MCPELE_CHUNKED_ARENA_H__
@@ -0,0 +1,87 @@
+#ifndef _MCPELE_COMPRESSED_TRAJECTORY_H__
+#define _MCPELE_COMPRESSED_TRAJECTORY_H__
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <pele/array.h>
+
+namespace mcpele {
+
+/**
+ * Lossy fixed precision trajectory format.
+ *
+ * Every coordinate is rounded to an integer multiple of the precision.
+ * A keyframe stores these integers, any other frame stores their
+ * difference to the previous frame. The values are zigzag encoded and
+ * written as variable length integers (7 bits per byte, the high bit
+ * marks a continuation), so that small displacements take one or two
+ * bytes instead of eight.
+ *
+ * Layout, all little endian:
+ *   header: 8 byte magic "MCPTRAJ1", uint64 ndof, double precision
+ *   frame:  uint64 step, double energy, uint32 flags (1 for keyframe),
+ *           uint32 number of payload bytes, payload
+ */
+class CompressedTrajectoryWriter {
+private:
+    std::ofstream m_file;
+    const size_t m_ndof;
+    const double m_precision;
+    const double m_inv_precision;
+    const size_t m_keyframe_every;
+    const size_t m_buffer_size;
+    std::vector<int64_t> m_previous;
+    std::vector<int64_t> m_quantized;
+    std::vector<unsigned char> m_buffer;
+    std::vector<unsigned char> m_payload;
+    size_t m_nr_frames;
+    size_t m_bytes_written;
+    void m_write_buffer();
+public:
+    CompressedTrajectoryWriter(const std::string& filename, const size_t ndof,
+            const double precision=1e-3, const size_t keyframe_every=100,
+            const size_t buffer_size=1<<20);
+    virtual ~CompressedTrajectoryWriter();
+    void write_frame(const pele::Array<double>& coords, const size_t step, const double energy);
+    /**
+     * write buffered frames to the file
+     */
+    void flush();
+    size_t get_nr_frames() const { return m_nr_frames; }
+    /**
+     * number of bytes in the file, including buffered frames
+     */
+    size_t get_bytes_written() const { return m_bytes_written + m_buffer.size(); }
+    size_t get_ndof() const { return m_ndof; }
+    double get_precision() const { return m_precision; }
+};
+
+/**
+ * Sequential reader for files written by CompressedTrajectoryWriter
+ */
+class CompressedTrajectoryReader {
+private:
+    std::ifstream m_file;
+    size_t m_ndof;
+    double m_precision;
+    std::vector<int64_t> m_previous;
+    std::vector<unsigned char> m_payload;
+    size_t m_nr_frames;
+public:
+    CompressedTrajectoryReader(const std::string& filename);
+    virtual ~CompressedTrajectoryReader() {}
+    /**
+     * read the next frame into coords (of size ndof), returns false at the end of the file
+     */
+    bool read_frame(pele::Array<double> coords, size_t& step, double& energy);
+    size_t get_nr_frames() const { return m_nr_frames; }
+    size_t get_ndof() const { return m_ndof; }
+    double get_precision() const { return m_precision; }
+};
+
+} // namespace mcpele
+
+#endif // #ifndef _MCPELE_COMPRESSED_TRAJECTORY_H__
@@ -0,0 +1,68 @@
+#ifndef _MCPELE_DISPLACEMENT_CORRELATOR_H__
+#define _MCPELE_DISPLACEMENT_CORRELATOR_H__
+
+#include <vector>
+
+namespace mcpele {
+
+/**
+ * Online multi-origin mean square displacement and self intermediate
+ * scattering function of a sequence of (unwrapped) configurations.
+ * The configurations are kept in multi-tau levels, as in
+ * MultiTauCorrelator: level 0 holds the last nr_lags configurations and
+ * correlates lags 1, ..., nr_lags - 1. Every second configuration entering
+ * level k is also added to level k + 1, which correlates lags
+ * nr_lags / 2, ..., nr_lags - 1 in units of 2^(k+1) configurations.
+ * Configurations are subsampled, not averaged, so each lag is an exact
+ * time difference, averaged over all origins at that level. Memory is
+ * O(nr_lags ndof log T) for T configurations.
+ * With the displacement d = x(t0 + t) - x(t0) of each degree of freedom,
+ *   msd(t) = < sum_{dof} d^2 > / nr_particles
+ *   fs(t)  = < sum_{dof} cos(q d) > / ndof
+ * i.e. the self intermediate scattering function is averaged over wave
+ * vectors of length q along the ndim axes.
+ */
+class DisplacementCorrelator {
+private:
+    const size_t m_ndim;
+    const double m_wavenumber;
+    const size_t m_nr_lags;
+    const size_t m_max_levels;
+    size_t m_ndof;
+    std::vector<std::vector<double> > m_shift;
+    std::vector<size_t> m_nr_inserted;
+    std::vector<std::vector<double> > m_msd;
+    std::vector<std::vector<double> > m_fs;
+    std::vector<std::vector<size_t> > m_nr_corr;
+    void m_add(const double* x, const size_t level);
+    void m_add_level();
+public:
+    /**
+     * ndim: dimension of the space, the number of particles is ndof / ndim
+     * wavenumber: q of the self intermediate scattering function, 0 to skip it
+     * nr_lags: lags per level, even and at least 2
+     * max_levels: cap on the number of levels, 0 for no cap
+     */
+    DisplacementCorrelator(const size_t ndim, const double wavenumber=0,
+            const size_t nr_lags=16, const size_t max_levels=0);
+    virtual ~DisplacementCorrelator() {}
+    void add(const double* x, const size_t ndof);
+    void clear();
+    size_t get_count() const { return m_nr_inserted.empty() ? 0 : m_nr_inserted[0]; }
+    size_t get_nr_levels() const { return m_shift.size(); }
+    double get_wavenumber() const { return m_wavenumber; }
+    /**
+     * lags, in units of configurations, with at least one origin
+     */
+    std::vector<double> get_lags() const;
+    std::vector<double> get_mean_square_displacement() const;
+    std::vector<double> get_self_intermediate_scattering() const;
+    /**
+     * number of origins averaged at each of get_lags()
+     */
+    std::vector<double> get_nr_origins() const;
+};
+
+} // namespace mcpele
+
+#endif // #ifndef _MCPELE_DISPLACEMENT_CORRELATOR_H__
@@ -21,6 +21,10 @@ public:
     virtual bool test(pele::Array<double> &trial_coords, double trial_energy,
             pele::Array<double> & old_coords, double old_energy, double temperature,
             MC * mc);
+    double get_min_energy() const { return m_min_energy; }
+    double get_max_energy() const { return m_max_energy; }
+    void set_min_energy(const double min_energy) { m_min_energy = min_energy; }
+    void set_max_energy(const double max_energy) { m_max_energy = max_energy; }
 };
 
 } // namesapce mcpele
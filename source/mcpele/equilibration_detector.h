@@ -0,0 +1,60 @@
+#ifndef _MCPELE_EQUILIBRATION_DETECTOR_H__
+#define _MCPELE_EQUILIBRATION_DETECTOR_H__
+
+#include <vector>
+
+#include "mc.h"
+
+namespace mcpele {
+
+/**
+ * Detect equilibration from the energy, instead of a fixed eqsteps.
+ * The energy is recorded every record_every-th step. Every nr_samples / 4
+ * records, the last nr_samples energies are tested for stationarity with
+ * moving_average_is_stable(): the moving averages over windows of
+ * nr_samples / 2 energies, from the first to the second half, must have a
+ * standard deviation below threshold times that of the energies themselves.
+ * Once the energy is stationary:
+ * --- the step size adaptation of the MC is ended (set_report_steps)
+ * --- the actions added to the detector are switched on, i.e. they are
+ *     called from then on; they should be constructed with eqsteps = 0
+ */
+class EquilibrationDetector : public Action {
+private:
+    const size_t m_record_every;
+    const size_t m_nr_samples;
+    const double m_threshold;
+    std::vector<double> m_energies;
+    size_t m_nr_recorded;
+    bool m_equilibrated;
+    size_t m_equilibration_step;
+    MC::actions_t m_actions;
+public:
+    EquilibrationDetector(const size_t record_every, const size_t nr_samples, const double threshold=0.1);
+    virtual ~EquilibrationDetector() {}
+    virtual void action(pele::Array<double> &coords, double energy, bool accepted, MC* mc);
+    void add_action(std::shared_ptr<Action> action) { m_actions.push_back(action); }
+    bool is_equilibrated() const { return m_equilibrated; }
+    /**
+     * MC step at which equilibration was detected, 0 before
+     */
+    size_t get_equilibration_step() const { return m_equilibration_step; }
+    /**
+     * test the last nr_steps_total entries of time_series for stationarity
+     */
+    static bool moving_average_is_stable(const std::vector<double>& time_series,
+            const size_t nr_steps_total, const double threshold)
+    {
+        return moving_average_is_stable(time_series.data(), time_series.data() + time_series.size(),
+                nr_steps_total, threshold);
+    }
+    /**
+     * test the last nr_steps_total entries of the time series [begin, end)
+     */
+    static bool moving_average_is_stable(const double* begin, const double* end,
+            const size_t nr_steps_total, const double threshold);
+};
+
+} // namespace mcpele
+
+#endif // #ifndef _MCPELE_EQUILIBRATION_DETECTOR_H__
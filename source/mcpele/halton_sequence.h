@@ -0,0 +1,55 @@
+#ifndef _MCPELE_HALTON_SEQUENCE_H__
+#define _MCPELE_HALTON_SEQUENCE_H__
+
+#include <cstddef>
+#include <vector>
+
+namespace mcpele {
+
+/**
+ * Low-discrepancy Halton sequence in ndim dimensions.
+ * Dimension d uses the radical inverse of the point index in the d-th prime
+ * base. If scrambling is enabled, the digits at each position are passed
+ * through a random permutation (one per dimension and digit position), drawn
+ * from a generator seeded with seed. Scrambling removes the strong
+ * correlations between the higher dimensions of the plain Halton sequence and
+ * makes independent randomisations possible for error estimates.
+ * Every point is computed directly from its index, so skipping ahead is O(1).
+ * Parallel chunks of n points can be generated by giving each chunk the same
+ * seed and calling skip_ahead(chunk_index * n).
+ *
+ * Reference
+ * ---------
+ * Owen, A. B., "A randomized Halton algorithm in R", arXiv:1706.02808 (2017)
+ */
+class HaltonSequence {
+private:
+    const size_t m_ndim;
+    const bool m_scramble;
+    size_t m_index;
+    std::vector<size_t> m_bases;
+    std::vector<size_t> m_ndigits;
+    std::vector<std::vector<size_t> > m_permutations;
+public:
+    HaltonSequence(const size_t ndim, const size_t seed=42, const bool scramble=true);
+    virtual ~HaltonSequence() {}
+    /**
+     * write the next point of the sequence into x, which holds ndim values
+     */
+    void next(double* x) { get_point(m_index++, x); }
+    void get_point(const size_t index, double* x) const;
+    double get_coordinate(const size_t index, const size_t dim) const;
+    void skip_ahead(const size_t n) { m_index += n; }
+    void set_index(const size_t index) { m_index = index; }
+    size_t get_index() const { return m_index; }
+    size_t get_ndim() const { return m_ndim; }
+    size_t get_base(const size_t dim) const { return m_bases.at(dim); }
+    /**
+     * draw a new set of digit permutations
+     */
+    void set_seed(const size_t seed);
+};
+
+} // namespace mcpele
+
+#endif // #ifndef _MCPELE_HALTON_SEQUENCE_H__
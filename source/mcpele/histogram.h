@@ -6,6 +6,9 @@
 #include <list>
 #include <iostream>
 #include <limits>
+#include <utility>
+#include <stdexcept>
+#include <vector>
 
 #include "pele/array.h"
 
@@ -23,42 +26,220 @@ namespace mcpele {
  *      beads as the number of iterations (commented out at the end of the script)
  * */
 
+/**
+ * Streaming mean and variance (Welford's algorithm), optionally with the
+ * third and fourth central moments.
+ * The running mean and sum of squared deviations are accumulated with
+ * compensated (Kahan) summation, so that very long runs do not lose
+ * precision, and the variance does not suffer from the cancellation of
+ * E[x^2] - E[x]^2.
+ * Samples can also be added as a whole array (update(begin, end)): each
+ * chunk is reduced with plain, vectorisable two-pass sums and then merged
+ * with the pairwise formulas of Chan et al. and Pebay.
+ */
 class Moments {
 public:
     typedef double data_t;
     typedef size_t index_t;
 private:
+    static const size_t m_chunk_size = 1024;
     data_t m_mean;
-    data_t m_mean2;
+    data_t m_m2;
+    data_t m_m3;
+    data_t m_m4;
+    data_t m_mean_comp;
+    data_t m_m2_comp;
     index_t m_count;
+    bool m_higher;
+    static void m_kahan_add(data_t& sum, data_t& comp, const data_t value)
+    {
+        const data_t y = value - comp;
+        const data_t t = sum + y;
+        comp = (t - sum) - y;
+        sum = t;
+    }
 public:
-    Moments()
+    explicit Moments(const bool higher_moments=false)
         : m_mean(0),
-          m_mean2(0),
-          m_count(0)
+          m_m2(0),
+          m_m3(0),
+          m_m4(0),
+          m_mean_comp(0),
+          m_m2_comp(0),
+          m_count(0),
+          m_higher(higher_moments)
     {}
     void update(const data_t input)
     {
-        m_mean = (m_mean * m_count + input) / (m_count + 1);
-        m_mean2 = (m_mean2 * m_count + (input * input)) / (m_count + 1);
         if (m_count == std::numeric_limits<index_t>::max()) {
             throw std::runtime_error("Moments: update: integer overflow");
         }
+        const data_t n1 = m_count;
         ++m_count;
+        const data_t n = m_count;
+        const data_t delta = input - m_mean;
+        const data_t delta_n = delta / n;
+        const data_t term = delta * delta_n * n1;
+        if (m_higher) {
+            const data_t delta_n2 = delta_n * delta_n;
+            m_m4 += term * delta_n2 * (n * n - 3 * n + 3) + 6 * delta_n2 * m_m2 - 4 * delta_n * m_m3;
+            m_m3 += term * delta_n * (n - 2) - 3 * delta_n * m_m2;
+        }
+        m_kahan_add(m_mean, m_mean_comp, delta_n);
+        m_kahan_add(m_m2, m_m2_comp, term);
     }
     /**
-     * replace a data point with another one
+     * add the samples in [begin, end)
+     */
+    void update(const data_t* begin, const data_t* end)
+    {
+        const size_t chunk_size = m_chunk_size;
+        while (begin < end) {
+            const data_t* chunk_end = begin + std::min<size_t>(chunk_size, end - begin);
+            const data_t nb = chunk_end - begin;
+            data_t sum = 0;
+            for (const data_t* x = begin; x < chunk_end; ++x) {
+                sum += *x;
+            }
+            Moments chunk(m_higher);
+            chunk.m_count = chunk_end - begin;
+            chunk.m_mean = sum / nb;
+            data_t m2 = 0;
+            data_t m3 = 0;
+            data_t m4 = 0;
+            if (m_higher) {
+                for (const data_t* x = begin; x < chunk_end; ++x) {
+                    const data_t d = *x - chunk.m_mean;
+                    const data_t d2 = d * d;
+                    m2 += d2;
+                    m3 += d2 * d;
+                    m4 += d2 * d2;
+                }
+            }
+            else {
+                for (const data_t* x = begin; x < chunk_end; ++x) {
+                    const data_t d = *x - chunk.m_mean;
+                    m2 += d * d;
+                }
+            }
+            chunk.m_m2 = m2;
+            chunk.m_m3 = m3;
+            chunk.m_m4 = m4;
+            merge(chunk);
+            begin = chunk_end;
+        }
+    }
+    void update(pele::Array<double> input)
+    {
+        update(input.data(), input.data() + input.size());
+    }
+    /**
+     * replace a data point with another one, keeping the count fixed; not
+     * available with higher moments
      */
     void replace(const data_t old_data, const data_t new_data)
     {
-        m_mean += (new_data - old_data) / m_count;
-        m_mean2 += (new_data * new_data - old_data * old_data) / m_count;
+        if (m_higher) {
+            throw std::runtime_error("Moments: replace: not available with higher moments");
+        }
+        const data_t old_mean = m_mean;
+        m_kahan_add(m_mean, m_mean_comp, (new_data - old_data) / m_count);
+        m_kahan_add(m_m2, m_m2_comp, (new_data - old_data) * (new_data - m_mean + old_data - old_mean));
+    }
+    /**
+     * combine with the moments of another sample, using the pairwise
+     * formulas of Chan, Golub and LeVeque and of Pebay; higher moments are
+     * kept only if both samples have them. The compensations of both sides
+     * enter the merged mean and M2.
+     */
+    void merge(const Moments& other)
+    {
+        if (other.m_count == 0) {
+            return;
+        }
+        if (m_count == 0) {
+            const bool higher = m_higher && other.m_higher;
+            *this = other;
+            m_higher = higher;
+            return;
+        }
+        const data_t na = m_count;
+        const data_t nb = other.m_count;
+        const data_t n = na + nb;
+        // the Kahan sums exceed the compensated values by their compensation terms
+        const data_t delta = (other.m_mean - m_mean) + (m_mean_comp - other.m_mean_comp);
+        const data_t delta_n = delta / n;
+        m_higher = m_higher && other.m_higher;
+        if (m_higher) {
+            const data_t delta_n2 = delta_n * delta_n;
+            m_m4 += other.m_m4 + delta * delta_n2 * delta_n * na * nb * (na * na - na * nb + nb * nb)
+                    + 6 * delta_n2 * (na * na * other.m_m2 + nb * nb * m_m2)
+                    + 4 * delta_n * (na * other.m_m3 - nb * m_m3);
+            m_m3 += other.m_m3 + delta * delta_n2 * na * nb * (na - nb)
+                    + 3 * delta_n * (na * other.m_m2 - nb * m_m2);
+        }
+        else {
+            m_m3 = 0;
+            m_m4 = 0;
+        }
+        m_kahan_add(m_m2, m_m2_comp, other.m_m2 + delta * delta_n * na * nb);
+        m_kahan_add(m_m2, m_m2_comp, -other.m_m2_comp);
+        m_kahan_add(m_mean, m_mean_comp, delta_n * nb);
+        m_count += other.m_count;
+    }
+    /**
+     * contiguous representation, e.g. for MPI communication:
+     * [count, mean, M2, higher, M3, M4], M_k being the sums of the k-th
+     * powers of the deviations from the mean
+     */
+    static const size_t buffer_size = 6;
+    void write_buffer(double* buffer) const
+    {
+        buffer[0] = m_count;
+        buffer[1] = m_mean - m_mean_comp;
+        buffer[2] = m_m2 - m_m2_comp;
+        buffer[3] = m_higher;
+        buffer[4] = m_m3;
+        buffer[5] = m_m4;
+    }
+    void read_buffer(const double* buffer)
+    {
+        *this = Moments(buffer[3] != 0);
+        m_count = buffer[0];
+        m_mean = buffer[1];
+        m_m2 = buffer[2];
+        m_m3 = buffer[4];
+        m_m4 = buffer[5];
     }
     void operator() (const data_t input) { update(input); }
     index_t count() const { return m_count; }
+    bool has_higher_moments() const { return m_higher; }
     data_t mean() const { return m_mean; }
-    data_t variance() const { return (m_mean2 - m_mean * m_mean); }
+    /**
+     * population variance
+     */
+    data_t variance() const { return m_count > 0 ? m_m2 / m_count : 0; }
     data_t std() const { return sqrt(variance()); }
+    data_t skewness() const
+    {
+        m_check_higher();
+        return sqrt(static_cast<data_t>(m_count)) * m_m3 / pow(m_m2, 1.5);
+    }
+    /**
+     * excess kurtosis
+     */
+    data_t kurtosis() const
+    {
+        m_check_higher();
+        return m_count * m_m4 / (m_m2 * m_m2) - 3;
+    }
+private:
+    void m_check_higher() const
+    {
+        if (!m_higher) {
+            throw std::runtime_error("Moments: higher moments are not accumulated");
+        }
+    }
 };
 
 class Histogram{
@@ -73,6 +254,10 @@ private:
     Moments m_moments;
 public:
     Histogram(const double min, const double max, const double bin);
+    /**
+     * construct from the output of get_buffer()
+     */
+    Histogram(const std::vector<double>& buffer);
     ~Histogram() {}
     void add_entry(double entry);
     double max() const { return m_max; }
@@ -92,9 +277,181 @@ public:
     std::vector<double> get_vecdata_normalized() const;
     void print_terminal() const;
     void resize(const double E, const int i);
+    /**
+     * add the entries of another histogram with the same bin size, the
+     * range is extended to cover both histograms
+     */
+    void merge(const Histogram& other);
+    /**
+     * contiguous representation, e.g. for MPI communication:
+     * [bin, min, max, count, moments, bins...]
+     */
+    std::vector<double> get_buffer() const;
+    void merge_buffer(const std::vector<double>& buffer) { merge(Histogram(buffer)); }
+};
+
+/**
+ * Common base of the histograms with integer counts, that can grow to
+ * accommodate entries outside of the initial range.
+ * Bins are labelled by their absolute index k = floor(E / bin), with the same
+ * binning convention as Histogram. min() and max() span the initial range and
+ * all bins that have been visited since, and bin_index i refers to the i-th
+ * bin from min().
+ */
+class BaseHistogram {
+public:
+    typedef size_t count_t;
+protected:
+    double m_bin;
+    double m_eps;
+    long m_kmin;
+    long m_kmax;
+    count_t m_niter;
+    Moments m_moments;
+public:
+    BaseHistogram(const double min, const double max, const double bin);
+    virtual ~BaseHistogram() {}
+    virtual void add_entry(double entry) =0;
+    virtual count_t get_entry(const size_t bin_index) const =0;
+    double max() const { return (m_kmax + 1) * m_bin; }
+    double min() const { return m_kmin * m_bin; }
+    double bin() const { return m_bin; }
+    size_t size() const { return m_kmax - m_kmin + 1; }
+    count_t get_count() const { return m_niter; }
+    double get_mean() const { return m_moments.mean(); }
+    double get_variance() const { return m_moments.variance(); }
+    double get_position(const size_t bin_index) const { return min() + (0.5 + bin_index) * m_bin; }
+    virtual std::vector<double> get_vecdata() const;
+    std::vector<double> get_vectics() const;
+    std::vector<double> get_vecdata_error() const;
+    std::vector<double> get_vecdata_normalized() const;
+    /**
+     * positions (bin centres) and counts of the visited bins, sorted by
+     * position; unlike get_vecdata() this does not allocate the whole range
+     */
+    void get_occupied_bins(std::vector<double>& positions, std::vector<count_t>& counts) const;
+    virtual void print_terminal() const;
+    /**
+     * add the entries of another histogram with the same bin size, the
+     * range is extended to cover both histograms
+     */
+    void merge(const BaseHistogram& other);
+    /**
+     * contiguous representation, e.g. for MPI communication:
+     * [bin, kmin, kmax, count, layout, moments, bins]
+     * with layout 0 (dense) the bins are the counts of kmin..kmax, with
+     * layout 1 (sparse) they are (k, count) pairs of the visited bins only.
+     * The sparse layout is used when it is shorter, so that e.g. a
+     * SparseHistogram spread over a wide range is not densified.
+     * merge_buffer() accepts both layouts.
+     * Histograms can also be reduced with a plain sum of get_vecdata(),
+     * after extend_range() has been called with the global range on every
+     * process.
+     */
+    std::vector<double> get_buffer() const;
+    void merge_buffer(const std::vector<double>& buffer);
+    void extend_range(const double min, const double max);
+    static const size_t buffer_header_size = 5 + Moments::buffer_size;
+protected:
+    /**
+     * add count entries to the bin with absolute index k, which must lie
+     * in [m_kmin, m_kmax]
+     */
+    virtual void m_add_count(const long k, const count_t count) =0;
+    /**
+     * extend the range to include the bins [kmin, kmax]
+     */
+    virtual void m_extend_range(const long kmin, const long kmax)
+    {
+        m_kmin = std::min(m_kmin, kmin);
+        m_kmax = std::max(m_kmax, kmax);
+    }
+    /**
+     * absolute index and count of all non-empty bins
+     */
+    virtual void m_get_bins(std::vector<std::pair<long, count_t> >& bins) const;
+    /**
+     * update moments and count, return the bin of the entry
+     */
+    long m_record_entry(double E)
+    {
+        m_moments(E);
+        ++m_niter;
+        E = E + m_eps; //same binning as Histogram::add_entry
+        const long k = floor(E / m_bin);
+        m_kmin = std::min(m_kmin, k);
+        m_kmax = std::max(m_kmax, k);
+        return k;
+    }
+};
+
+/**
+ * Dynamic histogram with amortised O(1) growth in both directions.
+ * Drop-in replacement for Histogram that counts entries with integers.
+ * The counts are stored in a vector with free space on both sides of the
+ * occupied range; when an entry falls outside the storage, the storage is
+ * reallocated with at least twice the size, centred on the new occupied
+ * range. Extending the histogram by one bin is then O(1) on average, both
+ * towards lower and towards higher energies.
+ */
+class DynamicHistogram : public BaseHistogram {
+public:
+    typedef std::vector<count_t>::const_iterator const_iterator;
+private:
+    long m_origin;
+    std::vector<count_t> m_counts;
+public:
+    DynamicHistogram(const double min, const double max, const double bin);
+    virtual ~DynamicHistogram() {}
+    virtual void add_entry(double entry);
+    virtual count_t get_entry(const size_t bin_index) const { return m_counts.at(bin_index + (m_kmin - m_origin)); }
+    virtual std::vector<double> get_vecdata() const { return std::vector<double>(begin(), end()); }
+    const_iterator begin() const { return m_counts.begin() + (m_kmin - m_origin); }
+    const_iterator end() const { return m_counts.begin() + (m_kmax + 1 - m_origin); }
+    std::vector<count_t> get_veccounts() const { return std::vector<count_t>(begin(), end()); }
+    size_t get_capacity() const { return m_counts.size(); }
+protected:
+    virtual void m_add_count(const long k, const count_t count) { m_counts[k - m_origin] += count; }
+    virtual void m_extend_range(const long kmin, const long kmax);
+private:
+    void m_grow(const long lo, const long hi);
+};
+
+/**
+ * Sparse histogram, that only stores the bins which have been visited.
+ * Counts are kept in an open-addressing hash map (linear probing) keyed by the
+ * bin index, so memory is bounded by the number of distinct bins visited
+ * rather than by the energy range. This avoids bad_alloc when a run visits
+ * a very wide range of energies.
+ * get_vecdata() builds the dense histogram on demand, get_occupied_bins()
+ * returns only the visited bins.
+ */
+class SparseHistogram : public BaseHistogram {
+private:
+    static const long m_empty_key;
+    std::vector<long> m_keys;
+    std::vector<count_t> m_values;
+    size_t m_nr_occupied;
+public:
+    SparseHistogram(const double min, const double max, const double bin);
+    virtual ~SparseHistogram() {}
+    virtual void add_entry(double entry);
+    virtual count_t get_entry(const size_t bin_index) const;
+    virtual std::vector<double> get_vecdata() const;
+    size_t get_nr_occupied_bins() const { return m_nr_occupied; }
+    /**
+     * only the visited bins are drawn
+     */
+    virtual void print_terminal() const;
+    size_t get_capacity() const { return m_keys.size(); }
+protected:
+    virtual void m_add_count(const long k, const count_t count);
+    virtual void m_get_bins(std::vector<std::pair<long, count_t> >& bins) const;
+private:
+    size_t m_find_slot(const long k) const;
+    void m_rehash(const size_t capacity);
 };
 
 } // namespace mcpele
 
 #endif // #ifndef _MCPELE_HISTOGRAM_H
-
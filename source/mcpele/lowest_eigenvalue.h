@@ -1,22 +1,73 @@
 #ifndef _MCPELE_LOWEST_EIGENVALUE_H
 #define _MCPELE_LOWEST_EIGENVALUE_H
 
+#include <vector>
+
 #include "pele/base_potential.h"
 #include "pele/lbfgs.h"
 #include "pele/lowest_eig_potential.h"
 
 namespace mcpele{
 
-
+/**
+ * Lowest eigenvalue of the Hessian of landscape_potential, with the
+ * translational zero modes projected out.
+ * By default the Rayleigh quotient is minimised with LBFGS (at most
+ * lbfgsniter iterations), starting from ranvec.
+ * With use_lanczos the Lanczos method is used instead, with at most
+ * lbfgsniter Hessian-vector products, each from two gradients (central
+ * differences). It stops once the residual of the lowest Ritz pair is
+ * below tol times the estimated norm of the Hessian.
+ * With warm_start each computation starts from the eigenvector found by the
+ * previous one instead of ranvec; for the correlated configurations of an MC
+ * chain this is close to the answer, so far fewer iterations are needed.
+ */
 class FindLowestEigenvalue{
 private:
+    std::shared_ptr<pele::BasePotential> m_landscape_potential;
     std::shared_ptr<pele::LowestEigPotential> m_lowesteigpot;
     pele::Array<double> m_ranvec;
     pele::LBFGS m_lbfgs;
+    const size_t m_boxdimension;
+    const size_t m_max_iter;
+    const bool m_warm_start;
+    const bool m_use_lanczos;
+    const double m_tol;
+    pele::Array<double> m_eigenvector;
+    size_t m_last_niter;
+    size_t m_total_niter;
+    size_t m_nr_computations;
+    double m_compute_lanczos(pele::Array<double> coords);
+    void m_hessian_vector_product(pele::Array<double> coords, pele::Array<double> v, pele::Array<double> hv);
+    void m_project_out_translations(pele::Array<double> v) const;
 public:
     FindLowestEigenvalue(std::shared_ptr<pele::BasePotential> landscape_potential, const size_t boxdimension,
-            const pele::Array<double> ranvec, const size_t lbfgsniter);
+            const pele::Array<double> ranvec, const size_t lbfgsniter, const bool warm_start=false,
+            const bool use_lanczos=false, const double tol=1e-6);
     double compute_lowest_eigenvalue(pele::Array<double> coords);
+    /**
+     * eigenvector found by the last computation, normalised
+     */
+    pele::Array<double> get_eigenvector() const { return m_eigenvector.copy(); }
+    /**
+     * iterations (LBFGS) or Hessian-vector products (Lanczos) of the last computation
+     */
+    size_t get_last_niter() const { return m_last_niter; }
+    size_t get_total_niter() const { return m_total_niter; }
+    size_t get_nr_computations() const { return m_nr_computations; }
+    bool get_warm_start() const { return m_warm_start; }
+    bool get_use_lanczos() const { return m_use_lanczos; }
+    /**
+     * smallest eigenvalue of the symmetric tridiagonal matrix with diagonal
+     * alpha and off-diagonal beta (of size alpha.size() - 1), by bisection
+     */
+    static double tridiagonal_lowest_eigenvalue(const std::vector<double>& alpha, const std::vector<double>& beta);
+    /**
+     * normalised eigenvector of the same matrix for the lowest eigenvalue, by
+     * inverse iteration
+     */
+    static std::vector<double> tridiagonal_lowest_eigenvector(const std::vector<double>& alpha,
+            const std::vector<double>& beta, const double eigenvalue);
 };
 
 
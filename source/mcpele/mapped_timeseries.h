@@ -0,0 +1,86 @@
+#ifndef _MCPELE_MAPPED_TIMESERIES_H__
+#define _MCPELE_MAPPED_TIMESERIES_H__
+
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+
+namespace mcpele {
+
+/**
+ * Time series of equally sized rows of doubles, appended directly into a
+ * memory mapped file.
+ * The file is in numpy .npy format (version 1.0): a 128 byte header
+ * describing dtype and shape, followed by the raw row-major data, so that
+ * numpy.load(filename, mmap_mode="r") maps it without parsing.
+ * The file grows by doubling; every flush_every rows the shape in the
+ * header is updated and the dirty pages are scheduled for writing with
+ * msync(MS_ASYNC), which does not wait for the disk. Readers of a live
+ * file see the rows up to the last flush. close() (or the destructor)
+ * writes the final header and truncates the file to its exact size.
+ */
+class MappedTimeseries {
+private:
+    const std::string m_filename;
+    const size_t m_row_size;
+    const bool m_one_dimensional;
+    const size_t m_flush_every;
+    int m_fd;
+    char* m_map;
+    size_t m_capacity;
+    size_t m_nr_rows;
+    void m_map_file(const size_t capacity);
+    void m_unmap();
+    void m_write_header();
+    size_t m_file_size(const size_t nr_rows) const { return header_size + nr_rows * m_row_size * sizeof(double); }
+public:
+    static const size_t header_size = 128;
+    /**
+     * one_dimensional: write the shape as (nr_rows,) instead of
+     * (nr_rows, row_size), for scalar time series (row_size 1)
+     */
+    MappedTimeseries(const std::string& filename, const size_t row_size,
+            const bool one_dimensional=false, const size_t flush_every=1024);
+    virtual ~MappedTimeseries();
+    void append(const double* row)
+    {
+        if (m_map == NULL) {
+            throw std::runtime_error("MappedTimeseries::append: file is closed");
+        }
+        if (m_nr_rows == m_capacity) {
+            m_map_file(2 * m_capacity);
+        }
+        double* dest = data() + m_nr_rows * m_row_size;
+        for (size_t i = 0; i < m_row_size; ++i) {
+            dest[i] = row[i];
+        }
+        ++m_nr_rows;
+        if (m_nr_rows % m_flush_every == 0) {
+            flush();
+        }
+    }
+    /**
+     * update the header and schedule the dirty pages for writing, without waiting
+     */
+    void flush();
+    /**
+     * write everything to the file and unmap it, no rows can be appended after close
+     */
+    void close();
+    /**
+     * drop all rows
+     */
+    void clear();
+    bool is_open() const { return m_map != NULL; }
+    size_t size() const { return m_nr_rows; }
+    size_t row_size() const { return m_row_size; }
+    const std::string& get_filename() const { return m_filename; }
+    /**
+     * mapped rows, valid until the next append, clear or close
+     */
+    double* data() const { return reinterpret_cast<double*>(m_map + header_size); }
+};
+
+} // namespace mcpele
+
+#endif // #ifndef _MCPELE_MAPPED_TIMESERIES_H__
@@ -3,8 +3,10 @@
 
 #include <cmath>
 #include <algorithm>
+#include <limits>
 #include <memory>
 #include <stdexcept>
+#include <string>
 
 #include "pele/array.h"
 #include "pele/base_potential.h"
@@ -66,6 +68,24 @@ public:
     virtual void decrease_acceptance(const double) {}
 };
 
+/*
+ * Stop Criterion
+ * checked by MC::run every stop_check_every steps; the run stops as soon as
+ * one criterion is satisfied, and get_reason() is reported by
+ * MC::get_stop_reason()
+ */
+
+class StopCriterion {
+public:
+    virtual ~StopCriterion() {}
+    /**
+     * called at the beginning of each MC::run
+     */
+    virtual void start(MC* mc) {}
+    virtual bool stop(MC* mc) =0;
+    virtual std::string get_reason() const =0;
+};
+
 /**
  * Monte Carlo
  * _coords and _trialcoords are arrays that store coordinates and trial coordinates respectively
@@ -85,6 +105,7 @@ public:
     typedef std::vector<std::shared_ptr<Action> > actions_t;
     typedef std::vector<std::shared_ptr<AcceptTest> > accept_t;
     typedef std::vector<std::shared_ptr<ConfTest> > conf_t;
+    typedef std::vector<std::shared_ptr<StopCriterion> > stop_t;
 protected:
     std::shared_ptr<pele::BasePotential> m_potential;
     pele::Array<double> m_coords;
@@ -94,6 +115,9 @@ protected:
     conf_t m_conf_tests;
     conf_t m_late_conf_tests;
     std::shared_ptr<TakeStep> m_take_step;
+    stop_t m_stop_criteria;
+    size_t m_stop_check_every;
+    std::string m_stop_reason;
     size_t m_nitercount;
     size_t m_accept_count;
     size_t m_E_reject_count;
@@ -125,12 +149,28 @@ public:
     void add_conf_test(std::shared_ptr<ConfTest> conf_test) { m_conf_tests.push_back(conf_test); }
     void add_late_conf_test(std::shared_ptr<ConfTest> conf_test) { m_late_conf_tests.push_back(conf_test); }
     void set_takestep(std::shared_ptr<TakeStep> takestep) { m_take_step = takestep; }
+    /**
+     * with stop criteria, run(max_iter) ends early once one of them is
+     * satisfied; they are checked every stop_check_every steps
+     */
+    void add_stop_criterion(std::shared_ptr<StopCriterion> criterion) { m_stop_criteria.push_back(criterion); }
+    void set_stop_check_every(const size_t stop_check_every);
+    size_t get_stop_check_every() const { return m_stop_check_every; }
+    /**
+     * why the last run ended: "max_iter", "aborted" or the reason given by
+     * the stop criterion
+     */
+    std::string get_stop_reason() const { return m_stop_reason; }
     std::shared_ptr<TakeStep> get_takestep() const { return m_take_step; }
     void set_coordinates(pele::Array<double>& coords, double energy);
     double get_energy() const { return m_energy; }
     void reset_energy();
     double get_trial_energy() const { return m_trial_energy; }
     pele::Array<double> get_coords() const { return m_coords.copy(); }
+    /**
+     * copy the coordinates into coords, which must have the same size
+     */
+    void copy_coords(pele::Array<double>& coords) const { coords.assign(m_coords); }
     pele::Array<double> get_trial_coords() const { return m_trial_coords.copy(); }
     double get_norm_coords() const { return norm(m_coords); }
     size_t get_naccept() const { return m_accept_count; }
@@ -166,6 +206,7 @@ protected:
     bool do_accept_tests(pele::Array<double> xtrial, double etrial, pele::Array<double> xold, double eold);
     bool do_late_conf_tests(pele::Array<double> x);
     void do_actions(pele::Array<double> x, double energy, bool success);
+    bool do_stop_criteria();
     void take_steps();
 };
 
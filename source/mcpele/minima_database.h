@@ -0,0 +1,53 @@
+#ifndef _MCPELE_MINIMA_DATABASE_H__
+#define _MCPELE_MINIMA_DATABASE_H__
+
+#include <vector>
+
+#include "mc.h"
+
+namespace mcpele {
+
+/**
+ * Distinct minima, e.g. passed on by a QuenchPool, kept sorted by energy.
+ * Two minima are the same if their energies differ by at most energy_tol
+ * and, for coords_tol > 0, the Euclidean distance between their
+ * coordinates is at most coords_tol. With coords_tol = 0 minima are told
+ * apart by energy alone, so that distinct but (near) degenerate minima,
+ * e.g. mirror images, are merged. The distance is taken as is, without
+ * minimising over translations, rotations, permutations or periodic
+ * images, so coords_tol is only useful where such equivalent copies of a
+ * minimum should count as distinct, or cannot occur.
+ * For each distinct minimum the coordinates of its first occurrence, the
+ * step of that occurrence and the number of occurrences are stored.
+ */
+class MinimaDatabase : public Action {
+private:
+    const double m_energy_tol;
+    const double m_coords_tol;
+    std::vector<double> m_energies;
+    std::vector<pele::Array<double> > m_coords;
+    std::vector<size_t> m_counts;
+    std::vector<size_t> m_first_steps;
+    bool m_same_coords(const pele::Array<double>& a, const pele::Array<double>& b) const;
+public:
+    MinimaDatabase(const double energy_tol=1e-6, const double coords_tol=0);
+    virtual ~MinimaDatabase() {}
+    virtual void action(pele::Array<double> &coords, double energy, bool accepted, MC* mc)
+    {
+        add_minimum(coords, energy, mc->get_iterations_count());
+    }
+    /**
+     * returns the index of the minimum in the database
+     */
+    size_t add_minimum(pele::Array<double> coords, const double energy, const size_t step=0);
+    size_t size() const { return m_energies.size(); }
+    pele::Array<double> get_energies() const;
+    pele::Array<double> get_counts() const;
+    pele::Array<double> get_minimum(const size_t i) const { return m_coords.at(i).copy(); }
+    size_t get_first_step(const size_t i) const { return m_first_steps.at(i); }
+    void clear();
+};
+
+} // namespace mcpele
+
+#endif // #ifndef _MCPELE_MINIMA_DATABASE_H__
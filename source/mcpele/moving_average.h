@@ -10,7 +10,8 @@ namespace mcpele {
 
 /**
  * Computes moving averages of time series.
- * Reference to time series, from small to large times, is in m_time_series.
+ * The time series, from small to large times, is referenced by
+ * [m_series_begin, m_series_end), e.g. the data of a std::vector.
  * Assume that one wants to compute moving averages for the rightmost (latest)
  * m_nr_steps_total elements of the time series.
  * The number of time series steps that go into one moving average is
@@ -25,33 +26,39 @@ namespace mcpele {
  */
 class MovingAverageAcc {
 private:
-    const std::vector<double>& m_time_series;
+    const double* const m_series_begin;
+    const double* const m_series_end;
     const size_t m_nr_steps_total;
     const size_t m_window_size;
     const size_t m_nr_steps_ma;
-    std::vector<double>::const_iterator m_begin;
-    std::vector<double>::const_iterator m_end;
+    const double* m_begin;
+    const double* m_end;
     mcpele::Moments m_moments;
 public:
     MovingAverageAcc(const std::vector<double>& time_series, const size_t nr_steps_total, const size_t nr_steps_ma)
-        : m_time_series(time_series),
+        : MovingAverageAcc(time_series.data(), time_series.data() + time_series.size(), nr_steps_total, nr_steps_ma)
+    {}
+    /**
+     * time series in the contiguous range [series_begin, series_end)
+     */
+    MovingAverageAcc(const double* series_begin, const double* series_end, const size_t nr_steps_total, const size_t nr_steps_ma)
+        : m_series_begin(series_begin),
+          m_series_end(series_end),
           m_nr_steps_total(nr_steps_total),
           m_window_size(nr_steps_ma), //window size
           m_nr_steps_ma(nr_steps_total - m_window_size + 1), //number of steps to move window from left to right end
-          m_begin(m_time_series.end() - nr_steps_total),
+          m_begin(m_series_end - nr_steps_total),
           m_end(m_begin + m_window_size),
           m_moments()
     {
         if (nr_steps_ma % 2 != 0) {
             throw std::runtime_error("MovingAverageAcc: illegal input: nr_steps_ma");
         }
-        if (time_series.size() < nr_steps_total) {
+        if (static_cast<size_t>(series_end - series_begin) < nr_steps_total) {
             throw std::runtime_error("MovingAverageAcc: illegal input: time series too short");
         }
         //initialise moments
-        for(auto it = m_begin; it != m_end; ++it) {
-            m_moments(*it);
-        }
+        m_init_moments();
     }
     double get_mean() const { return m_moments.mean(); }
     double get_variance() const { return m_moments.variance(); }
@@ -60,7 +67,7 @@ public:
     {
         ++m_begin;
         ++m_end;
-        if (m_end == m_time_series.end()) {
+        if (m_end == m_series_end) {
             reset();
         }
         else {
@@ -69,13 +76,16 @@ public:
     }
     void reset()
     {
-        m_begin = m_time_series.end() - m_nr_steps_total;
+        m_begin = m_series_end - m_nr_steps_total;
         m_end = m_begin + m_window_size;
-        m_moments = mcpele::Moments();
         //initialise moments
-        for(auto it = m_begin; it != m_end; ++it) {
-            m_moments(*it);
-        }
+        m_init_moments();
+    }
+private:
+    void m_init_moments()
+    {
+        m_moments = mcpele::Moments();
+        m_moments.update(m_begin, m_end);
     }
 };
 
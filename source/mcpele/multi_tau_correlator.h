@@ -0,0 +1,64 @@
+#ifndef _MCPELE_MULTI_TAU_CORRELATOR_H__
+#define _MCPELE_MULTI_TAU_CORRELATOR_H__
+
+#include <vector>
+
+#include "histogram.h"
+
+namespace mcpele {
+
+/**
+ * Online multi-tau autocorrelation of a scalar time series.
+ * Level 0 correlates the samples at lags 0, 1, ..., nr_lags - 1. Every pair
+ * of values entering level k is averaged into one value of level k + 1,
+ * which correlates lags nr_lags / 2, ..., nr_lags - 1 in units of 2^(k+1)
+ * samples. Levels are added as the series grows, so memory is
+ * O(nr_lags log T) for T samples.
+ * The samples are correlated relative to the first sample, which does not
+ * change the autocovariance but avoids cancellation for large offsets.
+ * The integrated autocorrelation time, in units of samples, is
+ * tau_int = 1/2 + sum_{t > 0} rho(t), summed with trapezoidal weights over
+ * the logarithmic lags and truncated with Sokal's window: at the first lag
+ * t >= window * tau_int.
+ */
+class MultiTauCorrelator {
+private:
+    const size_t m_nr_lags;
+    const size_t m_max_levels;
+    double m_offset;
+    Moments m_moments;
+    std::vector<std::vector<double> > m_shift;
+    std::vector<size_t> m_nr_inserted;
+    std::vector<std::vector<double> > m_corr;
+    std::vector<std::vector<size_t> > m_nr_corr;
+    std::vector<double> m_accumulator;
+    std::vector<size_t> m_nr_accumulated;
+    void m_add(const double x, const size_t level);
+    void m_add_level();
+public:
+    /**
+     * nr_lags: lags per level, even and at least 2
+     * max_levels: cap on the number of levels, 0 for no cap
+     */
+    MultiTauCorrelator(const size_t nr_lags=16, const size_t max_levels=0);
+    void add(const double x);
+    void operator() (const double x) { add(x); }
+    void clear();
+    size_t get_count() const { return m_moments.count(); }
+    double get_mean() const { return m_offset + m_moments.mean(); }
+    double get_variance() const { return m_moments.variance(); }
+    size_t get_nr_levels() const { return m_shift.size(); }
+    /**
+     * lags, in units of samples, with at least one correlation product
+     */
+    std::vector<double> get_lags() const;
+    /**
+     * normalised autocorrelation rho(t) at get_lags()
+     */
+    std::vector<double> get_autocorrelation() const;
+    double get_integrated_time(const double window=6) const;
+};
+
+} // namespace mcpele
+
+#endif // #ifndef _MCPELE_MULTI_TAU_CORRELATOR_H__
@@ -0,0 +1,135 @@
+#ifndef _MCPELE_NESTED_SAMPLING_H__
+#define _MCPELE_NESTED_SAMPLING_H__
+
+#include <condition_variable>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "pele/array.h"
+
+#include "mc.h"
+#include "energy_window_test.h"
+
+namespace mcpele {
+
+/**
+ * Nested sampling with K live points and one walker per thread.
+ * Every iteration the P highest energy live points, P being the number of
+ * walkers, are removed and recorded. Each is replaced by a copy of a
+ * randomly chosen surviving live point, decorrelated by a walk of nr_steps
+ * MC steps under the upper energy bound E < E_max, E_max being the lowest
+ * of the removed energies. The P walks run in parallel: walker 0 on the
+ * calling thread, the others on threads that are started by the
+ * constructor and wait for the next iteration.
+ * The walkers are independent MC instances, each with its own potential,
+ * takestep and conf tests (e.g. a CheckSphericalContainer that defines the
+ * sampled volume); they should not have a MetropolisTest. The bound is an
+ * EnergyWindowTest added to each walker. After every walk the step size
+ * is adjusted towards an acceptance between min_acceptance_ratio and
+ * max_acceptance_ratio with the takestep's increase_acceptance() and
+ * decrease_acceptance(), as in AdaptiveTakeStep, because the volume below
+ * E_max keeps shrinking.
+ * The coordinates of the live points are stored in one contiguous block of
+ * K ndof doubles, walkers copy in and out of it without allocating.
+ * With n live points a removal compresses the volume by ln X -= 1 / n on
+ * average; the P removals of one iteration have n = K, K - 1, ...,
+ * K - P + 1. The volume is relative to that sampled by the initial live
+ * points, X_0 = 1, so that
+ *   Z(T) = sum_i (X_{i-1} - X_i) exp(-E_i / T) + X_last / K sum_live exp(-E / T)
+ * is the configurational partition function divided by that volume.
+ */
+class NestedSampling {
+private:
+    std::vector<std::shared_ptr<MC> > m_walkers;
+    std::vector<std::shared_ptr<EnergyWindowTest> > m_bounds;
+    const size_t m_nr_steps;
+    const double m_factor;
+    const double m_min_acceptance_ratio;
+    const double m_max_acceptance_ratio;
+    size_t m_ndof;
+    size_t m_nr_live;
+    pele::Array<double> m_live_coords;
+    std::vector<pele::Array<double> > m_live_views;
+    std::vector<double> m_live_energies;
+    std::vector<double> m_dead_energies;
+    std::vector<double> m_log_volumes;
+    std::vector<size_t> m_order;
+    std::vector<size_t> m_sources;
+    std::vector<size_t> m_walk_accepted;
+    size_t m_nr_iterations;
+    size_t m_nr_accepted;
+    size_t m_nr_trials;
+    std::mt19937_64 m_generator;
+    std::vector<std::thread> m_threads;
+    size_t m_generation;
+    size_t m_nr_busy;
+    double m_max_energy;
+    bool m_stop;
+    std::exception_ptr m_error;
+    std::mutex m_mutex;
+    std::condition_variable m_walk_ready;
+    std::condition_variable m_walk_done;
+    void m_walk(const size_t iwalker, const double max_energy);
+    void m_work(const size_t iwalker);
+    void m_stop_workers();
+    void m_moments(const double temperature, double& log_partition_function,
+            double& mean_energy, double& energy_variance) const;
+public:
+    /**
+     * live_coords: the coordinates of the K initial live points, one after
+     * the other, sampled uniformly from the volume of interest
+     */
+    NestedSampling(std::vector<std::shared_ptr<MC> > walkers, pele::Array<double> live_coords,
+            const size_t nr_steps, const size_t rseed, const double factor=0.9,
+            const double min_acceptance_ratio=0.2, const double max_acceptance_ratio=0.5);
+    virtual ~NestedSampling();
+    /**
+     * do nr_iterations iterations, removing nr_iterations * P live points
+     */
+    void run(const size_t nr_iterations);
+    size_t get_nr_threads() const { return m_walkers.size(); }
+    size_t get_nr_live() const { return m_nr_live; }
+    size_t get_ndof() const { return m_ndof; }
+    size_t get_nr_iterations() const { return m_nr_iterations; }
+    /**
+     * the current bound, the highest live energy
+     */
+    double get_max_energy() const;
+    /**
+     * fraction of accepted steps of all walks
+     */
+    double get_accepted_fraction() const
+    {
+        return m_nr_trials ? static_cast<double>(m_nr_accepted) / m_nr_trials : 0;
+    }
+    /**
+     * energies of the removed points, in decreasing order
+     */
+    pele::Array<double> get_energies() const;
+    /**
+     * ln X after each removal
+     */
+    pele::Array<double> get_log_volumes() const;
+    /**
+     * energies of the K current live points
+     */
+    pele::Array<double> get_live_energies() const;
+    /**
+     * coordinates of live point i
+     */
+    pele::Array<double> get_live_coords(const size_t i) const;
+    double get_log_partition_function(const double temperature) const;
+    double get_mean_energy(const double temperature) const;
+    /**
+     * configurational heat capacity, (<E^2> - <E>^2) / T^2
+     */
+    double get_heat_capacity(const double temperature) const;
+};
+
+} // namespace mcpele
+
+#endif // #ifndef _MCPELE_NESTED_SAMPLING_H__
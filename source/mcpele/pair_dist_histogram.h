@@ -5,71 +5,178 @@
 #include <cassert>
 #include <cmath>
 #include <stdexcept>
+#include <thread>
 #include <utility>
+#include <vector>
 
 #include "pele/distance.h"
 
-#include "mcpele/histogram.h"
-
 namespace mcpele{
 
+/**
+ * Pair-distance histogram, accumulated over configurations in a periodic box.
+ * Pairs are binned on the squared distance, using the squared bin edges and
+ * a small lookup table, so no sqrt is taken per pair.
+ * If the box holds at least three cells of side max_dist in every direction,
+ * only pairs in neighbouring cells are visited (cell list), otherwise all
+ * pairs are visited. In both cases the work of one configuration can be split
+ * over nr_threads threads, each with a private histogram.
+ * max_dist defaults to half the smallest box side; a smaller max_dist is
+ * what makes the cell list pay off for large systems.
+ * Alternatively, the histogram of a live configuration can be kept up to
+ * date by update_live_configuration, which only recomputes the pairs of the
+ * particles that moved, and accumulated with add_live_configuration.
+ */
 template<size_t BOXDIM>
 class PairDistHistogram{
 private:
     pele::periodic_distance<BOXDIM> m_distance;
+    double m_boxvec[BOXDIM];
     const size_t m_nr_bins;
     const double m_min_dist;
     const double m_max_dist;
+    const double m_max_dist2;
     const double m_delta_bin;
-    mcpele::Histogram m_hist;
+    std::vector<double> m_hist;
     size_t m_nr_configs;
+    size_t m_nr_threads;
+    /**
+     * squared bin edges, m_bin_edge2[i] = (i * m_delta_bin)^2
+     */
+    std::vector<double> m_bin_edge2;
+    /**
+     * lowest bin overlapping the r^2 interval [j, j + 1) / m_lookup_scale
+     */
+    std::vector<size_t> m_lookup;
+    double m_lookup_scale;
+    /**
+     * cell list, cells of side >= m_max_dist
+     */
+    bool m_use_cells;
+    size_t m_ncells_dim[BOXDIM];
+    size_t m_ncells;
+    std::vector<long> m_neighbour_offsets;
+    std::vector<size_t> m_cell_start;
+    std::vector<size_t> m_cell_particles;
+    /**
+     * live configuration and its pair-distance histogram
+     */
+    pele::Array<double> m_live_coords;
+    std::vector<double> m_live_hist;
 public:
-    PairDistHistogram(pele::Array<double> boxvector, const size_t nr_bins)
+    PairDistHistogram(pele::Array<double> boxvector, const size_t nr_bins,
+            const size_t nr_threads=1, const double max_dist=0)
         : m_distance(boxvector),
           m_nr_bins(nr_bins),
           m_min_dist(0),
-          m_max_dist(0.5 * *std::min_element(boxvector.data(), boxvector.data() + BOXDIM)),
+          m_max_dist(max_dist > 0 ? max_dist : 0.5 * *std::min_element(boxvector.data(), boxvector.data() + BOXDIM)),
+          m_max_dist2(m_max_dist * m_max_dist),
           m_delta_bin((m_max_dist - m_min_dist) / static_cast<double>(m_nr_bins)),
-          m_hist(m_min_dist, m_max_dist, m_delta_bin),
-          m_nr_configs(0)
+          m_hist(nr_bins, 0),
+          m_nr_configs(0),
+          m_nr_threads(std::max<size_t>(1, nr_threads)),
+          m_ncells(1)
     {
         if (BOXDIM != boxvector.size()) {
             throw std::runtime_error("PairDistHistogram: illegal boxvector size");
         }
+        if (nr_bins == 0) {
+            throw std::runtime_error("PairDistHistogram: nr_bins must be positive");
+        }
+        if (m_max_dist > 0.5 * *std::min_element(boxvector.data(), boxvector.data() + BOXDIM)) {
+            throw std::runtime_error("PairDistHistogram: max_dist exceeds half the box");
+        }
+        std::copy(boxvector.data(), boxvector.data() + BOXDIM, m_boxvec);
+        m_build_lookup();
+        m_build_cells();
     }
     virtual ~PairDistHistogram() {}
+    void set_nr_threads(const size_t nr_threads) { m_nr_threads = std::max<size_t>(1, nr_threads); }
+    size_t get_nr_threads() const { return m_nr_threads; }
+    bool uses_cell_list() const { return m_use_cells; }
+    double get_max_dist() const { return m_max_dist; }
+    size_t get_nr_configs() const { return m_nr_configs; }
     void add_configuration(pele::Array<double> coords)
     {
         ++m_nr_configs;
+        m_accumulate(coords, m_hist);
+    }
+    void add_distance(const size_t i, const size_t j, const double* coor)
+    {
+        m_add_distance(i, j, coor, m_hist);
+    }
+    /**
+     * bring the live histogram up to date with coords: only the pairs of
+     * particles whose coordinates changed since the last call are updated,
+     * unless so many moved that recomputing all pairs is cheaper
+     */
+    void update_live_configuration(pele::Array<double> coords)
+    {
         const size_t nr_particles(coords.size() / BOXDIM);
+        if (m_live_coords.size() != coords.size()) {
+            m_set_live_configuration(coords);
+            return;
+        }
+        std::vector<size_t> moved;
         for (size_t i = 0; i < nr_particles; ++i) {
-            for (size_t j = i + 1; j < nr_particles; ++j) {
-                add_distance(i, j, coords.data());
+            if (!std::equal(coords.data() + i * BOXDIM, coords.data() + (i + 1) * BOXDIM,
+                    m_live_coords.data() + i * BOXDIM)) {
+                moved.push_back(i);
             }
         }
+        // a moved particle costs 2 * N distances, all pairs cost N^2 / 2
+        if (4 * moved.size() > nr_particles) {
+            m_set_live_configuration(coords);
+            return;
+        }
+        for (size_t m = 0; m < moved.size(); ++m) {
+            const size_t i = moved[m];
+            m_add_particle_pairs(i, m_live_coords.data(), nr_particles, m_live_hist, -1);
+            std::copy(coords.data() + i * BOXDIM, coords.data() + (i + 1) * BOXDIM,
+                    m_live_coords.data() + i * BOXDIM);
+            m_add_particle_pairs(i, m_live_coords.data(), nr_particles, m_live_hist, 1);
+        }
     }
-    void add_distance(const size_t i, const size_t j, const double* coor)
+    /**
+     * accumulate the live configuration, a vector add
+     */
+    void add_live_configuration()
     {
-        double rij[BOXDIM];
-        m_distance.get_rij(rij, coor + i * BOXDIM, coor + j * BOXDIM);
-        const double r = sqrt(std::inner_product(rij, rij + BOXDIM, rij, double(0)));
-        if (r > m_max_dist) {
-            // here, g(r) measurement is resticted to a disc domain of radius
-            // m_max_dist in distance space; could be done differently
-            return;
+        if (m_live_hist.empty()) {
+            throw std::runtime_error("PairDistHistogram: live configuration not set");
+        }
+        ++m_nr_configs;
+        for (size_t i = 0; i < m_nr_bins; ++i) {
+            m_hist[i] += m_live_hist[i];
+        }
+    }
+    /**
+     * bin index of squared distance r2 < m_max_dist2
+     */
+    size_t get_bin_index2(const double r2) const
+    {
+        size_t i = m_lookup[std::min(static_cast<size_t>(r2 * m_lookup_scale), m_lookup.size() - 1)];
+        while (i + 1 < m_nr_bins && r2 >= m_bin_edge2[i + 1]) {
+            ++i;
+        }
+        while (i > 0 && r2 < m_bin_edge2[i]) {
+            --i;
         }
-        m_hist.add_entry(r);
+        return i;
     }
     double volume_nball(const double radius, const size_t ndim) const
     {
         return pow(M_PI, 0.5 * ndim) * pow(radius, ndim) / tgamma(0.5 * ndim + 1);
     }
+    double get_position(const size_t i) const
+    {
+        return m_min_dist + (0.5 + i) * m_delta_bin;
+    }
     std::vector<double> get_vecdata_r() const
     {
         std::vector<double> result(m_nr_bins);
         for (size_t i = 0; i < m_nr_bins; ++i) {
-            const double r = m_hist.get_position(i);
-            result.at(i) = r;
+            result.at(i) = get_position(i);
         }
         return result;
     }
@@ -77,16 +184,214 @@ public:
     {
         std::vector<double> result(m_nr_bins);
         for (size_t i = 0; i < m_nr_bins; ++i) {
-            const double r = m_hist.get_position(i);
-            const double delta_r = m_hist.bin();
+            const double r = get_position(i);
+            const double delta_r = m_delta_bin;
             const double shell_volume_r = volume_nball(r + 0.5 * delta_r, BOXDIM) - volume_nball(r - 0.5 * delta_r, BOXDIM);
             const double nid = shell_volume_r * number_density;
             const double normalization = 2.0 / (static_cast<double>(m_nr_configs) * static_cast<double>(nr_particles) * nid);
-            const double g_of_r = normalization * static_cast<double>(m_hist.get_entry(i));
+            const double g_of_r = normalization * m_hist.at(i);
             result.at(i) = g_of_r;
         }
         return result;
     }
+private:
+    /**
+     * add all pairs of coords to hist
+     */
+    void m_accumulate(pele::Array<double> coords, std::vector<double>& hist)
+    {
+        const size_t nr_particles(coords.size() / BOXDIM);
+        if (m_use_cells) {
+            m_fill_cells(coords.data(), nr_particles);
+        }
+        const size_t nr_threads = std::min(m_nr_threads, std::max<size_t>(1, m_use_cells ? m_ncells : nr_particles));
+        if (nr_threads == 1) {
+            m_add_pairs(coords.data(), nr_particles, 0, 1, hist);
+            return;
+        }
+        std::vector<std::vector<double> > private_hist(nr_threads - 1, std::vector<double>(m_nr_bins, 0));
+        std::vector<std::thread> threads;
+        for (size_t t = 1; t < nr_threads; ++t) {
+            threads.push_back(std::thread(&PairDistHistogram::m_add_pairs, this, coords.data(),
+                    nr_particles, t, nr_threads, std::ref(private_hist[t - 1])));
+        }
+        m_add_pairs(coords.data(), nr_particles, 0, nr_threads, hist);
+        for (size_t t = 0; t < threads.size(); ++t) {
+            threads[t].join();
+            for (size_t i = 0; i < m_nr_bins; ++i) {
+                hist[i] += private_hist[t][i];
+            }
+        }
+    }
+    void m_add_distance(const size_t i, const size_t j, const double* coor, std::vector<double>& hist,
+            const double weight=1) const
+    {
+        double rij[BOXDIM];
+        m_distance.get_rij(rij, coor + i * BOXDIM, coor + j * BOXDIM);
+        double r2 = 0;
+        for (size_t k = 0; k < BOXDIM; ++k) {
+            r2 += rij[k] * rij[k];
+        }
+        if (r2 >= m_max_dist2) {
+            // here, g(r) measurement is resticted to a disc domain of radius
+            // m_max_dist in distance space; could be done differently
+            return;
+        }
+        hist[get_bin_index2(r2)] += weight;
+    }
+    void m_add_particle_pairs(const size_t i, const double* coor, const size_t nr_particles,
+            std::vector<double>& hist, const double weight) const
+    {
+        for (size_t j = 0; j < nr_particles; ++j) {
+            if (j != i) {
+                m_add_distance(i, j, coor, hist, weight);
+            }
+        }
+    }
+    void m_set_live_configuration(pele::Array<double> coords)
+    {
+        m_live_coords = coords.copy();
+        m_live_hist.assign(m_nr_bins, 0);
+        m_accumulate(m_live_coords, m_live_hist);
+    }
+    /**
+     * accumulate the share of thread ithread out of nthreads into hist:
+     * particles i = ithread, ithread + nthreads, ... without cell list,
+     * cells c = ithread, ithread + nthreads, ... with cell list
+     */
+    void m_add_pairs(const double* coor, const size_t nr_particles, const size_t ithread,
+            const size_t nthreads, std::vector<double>& hist) const
+    {
+        if (!m_use_cells) {
+            for (size_t i = ithread; i < nr_particles; i += nthreads) {
+                for (size_t j = i + 1; j < nr_particles; ++j) {
+                    m_add_distance(i, j, coor, hist);
+                }
+            }
+            return;
+        }
+        for (size_t c = ithread; c < m_ncells; c += nthreads) {
+            for (size_t a = m_cell_start[c]; a < m_cell_start[c + 1]; ++a) {
+                for (size_t b = a + 1; b < m_cell_start[c + 1]; ++b) {
+                    m_add_distance(m_cell_particles[a], m_cell_particles[b], coor, hist);
+                }
+            }
+            for (size_t n = 0; n < m_neighbour_offsets.size() / BOXDIM; ++n) {
+                const size_t c2 = m_neighbour_cell(c, &m_neighbour_offsets[n * BOXDIM]);
+                for (size_t a = m_cell_start[c]; a < m_cell_start[c + 1]; ++a) {
+                    for (size_t b = m_cell_start[c2]; b < m_cell_start[c2 + 1]; ++b) {
+                        m_add_distance(m_cell_particles[a], m_cell_particles[b], coor, hist);
+                    }
+                }
+            }
+        }
+    }
+    void m_build_lookup()
+    {
+        m_bin_edge2.resize(m_nr_bins + 1);
+        for (size_t i = 0; i <= m_nr_bins; ++i) {
+            const double edge = m_min_dist + i * m_delta_bin;
+            m_bin_edge2[i] = edge * edge;
+        }
+        // near r = max_dist adjacent squared edges are ~2 * r * dr apart, a
+        // table of 4 * nr_bins entries leaves at most one correction step
+        // there; the few pairs at small r may need a couple more
+        const size_t nr_lookup = 4 * m_nr_bins;
+        m_lookup_scale = nr_lookup / m_max_dist2;
+        m_lookup.resize(nr_lookup);
+        size_t i = 0;
+        for (size_t j = 0; j < nr_lookup; ++j) {
+            const double r2 = j / m_lookup_scale;
+            while (i + 1 < m_nr_bins && r2 >= m_bin_edge2[i + 1]) {
+                ++i;
+            }
+            m_lookup[j] = i;
+        }
+    }
+    void m_build_cells()
+    {
+        m_use_cells = true;
+        for (size_t k = 0; k < BOXDIM; ++k) {
+            m_ncells_dim[k] = static_cast<size_t>(m_boxvec[k] / m_max_dist);
+            m_use_cells = m_use_cells && m_ncells_dim[k] >= 3;
+        }
+        if (!m_use_cells) {
+            return;
+        }
+        m_ncells = 1;
+        for (size_t k = 0; k < BOXDIM; ++k) {
+            m_ncells *= m_ncells_dim[k];
+        }
+        // half of the 3^BOXDIM - 1 neighbouring cells, so that every pair of
+        // cells is visited once: the first non-zero offset is positive
+        size_t nr_offsets = 1;
+        for (size_t k = 0; k < BOXDIM; ++k) {
+            nr_offsets *= 3;
+        }
+        for (size_t n = 0; n < nr_offsets; ++n) {
+            long offset[BOXDIM];
+            size_t m = n;
+            for (size_t k = 0; k < BOXDIM; ++k) {
+                offset[k] = static_cast<long>(m % 3) - 1;
+                m /= 3;
+            }
+            long first = 0;
+            for (size_t k = 0; k < BOXDIM && first == 0; ++k) {
+                first = offset[k];
+            }
+            if (first > 0) {
+                m_neighbour_offsets.insert(m_neighbour_offsets.end(), offset, offset + BOXDIM);
+            }
+        }
+        m_cell_start.assign(m_ncells + 1, 0);
+    }
+    size_t m_neighbour_cell(size_t c, const long* offset) const
+    {
+        size_t result = 0;
+        size_t stride = 1;
+        for (size_t k = 0; k < BOXDIM; ++k) {
+            const long n = m_ncells_dim[k];
+            const long ck = static_cast<long>(c % n);
+            c /= n;
+            result += ((ck + offset[k] + n) % n) * stride;
+            stride *= n;
+        }
+        return result;
+    }
+    size_t m_get_cell(const double* x) const
+    {
+        size_t result = 0;
+        size_t stride = 1;
+        for (size_t k = 0; k < BOXDIM; ++k) {
+            const double L = m_boxvec[k];
+            const double xk = x[k] - L * round(x[k] / L);
+            size_t ck = static_cast<size_t>((xk / L + 0.5) * m_ncells_dim[k]);
+            ck = std::min(ck, m_ncells_dim[k] - 1);
+            result += ck * stride;
+            stride *= m_ncells_dim[k];
+        }
+        return result;
+    }
+    /**
+     * counting sort of the particles by cell
+     */
+    void m_fill_cells(const double* coor, const size_t nr_particles)
+    {
+        std::vector<size_t> cell_of(nr_particles);
+        std::fill(m_cell_start.begin(), m_cell_start.end(), 0);
+        for (size_t i = 0; i < nr_particles; ++i) {
+            cell_of[i] = m_get_cell(coor + i * BOXDIM);
+            ++m_cell_start[cell_of[i] + 1];
+        }
+        for (size_t c = 0; c < m_ncells; ++c) {
+            m_cell_start[c + 1] += m_cell_start[c];
+        }
+        m_cell_particles.resize(nr_particles);
+        std::vector<size_t> fill(m_cell_start.begin(), m_cell_start.end() - 1);
+        for (size_t i = 0; i < nr_particles; ++i) {
+            m_cell_particles[fill[cell_of[i]]++] = i;
+        }
+    }
 };
 
 } //namespace mcpele
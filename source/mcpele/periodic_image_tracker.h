@@ -0,0 +1,64 @@
+#ifndef _MCPELE_PERIODIC_IMAGE_TRACKER_H__
+#define _MCPELE_PERIODIC_IMAGE_TRACKER_H__
+
+#include <vector>
+
+#include "pele/array.h"
+
+namespace mcpele {
+
+/**
+ * Keep particles inside a periodic box centred at the origin, while counting
+ * how many box lengths each coordinate has been shifted by.
+ * Wrapping follows the same convention as pele::periodic_distance, i.e. after
+ * wrap() every coordinate lies in [-L/2, L/2].
+ * The tracker is meant to be used from a TakeStep, which only sees the trial
+ * coordinates. The shifts applied to the latest trial are therefore kept
+ * pending until the tracker is shown the accepted configuration again: if it
+ * still contains the wrapped trial coordinates, the move has been accepted
+ * and the shifts are committed to the image counts, otherwise they are
+ * dropped.
+ * The unwrapped coordinates, coords + images * boxvec, are the ones that
+ * should be used to compute displacement observables.
+ */
+class PeriodicImageTracker {
+private:
+    pele::Array<double> m_boxvec;
+    const size_t m_ndim;
+    std::vector<long> m_images;
+    std::vector<long> m_pending;
+    std::vector<double> m_trial;
+    size_t m_pending_begin;
+    size_t m_pending_end;
+public:
+    PeriodicImageTracker(const pele::Array<double> boxvec);
+    virtual ~PeriodicImageTracker() {}
+    /**
+     * wrap the degrees of freedom in [begin, end) back into the box,
+     * begin and end must be aligned to particle boundaries.
+     * Call update() on the accepted configuration before displacing it,
+     * otherwise the shifts of the previous trial are lost.
+     */
+    void wrap(pele::Array<double>& coords, const size_t begin, const size_t end);
+    void wrap(pele::Array<double>& coords) { wrap(coords, 0, coords.size()); }
+    /**
+     * commit the pending shifts if coords is the last wrapped trial
+     * configuration, discard them otherwise
+     */
+    void update(const pele::Array<double>& coords);
+    pele::Array<long> get_image_counts(const pele::Array<double>& coords);
+    pele::Array<double> get_unwrapped_coords(const pele::Array<double>& coords);
+    /**
+     * write the unwrapped coordinates into unwrapped (of the size of coords),
+     * without allocating
+     */
+    void unwrap(const pele::Array<double>& coords, pele::Array<double> unwrapped);
+    pele::Array<double> get_boxvec() const { return m_boxvec.copy(); }
+    size_t get_ndim() const { return m_ndim; }
+private:
+    void m_check_size(const size_t ndof);
+};
+
+} // namespace mcpele
+
+#endif // #ifndef _MCPELE_PERIODIC_IMAGE_TRACKER_H__
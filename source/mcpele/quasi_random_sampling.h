@@ -0,0 +1,102 @@
+#ifndef _MCPELE_QUASI_RANDOM_SAMPLING_H__
+#define _MCPELE_QUASI_RANDOM_SAMPLING_H__
+
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+
+#include "pele/array.h"
+
+#include "mc.h"
+#include "halton_sequence.h"
+
+namespace mcpele {
+
+/**
+ * Quasi-random version of UniformRectangularSampling.
+ * Coordinates of particles in boxvec.size()-dim space are sampled in the box
+ * specified by boxvec (centred at zero), using one point of a scrambled
+ * Halton sequence of dimension ndof per step. For smooth integrands the
+ * integration error decreases roughly as 1/N rather than 1/sqrt(N).
+ * Independent parallel chunks of n samples are obtained by constructing each
+ * chunk with the same seed and calling skip_ahead(chunk_index * n).
+ */
+class QuasiRandomRectangularSampling : public TakeStep {
+protected:
+    HaltonSequence m_sequence;
+    pele::Array<double> m_boxvec;
+    std::vector<double> m_point;
+public:
+    virtual ~QuasiRandomRectangularSampling() {}
+    QuasiRandomRectangularSampling(const size_t seed, const pele::Array<double> boxvec, const size_t ndof)
+        : m_sequence(ndof, seed),
+          m_boxvec(boxvec.copy()),
+          m_point(ndof)
+    {
+        if (ndof % m_boxvec.size()) {
+            throw std::runtime_error("QuasiRandomRectangularSampling: ndof incompatible with boxvec size");
+        }
+    }
+    void set_generator_seed(const size_t inp) { m_sequence.set_seed(inp); }
+    void skip_ahead(const size_t n) { m_sequence.skip_ahead(n); }
+    size_t get_count() const { return m_sequence.get_index(); }
+    virtual void displace(pele::Array<double>& coords, MC* mc)
+    {
+        if (coords.size() != m_point.size()) {
+            throw std::runtime_error("QuasiRandomRectangularSampling::displace: coords size incompatible with ndof");
+        }
+        m_sequence.next(m_point.data());
+        const size_t dim = m_boxvec.size();
+        for (size_t i = 0; i < coords.size(); ++i) {
+            coords[i] = m_boxvec[i % dim] * (m_point[i] - 0.5);
+        }
+    }
+};
+
+/**
+ * Quasi-random version of UniformSphericalSampling.
+ * The ndof normal variates are obtained from pairs of Halton coordinates with
+ * the Box-Muller transform, and one further coordinate sets the radius, as in
+ * UniformSphericalSampling.
+ */
+class QuasiRandomSphericalSampling : public TakeStep {
+protected:
+    HaltonSequence m_sequence;
+    const double m_radius;
+    const size_t m_ndof;
+    std::vector<double> m_point;
+public:
+    virtual ~QuasiRandomSphericalSampling() {}
+    QuasiRandomSphericalSampling(const size_t seed, const double radius, const size_t ndof)
+        : m_sequence(2 * ((ndof + 1) / 2) + 1, seed),
+          m_radius(radius),
+          m_ndof(ndof),
+          m_point(m_sequence.get_ndim())
+    {}
+    void set_generator_seed(const size_t inp) { m_sequence.set_seed(inp); }
+    void skip_ahead(const size_t n) { m_sequence.skip_ahead(n); }
+    size_t get_count() const { return m_sequence.get_index(); }
+    virtual void displace(pele::Array<double>& coords, MC* mc)
+    {
+        if (coords.size() != m_ndof) {
+            throw std::runtime_error("QuasiRandomSphericalSampling::displace: coords size incompatible with ndof");
+        }
+        m_sequence.next(m_point.data());
+        for (size_t i = 0; i < m_ndof; i += 2) {
+            // 1 - u is in (0, 1], so that the log is finite
+            const double r = std::sqrt(-2 * std::log(1 - m_point[i]));
+            const double phi = 2 * M_PI * m_point[i + 1];
+            coords[i] = r * std::cos(phi);
+            if (i + 1 < m_ndof) {
+                coords[i + 1] = r * std::sin(phi);
+            }
+        }
+        double tmp = 1.0 / norm(coords);
+        tmp *= m_radius * std::pow(m_point.back(), 1.0 / m_ndof);
+        coords *= tmp;
+    }
+};
+
+} // namespace mcpele
+
+#endif // #ifndef _MCPELE_QUASI_RANDOM_SAMPLING_H__
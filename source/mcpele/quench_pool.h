@@ -0,0 +1,74 @@
+#ifndef _MCPELE_QUENCH_POOL_H__
+#define _MCPELE_QUENCH_POOL_H__
+
+#include <memory>
+#include <vector>
+
+#include "pele/optimizer.h"
+
+#include "mc.h"
+#include "snapshot_mc.h"
+
+namespace mcpele {
+
+/**
+ * Inherent structure sampling with batched, parallel quenches.
+ * Every record_every-th step after eqsteps steps the coordinates are
+ * copied into the current batch. Once batch_size configurations are
+ * collected they are minimised in parallel, one thread per optimizer;
+ * the optimizers must be independent instances, each with its own
+ * potential. The minima are then passed, in the order of the MC steps,
+ * to the actions added with add_action(): e.g. a RecordPairDistHistogram
+ * (without optimizer) for the inherent structure g(r), a
+ * RecordEnergyHistogram, or a MinimaDatabase. These actions see a
+ * SnapshotMC at the step of the configuration, with the energy of the
+ * minimum, so they can keep record_every = 1 and eqsteps = 0.
+ * Minima of unconverged quenches are not passed on, but counted.
+ * Call flush() at the end of the run to quench the last, partial batch.
+ */
+class QuenchPool : public Action {
+private:
+    const size_t m_record_every;
+    const size_t m_eqsteps;
+    const size_t m_batch_size;
+    std::vector<std::shared_ptr<pele::GradientOptimizer> > m_optimizers;
+    MC::actions_t m_actions;
+    std::vector<pele::Array<double> > m_batch;
+    std::vector<size_t> m_batch_steps;
+    std::vector<double> m_batch_energies;
+    std::vector<char> m_batch_success;
+    size_t m_batch_fill;
+    double m_temperature;
+    size_t m_nr_quenched;
+    size_t m_nr_failed;
+    std::unique_ptr<SnapshotMC> m_snapshot_mc;
+    void m_quench(const size_t nr_configurations, const size_t ithread, const size_t nr_threads);
+public:
+    QuenchPool(std::vector<std::shared_ptr<pele::GradientOptimizer> > optimizers, const size_t record_every,
+            const size_t eqsteps, const size_t batch_size=0);
+    virtual ~QuenchPool() {}
+    virtual void action(pele::Array<double> &coords, double energy, bool accepted, MC* mc);
+    /**
+     * add an action that is given the minima
+     */
+    void add_action(std::shared_ptr<Action> action) { m_actions.push_back(action); }
+    /**
+     * quench the configurations of the current, partial batch
+     */
+    void flush();
+    size_t get_nr_threads() const { return m_optimizers.size(); }
+    size_t get_batch_size() const { return m_batch_size; }
+    /**
+     * quenches done, including the unconverged ones
+     */
+    size_t get_nr_quenched() const { return m_nr_quenched; }
+    size_t get_nr_failed() const { return m_nr_failed; }
+    /**
+     * configurations waiting for the next batch
+     */
+    size_t get_nr_pending() const { return m_batch_fill; }
+};
+
+} // namespace mcpele
+
+#endif // #ifndef _MCPELE_QUENCH_POOL_H__
@@ -4,6 +4,7 @@
 #include <random>
 
 #include "mc.h"
+#include "periodic_image_tracker.h"
 
 namespace mcpele {
 
@@ -54,6 +55,35 @@ public:
     size_t get_rand_particle(){return m_rand_particle;} //dangerous function, should be used only for testing purposes
 };
 
+/**
+ * Periodic versions of the random coords displacements.
+ * After each displacement the moved particles are put back into the periodic
+ * box defined by boxvec (centred at the origin), so that coordinates do not
+ * drift far away from the primary image in long runs. The number of box
+ * lengths by which each coordinate has been shifted is kept by a
+ * PeriodicImageTracker, which can be shared with actions that need the
+ * unwrapped coordinates (e.g. RecordDisplacementPerParticleTimeseries).
+ */
+class RandomCoordsDisplacementPeriodicAll : public RandomCoordsDisplacementAll {
+protected:
+    std::shared_ptr<PeriodicImageTracker> m_images;
+public:
+    RandomCoordsDisplacementPeriodicAll(const size_t rseed, const pele::Array<double> boxvec, const double stepsize=1);
+    virtual ~RandomCoordsDisplacementPeriodicAll() {}
+    virtual void displace(pele::Array<double>& coords, MC* mc);
+    std::shared_ptr<PeriodicImageTracker> get_image_tracker() const { return m_images; }
+};
+
+class RandomCoordsDisplacementPeriodicSingle : public RandomCoordsDisplacementSingle {
+protected:
+    std::shared_ptr<PeriodicImageTracker> m_images;
+public:
+    RandomCoordsDisplacementPeriodicSingle(const size_t rseed, const size_t nparticles, const pele::Array<double> boxvec, const double stepsize=1);
+    virtual ~RandomCoordsDisplacementPeriodicSingle() {}
+    virtual void displace(pele::Array<double>& coords, MC* mc);
+    std::shared_ptr<PeriodicImageTracker> get_image_tracker() const { return m_images; }
+};
+
 } // namespace mcpele
 
 #endif // #ifndef _MCPELE_RANDOM_COORDS_DISPLACEMENT_H__
@@ -0,0 +1,33 @@
+#ifndef _MCPELE_RECORD_COMPRESSED_TRAJECTORY_H__
+#define _MCPELE_RECORD_COMPRESSED_TRAJECTORY_H__
+
+#include "mc.h"
+#include "compressed_trajectory.h"
+
+namespace mcpele {
+
+/**
+ * Stream the coordinates, every record_every-th step after eqsteps steps,
+ * to a file in the fixed precision format of CompressedTrajectoryWriter.
+ * Only the write buffer is kept in memory.
+ */
+class RecordCompressedTrajectory : public Action {
+private:
+    const size_t m_record_every;
+    const size_t m_eqsteps;
+    CompressedTrajectoryWriter m_writer;
+public:
+    RecordCompressedTrajectory(const std::string& filename, const size_t ndof,
+            const size_t record_every, const size_t eqsteps, const double precision=1e-3,
+            const size_t keyframe_every=100);
+    virtual ~RecordCompressedTrajectory() {}
+    virtual void action(pele::Array<double> &coords, double energy, bool accepted, MC* mc);
+    void flush() { m_writer.flush(); }
+    size_t get_nr_frames() const { return m_writer.get_nr_frames(); }
+    size_t get_bytes_written() const { return m_writer.get_bytes_written(); }
+    size_t get_record_every() const { return m_record_every; }
+};
+
+} // namespace mcpele
+
+#endif // #ifndef _MCPELE_RECORD_COMPRESSED_TRAJECTORY_H__
@@ -0,0 +1,49 @@
+#ifndef _MCPELE_RECORD_DISPLACEMENT_CORRELATION_H__
+#define _MCPELE_RECORD_DISPLACEMENT_CORRELATION_H__
+
+#include <memory>
+
+#include "mc.h"
+#include "displacement_correlator.h"
+#include "periodic_image_tracker.h"
+
+namespace mcpele {
+
+/**
+ * Record the multi-origin mean square displacement and self intermediate
+ * scattering function (see DisplacementCorrelator), every record_every-th
+ * step after eqsteps steps, without storing the trajectory.
+ * Lags are reported in MC steps.
+ * If particles are placed back into the box by a periodic take step, pass
+ * its image tracker: the displacements are then computed from the
+ * unwrapped coordinates.
+ */
+class RecordDisplacementCorrelation : public Action {
+private:
+    const size_t m_record_every;
+    const size_t m_eqsteps;
+    DisplacementCorrelator m_correlator;
+    std::shared_ptr<PeriodicImageTracker> m_images;
+    pele::Array<double> m_unwrapped;
+public:
+    RecordDisplacementCorrelation(const size_t record_every, const size_t eqsteps,
+            const size_t boxdimension, const double wavenumber=0, const size_t nr_lags=16);
+    RecordDisplacementCorrelation(const size_t record_every, const size_t eqsteps,
+            std::shared_ptr<PeriodicImageTracker> images, const double wavenumber=0,
+            const size_t nr_lags=16);
+    virtual ~RecordDisplacementCorrelation() {}
+    virtual void action(pele::Array<double> &coords, double energy, bool accepted, MC* mc);
+    size_t get_record_every() const { return m_record_every; }
+    size_t get_eqsteps() const { return m_eqsteps; }
+    size_t get_count() const { return m_correlator.get_count(); }
+    size_t get_nr_levels() const { return m_correlator.get_nr_levels(); }
+    pele::Array<double> get_lags() const;
+    pele::Array<double> get_mean_square_displacement() const;
+    pele::Array<double> get_self_intermediate_scattering() const;
+    pele::Array<double> get_nr_origins() const;
+    void clear() { m_correlator.clear(); }
+};
+
+} // namespace mcpele
+
+#endif // #ifndef _MCPELE_RECORD_DISPLACEMENT_CORRELATION_H__
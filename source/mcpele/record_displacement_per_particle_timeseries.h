@@ -3,6 +3,7 @@
 
 #include "record_scalar_timeseries.h"
 #include "rsm_displacement.h"
+#include "periodic_image_tracker.h"
 
 namespace mcpele {
 
@@ -10,10 +11,15 @@ namespace mcpele {
  * Record time series of mean displacement per particle.
  * Motivation: check if HS fluid is decorrelated between snapshots
  * This is useful if particles are not placed back into periodic box.
+ * If particles are placed back into the box by a periodic take step, pass its
+ * image tracker: the displacement is then computed from the unwrapped
+ * coordinates.
  */
 class RecordDisplacementPerParticleTimeseries : public RecordScalarTimeseries{
 private:
     GetDisplacementPerParticle m_rsm_displacement;
+    std::shared_ptr<PeriodicImageTracker> m_images;
+    pele::Array<double> m_unwrapped;
 public:
     RecordDisplacementPerParticleTimeseries(const size_t niter,
             const size_t record_every, pele::Array<double> initial_coords,
@@ -21,10 +27,24 @@ public:
         : RecordScalarTimeseries(niter, record_every),
           m_rsm_displacement(initial_coords, boxdimension)
     {}
+    RecordDisplacementPerParticleTimeseries(const size_t niter,
+            const size_t record_every, pele::Array<double> initial_coords,
+            std::shared_ptr<PeriodicImageTracker> images)
+        : RecordScalarTimeseries(niter, record_every),
+          m_rsm_displacement(initial_coords, images->get_ndim()),
+          m_images(images),
+          m_unwrapped(initial_coords.size())
+    {}
     virtual ~RecordDisplacementPerParticleTimeseries(){}
     virtual double get_recorded_scalar(pele::Array<double> &coords,
             const double energy, const bool accepted, MC* mc)
-            { return m_rsm_displacement.compute_mean_particle_displacement(coords); }
+    {
+        if (m_images) {
+            m_images->unwrap(coords, m_unwrapped);
+            return m_rsm_displacement.compute_mean_particle_displacement(m_unwrapped);
+        }
+        return m_rsm_displacement.compute_mean_particle_displacement(coords);
+    }
 };
 
 } // namespace mcpele
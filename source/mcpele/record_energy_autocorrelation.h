@@ -0,0 +1,20 @@
+#ifndef _MCPELE_RECORD_ENERGY_AUTOCORRELATION_H__
+#define _MCPELE_RECORD_ENERGY_AUTOCORRELATION_H__
+
+#include "record_scalar_autocorrelation.h"
+
+namespace mcpele {
+
+class RecordEnergyAutocorrelation : public RecordScalarAutocorrelation {
+public:
+    RecordEnergyAutocorrelation(const size_t record_every, const size_t eqsteps, const size_t nr_lags=16)
+        : RecordScalarAutocorrelation(record_every, eqsteps, nr_lags)
+    {}
+    virtual ~RecordEnergyAutocorrelation() {}
+    virtual double get_recorded_scalar(pele::Array<double> &coords,
+            const double energy, const bool accepted, MC* mc) { return energy; }
+};
+
+} // namespace mcpele
+
+#endif // #ifndef _MCPELE_RECORD_ENERGY_AUTOCORRELATION_H__
@@ -0,0 +1,20 @@
+#ifndef _MCPELE_RECORD_ENERGY_BLOCKING_H__
+#define _MCPELE_RECORD_ENERGY_BLOCKING_H__
+
+#include "record_scalar_blocking.h"
+
+namespace mcpele {
+
+class RecordEnergyBlocking : public RecordScalarBlocking {
+public:
+    RecordEnergyBlocking(const size_t record_every, const size_t eqsteps, const size_t min_blocks=16)
+        : RecordScalarBlocking(record_every, eqsteps, min_blocks)
+    {}
+    virtual ~RecordEnergyBlocking() {}
+    virtual double get_recorded_scalar(pele::Array<double> &coords,
+            const double energy, const bool accepted, MC* mc) { return energy; }
+};
+
+} // namespace mcpele
+
+#endif // #ifndef _MCPELE_RECORD_ENERGY_BLOCKING_H__
@@ -8,26 +8,44 @@ namespace mcpele {
 
 /*
  * Record energy histogram
+ * The histogram grows as needed to accommodate energies outside of [min, max).
+ * If sparse is true, only the visited bins are stored (see SparseHistogram),
+ * which bounds memory for very wide energy ranges. get_histogram() always
+ * builds the dense histogram over the whole range, read a sparse histogram
+ * with get_occupied_bins() instead.
 */
 
 class RecordEnergyHistogram : public Action {
 protected:
-    mcpele::Histogram m_hist;
+    std::shared_ptr<mcpele::BaseHistogram> m_hist;
 private:
     const size_t m_eqsteps;
+    const bool m_sparse;
     size_t m_count;
 public:
-    RecordEnergyHistogram(const double min, const double max, const double bin, const size_t eqsteps);
+    RecordEnergyHistogram(const double min, const double max, const double bin, const size_t eqsteps, const bool sparse=false);
     virtual ~RecordEnergyHistogram() {} ;
     virtual void action(pele::Array<double> &coords, double energy, bool accepted, MC* mc);
     pele::Array<double> get_histogram() const;
-    void print_terminal() const { m_hist.print_terminal(); }
-    double get_max() const { return m_hist.max(); }
-    double get_min() const { return m_hist.min(); }
+    /**
+     * bin centres and counts of the visited bins, sorted by energy
+     */
+    void get_occupied_bins(std::vector<double>& positions, std::vector<double>& counts) const;
+    void print_terminal() const { m_hist->print_terminal(); }
+    double get_max() const { return m_hist->max(); }
+    double get_min() const { return m_hist->min(); }
     size_t get_eqsteps() const { return m_eqsteps; }
-    double get_mean() const { return m_hist.get_mean(); }
-    double get_variance() const { return m_hist.get_variance(); }
-    int get_count() const { return m_hist.get_count(); }
+    double get_mean() const { return m_hist->get_mean(); }
+    double get_variance() const { return m_hist->get_variance(); }
+    size_t get_count() const { return m_hist->get_count(); }
+    bool is_sparse() const { return m_sparse; }
+    /**
+     * combine histograms recorded e.g. by different threads or processes
+     * (see BaseHistogram::merge)
+     */
+    void merge(const RecordEnergyHistogram& other) { m_hist->merge(*other.m_hist); }
+    std::vector<double> get_buffer() const { return m_hist->get_buffer(); }
+    void merge_buffer(const std::vector<double>& buffer) { m_hist->merge_buffer(buffer); }
 };
 
 } // namespace mcpele
@@ -7,8 +7,8 @@ namespace mcpele {
 
 class RecordEnergyTimeseries : public RecordScalarTimeseries {
 public:
-    RecordEnergyTimeseries(const size_t niter, const size_t record_every)
-        : RecordScalarTimeseries(niter, record_every)
+    RecordEnergyTimeseries(const size_t niter, const size_t record_every, const size_t capacity=0)
+        : RecordScalarTimeseries(niter, record_every, capacity)
     {}
     virtual ~RecordEnergyTimeseries() {}
     virtual double get_recorded_scalar(pele::Array<double> &coords,
@@ -7,7 +7,8 @@
 namespace mcpele {
 
 /**
- * Record time series of lowest eigenvalue
+ * Record time series of lowest eigenvalue, see FindLowestEigenvalue for
+ * the warm_start, use_lanczos and tol options
  */
 
 class RecordLowestEValueTimeseries : public RecordScalarTimeseries{
@@ -18,14 +19,21 @@ public:
             const size_t record_every,
             std::shared_ptr<pele::BasePotential> landscape_potential,
             const size_t boxdimension, pele::Array<double> ranvec,
-            const size_t lbfgsniter = 30)
+            const size_t lbfgsniter = 30, const bool warm_start=false,
+            const bool use_lanczos=false, const double tol=1e-6)
         : RecordScalarTimeseries(niter, record_every),
-          m_lowest_ev(landscape_potential, boxdimension, ranvec, lbfgsniter)
+          m_lowest_ev(landscape_potential, boxdimension, ranvec, lbfgsniter, warm_start, use_lanczos, tol)
     {}
     virtual ~RecordLowestEValueTimeseries(){}
     virtual double get_recorded_scalar(pele::Array<double> &coords,
             const double energy, const bool accepted, MC* mc)
             { return m_lowest_ev.compute_lowest_eigenvalue(coords); }
+    /**
+     * solver iterations of the last sample, and in total
+     */
+    size_t get_last_niter() const { return m_lowest_ev.get_last_niter(); }
+    size_t get_total_niter() const { return m_lowest_ev.get_total_niter(); }
+    size_t get_nr_computations() const { return m_lowest_ev.get_nr_computations(); }
 };
 
 } // namespace mcpele
@@ -16,6 +16,12 @@ namespace mcpele {
  * --- nr_bins: number of bins for g(r) histogram
  * --- eqsteps: number of equilibration steps to be excluded from g(r) computation
  * --- record_every: after more than eqsteps steps have been done, record every record_everyth step
+ * --- nr_threads: number of threads sharing the pair loop of each recorded configuration (optional)
+ * --- max_dist: range of the g(r) histogram, defaults to half the smallest box side (optional);
+ *     if max_dist is at most a third of every box side, a cell list is used to find the pairs
+ * --- incremental: keep the histogram of the current configuration and only update the pairs
+ *     of the particles that moved since the last record (optional, not with a quench);
+ *     recording is then a vector add, which makes it cheap to record at every step
  * Everytime the action is called, it accumulates the present configuration into the same g(r) histogram.
  * The action function calls add_configuration which accumulates the current configuration into the g(r) histogram.
  * The g(r) histogram can be read out at any point after that.
@@ -32,19 +38,24 @@ private:
     const size_t m_eqsteps;
     const size_t m_record_every;
     const bool m_quench;
+    const bool m_incremental;
     std::shared_ptr<pele::GradientOptimizer> m_optimizer;
 public:
-    RecordPairDistHistogram(pele::Array<double> boxvector, const size_t nr_bins, const size_t eqsteps, const size_t record_every)
-        : m_hist_gr(boxvector, nr_bins),
+    RecordPairDistHistogram(pele::Array<double> boxvector, const size_t nr_bins, const size_t eqsteps, const size_t record_every,
+            const size_t nr_threads=1, const double max_dist=0, const bool incremental=false)
+        : m_hist_gr(boxvector, nr_bins, nr_threads, max_dist),
           m_eqsteps(eqsteps),
           m_record_every(record_every),
-          m_quench(false)
+          m_quench(false),
+          m_incremental(incremental)
     {}
-    RecordPairDistHistogram(pele::Array<double> boxvector, const size_t nr_bins, const size_t eqsteps, const size_t record_every, std::shared_ptr<pele::GradientOptimizer> optimizer)
-        : m_hist_gr(boxvector, nr_bins),
+    RecordPairDistHistogram(pele::Array<double> boxvector, const size_t nr_bins, const size_t eqsteps, const size_t record_every, std::shared_ptr<pele::GradientOptimizer> optimizer,
+            const size_t nr_threads=1, const double max_dist=0)
+        : m_hist_gr(boxvector, nr_bins, nr_threads, max_dist),
           m_eqsteps(eqsteps),
           m_record_every(record_every),
           m_quench(true),
+          m_incremental(false),
           m_optimizer(optimizer)
     {}
     virtual ~RecordPairDistHistogram() {}
@@ -59,6 +70,11 @@ public:
     }
     virtual void process_add_configuration(pele::Array<double>& coords)
     {
+        if (m_incremental) {
+            m_hist_gr.update_live_configuration(coords);
+            m_hist_gr.add_live_configuration();
+            return;
+        }
         pele::Array<double> tmp = coords.copy();
         if (m_quench) {
             m_optimizer->reset(tmp);
@@ -71,6 +87,14 @@ public:
     {
         return m_eqsteps;
     }
+    bool is_incremental() const
+    {
+        return m_incremental;
+    }
+    void set_nr_threads(const size_t nr_threads)
+    {
+        m_hist_gr.set_nr_threads(nr_threads);
+    }
     pele::Array<double> get_hist_r() const
     {
         std::vector<double> vecdata(m_hist_gr.get_vecdata_r());
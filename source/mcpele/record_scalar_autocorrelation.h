@@ -0,0 +1,50 @@
+#ifndef _MCPELE_RECORD_SCALAR_AUTOCORRELATION_H__
+#define _MCPELE_RECORD_SCALAR_AUTOCORRELATION_H__
+
+#include <cmath>
+
+#include "mc.h"
+#include "multi_tau_correlator.h"
+
+namespace mcpele {
+
+/**
+ * Record the autocorrelation of a scalar observable with a multi-tau
+ * correlator (see MultiTauCorrelator), every record_every-th step after
+ * eqsteps steps, without storing the time series.
+ * Lags and the integrated autocorrelation time are reported in MC steps.
+ * get_decorrelation_steps() = 2 tau_int is the number of steps between
+ * effectively independent samples, e.g. for the record_every of time series
+ * actions.
+ */
+class RecordScalarAutocorrelation : public Action {
+private:
+    const size_t m_record_every;
+    const size_t m_eqsteps;
+    MultiTauCorrelator m_correlator;
+public:
+    RecordScalarAutocorrelation(const size_t record_every, const size_t eqsteps, const size_t nr_lags=16);
+    virtual ~RecordScalarAutocorrelation() {}
+    virtual void action(pele::Array<double> &coords, double energy, bool accepted, MC* mc);
+    virtual double get_recorded_scalar(pele::Array<double> &coords, const double energy, const bool accepted, MC* mc)=0;
+    size_t get_record_every() const { return m_record_every; }
+    size_t get_eqsteps() const { return m_eqsteps; }
+    size_t get_count() const { return m_correlator.get_count(); }
+    double get_mean() const { return m_correlator.get_mean(); }
+    double get_variance() const { return m_correlator.get_variance(); }
+    pele::Array<double> get_lags() const;
+    pele::Array<double> get_autocorrelation() const;
+    double get_integrated_time(const double window=6) const
+    {
+        return m_record_every * m_correlator.get_integrated_time(window);
+    }
+    size_t get_decorrelation_steps() const
+    {
+        return static_cast<size_t>(std::ceil(2 * get_integrated_time()));
+    }
+    void clear() { m_correlator.clear(); }
+};
+
+} // namespace mcpele
+
+#endif // #ifndef _MCPELE_RECORD_SCALAR_AUTOCORRELATION_H__
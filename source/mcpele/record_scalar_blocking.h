@@ -0,0 +1,42 @@
+#ifndef _MCPELE_RECORD_SCALAR_BLOCKING_H__
+#define _MCPELE_RECORD_SCALAR_BLOCKING_H__
+
+#include "mc.h"
+#include "blocking_analysis.h"
+
+namespace mcpele {
+
+/**
+ * Blocking analysis (see BlockingAnalysis) of a scalar observable, recorded
+ * every record_every-th step after eqsteps steps, without storing the time
+ * series. The standard error of the mean is available while the run is
+ * going; block sizes are reported in recorded samples.
+ */
+class RecordScalarBlocking : public Action {
+private:
+    const size_t m_record_every;
+    const size_t m_eqsteps;
+    BlockingAnalysis m_blocking;
+public:
+    RecordScalarBlocking(const size_t record_every, const size_t eqsteps, const size_t min_blocks=16);
+    virtual ~RecordScalarBlocking() {}
+    virtual void action(pele::Array<double> &coords, double energy, bool accepted, MC* mc);
+    virtual double get_recorded_scalar(pele::Array<double> &coords, const double energy, const bool accepted, MC* mc)=0;
+    size_t get_record_every() const { return m_record_every; }
+    size_t get_eqsteps() const { return m_eqsteps; }
+    size_t get_count() const { return m_blocking.get_count(); }
+    double get_mean() const { return m_blocking.get_mean(); }
+    double get_variance() const { return m_blocking.get_variance(); }
+    double get_standard_error() const { return m_blocking.get_standard_error(); }
+    bool has_plateau() const { return m_blocking.has_plateau(); }
+    double get_statistical_inefficiency() const { return m_blocking.get_statistical_inefficiency(); }
+    pele::Array<double> get_block_sizes() const;
+    pele::Array<double> get_standard_errors() const;
+    pele::Array<double> get_standard_error_errors() const;
+    const BlockingAnalysis& get_blocking() const { return m_blocking; }
+    void clear() { m_blocking.clear(); }
+};
+
+} // namespace mcpele
+
+#endif // #ifndef _MCPELE_RECORD_SCALAR_BLOCKING_H__
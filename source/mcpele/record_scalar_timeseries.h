@@ -1,32 +1,97 @@
 #ifndef _MCPELE_RECORD_SCALAR_TIMESERIES_H__
 #define _MCPELE_RECORD_SCALAR_TIMESERIES_H__
 
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
 #include "mc.h"
+#include "mapped_timeseries.h"
 
 namespace mcpele {
 
 /**
  * Record scalar time series, every record_every-th step.
+ * With capacity > 0 only the last capacity values are kept, in a ring
+ * buffer of twice that size where every value is written twice (at
+ * position i and i + capacity), so that the retained values are always
+ * contiguous and can be handed out without copying.
+ * After map_to_file() the values are appended to a memory mapped .npy
+ * file (see MappedTimeseries) instead of being kept in memory.
  */
 class RecordScalarTimeseries : public Action {
 private:
     const size_t m_record_every;
+    const size_t m_capacity;
     std::vector<double> m_time_series;
+    size_t m_ring_head;
+    size_t m_ring_count;
+    std::unique_ptr<MappedTimeseries> m_mapped;
     void m_record_scalar_value(const double input)
     {
-        m_time_series.push_back(input);
+        if (m_mapped) {
+            m_mapped->append(&input);
+        }
+        else if (m_capacity) {
+            m_time_series[m_ring_head] = input;
+            m_time_series[m_ring_head + m_capacity] = input;
+            m_ring_head = (m_ring_head + 1) % m_capacity;
+            m_ring_count = std::min(m_ring_count + 1, m_capacity);
+        }
+        else {
+            m_time_series.push_back(input);
+        }
     }
+    const double* m_series_begin() const;
+    const double* m_series_end() const;
 public:
-    RecordScalarTimeseries(const size_t, const size_t);
+    /**
+     * niter: expected number of steps, to preallocate
+     * capacity: number of most recent values to keep, 0 to keep all
+     */
+    RecordScalarTimeseries(const size_t niter, const size_t record_every, const size_t capacity=0);
     virtual ~RecordScalarTimeseries(){}
     virtual void action(pele::Array<double> &coords, double energy, bool accepted, MC* mc);
     virtual double get_recorded_scalar(pele::Array<double> &coords, const double energy, const bool accepted, MC* mc)=0;
-    pele::Array<double> get_time_series()
+    pele::Array<double> get_time_series() const
+    {
+        return get_time_series_view().copy();
+    }
+    /**
+     * the recorded values, from old to new, without copying.
+     * The view is valid until the next value is recorded.
+     */
+    pele::Array<double> get_time_series_view() const
+    {
+        return pele::Array<double>(const_cast<double*>(m_series_begin()), size());
+    }
+    /**
+     * number of values held
+     */
+    size_t size() const { return m_series_end() - m_series_begin(); }
+    size_t get_capacity() const { return m_capacity; }
+    void clear();
+    /**
+     * from now on append the time series to the .npy file filename,
+     * values recorded so far are moved there; not available with a capacity
+     */
+    void map_to_file(const std::string& filename, const size_t flush_every=1024);
+    bool is_mapped() const { return static_cast<bool>(m_mapped); }
+    /**
+     * update the file so that readers see all values recorded so far
+     */
+    void flush_file()
     {
-        m_time_series.shrink_to_fit();
-        return pele::Array<double>(m_time_series).copy();
+        if (m_mapped) {
+            m_mapped->flush();
+        }
     }
-    void clear() { m_time_series.clear(); }
+    /**
+     * test the last nr_steps_total entries of the time series for
+     * stationarity, see EquilibrationDetector
+     */
+    bool moving_average_is_stable(const size_t nr_steps_total, const double threshold) const;
 };
 
 } // namespace mcpele
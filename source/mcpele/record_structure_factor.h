@@ -0,0 +1,81 @@
+#ifndef _MCPELE_RECORD_STRUCTURE_FACTOR_H__
+#define _MCPELE_RECORD_STRUCTURE_FACTOR_H__
+
+#include "mc.h"
+#include "structure_factor.h"
+
+namespace mcpele {
+
+/**
+ * Record the static structure factor S(k) on the fly
+ * Templated on boxdimension, the wavevectors are those of the periodic box
+ * Input parameters:
+ * --- boxvector: defines the periodic simulation box
+ * --- kmax: wavevectors with |k| < kmax are used
+ * --- nr_bins: number of |k| shells of the S(k) histogram
+ * --- eqsteps: number of equilibration steps to be excluded from S(k) computation
+ * --- record_every: after more than eqsteps steps have been done, record every record_everyth step
+ * --- incremental: keep the density modes of the current configuration and only update the
+ *     particles that moved since the last record (optional), which is cheap for single particle moves
+ * To read out the data:
+ * --- get_hist_k() gives the centres of the |k| shells
+ * --- get_hist_sk() gives the corresponding S(k), averaged over the wavevectors in each shell
+ */
+template<size_t BOXDIM>
+class RecordStructureFactor : public Action {
+private:
+    mcpele::StructureFactor<BOXDIM> m_sk;
+    const size_t m_eqsteps;
+    const size_t m_record_every;
+    const bool m_incremental;
+public:
+    RecordStructureFactor(pele::Array<double> boxvector, const double kmax, const size_t nr_bins,
+            const size_t eqsteps, const size_t record_every, const bool incremental=false)
+        : m_sk(boxvector, kmax, nr_bins),
+          m_eqsteps(eqsteps),
+          m_record_every(record_every),
+          m_incremental(incremental)
+    {}
+    virtual ~RecordStructureFactor() {}
+    virtual void action(pele::Array<double>& coords, double energy, bool accepted, MC* mc)
+    {
+        const size_t count = mc->get_iterations_count();
+        if (count > m_eqsteps) {
+            if (count % m_record_every == 0) {
+                if (m_incremental) {
+                    m_sk.update_live_configuration(coords);
+                    m_sk.add_live_configuration();
+                }
+                else {
+                    m_sk.add_configuration(coords);
+                }
+            }
+        }
+    }
+    size_t get_eqsteps() const
+    {
+        return m_eqsteps;
+    }
+    bool is_incremental() const
+    {
+        return m_incremental;
+    }
+    size_t get_nr_wavevectors() const
+    {
+        return m_sk.get_nr_wavevectors();
+    }
+    pele::Array<double> get_hist_k() const
+    {
+        std::vector<double> vecdata(m_sk.get_vecdata_k());
+        return pele::Array<double>(vecdata).copy();
+    }
+    pele::Array<double> get_hist_sk() const
+    {
+        std::vector<double> vecdata(m_sk.get_vecdata_sk());
+        return pele::Array<double>(vecdata).copy();
+    }
+};
+
+} // namespace mcpele
+
+#endif // #ifndef _MCPELE_RECORD_STRUCTURE_FACTOR_H__
@@ -2,39 +2,100 @@
 #define _MCPELE_RECORD_VECTOR_TIMESERIES_H__
 
 #include "mc.h"
+#include "chunked_arena.h"
+#include "mapped_timeseries.h"
 #include <deque>
+#include <memory>
+#include <string>
 #include <cstdlib>
 
 namespace mcpele {
 
 /**
  * Record vector time series, every record_every-th step.
+ * The vectors are stored row-major in a ChunkedArena, or after
+ * map_to_file() appended to a memory mapped .npy file (see MappedTimeseries).
  */
 class RecordVectorTimeseries : public Action {
 protected:
     const size_t m_record_every, m_eqsteps;
-    std::deque<pele::Array<double>> m_time_series;
+    ChunkedArena m_time_series;
+    std::string m_mapped_filename;
+    size_t m_mapped_flush_every;
+    std::unique_ptr<MappedTimeseries> m_mapped;
     void m_record_vector_value(pele::Array<double> input)
     {
+        if (!m_mapped_filename.empty()) {
+            m_record_mapped(input);
+            return;
+        }
         try{
-            m_time_series.push_back(input.copy());
+            m_time_series.push_back(input);
         }
         catch(std::bad_alloc &ba){
             std::cerr<< "mcpele::RecordVectorTimeseries: bad_alloc caught: " << ba.what() << std::endl;
             std::exit(EXIT_FAILURE);
         }
     }
+    void m_record_mapped(const pele::Array<double>& input);
 public:
     RecordVectorTimeseries(const size_t record_every, const size_t eqsteps);
     virtual ~RecordVectorTimeseries(){}
     virtual void action(pele::Array<double> &coords, double energy, bool accepted, MC* mc);
     virtual pele::Array<double> get_recorded_vector(pele::Array<double> &coords, const double energy, const bool accepted, MC* mc)=0;
+    /**
+     * views of the recorded vectors in the arena, the data is not copied;
+     * vectors in a mapped file are copied, as the mapping moves when the file grows
+     */
     std::deque<pele::Array<double>> get_time_series()
     {
-        m_time_series.shrink_to_fit();
-        return m_time_series;
+        std::deque<pele::Array<double>> series;
+        if (m_mapped) {
+            for (size_t i = 0; i < m_mapped->size(); ++i) {
+                const double* row = m_mapped->data() + i * m_mapped->row_size();
+                series.push_back(pele::Array<double>(const_cast<double*>(row), m_mapped->row_size()).copy());
+            }
+            return series;
+        }
+        const size_t row_size = m_time_series.row_size();
+        for (size_t ichunk = 0; ichunk < m_time_series.get_nr_chunks(); ++ichunk) {
+            pele::Array<double> chunk = m_time_series.get_chunk(ichunk);
+            for (size_t i = 0; i < chunk.size(); i += row_size) {
+                series.push_back(chunk.view(i, i + row_size));
+            }
+        }
+        return series;
+    }
+    /**
+     * row-major storage of the recorded vectors
+     */
+    ChunkedArena& get_arena() { return m_time_series; }
+    void clear()
+    {
+        m_time_series.clear();
+        if (m_mapped) {
+            m_mapped->clear();
+        }
+    }
+    /**
+     * from now on append the vectors to the .npy file filename, which is
+     * created at the next record; vectors recorded so far are moved there
+     */
+    void map_to_file(const std::string& filename, const size_t flush_every=1024);
+    bool is_mapped() const { return !m_mapped_filename.empty(); }
+    /**
+     * whether the mapped file exists, i.e. a vector was recorded since map_to_file()
+     */
+    bool is_file_created() const { return static_cast<bool>(m_mapped); }
+    /**
+     * update the file so that readers see all vectors recorded so far
+     */
+    void flush_file()
+    {
+        if (m_mapped) {
+            m_mapped->flush();
+        }
     }
-    void clear() { m_time_series.clear(); }
     size_t get_record_every(){return m_record_every;}
 };
 
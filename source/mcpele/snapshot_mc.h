@@ -0,0 +1,35 @@
+#ifndef _MCPELE_SNAPSHOT_MC_H__
+#define _MCPELE_SNAPSHOT_MC_H__
+
+#include <memory>
+
+#include "mc.h"
+#include "nullpotential.h"
+
+namespace mcpele {
+
+/**
+ * MC that only reports the state of an earlier step.
+ * Actions run outside of the chain (on a worker thread, or on quenched
+ * configurations) are given a SnapshotMC, so that get_iterations_count(),
+ * get_energy(), get_temperature() and get_success() refer to the step
+ * at which their configuration was taken.
+ */
+class SnapshotMC : public MC {
+public:
+    SnapshotMC(pele::Array<double> coords)
+        : MC(std::make_shared<NullPotential>(), coords, 1)
+    {}
+    virtual ~SnapshotMC() {}
+    void set_snapshot(const size_t step, const double energy, const double temperature, const bool accepted)
+    {
+        m_nitercount = step;
+        m_energy = energy;
+        m_temperature = temperature;
+        m_success = accepted;
+    }
+};
+
+} // namespace mcpele
+
+#endif // #ifndef _MCPELE_SNAPSHOT_MC_H__
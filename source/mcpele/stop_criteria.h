@@ -0,0 +1,83 @@
+#ifndef _MCPELE_STOP_CRITERIA_H__
+#define _MCPELE_STOP_CRITERIA_H__
+
+#include <chrono>
+#include <memory>
+#include <string>
+
+#include "mc.h"
+#include "record_scalar_autocorrelation.h"
+#include "record_scalar_blocking.h"
+#include "wang_landau.h"
+
+namespace mcpele {
+
+/**
+ * Stop once the standard error of the mean of the observable recorded by a
+ * blocking action is below tolerance; by default the blocking analysis
+ * must also have reached a plateau, so that the estimate can be trusted.
+ */
+class StopStandardError : public StopCriterion {
+private:
+    std::shared_ptr<RecordScalarBlocking> m_blocking;
+    const double m_tolerance;
+    const bool m_require_plateau;
+    std::string m_reason;
+public:
+    StopStandardError(std::shared_ptr<RecordScalarBlocking> blocking, const double tolerance,
+            const bool require_plateau=true);
+    virtual ~StopStandardError() {}
+    virtual bool stop(MC* mc);
+    virtual std::string get_reason() const { return m_reason; }
+};
+
+/**
+ * Stop once the effective sample size, count / (2 tau_int), of the
+ * observable recorded by an autocorrelation action reaches target
+ */
+class StopEffectiveSampleSize : public StopCriterion {
+private:
+    std::shared_ptr<RecordScalarAutocorrelation> m_autocorrelation;
+    const double m_target;
+    std::string m_reason;
+public:
+    StopEffectiveSampleSize(std::shared_ptr<RecordScalarAutocorrelation> autocorrelation, const double target);
+    virtual ~StopEffectiveSampleSize() {}
+    virtual bool stop(MC* mc);
+    virtual std::string get_reason() const { return m_reason; }
+    double get_effective_sample_size() const;
+};
+
+/**
+ * Stop once the run has taken more than seconds of wall-clock time
+ */
+class StopWallClock : public StopCriterion {
+private:
+    const double m_seconds;
+    std::chrono::steady_clock::time_point m_start;
+    std::string m_reason;
+public:
+    StopWallClock(const double seconds);
+    virtual ~StopWallClock() {}
+    virtual void start(MC* mc) { m_start = std::chrono::steady_clock::now(); }
+    virtual bool stop(MC* mc);
+    virtual std::string get_reason() const { return m_reason; }
+};
+
+/**
+ * Stop once the ln f of a Wang-Landau run is below its lnf_final
+ */
+class StopWangLandau : public StopCriterion {
+private:
+    std::shared_ptr<RecordWangLandau> m_dos;
+    std::string m_reason;
+public:
+    StopWangLandau(std::shared_ptr<RecordWangLandau> dos);
+    virtual ~StopWangLandau() {}
+    virtual bool stop(MC* mc);
+    virtual std::string get_reason() const { return m_reason; }
+};
+
+} // namespace mcpele
+
+#endif // #ifndef _MCPELE_STOP_CRITERIA_H__
@@ -0,0 +1,309 @@
+#ifndef _MCPELE_STRUCTURE_FACTOR_H
+#define _MCPELE_STRUCTURE_FACTOR_H
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+
+#include "pele/array.h"
+
+namespace mcpele{
+
+/**
+ * Static structure factor S(k) = |sum_j exp(i k.r_j)|^2 / N, accumulated over
+ * configurations in a periodic box and averaged over shells of |k|.
+ * The wavevectors are k = 2 pi (n_1 / L_1, ..., n_d / L_d) with integer n and
+ * 0 < |k| < kmax; as S(-k) = S(k) only half of them are evaluated.
+ * The plane waves are computed for blocks of particles: one sincos per
+ * particle and dimension, the higher harmonics by the recurrence
+ * exp(i n x) = exp(i (n - 1) x) exp(i x), and the sum over each block is a
+ * contiguous loop over particles.
+ * As for PairDistHistogram, the density modes of a live configuration can be
+ * kept up to date for the particles that moved (update_live_configuration)
+ * and accumulated with add_live_configuration.
+ */
+template<size_t BOXDIM>
+class StructureFactor{
+private:
+    static const size_t m_block_size = 64;
+    double m_boxvec[BOXDIM];
+    const double m_kmax;
+    const size_t m_nr_bins;
+    const double m_delta_bin;
+    long m_nmax[BOXDIM];
+    /**
+     * integer wavevectors n, BOXDIM per wavevector, and their |k| bin
+     */
+    std::vector<long> m_wavevectors;
+    std::vector<size_t> m_wavevector_bin;
+    std::vector<size_t> m_bin_count;
+    std::vector<double> m_sk;
+    size_t m_nr_configs;
+    /**
+     * live configuration, its density modes and the number of single
+     * particle updates since they were last computed from scratch
+     */
+    pele::Array<double> m_live_coords;
+    std::vector<double> m_live_rho_re;
+    std::vector<double> m_live_rho_im;
+    size_t m_live_updates;
+    /**
+     * work space for the plane waves of a block of particles:
+     * m_wave_re[d][(n + m_nmax[d]) * m_block_size + j]
+     */
+    std::vector<double> m_wave_re[BOXDIM];
+    std::vector<double> m_wave_im[BOXDIM];
+    std::vector<double> m_rho_re;
+    std::vector<double> m_rho_im;
+public:
+    StructureFactor(pele::Array<double> boxvector, const double kmax, const size_t nr_bins)
+        : m_kmax(kmax),
+          m_nr_bins(nr_bins),
+          m_delta_bin(kmax / static_cast<double>(nr_bins)),
+          m_bin_count(nr_bins, 0),
+          m_sk(nr_bins, 0),
+          m_nr_configs(0),
+          m_live_updates(0)
+    {
+        if (BOXDIM != boxvector.size()) {
+            throw std::runtime_error("StructureFactor: illegal boxvector size");
+        }
+        if (kmax <= 0 || nr_bins == 0) {
+            throw std::runtime_error("StructureFactor: kmax and nr_bins must be positive");
+        }
+        for (size_t d = 0; d < BOXDIM; ++d) {
+            m_boxvec[d] = boxvector[d];
+            m_nmax[d] = static_cast<long>(kmax * m_boxvec[d] / (2 * M_PI));
+            m_wave_re[d].resize((2 * m_nmax[d] + 1) * m_block_size);
+            m_wave_im[d].resize((2 * m_nmax[d] + 1) * m_block_size);
+        }
+        m_build_wavevectors();
+        if (m_wavevector_bin.empty()) {
+            throw std::runtime_error("StructureFactor: no wavevector below kmax");
+        }
+    }
+    virtual ~StructureFactor() {}
+    size_t get_nr_wavevectors() const { return m_wavevector_bin.size(); }
+    size_t get_nr_configs() const { return m_nr_configs; }
+    /**
+     * density modes rho_k = sum_j exp(i k.r_j) of coords, in the order of
+     * the wavevectors
+     */
+    void compute_rho(pele::Array<double> coords, std::vector<double>& rho_re, std::vector<double>& rho_im)
+    {
+        rho_re.assign(get_nr_wavevectors(), 0);
+        rho_im.assign(get_nr_wavevectors(), 0);
+        const size_t nr_particles = coords.size() / BOXDIM;
+        for (size_t begin = 0; begin < nr_particles; begin += m_block_size) {
+            const size_t end = std::min(begin + m_block_size, nr_particles);
+            m_add_block(coords.data(), begin, end, 1, rho_re, rho_im);
+        }
+    }
+    void add_configuration(pele::Array<double> coords)
+    {
+        compute_rho(coords, m_rho_re, m_rho_im);
+        m_add_rho(m_rho_re, m_rho_im, coords.size() / BOXDIM);
+    }
+    /**
+     * bring the density modes of the live configuration up to date with
+     * coords, updating only the particles that moved; they are recomputed
+     * from scratch if many particles moved, or after N single particle
+     * updates to stop rounding errors from accumulating
+     */
+    void update_live_configuration(pele::Array<double> coords)
+    {
+        const size_t nr_particles = coords.size() / BOXDIM;
+        if (m_live_coords.size() != coords.size()) {
+            m_set_live_configuration(coords);
+            return;
+        }
+        std::vector<size_t> moved;
+        for (size_t i = 0; i < nr_particles; ++i) {
+            if (!std::equal(coords.data() + i * BOXDIM, coords.data() + (i + 1) * BOXDIM,
+                    m_live_coords.data() + i * BOXDIM)) {
+                moved.push_back(i);
+            }
+        }
+        m_live_updates += moved.size();
+        if (4 * moved.size() > nr_particles || m_live_updates > nr_particles) {
+            m_set_live_configuration(coords);
+            return;
+        }
+        for (size_t m = 0; m < moved.size(); ++m) {
+            const size_t i = moved[m];
+            m_add_block(m_live_coords.data(), i, i + 1, -1, m_live_rho_re, m_live_rho_im);
+            std::copy(coords.data() + i * BOXDIM, coords.data() + (i + 1) * BOXDIM,
+                    m_live_coords.data() + i * BOXDIM);
+            m_add_block(m_live_coords.data(), i, i + 1, 1, m_live_rho_re, m_live_rho_im);
+        }
+    }
+    void add_live_configuration()
+    {
+        if (m_live_rho_re.empty()) {
+            throw std::runtime_error("StructureFactor: live configuration not set");
+        }
+        m_add_rho(m_live_rho_re, m_live_rho_im, m_live_coords.size() / BOXDIM);
+    }
+    std::vector<double> get_vecdata_k() const
+    {
+        std::vector<double> result(m_nr_bins);
+        for (size_t i = 0; i < m_nr_bins; ++i) {
+            result.at(i) = (0.5 + i) * m_delta_bin;
+        }
+        return result;
+    }
+    /**
+     * S(k) averaged over configurations and over the wavevectors in each
+     * shell; shells without wavevectors are zero
+     */
+    std::vector<double> get_vecdata_sk() const
+    {
+        std::vector<double> result(m_nr_bins, 0);
+        for (size_t i = 0; i < m_nr_bins; ++i) {
+            if (m_bin_count[i] > 0 && m_nr_configs > 0) {
+                result.at(i) = m_sk[i] / (static_cast<double>(m_nr_configs) * m_bin_count[i]);
+            }
+        }
+        return result;
+    }
+private:
+    void m_build_wavevectors()
+    {
+        long n[BOXDIM];
+        std::fill(n, n + BOXDIM, 0);
+        size_t nr_candidates = 1;
+        for (size_t d = 0; d < BOXDIM; ++d) {
+            nr_candidates *= 2 * m_nmax[d] + 1;
+        }
+        for (size_t c = 0; c < nr_candidates; ++c) {
+            size_t m = c;
+            double k2 = 0;
+            for (size_t d = 0; d < BOXDIM; ++d) {
+                n[d] = static_cast<long>(m % (2 * m_nmax[d] + 1)) - m_nmax[d];
+                m /= 2 * m_nmax[d] + 1;
+                const double kd = 2 * M_PI * n[d] / m_boxvec[d];
+                k2 += kd * kd;
+            }
+            // half space: the first non-zero component is positive
+            long first = 0;
+            for (size_t d = 0; d < BOXDIM && first == 0; ++d) {
+                first = n[d];
+            }
+            if (first <= 0 || k2 >= m_kmax * m_kmax) {
+                continue;
+            }
+            const size_t bin = std::min(static_cast<size_t>(sqrt(k2) / m_delta_bin), m_nr_bins - 1);
+            m_wavevectors.insert(m_wavevectors.end(), n, n + BOXDIM);
+            m_wavevector_bin.push_back(bin);
+            ++m_bin_count[bin];
+        }
+    }
+    void m_add_rho(const std::vector<double>& rho_re, const std::vector<double>& rho_im, const size_t nr_particles)
+    {
+        ++m_nr_configs;
+        const double inorm = 1. / static_cast<double>(nr_particles);
+        for (size_t k = 0; k < m_wavevector_bin.size(); ++k) {
+            m_sk[m_wavevector_bin[k]] += (rho_re[k] * rho_re[k] + rho_im[k] * rho_im[k]) * inorm;
+        }
+    }
+    /**
+     * add weight * exp(i k.r_j) of particles begin <= j < end to rho
+     */
+    void m_add_block(const double* coords, const size_t begin, const size_t end, const double weight,
+            std::vector<double>& rho_re, std::vector<double>& rho_im)
+    {
+        const size_t nb = end - begin;
+        for (size_t d = 0; d < BOXDIM; ++d) {
+            const long nmax = m_nmax[d];
+            double* re = m_wave_re[d].data();
+            double* im = m_wave_im[d].data();
+            double* re0 = re + nmax * m_block_size;
+            double* im0 = im + nmax * m_block_size;
+            const double scale = 2 * M_PI / m_boxvec[d];
+            for (size_t j = 0; j < nb; ++j) {
+                re0[j] = 1;
+                im0[j] = 0;
+            }
+            if (nmax == 0) {
+                continue;
+            }
+            double* re1 = re0 + m_block_size;
+            double* im1 = im0 + m_block_size;
+            for (size_t j = 0; j < nb; ++j) {
+                const double x = scale * coords[(begin + j) * BOXDIM + d];
+                re1[j] = cos(x);
+                im1[j] = sin(x);
+            }
+            for (long n = 2; n <= nmax; ++n) {
+                const double* rp = re0 + (n - 1) * m_block_size;
+                const double* ip = im0 + (n - 1) * m_block_size;
+                double* rn = re0 + n * m_block_size;
+                double* in = im0 + n * m_block_size;
+                for (size_t j = 0; j < nb; ++j) {
+                    rn[j] = rp[j] * re1[j] - ip[j] * im1[j];
+                    in[j] = rp[j] * im1[j] + ip[j] * re1[j];
+                }
+            }
+            for (long n = 1; n <= nmax; ++n) {
+                const double* rp = re0 + n * m_block_size;
+                const double* ip = im0 + n * m_block_size;
+                double* rn = re0 - n * m_block_size;
+                double* in = im0 - n * m_block_size;
+                for (size_t j = 0; j < nb; ++j) {
+                    rn[j] = rp[j];
+                    in[j] = -ip[j];
+                }
+            }
+        }
+        for (size_t k = 0; k < m_wavevector_bin.size(); ++k) {
+            const long* n = &m_wavevectors[k * BOXDIM];
+            const double* r0 = &m_wave_re[0][(n[0] + m_nmax[0]) * m_block_size];
+            const double* i0 = &m_wave_im[0][(n[0] + m_nmax[0]) * m_block_size];
+            double sum_re = 0;
+            double sum_im = 0;
+            if (BOXDIM == 1) {
+                for (size_t j = 0; j < nb; ++j) {
+                    sum_re += r0[j];
+                    sum_im += i0[j];
+                }
+            }
+            else {
+                const double* r1 = &m_wave_re[1][(n[1] + m_nmax[1]) * m_block_size];
+                const double* i1 = &m_wave_im[1][(n[1] + m_nmax[1]) * m_block_size];
+                if (BOXDIM == 2) {
+                    for (size_t j = 0; j < nb; ++j) {
+                        sum_re += r0[j] * r1[j] - i0[j] * i1[j];
+                        sum_im += r0[j] * i1[j] + i0[j] * r1[j];
+                    }
+                }
+                else {
+                    for (size_t j = 0; j < nb; ++j) {
+                        double re = r0[j] * r1[j] - i0[j] * i1[j];
+                        double im = r0[j] * i1[j] + i0[j] * r1[j];
+                        for (size_t d = 2; d < BOXDIM; ++d) {
+                            const size_t idx = (n[d] + m_nmax[d]) * m_block_size + j;
+                            const double tmp = re * m_wave_re[d][idx] - im * m_wave_im[d][idx];
+                            im = re * m_wave_im[d][idx] + im * m_wave_re[d][idx];
+                            re = tmp;
+                        }
+                        sum_re += re;
+                        sum_im += im;
+                    }
+                }
+            }
+            rho_re[k] += weight * sum_re;
+            rho_im[k] += weight * sum_im;
+        }
+    }
+    void m_set_live_configuration(pele::Array<double> coords)
+    {
+        m_live_coords = coords.copy();
+        m_live_updates = 0;
+        compute_rho(m_live_coords, m_live_rho_re, m_live_rho_im);
+    }
+};
+
+} //namespace mcpele
+
+#endif//#ifndef _MCPELE_STRUCTURE_FACTOR_H
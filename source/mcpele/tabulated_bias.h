@@ -0,0 +1,209 @@
+#ifndef _MCPELE_TABULATED_BIAS_H__
+#define _MCPELE_TABULATED_BIAS_H__
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "pele/array.h"
+#include "mc.h"
+
+namespace mcpele {
+
+/**
+ * Scalar function of a configuration, e.g. a reaction coordinate
+ */
+class CollectiveVariable {
+public:
+    virtual ~CollectiveVariable() {}
+    virtual double get_value(pele::Array<double> &coords, const double energy) =0;
+};
+
+class EnergyCollectiveVariable : public CollectiveVariable {
+public:
+    virtual ~EnergyCollectiveVariable() {}
+    virtual double get_value(pele::Array<double> &coords, const double energy) { return energy; }
+};
+
+/**
+ * projection of the coordinates onto direction, e.g. a single coordinate
+ * for a unit vector
+ */
+class ProjectionCollectiveVariable : public CollectiveVariable {
+private:
+    pele::Array<double> m_direction;
+public:
+    ProjectionCollectiveVariable(pele::Array<double> direction);
+    virtual ~ProjectionCollectiveVariable() {}
+    virtual double get_value(pele::Array<double> &coords, const double energy);
+};
+
+/**
+ * Bias ln w(s) on a collective variable s, tabulated at nr_nodes equally
+ * spaced nodes s_i = min + i (max - min) / (nr_nodes - 1) and linearly
+ * interpolated in between. Lookup is O(1).
+ * The bias is shared by a TabulatedBiasTest, which samples with the extra
+ * weight w(s), and optionally a RefineTabulatedBias, which adjusts it.
+ */
+class TabulatedBias {
+private:
+    std::shared_ptr<CollectiveVariable> m_cv;
+    const double m_min;
+    const double m_max;
+    const size_t m_nr_nodes;
+    const double m_spacing;
+    const double m_inv_spacing;
+    std::vector<double> m_log_weights;
+public:
+    /**
+     * log_weights: ln w at the nodes, zero if empty
+     */
+    TabulatedBias(std::shared_ptr<CollectiveVariable> cv, const double min, const double max,
+            const size_t nr_nodes, pele::Array<double> log_weights=pele::Array<double>());
+    virtual ~TabulatedBias() {}
+    double get_value(pele::Array<double> &coords, const double energy) { return m_cv->get_value(coords, energy); }
+    bool in_range(const double s) const { return s >= m_min && s <= m_max; }
+    /**
+     * distance of s to the range of the table, 0 inside
+     */
+    double get_distance(const double s) const
+    {
+        return s < m_min ? m_min - s : (s > m_max ? s - m_max : 0);
+    }
+    /**
+     * linearly interpolated ln w(s), s must be in range
+     */
+    double get_log_weight(const double s) const
+    {
+        const double x = (s - m_min) * m_inv_spacing;
+        const size_t i = std::min(static_cast<size_t>(x), m_nr_nodes - 2);
+        const double frac = x - i;
+        return m_log_weights[i] + frac * (m_log_weights[i + 1] - m_log_weights[i]);
+    }
+    /**
+     * index of the node closest to s, s must be in range
+     */
+    size_t get_node_index(const double s) const
+    {
+        return std::min(static_cast<size_t>((s - m_min) * m_inv_spacing + 0.5), m_nr_nodes - 1);
+    }
+    double min() const { return m_min; }
+    double max() const { return m_max; }
+    double get_spacing() const { return m_spacing; }
+    size_t size() const { return m_nr_nodes; }
+    pele::Array<double> get_nodes() const;
+    pele::Array<double> get_log_weights() const;
+    void set_log_weights(pele::Array<double> log_weights);
+    /**
+     * add delta[i] to ln w at node i
+     */
+    void add_to_log_weights(const std::vector<double>& delta);
+};
+
+/**
+ * Accept a move from s_old to s_new with probability
+ * min(1, w(s_new) / w(s_old)) and reject moves out of the range of the
+ * table. While the walker is outside the range, e.g. at the start of a run,
+ * moves that do not take it further away are accepted.
+ * Together with a MetropolisTest this samples exp(-E / T) w(s), e.g. for
+ * umbrella sampling with w = exp(U(s) / T) to cancel a barrier U(s).
+ * Alone, with s the energy and ln w = -ln g(E), it is a multicanonical
+ * sampler.
+ * s of the current configuration is not recomputed: the values of the last
+ * trial and old configurations are kept, and the MC's step and acceptance
+ * counts tell which of them is current at the next call. The cache is used
+ * only if, in addition, the old energy is the one of that configuration,
+ * so a configuration set with MC::set_coordinates() is recomputed unless it
+ * has exactly the same energy.
+ */
+class TabulatedBiasTest : public AcceptTest {
+protected:
+    std::shared_ptr<TabulatedBias> m_bias;
+    size_t m_seed;
+    std::mt19937_64 m_generator;
+    std::uniform_real_distribution<double> m_distribution;
+    const MC* m_mc;
+    size_t m_step;
+    size_t m_naccept;
+    double m_old_value;
+    double m_old_energy;
+    double m_trial_value;
+    double m_trial_energy;
+    size_t m_nr_cached;
+    double m_old_value_of(pele::Array<double>& old_coords, const double old_energy, const MC* mc);
+public:
+    TabulatedBiasTest(std::shared_ptr<TabulatedBias> bias, const size_t rseed);
+    virtual ~TabulatedBiasTest() {}
+    virtual bool test(pele::Array<double> &trial_coords, double trial_energy,
+            pele::Array<double> & old_coords, double old_energy, double temperature,
+            MC * mc);
+    size_t get_seed() const { return m_seed; }
+    void set_generator_seed(const size_t inp) { m_generator.seed(inp); }
+    /**
+     * number of tests that took s of the old configuration from the cache
+     */
+    size_t get_nr_cached() const { return m_nr_cached; }
+};
+
+/**
+ * Record the histogram H of the collective variable of a TabulatedBias,
+ * binned to the nearest node, every step after eqsteps steps, and refine
+ * the bias towards a flat histogram.
+ * Every refine_every recorded steps the histogram is checked: if every node
+ * has at least flatness times the mean count, refinement stops. Otherwise
+ * the bias is updated with Berg's multicanonical recursion and the
+ * histogram is reset: for each pair of adjacent nodes visited in this
+ * round, ln w_{i+1} - ln w_i - ln(H_{i+1} / H_i) estimates the difference
+ * of ln w that flattens the histogram. It is averaged with the estimates of
+ * earlier rounds, weighted by H_i H_{i+1} / (H_i + H_{i+1}), so that the
+ * weights converge instead of following the noise of each round. Pairs
+ * that were not visited keep their difference.
+ * Once the refinement has stopped the histogram keeps accumulating.
+ * The unbiased free energy, in units of the temperature, is
+ *   F(s_i) = ln w_i - ln(H_i / width_i),
+ * width_i being the width of the bin of node i (half the spacing at the
+ * ends). With an energy collective variable and no MetropolisTest,
+ * -F is ln g(E).
+ */
+class RefineTabulatedBias : public Action {
+private:
+    std::shared_ptr<TabulatedBias> m_bias;
+    const size_t m_refine_every;
+    const size_t m_eqsteps;
+    const double m_flatness;
+    std::vector<double> m_histogram;
+    std::vector<double> m_pair_weights;
+    size_t m_count;
+    size_t m_nr_refinements;
+    bool m_refining;
+public:
+    RefineTabulatedBias(std::shared_ptr<TabulatedBias> bias, const size_t refine_every,
+            const size_t eqsteps=0, const double flatness=0.8);
+    virtual ~RefineTabulatedBias() {}
+    virtual void action(pele::Array<double> &coords, double energy, bool accepted, MC* mc);
+    /**
+     * update the bias from the current histogram, or stop refining if it is flat;
+     * returns true if the bias was changed
+     */
+    bool refine();
+    bool is_flat() const;
+    bool is_refining() const { return m_refining; }
+    void set_refining(const bool refining) { m_refining = refining; }
+    size_t get_nr_refinements() const { return m_nr_refinements; }
+    /**
+     * steps recorded in the histogram
+     */
+    size_t get_count() const { return m_count; }
+    pele::Array<double> get_histogram() const;
+    /**
+     * F(s) at the nodes, zero at its minimum and inf at nodes that were not visited
+     */
+    pele::Array<double> get_free_energy() const;
+    void clear_histogram();
+};
+
+} // namespace mcpele
+
+#endif // #ifndef _MCPELE_TABULATED_BIAS_H__
@@ -0,0 +1,140 @@
+#ifndef _MCPELE_WANG_LANDAU_H__
+#define _MCPELE_WANG_LANDAU_H__
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "pele/array.h"
+#include "mc.h"
+
+namespace mcpele {
+
+/**
+ * Wang-Landau estimate of the density of states g(E) on the energy window
+ * [min, max), binned with the same convention as Histogram.
+ * Every step the bin of the current energy is updated,
+ * ln g(E) += ln f, and its visit histogram is incremented. Every
+ * check_every steps the histogram is checked for flatness: if every
+ * visited bin has at least flatness times the mean number of visits, ln f
+ * is halved and the histogram is reset. Following Belardinelli and
+ * Pereyra, once ln f drops below 1/t, with t = steps / nr_bins, ln f is
+ * set to 1/t at every step and no more flatness checks are done, which
+ * removes the saturation of the error of the original scheme.
+ * The run has converged once ln f is below lnf_final (see StopWangLandau).
+ * Energies outside the window are not recorded; use together with
+ * WangLandauTest, which samples with weights 1/g(E).
+ * Windows on the same grid (same bin, min differing by a multiple of bin)
+ * can be run in parallel, one walker each, and joined with merge().
+ */
+class RecordWangLandau : public Action {
+private:
+    double m_min;
+    double m_max;
+    const double m_bin;
+    const double m_flatness;
+    const size_t m_check_every;
+    const double m_lnf_final;
+    size_t m_nr_bins;
+    std::vector<double> m_lng;
+    std::vector<size_t> m_histogram;
+    std::vector<char> m_visited;
+    double m_lnf;
+    size_t m_nr_updates;
+    size_t m_nr_stages;
+    bool m_one_over_t;
+    void m_check_flatness();
+public:
+    RecordWangLandau(const double min, const double max, const double bin,
+            const double flatness=0.8, const size_t check_every=1000,
+            const double lnf_initial=1, const double lnf_final=1e-8);
+    virtual ~RecordWangLandau() {}
+    virtual void action(pele::Array<double> &coords, double energy, bool accepted, MC* mc)
+    {
+        update(energy);
+    }
+    /**
+     * add ln f to ln g(energy), returns false if energy is outside the window
+     */
+    bool update(const double energy);
+    bool in_range(const double energy) const { return energy >= m_min && energy < m_max; }
+    size_t get_bin_index(const double energy) const
+    {
+        return std::min(static_cast<size_t>(std::floor((energy - m_min) / m_bin)), m_nr_bins - 1);
+    }
+    /**
+     * ln g of the bin of energy, which must be in the window
+     */
+    double get_log_density(const double energy) const { return m_lng[get_bin_index(energy)]; }
+    /**
+     * distance of energy to the window, 0 inside
+     */
+    double get_distance(const double energy) const
+    {
+        return energy < m_min ? m_min - energy : (energy >= m_max ? energy - m_max : 0);
+    }
+    bool is_flat() const;
+    bool is_converged() const { return m_lnf < m_lnf_final; }
+    /**
+     * join the density of states of another window on the same grid: the
+     * window is extended to cover both, the other ln g is shifted onto
+     * this one by the mean difference over the bins visited by both, and
+     * in the overlap the lower window is used below its midpoint and the
+     * upper window above
+     */
+    void merge(const RecordWangLandau& other);
+    double min() const { return m_min; }
+    double max() const { return m_max; }
+    double bin() const { return m_bin; }
+    size_t size() const { return m_nr_bins; }
+    double get_lnf() const { return m_lnf; }
+    double get_lnf_final() const { return m_lnf_final; }
+    size_t get_nr_updates() const { return m_nr_updates; }
+    /**
+     * number of times ln f was halved
+     */
+    size_t get_nr_stages() const { return m_nr_stages; }
+    bool is_one_over_t() const { return m_one_over_t; }
+    /**
+     * bin centres
+     */
+    pele::Array<double> get_energies() const;
+    /**
+     * ln g(E), shifted so that its minimum over the visited bins is 0;
+     * -inf for bins that were never visited
+     */
+    pele::Array<double> get_log_density_of_states() const;
+    /**
+     * visits since the last reduction of ln f
+     */
+    pele::Array<double> get_histogram() const;
+};
+
+/**
+ * Wang-Landau acceptance criterion: accept with probability
+ * min(1, g(E_old) / g(E_trial)), using the ln g of a RecordWangLandau,
+ * and reject trial energies outside its window. The temperature is not
+ * used. While the walker is still outside the window, e.g. at the start of
+ * a run, steps that do not move it further away are accepted.
+ */
+class WangLandauTest : public AcceptTest {
+protected:
+    std::shared_ptr<RecordWangLandau> m_dos;
+    size_t m_seed;
+    std::mt19937_64 m_generator;
+    std::uniform_real_distribution<double> m_distribution;
+public:
+    WangLandauTest(std::shared_ptr<RecordWangLandau> dos, const size_t rseed);
+    virtual ~WangLandauTest() {}
+    virtual bool test(pele::Array<double> &trial_coords, double trial_energy,
+            pele::Array<double> & old_coords, double old_energy, double temperature,
+            MC * mc);
+    size_t get_seed() const { return m_seed; }
+    void set_generator_seed(const size_t inp) { m_generator.seed(inp); }
+};
+
+} // namespace mcpele
+
+#endif // #ifndef _MCPELE_WANG_LANDAU_H__
@@ -0,0 +1,80 @@
+#include <algorithm>
+#include <cmath>
+
+#include "mcpele/minima_database.h"
+
+using pele::Array;
+
+namespace mcpele {
+
+MinimaDatabase::MinimaDatabase(const double energy_tol, const double coords_tol)
+    : m_energy_tol(energy_tol),
+      m_coords_tol(coords_tol)
+{
+    if (energy_tol < 0 || coords_tol < 0) {
+        throw std::runtime_error("MinimaDatabase: energy_tol and coords_tol expected to be non-negative");
+    }
+}
+
+bool MinimaDatabase::m_same_coords(const Array<double>& a, const Array<double>& b) const
+{
+    if (m_coords_tol == 0) {
+        return true;
+    }
+    if (a.size() != b.size()) {
+        throw std::runtime_error("MinimaDatabase: minima have different numbers of degrees of freedom");
+    }
+    double d2 = 0;
+    for (size_t i = 0; i < a.size(); ++i) {
+        const double d = a[i] - b[i];
+        d2 += d * d;
+    }
+    return d2 <= m_coords_tol * m_coords_tol;
+}
+
+size_t MinimaDatabase::add_minimum(Array<double> coords, const double energy, const size_t step)
+{
+    // closest stored energy within the tolerance, among the minima close enough in space
+    const size_t ibegin = std::lower_bound(m_energies.begin(), m_energies.end(), energy - m_energy_tol) - m_energies.begin();
+    size_t imatch = m_energies.size();
+    for (size_t i = ibegin; i < m_energies.size() && m_energies[i] <= energy + m_energy_tol; ++i) {
+        if (!m_same_coords(m_coords[i], coords)) {
+            continue;
+        }
+        if (imatch == m_energies.size() || std::abs(m_energies[i] - energy) < std::abs(m_energies[imatch] - energy)) {
+            imatch = i;
+        }
+    }
+    if (imatch < m_energies.size()) {
+        ++m_counts[imatch];
+        return imatch;
+    }
+    const size_t iinsert = std::upper_bound(m_energies.begin(), m_energies.end(), energy) - m_energies.begin();
+    m_energies.insert(m_energies.begin() + iinsert, energy);
+    m_coords.insert(m_coords.begin() + iinsert, coords.copy());
+    m_counts.insert(m_counts.begin() + iinsert, 1);
+    m_first_steps.insert(m_first_steps.begin() + iinsert, step);
+    return iinsert;
+}
+
+Array<double> MinimaDatabase::get_energies() const
+{
+    std::vector<double> vecdata(m_energies);
+    return Array<double>(vecdata).copy();
+}
+
+Array<double> MinimaDatabase::get_counts() const
+{
+    std::vector<double> vecdata(m_counts.begin(), m_counts.end());
+    return Array<double>(vecdata).copy();
+}
+
+void MinimaDatabase::clear()
+{
+    m_energies.clear();
+    m_coords.clear();
+    m_counts.clear();
+    m_first_steps.clear();
+}
+
+} // namespace mcpele
@@ -0,0 +1,125 @@
+#include <algorithm>
+#include <stdexcept>
+
+#include "mcpele/multi_tau_correlator.h"
+
+namespace mcpele {
+
+MultiTauCorrelator::MultiTauCorrelator(const size_t nr_lags, const size_t max_levels)
+    : m_nr_lags(nr_lags),
+      m_max_levels(max_levels),
+      m_offset(0)
+{
+    if (nr_lags < 2 || nr_lags % 2 != 0) {
+        throw std::runtime_error("MultiTauCorrelator: nr_lags must be even and at least 2");
+    }
+}
+
+void MultiTauCorrelator::clear()
+{
+    m_offset = 0;
+    m_moments = Moments();
+    m_shift.clear();
+    m_nr_inserted.clear();
+    m_corr.clear();
+    m_nr_corr.clear();
+    m_accumulator.clear();
+    m_nr_accumulated.clear();
+}
+
+void MultiTauCorrelator::m_add_level()
+{
+    m_shift.push_back(std::vector<double>(m_nr_lags, 0));
+    m_nr_inserted.push_back(0);
+    m_corr.push_back(std::vector<double>(m_nr_lags, 0));
+    m_nr_corr.push_back(std::vector<size_t>(m_nr_lags, 0));
+    m_accumulator.push_back(0);
+    m_nr_accumulated.push_back(0);
+}
+
+void MultiTauCorrelator::add(const double x)
+{
+    if (m_moments.count() == 0) {
+        m_offset = x;
+    }
+    m_moments(x - m_offset);
+    m_add(x - m_offset, 0);
+}
+
+void MultiTauCorrelator::m_add(const double x, const size_t level)
+{
+    if (level == m_shift.size()) {
+        m_add_level();
+    }
+    // circular shift register, the newest value at position nr_inserted % nr_lags
+    std::vector<double>& shift = m_shift[level];
+    const size_t pos = m_nr_inserted[level] % m_nr_lags;
+    shift[pos] = x;
+    ++m_nr_inserted[level];
+    const size_t first_lag = (level == 0) ? 0 : m_nr_lags / 2;
+    const size_t nr_valid = std::min(m_nr_inserted[level], m_nr_lags);
+    for (size_t j = first_lag; j < nr_valid; ++j) {
+        m_corr[level][j] += x * shift[(pos + m_nr_lags - j) % m_nr_lags];
+        ++m_nr_corr[level][j];
+    }
+    m_accumulator[level] += x;
+    ++m_nr_accumulated[level];
+    if (m_nr_accumulated[level] == 2) {
+        const double average = 0.5 * m_accumulator[level];
+        m_accumulator[level] = 0;
+        m_nr_accumulated[level] = 0;
+        if (m_max_levels == 0 || level + 1 < m_max_levels) {
+            m_add(average, level + 1);
+        }
+    }
+}
+
+std::vector<double> MultiTauCorrelator::get_lags() const
+{
+    std::vector<double> lags;
+    double spacing = 1;
+    for (size_t level = 0; level < m_shift.size(); ++level) {
+        const size_t first_lag = (level == 0) ? 0 : m_nr_lags / 2;
+        for (size_t j = first_lag; j < m_nr_lags; ++j) {
+            if (m_nr_corr[level][j] > 0) {
+                lags.push_back(j * spacing);
+            }
+        }
+        spacing *= 2;
+    }
+    return lags;
+}
+
+std::vector<double> MultiTauCorrelator::get_autocorrelation() const
+{
+    std::vector<double> rho;
+    const double mean = m_moments.mean();
+    const double variance = m_moments.variance();
+    for (size_t level = 0; level < m_shift.size(); ++level) {
+        const size_t first_lag = (level == 0) ? 0 : m_nr_lags / 2;
+        for (size_t j = first_lag; j < m_nr_lags; ++j) {
+            if (m_nr_corr[level][j] > 0) {
+                const double covariance = m_corr[level][j] / m_nr_corr[level][j] - mean * mean;
+                rho.push_back(variance > 0 ? covariance / variance : 0);
+            }
+        }
+    }
+    return rho;
+}
+
+double MultiTauCorrelator::get_integrated_time(const double window) const
+{
+    const std::vector<double> lags = get_lags();
+    const std::vector<double> rho = get_autocorrelation();
+    double tau = 0.5;
+    for (size_t i = 1; i < lags.size(); ++i) {
+        const double upper = (i + 1 < lags.size()) ? lags[i + 1] : lags[i];
+        tau += rho[i] * 0.5 * (upper - lags[i - 1]);
+        if (lags[i] >= window * tau) {
+            break;
+        }
+    }
+    return tau;
+}
+
+} // namespace mcpele
@@ -0,0 +1,321 @@
+#include <algorithm>
+#include <cmath>
+#include <exception>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+#include <thread>
+
+#include "mcpele/nested_sampling.h"
+
+using pele::Array;
+
+namespace mcpele {
+
+NestedSampling::NestedSampling(std::vector<std::shared_ptr<MC> > walkers, Array<double> live_coords,
+        const size_t nr_steps, const size_t rseed, const double factor,
+        const double min_acceptance_ratio, const double max_acceptance_ratio)
+    : m_walkers(walkers),
+      m_nr_steps(nr_steps),
+      m_factor(factor),
+      m_min_acceptance_ratio(min_acceptance_ratio),
+      m_max_acceptance_ratio(max_acceptance_ratio),
+      m_ndof(0),
+      m_nr_live(0),
+      m_sources(walkers.size()),
+      m_walk_accepted(walkers.size()),
+      m_nr_iterations(0),
+      m_nr_accepted(0),
+      m_nr_trials(0),
+      m_generator(rseed),
+      m_generation(0),
+      m_nr_busy(0),
+      m_max_energy(0),
+      m_stop(false)
+{
+    if (walkers.empty()) {
+        throw std::runtime_error("NestedSampling: expected at least one walker");
+    }
+    for (auto & walker : m_walkers) {
+        if (!walker) {
+            throw std::runtime_error("NestedSampling: walker is NULL");
+        }
+    }
+    if (nr_steps == 0) {
+        throw std::runtime_error("NestedSampling: nr_steps expected to be at least 1");
+    }
+    if (!(factor > 0 && factor < 1) || !(min_acceptance_ratio < max_acceptance_ratio)) {
+        throw std::runtime_error("NestedSampling: illegal input: expected 0 < factor < 1 and min_acceptance_ratio < max_acceptance_ratio");
+    }
+    m_ndof = m_walkers[0]->get_coords().size();
+    for (auto & walker : m_walkers) {
+        if (walker->get_coords().size() != m_ndof) {
+            throw std::runtime_error("NestedSampling: walkers have different numbers of degrees of freedom");
+        }
+    }
+    if (m_ndof == 0 || live_coords.size() % m_ndof != 0) {
+        throw std::runtime_error("NestedSampling: live_coords size expected to be a multiple of ndof");
+    }
+    m_nr_live = live_coords.size() / m_ndof;
+    if (m_nr_live <= m_walkers.size()) {
+        throw std::runtime_error("NestedSampling: expected more live points than walkers");
+    }
+    m_live_coords = live_coords.copy();
+    m_live_views.reserve(m_nr_live);
+    m_live_energies.resize(m_nr_live);
+    m_order.resize(m_nr_live);
+    auto potential = m_walkers[0]->get_potential_ptr();
+    for (size_t i = 0; i < m_nr_live; ++i) {
+        m_live_views.push_back(m_live_coords.view(i * m_ndof, (i + 1) * m_ndof));
+        m_live_energies[i] = potential->get_energy(m_live_views[i]);
+    }
+    for (auto & walker : m_walkers) {
+        auto bound = std::make_shared<EnergyWindowTest>(-std::numeric_limits<double>::max(),
+                std::numeric_limits<double>::max());
+        walker->add_accept_test(bound);
+        walker->disable_input_warnings();
+        m_bounds.push_back(bound);
+    }
+    m_threads.reserve(m_walkers.size() - 1);
+    try {
+        for (size_t i = 1; i < m_walkers.size(); ++i) {
+            m_threads.push_back(std::thread(&NestedSampling::m_work, this, i));
+        }
+    }
+    catch (...) {
+        // the destructor does not run, join the workers started so far
+        m_stop_workers();
+        throw;
+    }
+}
+
+NestedSampling::~NestedSampling()
+{
+    m_stop_workers();
+}
+
+void NestedSampling::m_stop_workers()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_walk_ready.notify_all();
+    for (auto & thread : m_threads) {
+        thread.join();
+    }
+}
+
+/**
+ * replace the live point m_order[iwalker] by a walk from the live point
+ * m_sources[iwalker] below max_energy
+ */
+void NestedSampling::m_walk(const size_t iwalker, const double max_energy)
+{
+    MC& walker = *m_walkers[iwalker];
+    const size_t source = m_sources[iwalker];
+    const size_t target = m_order[iwalker];
+    m_bounds[iwalker]->set_max_energy(max_energy);
+    walker.set_coordinates(m_live_views[source], m_live_energies[source]);
+    const size_t naccept = walker.get_naccept();
+    walker.run(m_nr_steps);
+    walker.copy_coords(m_live_views[target]);
+    m_live_energies[target] = walker.get_energy();
+    m_walk_accepted[iwalker] = walker.get_naccept() - naccept;
+    const double acceptance_fraction = static_cast<double>(m_walk_accepted[iwalker]) / m_nr_steps;
+    auto takestep = walker.get_takestep();
+    if (acceptance_fraction < m_min_acceptance_ratio) {
+        takestep->increase_acceptance(m_factor);
+    }
+    else if (acceptance_fraction > m_max_acceptance_ratio) {
+        takestep->decrease_acceptance(m_factor);
+    }
+}
+
+/**
+ * worker thread of walker iwalker, walks once per iteration of run()
+ */
+void NestedSampling::m_work(const size_t iwalker)
+{
+    size_t generation = 0;
+    while (true) {
+        double max_energy;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_walk_ready.wait(lock, [this, generation]{ return m_stop || m_generation != generation; });
+            if (m_stop) {
+                return;
+            }
+            generation = m_generation;
+            max_energy = m_max_energy;
+        }
+        std::exception_ptr error;
+        try {
+            m_walk(iwalker, max_energy);
+        }
+        catch (...) {
+            error = std::current_exception();
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (error && !m_error) {
+                m_error = error;
+            }
+            --m_nr_busy;
+        }
+        m_walk_done.notify_all();
+    }
+}
+
+void NestedSampling::run(const size_t nr_iterations)
+{
+    const size_t nr_threads = m_walkers.size();
+    std::uniform_int_distribution<size_t> survivor(nr_threads, m_nr_live - 1);
+    auto higher = [this](const size_t i, const size_t j) { return m_live_energies[i] > m_live_energies[j]; };
+    for (size_t iteration = 0; iteration < nr_iterations; ++iteration) {
+        // the highest energies first, the survivors after them
+        std::iota(m_order.begin(), m_order.end(), 0);
+        std::nth_element(m_order.begin(), m_order.begin() + nr_threads - 1, m_order.end(), higher);
+        std::sort(m_order.begin(), m_order.begin() + nr_threads, higher);
+        double log_volume = m_log_volumes.empty() ? 0 : m_log_volumes.back();
+        for (size_t j = 0; j < nr_threads; ++j) {
+            m_dead_energies.push_back(m_live_energies[m_order[j]]);
+            log_volume -= 1. / (m_nr_live - j);
+            m_log_volumes.push_back(log_volume);
+            m_sources[j] = m_order[survivor(m_generator)];
+        }
+        const double max_energy = m_live_energies[m_order[nr_threads - 1]];
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_max_energy = max_energy;
+            m_nr_busy = m_threads.size();
+            ++m_generation;
+        }
+        m_walk_ready.notify_all();
+        std::exception_ptr error;
+        try {
+            m_walk(0, max_energy);
+        }
+        catch (...) {
+            error = std::current_exception();
+        }
+        {
+            // the other walks use the live points as well, wait for them before rethrowing
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_walk_done.wait(lock, [this]{ return m_nr_busy == 0; });
+            if (!error) {
+                error = m_error;
+            }
+            m_error = std::exception_ptr();
+        }
+        if (error) {
+            std::rethrow_exception(error);
+        }
+        for (size_t j = 0; j < nr_threads; ++j) {
+            m_nr_accepted += m_walk_accepted[j];
+            m_nr_trials += m_nr_steps;
+        }
+        ++m_nr_iterations;
+    }
+}
+
+double NestedSampling::get_max_energy() const
+{
+    return *std::max_element(m_live_energies.begin(), m_live_energies.end());
+}
+
+Array<double> NestedSampling::get_energies() const
+{
+    Array<double> energies(m_dead_energies.size());
+    std::copy(m_dead_energies.begin(), m_dead_energies.end(), energies.data());
+    return energies;
+}
+
+Array<double> NestedSampling::get_log_volumes() const
+{
+    Array<double> log_volumes(m_log_volumes.size());
+    std::copy(m_log_volumes.begin(), m_log_volumes.end(), log_volumes.data());
+    return log_volumes;
+}
+
+Array<double> NestedSampling::get_live_energies() const
+{
+    Array<double> energies(m_nr_live);
+    std::copy(m_live_energies.begin(), m_live_energies.end(), energies.data());
+    return energies;
+}
+
+Array<double> NestedSampling::get_live_coords(const size_t i) const
+{
+    if (i >= m_nr_live) {
+        throw std::runtime_error("NestedSampling::get_live_coords: index out of range");
+    }
+    return m_live_views[i].copy();
+}
+
+/**
+ * ln Z and the moments of the energy at temperature, summing the weights
+ * relative to the largest one and the energies relative to the lowest one
+ */
+void NestedSampling::m_moments(const double temperature, double& log_partition_function,
+        double& mean_energy, double& energy_variance) const
+{
+    if (!(temperature > 0)) {
+        throw std::runtime_error("NestedSampling: temperature expected to be positive");
+    }
+    const size_t nr_dead = m_dead_energies.size();
+    const double log_volume = m_log_volumes.empty() ? 0 : m_log_volumes.back();
+    const double log_live_weight = log_volume - std::log(static_cast<double>(m_nr_live));
+    std::vector<double> log_weights(nr_dead + m_nr_live);
+    std::vector<double> energies(nr_dead + m_nr_live);
+    double previous = 0;
+    for (size_t i = 0; i < nr_dead; ++i) {
+        // ln(X_{i-1} - X_i)
+        const double log_width = previous + std::log1p(-std::exp(m_log_volumes[i] - previous));
+        previous = m_log_volumes[i];
+        energies[i] = m_dead_energies[i];
+        log_weights[i] = log_width - energies[i] / temperature;
+    }
+    for (size_t i = 0; i < m_nr_live; ++i) {
+        energies[nr_dead + i] = m_live_energies[i];
+        log_weights[nr_dead + i] = log_live_weight - m_live_energies[i] / temperature;
+    }
+    const double highest = *std::max_element(log_weights.begin(), log_weights.end());
+    const double lowest = *std::min_element(energies.begin(), energies.end());
+    double z = 0, e1 = 0, e2 = 0;
+    for (size_t i = 0; i < energies.size(); ++i) {
+        const double w = std::exp(log_weights[i] - highest);
+        const double de = energies[i] - lowest;
+        z += w;
+        e1 += w * de;
+        e2 += w * de * de;
+    }
+    e1 /= z;
+    e2 /= z;
+    log_partition_function = highest + std::log(z);
+    mean_energy = lowest + e1;
+    energy_variance = e2 - e1 * e1;
+}
+
+double NestedSampling::get_log_partition_function(const double temperature) const
+{
+    double log_partition_function, mean_energy, energy_variance;
+    m_moments(temperature, log_partition_function, mean_energy, energy_variance);
+    return log_partition_function;
+}
+
+double NestedSampling::get_mean_energy(const double temperature) const
+{
+    double log_partition_function, mean_energy, energy_variance;
+    m_moments(temperature, log_partition_function, mean_energy, energy_variance);
+    return mean_energy;
+}
+
+double NestedSampling::get_heat_capacity(const double temperature) const
+{
+    double log_partition_function, mean_energy, energy_variance;
+    m_moments(temperature, log_partition_function, mean_energy, energy_variance);
+    return energy_variance / (temperature * temperature);
+}
+
+} // namespace mcpele
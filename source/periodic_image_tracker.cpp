@@ -0,0 +1,107 @@
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include "mcpele/periodic_image_tracker.h"
+
+namespace mcpele {
+
+PeriodicImageTracker::PeriodicImageTracker(const pele::Array<double> boxvec)
+    : m_boxvec(boxvec.copy()),
+      m_ndim(boxvec.size()),
+      m_pending_begin(0),
+      m_pending_end(0)
+{
+    if (m_ndim == 0) {
+        throw std::runtime_error("PeriodicImageTracker: illegal input: empty boxvec");
+    }
+    for (size_t k = 0; k < m_ndim; ++k) {
+        if (m_boxvec[k] <= 0) {
+            throw std::runtime_error("PeriodicImageTracker: illegal input: boxvec must be positive");
+        }
+    }
+}
+
+void PeriodicImageTracker::m_check_size(const size_t ndof)
+{
+    if (ndof % m_ndim) {
+        throw std::runtime_error("PeriodicImageTracker: coords size incompatible with boxvec size");
+    }
+    if (m_images.size() == 0) {
+        m_images.assign(ndof, 0);
+        m_pending.assign(ndof, 0);
+        m_trial.assign(ndof, 0);
+    }
+    else if (m_images.size() != ndof) {
+        throw std::runtime_error("PeriodicImageTracker: coords size changed");
+    }
+}
+
+void PeriodicImageTracker::wrap(pele::Array<double>& coords, const size_t begin, const size_t end)
+{
+    m_check_size(coords.size());
+    if (begin % m_ndim || end % m_ndim || end > coords.size()) {
+        throw std::runtime_error("PeriodicImageTracker::wrap: illegal range");
+    }
+    for (size_t i = begin; i < end; ++i) {
+        const double boxlength = m_boxvec[i % m_ndim];
+        const double shift = std::round(coords[i] / boxlength);
+        coords[i] -= shift * boxlength;
+        m_pending[i] = static_cast<long>(shift);
+        m_trial[i] = coords[i];
+    }
+    m_pending_begin = begin;
+    m_pending_end = end;
+}
+
+void PeriodicImageTracker::update(const pele::Array<double>& coords)
+{
+    if (m_pending_begin == m_pending_end) {
+        return;
+    }
+    m_check_size(coords.size());
+    const bool accepted = std::equal(m_trial.begin() + m_pending_begin,
+            m_trial.begin() + m_pending_end, coords.data() + m_pending_begin);
+    for (size_t i = m_pending_begin; i < m_pending_end; ++i) {
+        if (accepted) {
+            m_images[i] += m_pending[i];
+        }
+        m_pending[i] = 0;
+    }
+    m_pending_begin = m_pending_end = 0;
+}
+
+pele::Array<long> PeriodicImageTracker::get_image_counts(const pele::Array<double>& coords)
+{
+    m_check_size(coords.size());
+    update(coords);
+    pele::Array<long> result(m_images.size());
+    std::copy(m_images.begin(), m_images.end(), result.data());
+    return result;
+}
+
+pele::Array<double> PeriodicImageTracker::get_unwrapped_coords(const pele::Array<double>& coords)
+{
+    pele::Array<double> result(coords.size());
+    unwrap(coords, result);
+    return result;
+}
+
+void PeriodicImageTracker::unwrap(const pele::Array<double>& coords, pele::Array<double> unwrapped)
+{
+    m_check_size(coords.size());
+    if (unwrapped.size() != coords.size()) {
+        throw std::runtime_error("PeriodicImageTracker::unwrap: unwrapped size differs from coords size");
+    }
+    update(coords);
+    const double* x = coords.data();
+    const long* images = m_images.data();
+    double* y = unwrapped.data();
+    for (size_t i = 0; i < coords.size(); i += m_ndim) {
+        for (size_t k = 0; k < m_ndim; ++k) {
+            y[i + k] = x[i + k] + images[i + k] * m_boxvec[k];
+        }
+    }
+}
+
+} // namespace mcpele
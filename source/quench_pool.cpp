@@ -0,0 +1,125 @@
+#include <algorithm>
+#include <exception>
+#include <thread>
+
+#include "mcpele/quench_pool.h"
+
+using pele::Array;
+
+namespace mcpele {
+
+QuenchPool::QuenchPool(std::vector<std::shared_ptr<pele::GradientOptimizer> > optimizers, const size_t record_every,
+        const size_t eqsteps, const size_t batch_size)
+    : m_record_every(record_every),
+      m_eqsteps(eqsteps),
+      m_batch_size(batch_size ? batch_size : 4 * optimizers.size()),
+      m_optimizers(optimizers),
+      m_batch_steps(m_batch_size),
+      m_batch_energies(m_batch_size),
+      m_batch_success(m_batch_size),
+      m_batch_fill(0),
+      m_temperature(0),
+      m_nr_quenched(0),
+      m_nr_failed(0)
+{
+    if (record_every == 0) {
+        throw std::runtime_error("QuenchPool: record_every expected to be at least 1");
+    }
+    if (optimizers.empty()) {
+        throw std::runtime_error("QuenchPool: expected at least one optimizer");
+    }
+    for (auto & optimizer : m_optimizers) {
+        if (!optimizer) {
+            throw std::runtime_error("QuenchPool: optimizer is NULL");
+        }
+    }
+}
+
+void QuenchPool::action(Array<double> &coords, double energy, bool accepted, MC* mc)
+{
+    const size_t counter = mc->get_iterations_count();
+    if (counter % m_record_every != 0 || counter <= m_eqsteps) {
+        return;
+    }
+    if (m_batch.size() < m_batch_size) {
+        m_batch.push_back(Array<double>(coords.size()));
+    }
+    else if (m_batch[m_batch_fill].size() != coords.size()) {
+        m_batch[m_batch_fill] = Array<double>(coords.size());
+    }
+    m_batch[m_batch_fill].assign(coords);
+    m_batch_steps[m_batch_fill] = counter;
+    m_temperature = mc->get_temperature();
+    ++m_batch_fill;
+    if (m_batch_fill == m_batch_size) {
+        flush();
+    }
+}
+
+/**
+ * quench the batch configurations ithread, ithread + nr_threads, ... in place,
+ * with the optimizer of thread ithread
+ */
+void QuenchPool::m_quench(const size_t nr_configurations, const size_t ithread, const size_t nr_threads)
+{
+    pele::GradientOptimizer& optimizer = *m_optimizers[ithread];
+    for (size_t i = ithread; i < nr_configurations; i += nr_threads) {
+        optimizer.reset(m_batch[i]);
+        optimizer.run();
+        m_batch[i].assign(optimizer.get_x());
+        m_batch_energies[i] = optimizer.get_f();
+        m_batch_success[i] = optimizer.success();
+    }
+}
+
+void QuenchPool::flush()
+{
+    const size_t nr_configurations = m_batch_fill;
+    if (nr_configurations == 0) {
+        return;
+    }
+    // the batch is consumed even if a quench throws
+    m_batch_fill = 0;
+    const size_t nr_threads = std::min(m_optimizers.size(), nr_configurations);
+    if (nr_threads == 1) {
+        m_quench(nr_configurations, 0, 1);
+    }
+    else {
+        std::vector<std::exception_ptr> errors(nr_threads);
+        std::vector<std::thread> threads;
+        for (size_t t = 0; t < nr_threads; ++t) {
+            threads.push_back(std::thread([this, t, nr_configurations, nr_threads, &errors]{
+                try {
+                    m_quench(nr_configurations, t, nr_threads);
+                }
+                catch (...) {
+                    errors[t] = std::current_exception();
+                }
+            }));
+        }
+        for (auto & thread : threads) {
+            thread.join();
+        }
+        for (auto & error : errors) {
+            if (error) {
+                std::rethrow_exception(error);
+            }
+        }
+    }
+    for (size_t i = 0; i < nr_configurations; ++i) {
+        ++m_nr_quenched;
+        if (!m_batch_success[i]) {
+            ++m_nr_failed;
+            continue;
+        }
+        if (!m_snapshot_mc) {
+            m_snapshot_mc.reset(new SnapshotMC(m_batch[i]));
+        }
+        m_snapshot_mc->set_snapshot(m_batch_steps[i], m_batch_energies[i], m_temperature, true);
+        for (auto & action : m_actions) {
+            action->action(m_batch[i], m_batch_energies[i], true, m_snapshot_mc.get());
+        }
+    }
+}
+
+} // namespace mcpele
@@ -50,4 +50,34 @@ void RandomCoordsDisplacementSingle::displace(pele::Array<double>& coords, MC* m
     ++m_count;
 }
 
+/*RandomCoordsDisplacementPeriodicAll*/
+
+RandomCoordsDisplacementPeriodicAll::RandomCoordsDisplacementPeriodicAll(const size_t rseed, const pele::Array<double> boxvec, const double stepsize)
+    : RandomCoordsDisplacementAll(rseed, stepsize),
+      m_images(std::make_shared<PeriodicImageTracker>(boxvec))
+{}
+
+void RandomCoordsDisplacementPeriodicAll::displace(pele::Array<double>& coords, MC* mc)
+{
+    m_images->update(coords);
+    RandomCoordsDisplacementAll::displace(coords, mc);
+    m_images->wrap(coords);
+}
+
+/*RandomCoordsDisplacementPeriodicSingle*/
+
+RandomCoordsDisplacementPeriodicSingle::RandomCoordsDisplacementPeriodicSingle(const size_t rseed, const size_t nparticles, const pele::Array<double> boxvec, const double stepsize)
+    : RandomCoordsDisplacementSingle(rseed, nparticles, boxvec.size(), stepsize),
+      m_images(std::make_shared<PeriodicImageTracker>(boxvec))
+{}
+
+void RandomCoordsDisplacementPeriodicSingle::displace(pele::Array<double>& coords, MC* mc)
+{
+    m_images->update(coords);
+    RandomCoordsDisplacementSingle::displace(coords, mc);
+    const size_t ndim = m_images->get_ndim();
+    const size_t begin = get_rand_particle() * ndim;
+    m_images->wrap(coords, begin, begin + ndim);
+}
+
 } // namespace mcpele
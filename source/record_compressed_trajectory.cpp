@@ -0,0 +1,27 @@
+#include "mcpele/record_compressed_trajectory.h"
+
+using pele::Array;
+
+namespace mcpele {
+
+RecordCompressedTrajectory::RecordCompressedTrajectory(const std::string& filename, const size_t ndof,
+        const size_t record_every, const size_t eqsteps, const double precision,
+        const size_t keyframe_every)
+    : m_record_every(record_every),
+      m_eqsteps(eqsteps),
+      m_writer(filename, ndof, precision, keyframe_every)
+{
+    if (record_every == 0) {
+        throw std::runtime_error("RecordCompressedTrajectory: record_every expected to be at least 1");
+    }
+}
+
+void RecordCompressedTrajectory::action(Array<double> &coords, double energy, bool accepted, MC* mc)
+{
+    const size_t counter = mc->get_iterations_count();
+    if (counter % m_record_every == 0 && counter > m_eqsteps) {
+        m_writer.write_frame(coords, counter, energy);
+    }
+}
+
+} // namespace mcpele
@@ -0,0 +1,77 @@
+#include "mcpele/record_displacement_correlation.h"
+
+using pele::Array;
+
+namespace mcpele {
+
+RecordDisplacementCorrelation::RecordDisplacementCorrelation(const size_t record_every, const size_t eqsteps,
+        const size_t boxdimension, const double wavenumber, const size_t nr_lags)
+    : m_record_every(record_every),
+      m_eqsteps(eqsteps),
+      m_correlator(boxdimension, wavenumber, nr_lags)
+{
+    if (record_every == 0) {
+        throw std::runtime_error("RecordDisplacementCorrelation: record_every expected to be at least 1");
+    }
+}
+
+RecordDisplacementCorrelation::RecordDisplacementCorrelation(const size_t record_every, const size_t eqsteps,
+        std::shared_ptr<PeriodicImageTracker> images, const double wavenumber, const size_t nr_lags)
+    : m_record_every(record_every),
+      m_eqsteps(eqsteps),
+      m_correlator(images ? images->get_ndim() : 1, wavenumber, nr_lags),
+      m_images(images)
+{
+    if (record_every == 0) {
+        throw std::runtime_error("RecordDisplacementCorrelation: record_every expected to be at least 1");
+    }
+    if (!images) {
+        throw std::runtime_error("RecordDisplacementCorrelation: image tracker is NULL");
+    }
+}
+
+void RecordDisplacementCorrelation::action(Array<double> &coords, double energy, bool accepted, MC* mc)
+{
+    const size_t counter = mc->get_iterations_count();
+    if (counter % m_record_every != 0 || counter <= m_eqsteps) {
+        return;
+    }
+    if (!m_images) {
+        m_correlator.add(coords.data(), coords.size());
+        return;
+    }
+    if (m_unwrapped.size() != coords.size()) {
+        m_unwrapped = Array<double>(coords.size());
+    }
+    m_images->unwrap(coords, m_unwrapped);
+    m_correlator.add(m_unwrapped.data(), m_unwrapped.size());
+}
+
+Array<double> RecordDisplacementCorrelation::get_lags() const
+{
+    std::vector<double> lags(m_correlator.get_lags());
+    for (size_t i = 0; i < lags.size(); ++i) {
+        lags[i] *= m_record_every;
+    }
+    return Array<double>(lags).copy();
+}
+
+Array<double> RecordDisplacementCorrelation::get_mean_square_displacement() const
+{
+    std::vector<double> msd(m_correlator.get_mean_square_displacement());
+    return Array<double>(msd).copy();
+}
+
+Array<double> RecordDisplacementCorrelation::get_self_intermediate_scattering() const
+{
+    std::vector<double> fs(m_correlator.get_self_intermediate_scattering());
+    return Array<double>(fs).copy();
+}
+
+Array<double> RecordDisplacementCorrelation::get_nr_origins() const
+{
+    std::vector<double> nr_origins(m_correlator.get_nr_origins());
+    return Array<double>(nr_origins).copy();
+}
+
+} // namespace mcpele
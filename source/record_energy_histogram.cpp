@@ -4,25 +4,39 @@ using pele::Array;
 
 namespace mcpele {
 
-RecordEnergyHistogram::RecordEnergyHistogram(const double min, const double max, const double bin, const size_t eqsteps)
-    : m_hist(min, max, bin),
-      m_eqsteps(eqsteps),
+RecordEnergyHistogram::RecordEnergyHistogram(const double min, const double max, const double bin, const size_t eqsteps, const bool sparse)
+    : m_eqsteps(eqsteps),
+      m_sparse(sparse),
       m_count(0)
-    {}
+{
+    if (sparse) {
+        m_hist = std::make_shared<SparseHistogram>(min, max, bin);
+    }
+    else {
+        m_hist = std::make_shared<DynamicHistogram>(min, max, bin);
+    }
+}
 
 void RecordEnergyHistogram::action(Array<double> &coords, double energy, bool accepted, MC* mc)
 {
     m_count = mc->get_iterations_count();
     if (m_count > m_eqsteps){
-        m_hist.add_entry(energy);
+        m_hist->add_entry(energy);
     }
 }
 
 pele::Array<double> RecordEnergyHistogram::get_histogram() const
 {
-    std::vector<double> vecdata(m_hist.get_vecdata());
+    std::vector<double> vecdata(m_hist->get_vecdata());
     pele::Array<double> histogram(vecdata);
     return histogram.copy();
 }
 
+void RecordEnergyHistogram::get_occupied_bins(std::vector<double>& positions, std::vector<double>& counts) const
+{
+    std::vector<BaseHistogram::count_t> bin_counts;
+    m_hist->get_occupied_bins(positions, bin_counts);
+    counts.assign(bin_counts.begin(), bin_counts.end());
+}
+
 } // namespace mcpele
@@ -0,0 +1,40 @@
+#include "mcpele/record_scalar_autocorrelation.h"
+
+using pele::Array;
+
+namespace mcpele {
+
+RecordScalarAutocorrelation::RecordScalarAutocorrelation(const size_t record_every, const size_t eqsteps, const size_t nr_lags)
+    : m_record_every(record_every),
+      m_eqsteps(eqsteps),
+      m_correlator(nr_lags)
+{
+    if (record_every == 0) {
+        throw std::runtime_error("RecordScalarAutocorrelation: record_every expected to be at least 1");
+    }
+}
+
+void RecordScalarAutocorrelation::action(Array<double> &coords, double energy, bool accepted, MC* mc)
+{
+    const size_t counter = mc->get_iterations_count();
+    if (counter % m_record_every == 0 && counter > m_eqsteps) {
+        m_correlator.add(this->get_recorded_scalar(coords, energy, accepted, mc));
+    }
+}
+
+Array<double> RecordScalarAutocorrelation::get_lags() const
+{
+    std::vector<double> lags(m_correlator.get_lags());
+    for (size_t i = 0; i < lags.size(); ++i) {
+        lags[i] *= m_record_every;
+    }
+    return Array<double>(lags).copy();
+}
+
+Array<double> RecordScalarAutocorrelation::get_autocorrelation() const
+{
+    std::vector<double> rho(m_correlator.get_autocorrelation());
+    return Array<double>(rho).copy();
+}
+
+} // namespace mcpele
@@ -0,0 +1,43 @@
+#include "mcpele/record_scalar_blocking.h"
+
+using pele::Array;
+
+namespace mcpele {
+
+RecordScalarBlocking::RecordScalarBlocking(const size_t record_every, const size_t eqsteps, const size_t min_blocks)
+    : m_record_every(record_every),
+      m_eqsteps(eqsteps),
+      m_blocking(min_blocks)
+{
+    if (record_every == 0) {
+        throw std::runtime_error("RecordScalarBlocking: record_every expected to be at least 1");
+    }
+}
+
+void RecordScalarBlocking::action(Array<double> &coords, double energy, bool accepted, MC* mc)
+{
+    const size_t counter = mc->get_iterations_count();
+    if (counter % m_record_every == 0 && counter > m_eqsteps) {
+        m_blocking.add(this->get_recorded_scalar(coords, energy, accepted, mc));
+    }
+}
+
+Array<double> RecordScalarBlocking::get_block_sizes() const
+{
+    std::vector<double> vecdata(m_blocking.get_block_sizes());
+    return Array<double>(vecdata).copy();
+}
+
+Array<double> RecordScalarBlocking::get_standard_errors() const
+{
+    std::vector<double> vecdata(m_blocking.get_standard_errors());
+    return Array<double>(vecdata).copy();
+}
+
+Array<double> RecordScalarBlocking::get_standard_error_errors() const
+{
+    std::vector<double> vecdata(m_blocking.get_standard_error_errors());
+    return Array<double>(vecdata).copy();
+}
+
+} // namespace mcpele
@@ -1,17 +1,59 @@
 #include "mcpele/record_scalar_timeseries.h"
-#include "mcpele/moving_average.h"
+#include "mcpele/equilibration_detector.h"
 
 using pele::Array;
 
 namespace mcpele {
 
-RecordScalarTimeseries::RecordScalarTimeseries(const size_t niter, const size_t record_every)
-    : m_record_every(record_every)
+RecordScalarTimeseries::RecordScalarTimeseries(const size_t niter, const size_t record_every, const size_t capacity)
+    : m_record_every(record_every),
+      m_capacity(capacity),
+      m_ring_head(0),
+      m_ring_count(0)
 {
     if (record_every == 0) {
         throw std::runtime_error("RecordScalarTimeseries: record_every expected to be at least 1");
     }
-    m_time_series.reserve(niter / record_every);
+    if (capacity) {
+        m_time_series.assign(2 * capacity, 0);
+    }
+    else {
+        m_time_series.reserve(niter / record_every);
+    }
+}
+
+const double* RecordScalarTimeseries::m_series_begin() const
+{
+    if (m_mapped) {
+        return m_mapped->data();
+    }
+    if (m_capacity) {
+        return m_time_series.data() + m_ring_head + m_capacity - m_ring_count;
+    }
+    return m_time_series.data();
+}
+
+const double* RecordScalarTimeseries::m_series_end() const
+{
+    if (m_mapped) {
+        return m_mapped->data() + m_mapped->size();
+    }
+    if (m_capacity) {
+        return m_time_series.data() + m_ring_head + m_capacity;
+    }
+    return m_time_series.data() + m_time_series.size();
+}
+
+void RecordScalarTimeseries::clear()
+{
+    m_ring_head = 0;
+    m_ring_count = 0;
+    if (!m_capacity) {
+        m_time_series.clear();
+    }
+    if (m_mapped) {
+        m_mapped->clear();
+    }
 }
 
 void RecordScalarTimeseries::action(Array<double> &coords, double energy, bool accepted, MC* mc)
@@ -22,4 +64,26 @@ void RecordScalarTimeseries::action(Array<double> &coords, double energy, bool a
     }
 }
 
+void RecordScalarTimeseries::map_to_file(const std::string& filename, const size_t flush_every)
+{
+    if (m_mapped) {
+        throw std::runtime_error("RecordScalarTimeseries::map_to_file: time series is already mapped to " + m_mapped->get_filename());
+    }
+    if (m_capacity) {
+        throw std::runtime_error("RecordScalarTimeseries::map_to_file: not available with a bounded capacity");
+    }
+    m_mapped.reset(new MappedTimeseries(filename, 1, true, flush_every));
+    for (size_t i = 0; i < m_time_series.size(); ++i) {
+        m_mapped->append(&m_time_series[i]);
+    }
+    m_mapped->flush();
+    m_time_series.clear();
+    m_time_series.shrink_to_fit();
+}
+
+bool RecordScalarTimeseries::moving_average_is_stable(const size_t nr_steps_total, const double threshold) const
+{
+    return EquilibrationDetector::moving_average_is_stable(m_series_begin(), m_series_end(), nr_steps_total, threshold);
+}
+
 } // namespace mcpele
@@ -6,7 +6,8 @@ namespace mcpele {
 
 RecordVectorTimeseries::RecordVectorTimeseries(const size_t record_every, const size_t eqsteps)
     : m_record_every(record_every),
-      m_eqsteps(eqsteps)
+      m_eqsteps(eqsteps),
+      m_mapped_flush_every(0)
 {
     if (record_every == 0) {
         throw std::runtime_error("RecordVectorTimeseries: record_every expected to be at least 1");
@@ -21,4 +22,42 @@ void RecordVectorTimeseries::action(Array<double> &coords, double energy, bool a
     }
 }
 
+void RecordVectorTimeseries::map_to_file(const std::string& filename, const size_t flush_every)
+{
+    if (is_mapped()) {
+        throw std::runtime_error("RecordVectorTimeseries::map_to_file: time series is already mapped to " + m_mapped_filename);
+    }
+    if (filename.empty()) {
+        throw std::runtime_error("RecordVectorTimeseries::map_to_file: empty filename");
+    }
+    if (flush_every == 0) {
+        throw std::runtime_error("RecordVectorTimeseries::map_to_file: flush_every expected to be at least 1");
+    }
+    m_mapped_filename = filename;
+    m_mapped_flush_every = flush_every;
+}
+
+void RecordVectorTimeseries::m_record_mapped(const Array<double>& input)
+{
+    if (!m_mapped) {
+        // the row size is known from the first record
+        if (!m_time_series.empty() && m_time_series.row_size() != input.size()) {
+            throw std::runtime_error("RecordVectorTimeseries: vector size differs from previous records");
+        }
+        m_mapped.reset(new MappedTimeseries(m_mapped_filename, input.size(), false, m_mapped_flush_every));
+        const size_t row_size = input.size();
+        for (size_t ichunk = 0; ichunk < m_time_series.get_nr_chunks(); ++ichunk) {
+            const Array<double> chunk = m_time_series.get_chunk(ichunk);
+            for (size_t i = 0; i < chunk.size(); i += row_size) {
+                m_mapped->append(chunk.data() + i);
+            }
+        }
+        m_time_series.clear();
+    }
+    if (input.size() != m_mapped->row_size()) {
+        throw std::runtime_error("RecordVectorTimeseries: vector size differs from previous records");
+    }
+    m_mapped->append(input.data());
+}
+
 } // namespace mcpele
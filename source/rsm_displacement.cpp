@@ -1,7 +1,6 @@
 #include <cmath>
 #include <stdexcept>
 
-#include "mcpele/histogram.h"
 #include "mcpele/rsm_displacement.h"
 
 namespace mcpele{
@@ -19,11 +18,19 @@ double GetDisplacementPerParticle::compute_mean_particle_displacement(pele::Arra
     if (new_coords.size() != m_initial_coordinates.size()) {
         throw std::runtime_error("GetMeanRMSDisplacement::compute_mean_rsm_displacement: illegal new coords");
     }
-    Moments mom;
+    const double* x0 = m_initial_coordinates.data();
+    const double* x = new_coords.data();
+    double sum = 0;
     for (size_t particle = 0; particle < m_nr_particles; ++particle) {
-        mom.update(get_particle_displ(particle, new_coords));
+        const size_t particle_start = particle * m_boxdimension;
+        double sumsq = 0;
+        for (size_t k = 0; k < m_boxdimension; ++k) {
+            const double deltai = x0[particle_start + k] - x[particle_start + k];
+            sumsq += deltai * deltai;
+        }
+        sum += sqrt(sumsq);
     }
-    return mom.mean();
+    return sum / m_nr_particles;
 }
 
 double GetDisplacementPerParticle::get_particle_displ(const size_t particle_idx, pele::Array<double> new_coords)
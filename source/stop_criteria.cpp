@@ -0,0 +1,105 @@
+#include <sstream>
+#include <stdexcept>
+
+#include "mcpele/stop_criteria.h"
+
+namespace mcpele {
+
+StopStandardError::StopStandardError(std::shared_ptr<RecordScalarBlocking> blocking, const double tolerance,
+        const bool require_plateau)
+    : m_blocking(blocking),
+      m_tolerance(tolerance),
+      m_require_plateau(require_plateau)
+{
+    if (!blocking) {
+        throw std::runtime_error("StopStandardError: blocking action not set");
+    }
+}
+
+bool StopStandardError::stop(MC* mc)
+{
+    if (m_blocking->get_blocking().get_standard_errors().empty()) {
+        return false;
+    }
+    if (m_require_plateau && !m_blocking->has_plateau()) {
+        return false;
+    }
+    const double se = m_blocking->get_standard_error();
+    if (se >= m_tolerance) {
+        return false;
+    }
+    std::ostringstream reason;
+    reason << "standard error " << se << " below tolerance " << m_tolerance;
+    m_reason = reason.str();
+    return true;
+}
+
+StopEffectiveSampleSize::StopEffectiveSampleSize(std::shared_ptr<RecordScalarAutocorrelation> autocorrelation,
+        const double target)
+    : m_autocorrelation(autocorrelation),
+      m_target(target)
+{
+    if (!autocorrelation) {
+        throw std::runtime_error("StopEffectiveSampleSize: autocorrelation action not set");
+    }
+}
+
+double StopEffectiveSampleSize::get_effective_sample_size() const
+{
+    if (m_autocorrelation->get_count() == 0) {
+        return 0;
+    }
+    // tau_int in recorded samples
+    const double tau = m_autocorrelation->get_integrated_time() / m_autocorrelation->get_record_every();
+    return m_autocorrelation->get_count() / (2 * tau);
+}
+
+bool StopEffectiveSampleSize::stop(MC* mc)
+{
+    const double ess = get_effective_sample_size();
+    if (ess < m_target) {
+        return false;
+    }
+    std::ostringstream reason;
+    reason << "effective sample size " << ess << " reached target " << m_target;
+    m_reason = reason.str();
+    return true;
+}
+
+StopWallClock::StopWallClock(const double seconds)
+    : m_seconds(seconds),
+      m_start(std::chrono::steady_clock::now())
+{}
+
+bool StopWallClock::stop(MC* mc)
+{
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - m_start;
+    if (elapsed.count() < m_seconds) {
+        return false;
+    }
+    std::ostringstream reason;
+    reason << "wall-clock time " << elapsed.count() << " s exceeded budget " << m_seconds << " s";
+    m_reason = reason.str();
+    return true;
+}
+
+StopWangLandau::StopWangLandau(std::shared_ptr<RecordWangLandau> dos)
+    : m_dos(dos)
+{
+    if (!dos) {
+        throw std::runtime_error("StopWangLandau: density of states action not set");
+    }
+}
+
+bool StopWangLandau::stop(MC* mc)
+{
+    if (!m_dos->is_converged()) {
+        return false;
+    }
+    std::ostringstream reason;
+    reason << "Wang-Landau ln f " << m_dos->get_lnf() << " below " << m_dos->get_lnf_final();
+    m_reason = reason.str();
+    return true;
+}
+
+} // namespace mcpele
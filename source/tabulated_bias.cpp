@@ -0,0 +1,289 @@
+#include <limits>
+#include <stdexcept>
+
+#include "mcpele/tabulated_bias.h"
+
+using pele::Array;
+
+namespace mcpele {
+
+ProjectionCollectiveVariable::ProjectionCollectiveVariable(Array<double> direction)
+    : m_direction(direction.copy())
+{
+    if (direction.size() == 0) {
+        throw std::runtime_error("ProjectionCollectiveVariable: empty direction");
+    }
+}
+
+double ProjectionCollectiveVariable::get_value(Array<double> &coords, const double)
+{
+    if (coords.size() != m_direction.size()) {
+        throw std::runtime_error("ProjectionCollectiveVariable::get_value: coords size differs from direction size");
+    }
+    const double* x = coords.data();
+    const double* d = m_direction.data();
+    double s = 0;
+    for (size_t i = 0; i < coords.size(); ++i) {
+        s += x[i] * d[i];
+    }
+    return s;
+}
+
+TabulatedBias::TabulatedBias(std::shared_ptr<CollectiveVariable> cv, const double min, const double max,
+        const size_t nr_nodes, Array<double> log_weights)
+    : m_cv(cv),
+      m_min(min),
+      m_max(max),
+      m_nr_nodes(nr_nodes),
+      m_spacing(nr_nodes > 1 ? (max - min) / (nr_nodes - 1) : 0),
+      m_inv_spacing(m_spacing > 0 ? 1 / m_spacing : 0),
+      m_log_weights(nr_nodes, 0)
+{
+    if (!cv) {
+        throw std::runtime_error("TabulatedBias: collective variable is NULL");
+    }
+    if (nr_nodes < 2 || !(max > min)) {
+        throw std::runtime_error("TabulatedBias: illegal input: expected max > min and at least 2 nodes");
+    }
+    if (log_weights.size() > 0) {
+        set_log_weights(log_weights);
+    }
+}
+
+Array<double> TabulatedBias::get_nodes() const
+{
+    Array<double> nodes(m_nr_nodes);
+    for (size_t i = 0; i < m_nr_nodes; ++i) {
+        nodes[i] = m_min + i * m_spacing;
+    }
+    return nodes;
+}
+
+Array<double> TabulatedBias::get_log_weights() const
+{
+    Array<double> log_weights(m_nr_nodes);
+    std::copy(m_log_weights.begin(), m_log_weights.end(), log_weights.data());
+    return log_weights;
+}
+
+void TabulatedBias::set_log_weights(Array<double> log_weights)
+{
+    if (log_weights.size() != m_nr_nodes) {
+        throw std::runtime_error("TabulatedBias::set_log_weights: expected one weight per node");
+    }
+    std::copy(log_weights.begin(), log_weights.end(), m_log_weights.begin());
+}
+
+void TabulatedBias::add_to_log_weights(const std::vector<double>& delta)
+{
+    if (delta.size() != m_nr_nodes) {
+        throw std::runtime_error("TabulatedBias::add_to_log_weights: expected one value per node");
+    }
+    for (size_t i = 0; i < m_nr_nodes; ++i) {
+        m_log_weights[i] += delta[i];
+    }
+}
+
+TabulatedBiasTest::TabulatedBiasTest(std::shared_ptr<TabulatedBias> bias, const size_t rseed)
+    : m_bias(bias),
+      m_seed(rseed),
+      m_generator(rseed),
+      m_distribution(0.0, 1.0),
+      m_mc(NULL),
+      m_step(0),
+      m_naccept(0),
+      m_old_value(0),
+      m_old_energy(0),
+      m_trial_value(0),
+      m_trial_energy(0),
+      m_nr_cached(0)
+{
+    if (!bias) {
+        throw std::runtime_error("TabulatedBiasTest: bias is NULL");
+    }
+}
+
+/**
+ * Accept tests stop at the first rejection, so in the steps in which this
+ * test was not called the move was rejected: one more accepted step since
+ * the last call means that its trial configuration is the current one, none
+ * that the old one still is.
+ */
+double TabulatedBiasTest::m_old_value_of(Array<double>& old_coords, const double old_energy, const MC* mc)
+{
+    if (mc && mc == m_mc && mc->get_iterations_count() > m_step) {
+        const size_t naccept = mc->get_naccept() - m_naccept;
+        if (naccept == 1 && old_energy == m_trial_energy) {
+            ++m_nr_cached;
+            return m_trial_value;
+        }
+        if (naccept == 0 && old_energy == m_old_energy) {
+            ++m_nr_cached;
+            return m_old_value;
+        }
+    }
+    return m_bias->get_value(old_coords, old_energy);
+}
+
+bool TabulatedBiasTest::test(Array<double> &trial_coords, double trial_energy,
+        Array<double> &old_coords, double old_energy, double, MC* mc)
+{
+    const double s_trial = m_bias->get_value(trial_coords, trial_energy);
+    const double s_old = m_old_value_of(old_coords, old_energy, mc);
+    m_mc = mc;
+    if (mc) {
+        m_step = mc->get_iterations_count();
+        m_naccept = mc->get_naccept();
+    }
+    m_old_value = s_old;
+    m_old_energy = old_energy;
+    m_trial_value = s_trial;
+    m_trial_energy = trial_energy;
+    if (!m_bias->in_range(s_old)) {
+        return m_bias->get_distance(s_trial) <= m_bias->get_distance(s_old);
+    }
+    if (!m_bias->in_range(s_trial)) {
+        return false;
+    }
+    const double dlnw = m_bias->get_log_weight(s_trial) - m_bias->get_log_weight(s_old);
+    if (dlnw >= 0) {
+        return true;
+    }
+    return m_distribution(m_generator) < std::exp(dlnw);
+}
+
+RefineTabulatedBias::RefineTabulatedBias(std::shared_ptr<TabulatedBias> bias, const size_t refine_every,
+        const size_t eqsteps, const double flatness)
+    : m_bias(bias),
+      m_refine_every(refine_every),
+      m_eqsteps(eqsteps),
+      m_flatness(flatness),
+      m_histogram(bias ? bias->size() : 0, 0),
+      m_pair_weights(bias ? bias->size() - 1 : 0, 0),
+      m_count(0),
+      m_nr_refinements(0),
+      m_refining(true)
+{
+    if (!bias) {
+        throw std::runtime_error("RefineTabulatedBias: bias is NULL");
+    }
+    if (refine_every == 0) {
+        throw std::runtime_error("RefineTabulatedBias: refine_every expected to be at least 1");
+    }
+    if (!(flatness > 0 && flatness < 1)) {
+        throw std::runtime_error("RefineTabulatedBias: illegal input: flatness expected in (0, 1)");
+    }
+}
+
+void RefineTabulatedBias::action(Array<double> &coords, double energy, bool accepted, MC* mc)
+{
+    if (mc->get_iterations_count() <= m_eqsteps) {
+        return;
+    }
+    const double s = m_bias->get_value(coords, energy);
+    if (m_bias->in_range(s)) {
+        m_histogram[m_bias->get_node_index(s)] += 1;
+    }
+    ++m_count;
+    if (m_refining && m_count % m_refine_every == 0) {
+        refine();
+    }
+}
+
+bool RefineTabulatedBias::is_flat() const
+{
+    // the end nodes collect half a bin
+    const size_t n = m_histogram.size();
+    double total = 0;
+    for (size_t i = 0; i < n; ++i) {
+        total += m_histogram[i];
+    }
+    const double mean = total / (n - 1);
+    for (size_t i = 0; i < n; ++i) {
+        const double width = (i == 0 || i + 1 == n) ? 0.5 : 1;
+        if (m_histogram[i] < m_flatness * mean * width) {
+            return false;
+        }
+    }
+    return total > 0;
+}
+
+bool RefineTabulatedBias::refine()
+{
+    if (is_flat()) {
+        m_refining = false;
+        return false;
+    }
+    const size_t n = m_histogram.size();
+    const Array<double> log_weights = m_bias->get_log_weights();
+    // Berg's recursion on the differences of adjacent nodes
+    std::vector<double> delta(n, 0);
+    bool changed = false;
+    double log_weight = log_weights[0];
+    double highest = log_weight;
+    for (size_t i = 0; i + 1 < n; ++i) {
+        double difference = log_weights[i + 1] - log_weights[i];
+        const double h0 = m_histogram[i];
+        const double h1 = m_histogram[i + 1];
+        if (h0 > 0 && h1 > 0) {
+            const double width0 = (i == 0) ? 0.5 : 1;
+            const double width1 = (i + 2 == n) ? 0.5 : 1;
+            const double estimate = difference - std::log((h1 / width1) / (h0 / width0));
+            const double weight = h0 * h1 / (h0 + h1);
+            difference += weight / (m_pair_weights[i] + weight) * (estimate - difference);
+            m_pair_weights[i] += weight;
+            changed = true;
+        }
+        log_weight += difference;
+        delta[i + 1] = log_weight - log_weights[i + 1];
+        highest = std::max(highest, log_weight);
+    }
+    if (!changed) {
+        return false;
+    }
+    // keep the largest weight at ln w = 0
+    for (size_t i = 0; i < n; ++i) {
+        delta[i] -= highest;
+    }
+    m_bias->add_to_log_weights(delta);
+    ++m_nr_refinements;
+    clear_histogram();
+    return true;
+}
+
+Array<double> RefineTabulatedBias::get_histogram() const
+{
+    Array<double> histogram(m_histogram.size());
+    std::copy(m_histogram.begin(), m_histogram.end(), histogram.data());
+    return histogram;
+}
+
+Array<double> RefineTabulatedBias::get_free_energy() const
+{
+    const size_t n = m_histogram.size();
+    const Array<double> log_weights = m_bias->get_log_weights();
+    Array<double> free_energy(n);
+    double lowest = std::numeric_limits<double>::max();
+    for (size_t i = 0; i < n; ++i) {
+        const double width = (i == 0 || i + 1 == n) ? 0.5 : 1;
+        if (m_histogram[i] > 0) {
+            free_energy[i] = log_weights[i] - std::log(m_histogram[i] / width);
+            lowest = std::min(lowest, free_energy[i]);
+        }
+        else {
+            free_energy[i] = std::numeric_limits<double>::infinity();
+        }
+    }
+    for (size_t i = 0; i < n; ++i) {
+        free_energy[i] -= lowest;
+    }
+    return free_energy;
+}
+
+void RefineTabulatedBias::clear_histogram()
+{
+    std::fill(m_histogram.begin(), m_histogram.end(), 0);
+    m_count = 0;
+}
+
+} // namespace mcpele
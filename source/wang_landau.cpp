@@ -0,0 +1,221 @@
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+#include "mcpele/wang_landau.h"
+
+using pele::Array;
+
+namespace mcpele {
+
+RecordWangLandau::RecordWangLandau(const double min, const double max, const double bin,
+        const double flatness, const size_t check_every, const double lnf_initial,
+        const double lnf_final)
+    : m_min(min),
+      m_bin(bin),
+      m_flatness(flatness),
+      m_check_every(check_every),
+      m_lnf_final(lnf_final),
+      m_lnf(lnf_initial),
+      m_nr_updates(0),
+      m_nr_stages(0),
+      m_one_over_t(false)
+{
+    if (!(bin > 0) || !(max > min)) {
+        throw std::runtime_error("RecordWangLandau: illegal input: expected max > min and bin > 0");
+    }
+    if (!(flatness > 0 && flatness < 1)) {
+        throw std::runtime_error("RecordWangLandau: illegal input: flatness expected in (0, 1)");
+    }
+    if (check_every == 0) {
+        throw std::runtime_error("RecordWangLandau: check_every expected to be at least 1");
+    }
+    if (!(lnf_initial > 0) || !(lnf_final > 0)) {
+        throw std::runtime_error("RecordWangLandau: illegal input: ln f expected to be positive");
+    }
+    m_nr_bins = static_cast<size_t>(std::ceil((max - min) / bin - 1e-9));
+    m_max = m_min + m_nr_bins * m_bin;
+    m_lng.assign(m_nr_bins, 0);
+    m_histogram.assign(m_nr_bins, 0);
+    m_visited.assign(m_nr_bins, 0);
+}
+
+bool RecordWangLandau::update(const double energy)
+{
+    if (!in_range(energy)) {
+        return false;
+    }
+    const size_t i = get_bin_index(energy);
+    m_lng[i] += m_lnf;
+    ++m_histogram[i];
+    m_visited[i] = 1;
+    ++m_nr_updates;
+    if (m_one_over_t) {
+        m_lnf = static_cast<double>(m_nr_bins) / m_nr_updates;
+    }
+    else if (m_nr_updates % m_check_every == 0) {
+        m_check_flatness();
+    }
+    return true;
+}
+
+bool RecordWangLandau::is_flat() const
+{
+    size_t nr_visited = 0;
+    size_t total = 0;
+    size_t lowest = std::numeric_limits<size_t>::max();
+    for (size_t i = 0; i < m_nr_bins; ++i) {
+        if (m_visited[i]) {
+            ++nr_visited;
+            total += m_histogram[i];
+            lowest = std::min(lowest, m_histogram[i]);
+        }
+    }
+    if (nr_visited < 2) {
+        return false;
+    }
+    return lowest >= m_flatness * total / nr_visited;
+}
+
+void RecordWangLandau::m_check_flatness()
+{
+    if (!is_flat()) {
+        return;
+    }
+    m_lnf *= 0.5;
+    ++m_nr_stages;
+    std::fill(m_histogram.begin(), m_histogram.end(), 0);
+    const double one_over_t = static_cast<double>(m_nr_bins) / m_nr_updates;
+    if (m_lnf <= one_over_t) {
+        m_one_over_t = true;
+        m_lnf = one_over_t;
+    }
+}
+
+void RecordWangLandau::merge(const RecordWangLandau& other)
+{
+    const double offset = (other.m_min - m_min) / m_bin;
+    const long shift_bins = std::lround(offset);
+    if (std::fabs(other.m_bin - m_bin) > 1e-9 * m_bin || std::fabs(offset - shift_bins) > 1e-6) {
+        throw std::runtime_error("RecordWangLandau::merge: windows are not on the same grid");
+    }
+    // absolute bin index k of this window's bin i is i, of the other's bin j is j + shift_bins
+    const long begin = std::min(0L, shift_bins);
+    const long end = std::max(static_cast<long>(m_nr_bins), shift_bins + static_cast<long>(other.m_nr_bins));
+    const long nr_bins = end - begin;
+    std::vector<double> lng_self(nr_bins, 0), lng_other(nr_bins, 0);
+    std::vector<char> visited_self(nr_bins, 0), visited_other(nr_bins, 0);
+    std::vector<size_t> histogram(nr_bins, 0);
+    for (size_t i = 0; i < m_nr_bins; ++i) {
+        lng_self[i - begin] = m_lng[i];
+        visited_self[i - begin] = m_visited[i];
+        histogram[i - begin] += m_histogram[i];
+    }
+    for (size_t j = 0; j < other.m_nr_bins; ++j) {
+        const long k = j + shift_bins - begin;
+        lng_other[k] = other.m_lng[j];
+        visited_other[k] = other.m_visited[j];
+        histogram[k] += other.m_histogram[j];
+    }
+    long overlap_begin = -1, overlap_end = -1;
+    double difference = 0;
+    size_t nr_overlap = 0;
+    for (long k = 0; k < nr_bins; ++k) {
+        if (visited_self[k] && visited_other[k]) {
+            if (overlap_begin < 0) {
+                overlap_begin = k;
+            }
+            overlap_end = k + 1;
+            difference += lng_self[k] - lng_other[k];
+            ++nr_overlap;
+        }
+    }
+    if (nr_overlap == 0) {
+        throw std::runtime_error("RecordWangLandau::merge: the windows have no visited bins in common");
+    }
+    difference /= nr_overlap;
+    const long middle = (overlap_begin + overlap_end) / 2;
+    const bool self_is_lower = m_min <= other.m_min;
+    m_lng.assign(nr_bins, 0);
+    m_visited.assign(nr_bins, 0);
+    for (long k = 0; k < nr_bins; ++k) {
+        const bool use_self = visited_self[k] && (!visited_other[k] || (k < middle) == self_is_lower);
+        if (use_self) {
+            m_lng[k] = lng_self[k];
+        }
+        else if (visited_other[k]) {
+            m_lng[k] = lng_other[k] + difference;
+        }
+        m_visited[k] = visited_self[k] || visited_other[k];
+    }
+    m_histogram.swap(histogram);
+    m_min += begin * m_bin;
+    m_nr_bins = nr_bins;
+    m_max = m_min + m_nr_bins * m_bin;
+    m_lnf = std::max(m_lnf, other.m_lnf);
+    m_nr_updates += other.m_nr_updates;
+    m_nr_stages = std::min(m_nr_stages, other.m_nr_stages);
+    m_one_over_t = m_one_over_t && other.m_one_over_t;
+}
+
+Array<double> RecordWangLandau::get_energies() const
+{
+    Array<double> energies(m_nr_bins);
+    for (size_t i = 0; i < m_nr_bins; ++i) {
+        energies[i] = m_min + (0.5 + i) * m_bin;
+    }
+    return energies;
+}
+
+Array<double> RecordWangLandau::get_log_density_of_states() const
+{
+    double lowest = std::numeric_limits<double>::max();
+    for (size_t i = 0; i < m_nr_bins; ++i) {
+        if (m_visited[i]) {
+            lowest = std::min(lowest, m_lng[i]);
+        }
+    }
+    Array<double> lng(m_nr_bins);
+    for (size_t i = 0; i < m_nr_bins; ++i) {
+        lng[i] = m_visited[i] ? m_lng[i] - lowest : -std::numeric_limits<double>::infinity();
+    }
+    return lng;
+}
+
+Array<double> RecordWangLandau::get_histogram() const
+{
+    Array<double> histogram(m_nr_bins);
+    for (size_t i = 0; i < m_nr_bins; ++i) {
+        histogram[i] = m_histogram[i];
+    }
+    return histogram;
+}
+
+WangLandauTest::WangLandauTest(std::shared_ptr<RecordWangLandau> dos, const size_t rseed)
+    : m_dos(dos),
+      m_seed(rseed),
+      m_generator(rseed),
+      m_distribution(0.0, 1.0)
+{
+    if (!dos) {
+        throw std::runtime_error("WangLandauTest: density of states action not set");
+    }
+}
+
+bool WangLandauTest::test(Array<double>&, double trial_energy,
+        Array<double>&, double old_energy, double, MC*)
+{
+    if (!m_dos->in_range(old_energy)) {
+        return m_dos->get_distance(trial_energy) <= m_dos->get_distance(old_energy);
+    }
+    if (!m_dos->in_range(trial_energy)) {
+        return false;
+    }
+    const double dlng = m_dos->get_log_density(old_energy) - m_dos->get_log_density(trial_energy);
+    if (dlng >= 0) {
+        return true;
+    }
+    return m_distribution(m_generator) < std::exp(dlng);
+}
+
+} // namespace mcpele